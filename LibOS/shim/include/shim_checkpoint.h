@@ -117,6 +117,13 @@ struct shim_cp_store {
     /* entries of pal handles to send */
     struct shim_palhdl_entry* last_palhdl_entry;
     int palhdl_nentries;
+
+    /* PAL handles are not sent (e.g., snapshots), so shared memory is saved like private one */
+    bool copy_shared_memory;
+
+    /* an incremental snapshot: anonymous memory is saved only if written since the previous one */
+    bool incremental;
+    struct shim_written_pages* written;
 };
 
 #define CP_FUNC_ARGS struct shim_cp_store* store, void* obj, size_t size, void** objp
@@ -392,6 +399,7 @@ struct newproc_cp_header {
     struct mem_header {
         unsigned long entoffset;
         int nentries;
+        unsigned long dataoffset; /* the memory is sent after this much checkpoint data */
     } mem;
     struct palhdl_header {
         unsigned long entoffset;
@@ -414,14 +422,36 @@ struct newproc_response {
     int failure;
 };
 
+/* A snapshot file starts with this header; the checkpoint data follows at `data_offset` (aligned
+ * to the allocation alignment) in the same layout that is sent to a forked child. An incremental
+ * snapshot names the snapshot it was taken after in `parent`, which must be restored first;
+ * `chain_depth` counts the snapshots before it, and reaches at most SNAPSHOT_MAX_CHAIN - 1. */
+#define SNAPSHOT_MAGIC 0x3270616e73656e67UL /* "gensnap2" */
+#define SNAPSHOT_URI_MAX 256
+#define SNAPSHOT_MAX_CHAIN 64
+
+struct snapshot_header {
+    unsigned long magic;
+    unsigned long data_offset;
+    unsigned long chain_depth;
+    char parent[SNAPSHOT_URI_MAX];
+    struct newproc_cp_header checkpoint;
+};
+
 int do_migration(struct newproc_cp_header* hdr, void** cpptr);
 int restore_checkpoint(struct cp_header* cphdr, struct mem_header* memhdr, ptr_t base, ptr_t type);
 int do_migrate_process(int (*migrate)(struct shim_cp_store*, struct shim_thread*,
                                       struct shim_process*, va_list),
                        struct shim_handle* exec, const char** argv, struct shim_thread* thread,
                        ...);
+int do_snapshot_process(int (*migrate)(struct shim_cp_store*, struct shim_thread*,
+                                       struct shim_process*, va_list),
+                        PAL_HANDLE file, const char* uri, struct shim_thread* thread, ...);
 int init_from_checkpoint_file(const char* filename, struct newproc_cp_header* hdr, void** cpptr);
 int restore_from_file(const char* filename, struct newproc_cp_header* hdr, void** cpptr);
+int restore_from_snapshot(const char* uri, struct newproc_cp_header* hdr, void** cpptr);
+void restore_snapshot_chain(void* addr, size_t size);
+int finish_snapshot_restore(void);
 void restore_context(struct shim_context* context);
 int create_checkpoint(const char* cpdir, IDTYPE* session);
 int join_checkpoint(struct shim_thread* cur, IDTYPE sid);
@@ -55,6 +55,11 @@ struct shim_fs_ops {
     /* write: the content from the file opened as handle */
     ssize_t (*write)(struct shim_handle* hdl, const void* buf, size_t count);
 
+    /* pread, pwrite: read or write at an explicit offset, without touching the file marker
+       (and thus without taking the handle lock) */
+    ssize_t (*pread)(struct shim_handle* hdl, void* buf, size_t count, off_t pos);
+    ssize_t (*pwrite)(struct shim_handle* hdl, const void* buf, size_t count, off_t pos);
+
     /* mmap: mmap handle to address */
     int (*mmap)(struct shim_handle* hdl, void** addr, size_t size, int prot, int flags,
                 off_t offset);
@@ -523,11 +528,24 @@ extern struct shim_d_ops chroot_d_ops;
 extern struct shim_fs_ops str_fs_ops;
 extern struct shim_d_ops str_d_ops;
 
+/* in-process ring buffers of pipes and socketpairs (fs/shim_fs_ring.c); the read/write/poll
+ * functions return false if the pair has been migrated to its host stream */
+int ring_pipe_create(struct shim_handle* hdl1, struct shim_handle* hdl2);
+bool ring_pipe_read(struct shim_handle* hdl, void* buf, size_t count, ssize_t* ret);
+bool ring_pipe_write(struct shim_handle* hdl, const void* buf, size_t count, ssize_t* ret);
+bool ring_pipe_poll(struct shim_handle* hdl, int poll_type, off_t* ret);
+void ring_pipe_migrate(struct shim_handle* hdl);
+void ring_pipe_checkout(struct shim_handle* hdl);
+void ring_pipe_close(struct shim_handle* hdl);
+
 extern struct shim_mount chroot_builtin_fs;
 extern struct shim_mount pipe_builtin_fs;
 extern struct shim_mount socket_builtin_fs;
 extern struct shim_mount epoll_builtin_fs;
 extern struct shim_mount eventfd_builtin_fs;
+extern struct shim_mount shm_builtin_fs;
+extern struct shim_mount timerfd_builtin_fs;
+extern struct shim_mount signalfd_builtin_fs;
 
 /* pseudo file systems (separate treatment since they don't have associated dentries) */
 #define DIR_RX_MODE  0555
@@ -540,6 +558,9 @@ extern struct shim_d_ops dev_d_ops;
 extern struct shim_fs_ops proc_fs_ops;
 extern struct shim_d_ops proc_d_ops;
 
+extern struct shim_fs_ops sys_fs_ops;
+extern struct shim_d_ops sys_d_ops;
+
 struct pseudo_name_ops {
     int (*match_name)(const char* name);
     int (*list_name)(const char* name, struct shim_dirent** buf, int count);
@@ -583,6 +604,11 @@ int pseudo_stat(struct shim_dentry* dent, struct stat* buf, const struct pseudo_
 int pseudo_hstat(struct shim_handle* hdl, struct stat* buf, const struct pseudo_ent* root_ent);
 int pseudo_follow_link(struct shim_dentry* dent, struct shim_qstr* link,
                        const struct pseudo_ent* root_ent);
+int pseudo_str_open(struct shim_handle* hdl, int flags, char* str, size_t len);
+int pseudo_print_list(char* buf, size_t size, const unsigned long* bitmap, size_t count);
+int pseudo_print_mask(char* buf, size_t size, const unsigned long* bitmap, size_t count);
+int pseudo_bitmap_open(struct shim_handle* hdl, int flags, const unsigned long* bitmap,
+                       size_t count, bool mask);
 
 /* string-type file system */
 int str_add_dir(const char* path, mode_t mode, struct shim_dentry** dent);
@@ -50,7 +50,9 @@ enum shim_handle_type {
     TYPE_FUTEX,
     TYPE_STR,
     TYPE_EPOLL,
-    TYPE_EVENTFD
+    TYPE_EVENTFD,
+    TYPE_TIMERFD,
+    TYPE_SIGNALFD
 };
 
 struct shim_handle;
@@ -255,6 +257,8 @@ struct shim_msg_handle {
     int maxtypes;
     struct msg_type* types;
     struct sysv_score scores[MAX_SYSV_CLIENTS];
+    struct shim_msgq_shared* shared; /* queue in host shared memory, if any */
+    bool shared_failed;              /* do not try to map the shared queue again */
     LIST_TYPE(shim_msg_handle) list;
     LIST_TYPE(shim_msg_handle) key_hlist;
     LIST_TYPE(shim_msg_handle) qid_hlist;
@@ -311,9 +315,28 @@ struct shim_epoll_handle {
     LISTP_TYPE(shim_epoll_item) fds;
 };
 
+/* timerfd and signalfd keep a byte in their pal_handle (a PAL pipe) while they are readable, so
+ * that poll() and epoll() can wait on them like on any other stream */
+DEFINE_LIST(shim_timerfd_handle);
+struct shim_timerfd_handle {
+    int clockid;
+    uint64_t deadline;    /* in usecs of DkSystemTimeQuery(), 0 if disarmed */
+    uint64_t interval;    /* in usecs, 0 for one-shot timers */
+    uint64_t expirations; /* since the last read() */
+    LIST_TYPE(shim_timerfd_handle) list;
+};
+
+DEFINE_LIST(shim_signalfd_handle);
+struct shim_signalfd_handle {
+    __sigset_t mask;
+    bool ready;
+    LIST_TYPE(shim_signalfd_handle) list;
+};
+
 struct shim_mount;
 struct shim_qstr;
 struct shim_dentry;
+struct shim_ring_pipe;
 
 /* The epolls list links to the back field of the shim_epoll_item structure
  */
@@ -336,6 +359,10 @@ struct shim_handle {
 
     PAL_HANDLE pal_handle;
 
+    /* In-process data path of a pipe or socketpair whose ends have not left this process yet,
+     * see fs/shim_fs_ring.c. */
+    struct shim_ring_pipe* ring;
+
     union {
         struct shim_file_handle file;
         struct shim_dev_handle dev;
@@ -346,6 +373,8 @@ struct shim_handle {
         struct shim_sem_handle sem;
         struct shim_str_handle str;
         struct shim_epoll_handle epoll;
+        struct shim_timerfd_handle timerfd;
+        struct shim_signalfd_handle signalfd;
     } info;
 
     struct shim_dir_handle dir_info;
@@ -422,5 +451,8 @@ off_t get_file_size(struct shim_handle* file);
 
 int do_handle_read(struct shim_handle* hdl, void* buf, int count);
 int do_handle_write(struct shim_handle* hdl, const void* buf, int count);
+ssize_t do_handle_pread(struct shim_handle* hdl, void* buf, size_t count, off_t pos);
+ssize_t do_handle_pwrite(struct shim_handle* hdl, const void* buf, size_t count, off_t pos);
+int do_handle_fsync(struct shim_handle* hdl);
 
 #endif /* _SHIM_HANDLE_H_ */
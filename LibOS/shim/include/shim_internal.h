@@ -441,6 +441,26 @@ void parse_syscall_after (int sysno, const char * name, int nr, ...);
 
 #define PAL_CB(member)     (pal_control.member)
 
+/* hosts without a NUMA topology are presented as a single node holding all CPUs and memory */
+static inline size_t get_numa_node_count(void) {
+    return PAL_CB(numa_info.node_num) ? PAL_CB(numa_info.node_num) : 1;
+}
+
+/* without a topology from the host, every CPU is a core of its own in a single package */
+static inline size_t get_cpu_core(size_t cpu) {
+    return PAL_CB(cpu_info.cpu_core) ? PAL_CB(cpu_info.cpu_core)[cpu] : cpu;
+}
+
+static inline size_t get_cpu_package(size_t cpu) {
+    return PAL_CB(cpu_info.cpu_package) ? PAL_CB(cpu_info.cpu_package)[cpu] : 0;
+}
+
+static inline size_t get_numa_node_of_cpu(size_t cpu) {
+    if (!PAL_CB(numa_info.node_num) || cpu >= PAL_CB(cpu_info.cpu_num))
+        return 0;
+    return PAL_CB(numa_info.cpu_node)[cpu];
+}
+
 #define LOCK_FREE ((IDTYPE) -1)
 
 extern bool lock_enabled;
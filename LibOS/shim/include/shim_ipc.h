@@ -83,6 +83,9 @@ typedef void (*port_fini)(struct shim_ipc_port*, IDTYPE vmid, unsigned int exitc
 
 #define MAX_IPC_PORT_FINI_CB 3
 
+/* messages received in one read are handled in place in the port's buffer */
+#define IPC_PORT_RECV_BUF_SIZE 1024
+
 DEFINE_LIST(shim_ipc_port);
 DEFINE_LISTP(shim_ipc_msg_duplex);
 struct shim_ipc_port {
@@ -97,6 +100,24 @@ struct shim_ipc_port {
 
     IDTYPE type;
     IDTYPE vmid;
+
+    /* shared-memory rings (see shim_ipc_ring.c) */
+    bool ring_offered;
+    struct shim_ipc_ring* ring_in;  /* messages from the peer, handled by IPC helper */
+    PAL_HANDLE ring_in_file;        /* backing file of ring_in until the peer attaches */
+    unsigned int ring_in_epoch;     /* last epoch announced by the peer with IPC_RING_KICK */
+    /* messages to the peer; with rings enabled, all sending on the port is serialized by
+     * msgs_lock, which also protects these fields */
+    struct shim_ipc_ring* ring_out;
+    unsigned int ring_out_epoch;
+    bool ring_out_paused;           /* the last message went over the stream */
+
+    /* receive buffer used by IPC helper; a partially received message stays here until the rest
+     * of it arrives. recv_buf points to recv_inline unless a larger message is being received. */
+    char* recv_buf;
+    size_t recv_bufsize;
+    size_t recv_bytes;
+    char recv_inline[IPC_PORT_RECV_BUF_SIZE] __attribute__((aligned(8)));
 };
 
 #define IPC_CALLBACK_ARGS struct shim_ipc_msg* msg, struct shim_ipc_port* port
@@ -111,6 +132,8 @@ typedef int (*ipc_callback)(struct shim_ipc_msg* msg, struct shim_ipc_port* port
 enum {
     IPC_RESP = 0,
     IPC_CHECKPOINT,
+    IPC_RING_OFFER,
+    IPC_RING_KICK,
     IPC_BASE_BOUND,
 };
 
@@ -128,6 +151,22 @@ struct shim_ipc_checkpoint {
 int ipc_checkpoint_send(const char* cpdir, IDTYPE cpsession);
 int ipc_checkpoint_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
 
+/* IPC_RING_OFFER: offer a shared-memory ring for messages to the offering process */
+struct shim_ipc_ring_offer {
+    char uri[1];
+};
+
+int ipc_ring_offer_send(struct shim_ipc_port* port);
+int ipc_ring_offer_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
+
+/* IPC_RING_KICK: the sender (re)starts using the ring with the given epoch, or wakes up the IPC
+ * helper */
+struct shim_ipc_ring_kick {
+    unsigned int epoch;
+};
+
+int ipc_ring_kick_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
+
 /* Message code from child to parent */
 #define IPC_CLD_BASE IPC_BASE_BOUND
 enum {
@@ -492,6 +531,8 @@ struct shim_ipc_msg_duplex* pop_ipc_msg_duplex(struct shim_ipc_port* port, unsig
 
 int broadcast_ipc(struct shim_ipc_msg* msg, int target_type, struct shim_ipc_port* exclude_port);
 int send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
+int send_ipc_message_stream(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
+int __send_ipc_message_stream(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
 int send_ipc_message_duplex(struct shim_ipc_msg_duplex* msg, struct shim_ipc_port* port,
                             unsigned long* seq, void* private_data);
 int send_response_ipc_message(struct shim_ipc_port* port, IDTYPE dest, int ret, unsigned long seq);
@@ -500,6 +541,17 @@ void ipc_port_with_child_fini(struct shim_ipc_port* port, IDTYPE vmid, unsigned
 
 struct shim_thread* terminate_ipc_helper(void);
 
+/* shared-memory transport of IPC messages */
+int init_ipc_rings(void);
+bool ipc_rings_enabled(void);
+int ipc_ring_send(struct shim_ipc_msg* msg, struct shim_ipc_port* port);
+int ipc_ring_peek(struct shim_ipc_port* port, struct shim_ipc_msg** msg);
+void ipc_ring_consume(struct shim_ipc_port* port, struct shim_ipc_msg* msg);
+bool ipc_ring_pending(struct shim_ipc_port* port);
+bool ipc_ring_arm(struct shim_ipc_port* port);
+void ipc_ring_disarm(struct shim_ipc_port* port);
+void ipc_ring_fini(struct shim_ipc_port* port);
+
 int prepare_ns_leaders(void);
 
 #endif /* _SHIM_IPC_H_ */
@@ -136,6 +136,13 @@ void __store_context (shim_tcb_t * tcb, PAL_CONTEXT * pal_context,
 // Need to hold thread->lock when calling this function
 void append_signal(struct shim_thread* thread, int sig, siginfo_t* info, bool need_interrupt);
 
+struct shim_signal* fetch_pending_signal(struct shim_thread* thread, const __sigset_t* mask,
+                                         int* sig);
+
+/* signalfd support, see sys/shim_signalfd.c */
+bool signalfd_watches(int sig);
+void notify_signalfds(int sig);
+
 void deliver_signal(siginfo_t* info, PAL_CONTEXT* context);
 
 __sigset_t * get_sig_mask (struct shim_thread * thread);
@@ -114,6 +114,43 @@ struct msg_type {
 
 #define DEFAULT_MSG_QUEUE_SIZE 2048
 
+/* Layout of a message queue kept in host shared memory (see shim_msgget.c). Slots are linked by
+ * index; the messages of one type form a single chain from `head` to `tail`. */
+#define MSGQ_SHARED_MAGIC 0x71736d7673797367UL /* "gsysvmsq" */
+#define MSGQ_SHARED_TYPES 64
+
+struct msgq_shared_slot {
+    int next;
+    unsigned int size; /* only valid in the first slot of a message */
+    char data[MSG_QOBJ_SIZE - 2 * sizeof(int)];
+};
+
+#define MSGQ_SHARED_SLOTS(size) \
+    ((size) ? ((size) + sizeof(((struct msgq_shared_slot*)0)->data) - 1) / \
+              sizeof(((struct msgq_shared_slot*)0)->data) : 1)
+
+struct msgq_shared_type {
+    long type;
+    int head; /* -1 if the entry is unused */
+    int tail; /* last slot of the newest message */
+};
+
+struct shim_msgq_shared {
+    unsigned long magic;
+    unsigned int lock;     /* futex-based mutex: 0 unlocked, 1 locked, 2 locked with waiters */
+    unsigned int seq;      /* bumped on every change; waiters sleep on it */
+    unsigned int nwaiters;
+    unsigned int deleted;
+    IDTYPE creator; /* names the host file */
+    int nmsgs;
+    int currentsize;
+    int freed; /* first free slot */
+    int nfree;
+    int nslots;
+    struct msgq_shared_type types[MSGQ_SHARED_TYPES];
+    struct msgq_shared_slot slots[];
+};
+
 #define MSG_SND_SCORE         1
 #define MSG_RCV_SCORE         20
 #define MSG_SCORE_DECAY       10
@@ -150,6 +187,7 @@ int get_sysv_msg(struct shim_msg_handle* msgq, long type, size_t size, void* dat
                  struct sysv_client* src);
 
 int store_all_msg_persist(void);
+void detach_msg_shared(struct shim_msg_handle* msgq);
 
 #define HOST_SEM_NUM 65535
 
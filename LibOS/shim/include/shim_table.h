@@ -314,6 +314,7 @@ long __shim_syncfs(long);
 long __shim_sendmmsg(long, long, long, long);
 long __shim_setns(long, long);
 long __shim_getcpu(long, long, long);
+long __shim_copy_file_range(long, long, long, long, long, long);
 
 /* libos call entries */
 long __shim_msgpersist(long, long);
@@ -321,6 +322,7 @@ long __shim_benchmark_rpc(long, long, long, long);
 long __shim_send_rpc(long, long, long);
 long __shim_recv_rpc(long, long, long);
 long __shim_checkpoint(long);
+long __shim_snapshot(long);
 
 /* syscall implementation */
 size_t shim_do_read(int fd, void* buf, size_t count);
@@ -353,6 +355,7 @@ int shim_do_sched_yield(void);
 void* shim_do_mremap(void* addr, size_t old_len, size_t new_len, int flags, void* new_addr);
 int shim_do_msync(void* start, size_t len, int flags);
 int shim_do_mincore(void* start, size_t len, unsigned char* vec);
+int shim_do_madvise(void* start, size_t len, int behavior);
 int shim_do_dup(unsigned int fd);
 int shim_do_dup2(unsigned int oldfd, unsigned int newfd);
 int shim_do_pause(void);
@@ -363,6 +366,10 @@ int shim_do_setitimer(int which, struct __kernel_itimerval* value,
                       struct __kernel_itimerval* ovalue);
 pid_t shim_do_getpid(void);
 ssize_t shim_do_sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       int flags);
+ssize_t shim_do_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out,
+                                size_t len, unsigned int flags);
 int shim_do_socket(int family, int type, int protocol);
 int shim_do_connect(int sockfd, struct sockaddr* addr, int addrlen);
 int shim_do_accept(int fd, struct sockaddr* addr, socklen_t* addrlen);
@@ -453,6 +460,12 @@ time_t shim_do_time(time_t* tloc);
 int shim_do_futex(int* uaddr, int op, int val, void* utime, int* uaddr2, int val3);
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
+int shim_do_io_setup(unsigned nr_reqs, aio_context_t* ctx);
+int shim_do_io_destroy(aio_context_t ctx);
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout);
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp);
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result);
 int shim_do_set_tid_address(int* tidptr);
 int shim_do_semtimedop(int semid, struct sembuf* sops, unsigned int nsops,
                        const struct timespec* timeout);
@@ -469,6 +482,11 @@ noreturn int shim_do_exit_group(int error_code);
 int shim_do_tgkill(int tgid, int pid, int sig);
 int shim_do_mbind(void* start, unsigned long len, int mode, unsigned long* nmask,
                   unsigned long maxnode, int flags);
+int shim_do_set_mempolicy(int mode, unsigned long* nmask, unsigned long maxnode);
+int shim_do_get_mempolicy(int* policy, unsigned long* nmask, unsigned long maxnode, void* addr,
+                          unsigned long flags);
+int shim_do_move_pages(pid_t pid, unsigned long nr_pages, void** pages, const int* nodes,
+                       int* status, int flags);
 int shim_do_openat(int dfd, const char* filename, int flags, int mode);
 int shim_do_mkdirat(int dfd, const char* pathname, int mode);
 int shim_do_newfstatat(int dirfd, const char* pathname, struct stat* statbuf, int flags);
@@ -485,15 +503,26 @@ int shim_do_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_do_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
 int shim_do_epoll_pwait(int epfd, struct __kernel_epoll_event* events, int maxevents,
                         int timeout_ms, const __sigset_t* sigmask, size_t sigsetsize);
+int shim_do_signalfd(int ufd, __sigset_t* user_mask, size_t sizemask);
+int shim_do_timerfd_create(int clockid, int flags);
+int shim_do_timerfd_settime(int ufd, int flags, const struct __kernel_itimerspec* utmr,
+                            struct __kernel_itimerspec* otmr);
+int shim_do_timerfd_gettime(int ufd, struct __kernel_itimerspec* otmr);
 int shim_do_accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+int shim_do_signalfd4(int ufd, __sigset_t* user_mask, size_t sizemask, int flags);
 int shim_do_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_do_epoll_create1(int flags);
 int shim_do_pipe2(int* fildes, int flags);
+ssize_t shim_do_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                       unsigned long pos_l, unsigned long pos_h);
+ssize_t shim_do_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                        unsigned long pos_l, unsigned long pos_h);
 ssize_t shim_do_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags,
                          struct __kernel_timespec* timeout);
 int shim_do_prlimit64(pid_t pid, int resource, const struct __kernel_rlimit64* new_rlim,
                       struct __kernel_rlimit64* old_rlim);
 ssize_t shim_do_sendmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags);
+int shim_do_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused);
 int shim_do_eventfd2(unsigned int count, int flags);
 int shim_do_eventfd(unsigned int count);
 
@@ -503,6 +532,7 @@ int shim_do_benchmark_rpc(pid_t pid, int times, const void* buf, size_t size);
 size_t shim_do_send_rpc(pid_t pid, const void* buf, size_t size);
 size_t shim_do_recv_rpc(pid_t* pid, void* buf, size_t size);
 int shim_do_checkpoint(const char* filename);
+int shim_do_snapshot(const char* filename);
 
 #endif /* ! IN_SHIM */
 
@@ -747,7 +777,7 @@ int shim_utimes(char* filename, struct timeval* utimes);
 int shim_mbind(void* start, unsigned long len, int mode, unsigned long* nmask,
                unsigned long maxnode, int flags);
 int shim_set_mempolicy(int mode, unsigned long* nmask, unsigned long maxnode);
-int shim_get_mempolicy(int* policy, unsigned long* nmask, unsigned long maxnode, unsigned long addr,
+int shim_get_mempolicy(int* policy, unsigned long* nmask, unsigned long maxnode, void* addr,
                        unsigned long flags);
 int shim_mq_open(const char* name, int oflag, mode_t mode, struct __kernel_mq_attr* attr);
 int shim_mq_unlink(const char* name);
@@ -786,7 +816,7 @@ int shim_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __sigse
 int shim_unshare(int unshare_flags);
 int shim_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
-int shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len, int flags);
+ssize_t shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len, int flags);
 int shim_tee(int fdin, int fdout, size_t len, unsigned int flags);
 int shim_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags);
 int shim_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs, int flags);
@@ -809,10 +839,10 @@ int shim_epoll_create1(int flags);
 int shim_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_pipe2(int* fildes, int flags);
 int shim_inotify_init1(int flags);
-int shim_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                unsigned long pos_h);
-int shim_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                 unsigned long pos_h);
+ssize_t shim_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                    unsigned long pos_l, unsigned long pos_h);
+ssize_t shim_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                     unsigned long pos_l, unsigned long pos_h);
 int shim_rt_tgsigqueueinfo(pid_t tgid, pid_t pid, int sig, siginfo_t* uinfo);
 int shim_perf_event_open(struct perf_event_attr* attr_uptr, pid_t pid, int cpu, int group_fd,
                          int flags);
@@ -821,6 +851,9 @@ ssize_t shim_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags,
 int shim_prlimit64(pid_t pid, int resource, const struct __kernel_rlimit64* new_rlim,
                    struct __kernel_rlimit64* old_rlim);
 ssize_t shim_sendmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags);
+int shim_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* cache);
+ssize_t shim_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                             unsigned int flags);
 
 /* libos call wrappers */
 int shim_msgpersist(int msqid, int cmd);
@@ -828,5 +861,6 @@ int shim_benchmark_rpc(pid_t pid, int times, const void* buf, size_t size);
 size_t shim_send_rpc(pid_t pid, const void* buf, size_t size);
 size_t shim_recv_rpc(pid_t* pid, void* buf, size_t size);
 int shim_checkpoint(const char* filename);
+int shim_snapshot(const char* filename);
 
 #endif /* _SHIM_TABLE_H_ */
@@ -45,6 +45,7 @@ struct shim_tcb {
     struct shim_thread *    tp;
     struct shim_context     context;
     unsigned int            tid;
+    unsigned int            tgid;   /* cached for the getpid() fast path in syscalldb */
     int                     pal_errno;
     struct debug_buf *      debug_buf;
 
@@ -17,6 +17,7 @@ struct shim_handle;
 struct shim_fd_map;
 struct shim_dentry;
 struct shim_signal_log;
+struct shim_vfork_state;
 
 #define WAKE_QUEUE_TAIL ((void*)1)
 /* If next is NULL, then this node is not on any queue.
@@ -47,10 +48,10 @@ struct shim_thread {
     struct shim_thread * parent;
     /* thread leader */
     struct shim_thread * leader;
-#ifndef ALIAS_VFORK_AS_FORK
     /* dummy thread: stores blocked parent thread for vfork */
     struct shim_thread * dummy;
-#endif
+    /* state of this thread while it is blocked in vfork */
+    struct shim_vfork_state * vfork_state;
     /* child handles; protected by thread->lock */
     LISTP_TYPE(shim_thread) children;
     /* nodes in child handles; protected by the parent's lock */
@@ -100,6 +101,10 @@ struct shim_thread {
     shim_tcb_t * shim_tcb;
     void * frameptr;
 
+    /* scratch space of poll() and select() for large FD sets, grown on demand */
+    void * poll_buf;
+    size_t poll_buf_size;
+
     REFTYPE ref_count;
     struct shim_lock lock;
 
@@ -179,7 +184,7 @@ __attribute__((always_inline))
 void set_cur_thread (struct shim_thread * thread)
 {
     shim_tcb_t * tcb = shim_get_tcb();
-    IDTYPE tid = 0;
+    IDTYPE tid = 0, tgid = 0;
 
     if (thread) {
         if (tcb->tp && tcb->tp != thread)
@@ -191,6 +196,7 @@ void set_cur_thread (struct shim_thread * thread)
         tcb->tp = thread;
         thread->shim_tcb = tcb;
         tid = thread->tid;
+        tgid = thread->tgid;
 
         if (!is_internal(thread) && !thread->signal_logs) {
             thread->signal_logs = signal_logs_alloc();
@@ -203,6 +209,7 @@ void set_cur_thread (struct shim_thread * thread)
         BUG();
     }
 
+    tcb->tgid = tgid;
     if (tcb->tid != tid) {
         tcb->tid = tid;
         if (tcb->debug_buf)
@@ -292,6 +299,7 @@ extern struct shim_lock thread_list_lock;
  * Increases refcount of the returned thread.
  */
 struct shim_thread* lookup_thread(IDTYPE tid);
+int get_thread_cpu_affinity(struct shim_thread* thread, unsigned long* bitmap, size_t size);
 struct shim_simple_thread * __lookup_simple_thread (IDTYPE tid);
 struct shim_simple_thread * lookup_simple_thread (IDTYPE tid);
 
@@ -311,9 +319,15 @@ void del_simple_thread (struct shim_simple_thread * thread);
 void cleanup_thread(IDTYPE caller, void* thread);
 int check_last_thread(struct shim_thread* self);
 
-#ifndef ALIAS_VFORK_AS_FORK
-void switch_dummy_thread (struct shim_thread * thread);
-#endif
+/* Returns the thread of process `tgid` in this instance which takes a signal `sig` sent to the
+ * whole process: the first one which does not block it, or the first one if they all do. Returns 0
+ * if the process has no thread here. */
+IDTYPE __get_signal_thread(IDTYPE tgid, int sig);
+IDTYPE get_signal_thread(IDTYPE tgid, int sig);
+
+noreturn void switch_dummy_thread (struct shim_thread * thread);
+void exit_vfork_child(struct shim_thread* cur_thread, int error_code, int term_signal);
+void fixup_child_context (struct shim_regs * regs);
 
 int walk_thread_list (int (*callback) (struct shim_thread *, void *, bool *),
                       void * arg);
@@ -334,10 +334,14 @@ struct __kernel_ustat
 /* bits/socket.h */
 enum
 {
-    MSG_OOB  = 0x01, /* Process out-of-band data. */
-    MSG_PEEK = 0x02, /* Peek at incoming messages. */
+    MSG_OOB        = 0x01,    /* Process out-of-band data. */
+    MSG_PEEK       = 0x02,    /* Peek at incoming messages. */
+    MSG_DONTWAIT   = 0x40,    /* Nonblocking IO. */
+    MSG_WAITFORONE = 0x10000, /* Wait for at least one packet to return. */
 #define MSG_OOB MSG_OOB
 #define MSG_PEEK MSG_PEEK
+#define MSG_DONTWAIT MSG_DONTWAIT
+#define MSG_WAITFORONE MSG_WAITFORONE
 };
 
 struct msghdr {
@@ -46,6 +46,11 @@ struct sigcp {
 
 #define SIGCP 33
 
+#define __NR_snapshot (LIBOS_SYSCALL_BASE + 6)
+
+/* Returns 1 after writing the snapshot, and 0 when the process is resumed from it. */
+int snapshot(const char* filename);
+
 #include "shim_unistd_defs.h"
 
 #endif /* _SHIM_UNISTD_H_ */
@@ -188,6 +188,12 @@ void md5_init(struct shim_md5_ctx* mdContext);
 void md5_update(struct shim_md5_ctx* mdContext, const void* buf, size_t len);
 void md5_final(struct shim_md5_ctx* mdContext);
 
+/* LZ4 block format */
+#define LZ4_MAX_INPUT 65536
+
+size_t lz4_compress(const void* src, size_t size, void* dst, size_t dst_size);
+int lz4_decompress(const void* src, size_t csize, void* dst, size_t size);
+
 /* prompt user for confirmation */
 int message_confirm(const char* message, const char* options);
 
@@ -199,6 +205,7 @@ int free_elf_interp(void);
 noreturn void execute_elf_object(struct shim_handle* exec, int* argcp, const char** argp,
                                  elf_auxv_t* auxp);
 int remove_loaded_libraries(void);
+int syscall_trampolines_migrate(void);
 
 /* gdb debugging support */
 void remove_r_debug(void* addr);
@@ -216,8 +223,14 @@ int create_handle(const char* prefix, char* path, size_t size, PAL_HANDLE* hdl,
 int init_async(void);
 int64_t install_async_event(PAL_HANDLE object, unsigned long time,
                             void (*callback)(IDTYPE caller, void* arg), void* arg);
+int install_async_timer(uint64_t time, void (*callback)(IDTYPE caller, void* arg), void* arg);
+void cancel_async_timer(void (*callback)(IDTYPE caller, void* arg), void* arg);
 struct shim_thread* terminate_async_helper(void);
 
+/* TSC-based clock source */
+int init_time(void);
+void update_tsc_clock(void);
+
 extern struct config_store* root_config;
 
 #endif /* _SHIM_UTILS_H */
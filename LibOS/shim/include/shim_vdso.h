@@ -27,5 +27,7 @@ extern const uint8_t vdso_so[];
 extern const size_t vdso_so_size;
 
 int vdso_map_migrate(void);
+int vdso_clock_gettime(clockid_t which_clock, struct timespec* tp);
+long vdso_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused);
 
 #endif /* _SHIM_VDSO_H_ */
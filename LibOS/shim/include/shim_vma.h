@@ -96,6 +96,13 @@ static inline PAL_FLG PAL_PROT(int prot, int flags) {
     return pal_prot;
 }
 
+/* size of a huge page on the host */
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+/* True if an anonymous mapping should be aligned at and backed by huge pages: either requested
+ * with MAP_HUGETLB, or large enough while "sys.thp_align" is enabled in the manifest */
+bool vma_huge_pages(size_t length, int flags);
+
 int init_vma(void);
 
 /* Bookkeeping mmap() system call */
@@ -142,6 +149,12 @@ void* bkeep_unmapped_heap(size_t length, int prot, int flags, struct shim_handle
  */
 int dump_all_vmas(struct shim_vma_val* vmas, size_t max_count);
 
+/* Record the pages of the anonymous VMAs written since the previous snapshot, before resetting the
+ * tracking for the next one (see do_snapshot_process()) */
+struct shim_written_pages;
+int capture_written_pages(struct shim_written_pages** listp);
+void free_written_pages(struct shim_written_pages* list);
+
 /* Debugging */
 void debug_print_vma_list(void);
 
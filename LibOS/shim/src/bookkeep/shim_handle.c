@@ -486,6 +486,9 @@ void put_handle(struct shim_handle* hdl) {
                 free(hdl->info.sock.peek_buffer);
                 hdl->info.sock.peek_buffer = NULL;
             }
+
+            if (hdl->type == TYPE_MSG)
+                detach_msg_shared(&hdl->info.msg);
         }
 
         delete_from_epoll_handles(hdl);
@@ -127,7 +127,10 @@ fetch_signal_log (struct shim_thread * thread, int sig)
     struct shim_signal * signal = NULL;
     int tail, head, old_tail;
 
-    /* FIXME: race condition between finding the slot and clearing the slot. */
+    /* The thread itself and the signalfd readers of other threads consume the
+     * log concurrently. A slot is claimed by swapping it with NULL, so only
+     * one of them gets each signal; the others see an empty slot until the
+     * owner moves the tail past it. */
     while (1) {
         old_tail = tail = atomic_read(&log->tail);
         head = atomic_read(&log->head);
@@ -135,16 +138,18 @@ fetch_signal_log (struct shim_thread * thread, int sig)
         if (tail == head)
             return NULL;
 
-        if (!(signal = log->logs[tail]))
+        if (!(signal = __atomic_exchange_n(&log->logs[tail], NULL,
+                                           __ATOMIC_ACQ_REL)))
             return NULL;
 
-        log->logs[tail] = NULL;
         tail = (tail == MAX_SIGNAL_LOG - 1) ? 0 : tail + 1;
 
         if (atomic_cmpxchg(&log->tail, old_tail, tail) == old_tail)
             break;
 
-        log->logs[old_tail] = signal;
+        /* the log wrapped around since the tail was read: the slot holds a
+         * newer signal, which is not ours to take */
+        __atomic_store_n(&log->logs[old_tail], signal, __ATOMIC_RELEASE);
     }
 
     debug("signal_logs[%d]: tail=%d, head=%d\n", sig -1, tail, head);
@@ -154,6 +159,24 @@ fetch_signal_log (struct shim_thread * thread, int sig)
     return signal;
 }
 
+/* Removes the first pending signal of `thread` which is a member of `mask` (for signalfd) and
+ * stores its number in `sig`; the caller frees the returned signal. `thread` may be another thread
+ * than the caller, see fetch_signal_log(). */
+struct shim_signal* fetch_pending_signal(struct shim_thread* thread, const __sigset_t* mask,
+                                         int* sig) {
+    if (!thread->signal_logs || !atomic_read(&thread->has_signal))
+        return NULL;
+
+    for (int i = 1; i < NUM_SIGS; i++) {
+        struct shim_signal* signal;
+        if (__sigismember(mask, i) && (signal = fetch_signal_log(thread, i))) {
+            *sig = i;
+            return signal;
+        }
+    }
+    return NULL;
+}
+
 static void
 __handle_one_signal (shim_tcb_t * tcb, int sig, struct shim_signal * signal);
 
@@ -815,7 +838,8 @@ void append_signal(struct shim_thread* thread, int sig, siginfo_t* info, bool ne
          * For standard, please refer to
          * https://pubs.opengroup.org/onlinepubs/9699919799/functions/_Exit.html
          */
-        if (!__sigismember(&thread->signal_mask, sig) || sig == SIGCHLD)
+        if (!__sigismember(&thread->signal_mask, sig) ||
+            (sig == SIGCHLD && !signalfd_watches(sig)))
             return;
 
         // If a signal is set to be ignored, append the signal but don't interrupt the thread
@@ -838,6 +862,7 @@ void append_signal(struct shim_thread* thread, int sig, siginfo_t* info, bool ne
 
     if (signal_log) {
         *signal_log = signal;
+        notify_signalfds(sig);
         if (need_interrupt) {
             debug("resuming thread %u\n", thread->tid);
             thread_wakeup(thread);
@@ -860,6 +885,9 @@ static void sighandler_kill (int sig, siginfo_t * info, void * ucontext)
     __UNUSED(ucontext);
     debug("killed by %s\n", signal_name(sig_without_coredump_bit));
 
+    /* a vfork child must not take its parent's process down with it */
+    exit_vfork_child(cur_thread, 0, sig);
+
     if (sig_without_coredump_bit == SIGABRT ||
         (!info->si_pid && /* signal is sent from host OS, not from another process */
          (sig_without_coredump_bit == SIGTERM || sig_without_coredump_bit == SIGINT))) {
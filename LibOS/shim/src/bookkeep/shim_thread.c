@@ -376,6 +376,7 @@ void put_thread (struct shim_thread * thread)
         }
 
         signal_logs_free(thread->signal_logs);
+        free(thread->poll_buf);
         free(thread);
     }
 }
@@ -527,6 +528,31 @@ int check_last_thread(struct shim_thread* self) {
     return alive_thread_tid;
 }
 
+IDTYPE __get_signal_thread(IDTYPE tgid, int sig) {
+    assert(locked(&thread_list_lock));
+
+    IDTYPE first_tid = 0;
+
+    struct shim_thread* thread;
+    LISTP_FOR_EACH_ENTRY(thread, &thread_list, list) {
+        if (!thread->tid || thread->tgid != tgid || !thread->in_vm || !thread->is_alive)
+            continue;
+        /* racy read of the mask, the thread may change it right after anyway */
+        if (!__sigismember(&thread->signal_mask, sig))
+            return thread->tid;
+        if (!first_tid)
+            first_tid = thread->tid;
+    }
+    return first_tid;
+}
+
+IDTYPE get_signal_thread(IDTYPE tgid, int sig) {
+    lock(&thread_list_lock);
+    IDTYPE tid = __get_signal_thread(tgid, sig);
+    unlock(&thread_list_lock);
+    return tid;
+}
+
 /* This function is called by Async Helper thread to wait on thread->clear_child_tid_pal to be
  * zeroed (PAL does it when thread finally exits). Since it is a callback to Async Helper thread,
  * this function must follow the `void (*callback) (IDTYPE caller, void* arg)` signature. */
@@ -642,41 +668,6 @@ out:
     return ret;
 }
 
-#ifndef ALIAS_VFORK_AS_FORK
-void switch_dummy_thread (struct shim_thread * thread)
-{
-    struct shim_thread * real_thread = thread->dummy;
-    IDTYPE child = thread->tid;
-
-    assert(thread->frameptr);
-    assert(real_thread->stack);
-    assert(real_thread->stack_top > real_thread->stack);
-
-    memcpy(thread->frameptr, real_thread->stack,
-           real_thread->stack_top - real_thread->stack);
-
-    real_thread->stack     = thread->stack;
-    real_thread->stack_top = thread->stack_top;
-    real_thread->frameptr  = thread->frameptr;
-
-    DkSegmentRegister(PAL_SEGMENT_FS, real_thread->tcb);
-    set_cur_thread(real_thread);
-    debug("set tcb to %p\n", real_thread->tcb);
-
-    debug("jump to the stack %p\n", real_thread->frameptr);
-    debug("shim_vfork success (returning %d)\n", child);
-
-    /* jump onto old stack
-       we actually pop rbp as rsp, and later we will call 'ret' */
-    __asm__ volatile("movq %0, %%rbp\r\n"
-                     "leaveq\r\n"
-                     "retq\r\n" :
-                     : "g"(real_thread->frameptr),
-                       "a"(child)
-                     : "memory");
-}
-#endif
-
 BEGIN_CP_FUNC(thread)
 {
     __UNUSED(size);
@@ -700,14 +691,15 @@ BEGIN_CP_FUNC(thread)
 
         new_thread->in_vm  = false;
         new_thread->parent = NULL;
-#ifndef ALIAS_VFORK_AS_FORK
         new_thread->dummy  = NULL;
-#endif
+        new_thread->vfork_state = NULL;
         new_thread->handle_map = NULL;
         new_thread->root   = NULL;
         new_thread->cwd    = NULL;
         new_thread->signal_logs = NULL;
         new_thread->robust_list = NULL;
+        new_thread->poll_buf    = NULL;
+        new_thread->poll_buf_size = 0;
         REF_SET(new_thread->ref_count, 0);
 
         for (int i = 0 ; i < NUM_SIGS ; i++)
@@ -111,6 +111,16 @@ DEFINE_LISTP(shim_vma);
 static LISTP_TYPE(shim_vma) vma_list = LISTP_INIT;
 static struct shim_lock vma_list_lock;
 
+/*
+ * Return true if a file mapping with this protection may diverge from
+ * the file, so its memory has to be checkpointed. Shared anonymous memory
+ * is mapped again by the child instead.
+ */
+static inline bool __vma_tainted (struct shim_handle * file, int prot)
+{
+    return file && (prot & PROT_WRITE) && file->type != TYPE_SHM;
+}
+
 /*
  * Return true if [s, e) is exactly the area represented by vma.
  */
@@ -514,7 +524,7 @@ static int __bkeep_mmap (struct shim_vma * prev,
     new->start  = start;
     new->end    = end;
     new->prot   = prot;
-    new->flags  = flags|((file && (prot & PROT_WRITE)) ? VMA_TAINTED : 0);
+    new->flags  = flags|(__vma_tainted(file, prot) ? VMA_TAINTED : 0);
     new->file   = file;
     if (new->file)
         get_handle(new->file);
@@ -763,7 +773,7 @@ static int __bkeep_mprotect (struct shim_vma * prev,
             /* If [start, end) contains the VMA, just update its protection. */
             if (start <= cur->start && cur->end <= end) {
                 cur->prot = prot;
-                if (cur->file && (prot & PROT_WRITE)) {
+                if (__vma_tainted(cur->file, prot)) {
                     cur->flags |= VMA_TAINTED;
                 }
             } else {
@@ -772,7 +782,7 @@ static int __bkeep_mprotect (struct shim_vma * prev,
                 new->start = cur->start > start ? cur->start : start;
                 new->end   = cur->end < end ? cur->end : end;
                 new->prot  = prot;
-                new->flags = cur->flags | ((cur->file && (prot & PROT_WRITE)) ? VMA_TAINTED : 0);
+                new->flags = cur->flags | (__vma_tainted(cur->file, prot) ? VMA_TAINTED : 0);
                 new->file  = cur->file;
                 if (new->file) {
                     get_handle(new->file);
@@ -833,11 +843,37 @@ int bkeep_mprotect (void * addr, size_t length, int prot, int flags)
     return ret;
 }
 
+static int thp_align = -1;
+
+bool vma_huge_pages(size_t length, int flags)
+{
+    if (flags & MAP_HUGETLB)
+        return true;
+
+    if (length < HUGE_PAGE_SIZE)
+        return false;
+
+    if (thp_align < 0) {
+        /* the manifest is not loaded yet while the LibOS bootstraps */
+        if (!root_config)
+            return false;
+
+        char cfg[2];
+        ssize_t len = get_config(root_config, "sys.thp_align", cfg, sizeof(cfg));
+        thp_align = (len == 1 && cfg[0] == '1');
+    }
+
+    return thp_align;
+}
+
 /*
  * Search for an unmapped area within [bottom, top) that is big enough
  * to allocate "length" bytes. The search approach is top-down.
  * If this function returns a non-NULL address, the corresponding VMA is
  * added to the VMA list.
+ *
+ * Anonymous areas that should be backed by huge pages are placed at a
+ * huge-page boundary, so that the host can map them with huge pages.
  */
 static void * __bkeep_unmapped (void * top_addr, void * bottom_addr,
                                 size_t length, int prot, int flags,
@@ -850,6 +886,8 @@ static void * __bkeep_unmapped (void * top_addr, void * bottom_addr,
     if (!length || length > (uintptr_t) top_addr - (uintptr_t) bottom_addr)
         return NULL;
 
+    size_t align = (!file && vma_huge_pages(length, flags)) ? HUGE_PAGE_SIZE : 0;
+
     struct shim_vma * prev = NULL;
     struct shim_vma * cur = __lookup_vma(top_addr, &prev);
 
@@ -863,15 +901,21 @@ static void * __bkeep_unmapped (void * top_addr, void * bottom_addr,
 
         /* Check if there is enough space between prev and cur */
         if (length <= (uintptr_t) end - (uintptr_t) start) {
-            /* create a new VMA at the top of the range */
-            __bkeep_mmap(prev, end - length, end, prot, flags,
-                         file, offset, comment);
-            assert_vma_list();
+            void * addr = end - length;
+            if (align)
+                addr = ALIGN_DOWN_PTR(addr, align);
+
+            if (addr >= start) {
+                /* create a new VMA at the top of the range */
+                __bkeep_mmap(prev, addr, addr + length, prot, flags,
+                             file, offset, comment);
+                assert_vma_list();
 
-            debug("bkeep_unmapped: %p-%p%s%s\n", end - length, end,
-                  comment ? " => " : "", comment ? : "");
+                debug("bkeep_unmapped: %p-%p%s%s\n", addr, addr + length,
+                      comment ? " => " : "", comment ? : "");
 
-            return end - length;
+                return addr;
+            }
         }
 
         if (!prev || prev->start <= bottom_addr)
@@ -1073,6 +1117,221 @@ int dump_all_vmas (struct shim_vma_val * vmas, size_t max_count)
     return cnt;
 }
 
+/* Dump all non-internal VMAs into an array allocated for them; returns the
+ * number of VMAs, to be freed with free_vma_val_array(). */
+static int __dump_all_vmas_alloc (struct shim_vma_val ** vmasp)
+{
+    size_t count = DEFAULT_VMA_COUNT;
+    struct shim_vma_val * vmas = malloc(sizeof(*vmas) * count);
+    int ret;
+
+    if (!vmas)
+        return -ENOMEM;
+
+    while (true) {
+        ret = dump_all_vmas(vmas, count);
+        if (ret != -EOVERFLOW)
+            break;
+
+        struct shim_vma_val * new_vmas
+            = malloc(sizeof(*new_vmas) * count * 2);
+        if (!new_vmas) {
+            free(vmas);
+            return -ENOMEM;
+        }
+        free(vmas);
+        vmas = new_vmas;
+        count *= 2;
+    }
+
+    if (ret < 0) {
+        free(vmas);
+        return ret;
+    }
+
+    *vmasp = vmas;
+    return ret;
+}
+
+/* The pages of an anonymous vma written since the previous snapshot, captured
+ * before the tracking is reset (see capture_written_pages()). */
+struct shim_written_pages {
+    struct shim_written_pages * next;
+    void * addr;
+    size_t size;
+    PAL_BOL written[];
+};
+
+void free_written_pages (struct shim_written_pages * list)
+{
+    while (list) {
+        struct shim_written_pages * next = list->next;
+        free(list);
+        list = next;
+    }
+}
+
+/*
+ * Record which pages of the anonymous vmas were written since the previous
+ * snapshot. The caller resets the tracking right after, before the vmas are
+ * checkpointed, so the pages written meanwhile go into the next snapshot
+ * instead of being dropped from both. A write between the last query and the
+ * reset would be lost, so the caller must be the only thread of the process.
+ */
+int capture_written_pages (struct shim_written_pages ** listp)
+{
+    struct shim_written_pages * list = NULL;
+    struct shim_written_pages ** tail = &list;
+    struct shim_vma_val * vmas;
+    int ret = __dump_all_vmas_alloc(&vmas);
+    if (ret < 0)
+        return ret;
+
+    size_t count = ret;
+    ret = 0;
+    for (size_t i = 0 ; i < count ; i++) {
+        struct shim_vma_val * vma = &vmas[i];
+        /* only the anonymous memory (and shared memory saved as such) is
+         * delta-encoded, see cp_vma */
+        if (!NEED_MIGRATE_MEMORY(vma) ||
+            (vma->file && vma->file->type != TYPE_SHM))
+            continue;
+
+        size_t npages = vma->length / ALLOC_ALIGNMENT;
+        struct shim_written_pages * pages =
+                malloc(sizeof(*pages) + npages * sizeof(PAL_BOL));
+        if (!pages) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        pages->next = NULL;
+        pages->addr = vma->addr;
+        pages->size = vma->length;
+        if (!DkVirtualMemoryQueryWritten(vma->addr, vma->length,
+                                         pages->written)) {
+            free(pages);
+            ret = -PAL_ERRNO;
+            break;
+        }
+
+        *tail = pages;
+        tail = &pages->next;
+    }
+
+    free_vma_val_array(vmas, count);
+
+    if (ret < 0) {
+        free_written_pages(list);
+        return ret;
+    }
+
+    *listp = list;
+    return 0;
+}
+
+/* The written pages captured for [addr, addr + size), or NULL if the range was
+ * not mapped then, and must be saved in full. */
+static const PAL_BOL * __lookup_written_pages (struct shim_written_pages * list,
+                                               void * addr, size_t size)
+{
+    for (; list ; list = list->next)
+        if (addr >= list->addr && addr + size <= list->addr + list->size)
+            return &list->written[(addr - list->addr) / ALLOC_ALIGNMENT];
+
+    return NULL;
+}
+
+/* A range of written pages of a private file mapping, or of anonymous memory
+ * in an incremental snapshot. The other pages are mapped again from the file,
+ * or filled from the previous snapshots, and these are copied over them. */
+struct shim_vma_dirty {
+    struct shim_vma_dirty * next;
+    void * addr;
+    size_t size;
+    void * data;
+};
+
+static int __cp_dirty_range (struct shim_cp_store * store, void * addr,
+                             size_t size, PAL_FLG pal_prot,
+                             struct shim_vma_dirty *** tail)
+{
+    ptr_t base = store->base;
+    struct shim_vma_dirty * dirty =
+            (void *) (base + ADD_CP_OFFSET(sizeof(struct shim_vma_dirty)));
+    struct shim_mem_entry * mem;
+
+    dirty->next = NULL;
+    dirty->addr = addr;
+    dirty->size = size;
+    dirty->data = NULL;
+    **tail = dirty;
+    *tail = &dirty->next;
+
+    DO_CP_SIZE(memory, addr, size, &mem);
+    mem->prot  = pal_prot;
+    mem->paddr = &dirty->data;
+    return 0;
+}
+
+/*
+ * Checkpoint only the pages in [addr, addr + size) reported as written: by
+ * @query (DkVirtualMemoryQueryDirty() for the pages of a private file mapping
+ * written since they were mapped), or in @written if not NULL (the pages
+ * written since the previous snapshot). Returns 1 if the host cannot tell
+ * these pages apart, and nothing is checkpointed.
+ */
+static int __cp_dirty_pages (struct shim_cp_store * store, void * addr,
+                             size_t size, PAL_FLG pal_prot,
+                             PAL_BOL (*query) (PAL_PTR, PAL_NUM, PAL_BOL *),
+                             const PAL_BOL * written,
+                             struct shim_vma_dirty ** dirty_list)
+{
+    struct shim_vma_dirty ** tail = dirty_list;
+    PAL_BOL buf[256];
+    const PAL_BOL * dirty = buf;
+    void * start = addr;
+    void * end = addr + size;
+    void * run = NULL;
+    int ret;
+
+    *dirty_list = NULL;
+
+    while (addr < end) {
+        size_t count = (end - addr) / ALLOC_ALIGNMENT;
+
+        if (written) {
+            dirty = written + (addr - start) / ALLOC_ALIGNMENT;
+        } else {
+            if (count > ARRAY_SIZE(buf))
+                count = ARRAY_SIZE(buf);
+
+            if (!query(addr, count * ALLOC_ALIGNMENT, buf)) {
+                if (addr == start)
+                    return 1;
+                return -PAL_ERRNO;
+            }
+        }
+
+        for (size_t i = 0 ; i < count ; i++, addr += ALLOC_ALIGNMENT) {
+            if (dirty[i] && !run) {
+                run = addr;
+            } else if (!dirty[i] && run) {
+                if ((ret = __cp_dirty_range(store, run, addr - run, pal_prot,
+                                            &tail)) < 0)
+                    return ret;
+                run = NULL;
+            }
+        }
+    }
+
+    if (run && (ret = __cp_dirty_range(store, run, end - run, pal_prot,
+                                       &tail)) < 0)
+        return ret;
+
+    return 0;
+}
+
 BEGIN_CP_FUNC(vma)
 {
     __UNUSED(size);
@@ -1091,15 +1350,22 @@ BEGIN_CP_FUNC(vma)
         new_vma = (struct shim_vma_val *) (base + off);
         memcpy(new_vma, vma, sizeof(*vma));
 
-        if (vma->file)
+        if (vma->file && vma->file->type == TYPE_SHM && store->copy_shared_memory) {
+            /* the shared memory object cannot be saved, so save its contents
+             * and restore them as private memory */
+            new_vma->file  = NULL;
+            new_vma->flags = (vma->flags & ~MAP_SHARED) | MAP_PRIVATE;
+        } else if (vma->file) {
             DO_CP(handle, vma->file, &new_vma->file);
+        }
 
         void * need_mapped = vma->addr;
+        struct shim_vma_dirty * dirty = NULL;
 
-        if (NEED_MIGRATE_MEMORY(vma)) {
+        if (NEED_MIGRATE_MEMORY(new_vma)) {
             void* send_addr  = vma->addr;
             size_t send_size = vma->length;
-            if (vma->file) {
+            if (new_vma->file) {
                 /*
                  * Chia-Che 8/13/2017:
                  * A fix for cloning a private VMA which maps a file to a process.
@@ -1122,6 +1388,33 @@ BEGIN_CP_FUNC(vma)
                                 file_len - vma->offset : 0;
                     send_size = ALLOC_ALIGN_UP(send_size);
                 }
+
+                /* the pages still backed by the file (e.g., text and rodata of
+                 * libraries) are mapped again, so only send the written ones */
+                if (send_size > 0 && (vma->flags & MAP_PRIVATE)) {
+                    int ret = __cp_dirty_pages(store, send_addr, send_size,
+                                               pal_prot,
+                                               &DkVirtualMemoryQueryDirty,
+                                               NULL, &dirty);
+                    if (ret < 0)
+                        return ret;
+                    if (!ret)
+                        send_size = 0;
+                }
+            } else if (store->incremental) {
+                /* the other pages are restored from the previous snapshots;
+                 * a vma mapped after the capture is saved in full */
+                const PAL_BOL * written =
+                        __lookup_written_pages(store->written, send_addr,
+                                               send_size);
+                if (written) {
+                    int ret = __cp_dirty_pages(store, send_addr, send_size,
+                                               pal_prot, NULL, written,
+                                               &dirty);
+                    if (ret < 0)
+                        return ret;
+                    send_size = 0;
+                }
             }
             if (send_size > 0) {
                 struct shim_mem_entry * mem;
@@ -1133,6 +1426,7 @@ BEGIN_CP_FUNC(vma)
         }
         ADD_CP_FUNC_ENTRY(off);
         ADD_CP_ENTRY(ADDR, need_mapped);
+        ADD_CP_ENTRY(ADDR, dirty);
     } else {
         new_vma = (struct shim_vma_val *) (base + off);
     }
@@ -1142,18 +1436,54 @@ BEGIN_CP_FUNC(vma)
 }
 END_CP_FUNC(vma)
 
+/*
+ * Copy the pages checkpointed by __cp_dirty_pages() over the restored vma. If
+ * @from_chain, the anonymous memory of the vma is first filled from the
+ * snapshots that the restored incremental snapshot was taken after.
+ */
+static int __restore_dirty_pages (struct shim_vma_val * vma,
+                                  struct shim_vma_dirty * dirty,
+                                  bool from_chain, long rebase)
+{
+    bool protect = !(vma->prot & PROT_WRITE) && (dirty || from_chain);
+
+    if (protect &&
+        !DkVirtualMemoryProtect(vma->addr, vma->length,
+                                PAL_PROT(vma->prot|PROT_WRITE, vma->flags)))
+        return -PAL_ERRNO;
+
+    if (from_chain)
+        restore_snapshot_chain(vma->addr, vma->length);
+
+    for (; dirty ; dirty = dirty->next) {
+        CP_REBASE(dirty->next);
+        CP_REBASE(dirty->data);
+        memcpy(dirty->addr, dirty->data, dirty->size);
+    }
+
+    if (protect &&
+        !DkVirtualMemoryProtect(vma->addr, vma->length,
+                                PAL_PROT(vma->prot, vma->flags)))
+        return -PAL_ERRNO;
+
+    return 0;
+}
+
 DEFINE_PROFILE_CATEGORY(inside_rs_vma, resume_func);
 DEFINE_PROFILE_INTERVAL(vma_add_bookkeep,   inside_rs_vma);
 DEFINE_PROFILE_INTERVAL(vma_map_file,       inside_rs_vma);
+DEFINE_PROFILE_INTERVAL(vma_copy_dirty,     inside_rs_vma);
 DEFINE_PROFILE_INTERVAL(vma_map_anonymous,  inside_rs_vma);
 
 BEGIN_RS_FUNC(vma)
 {
     struct shim_vma_val * vma = (void *) (base + GET_CP_FUNC_ENTRY());
     void * need_mapped = (void *) GET_CP_ENTRY(ADDR);
+    struct shim_vma_dirty * dirty = (void *) GET_CP_ENTRY(ADDR);
     BEGIN_PROFILE_INTERVAL();
 
     CP_REBASE(vma->file);
+    CP_REBASE(dirty);
 
     int ret = bkeep_mmap(vma->addr, vma->length, vma->prot, vma->flags,
                          vma->file, vma->offset, vma->comment);
@@ -1196,6 +1526,7 @@ BEGIN_RS_FUNC(vma)
             }
         }
 
+        bool from_chain = false;
         if (need_mapped < vma->addr + vma->length) {
             int pal_alloc_type = 0;
             int pal_prot = vma->prot;
@@ -1203,6 +1534,7 @@ BEGIN_RS_FUNC(vma)
                                      vma->addr + vma->length - need_mapped,
                                      pal_alloc_type, pal_prot)) {
                 need_mapped += vma->length;
+                from_chain = !vma->file;
                 SAVE_PROFILE_INTERVAL(vma_map_anonymous);
             }
         }
@@ -1210,6 +1542,17 @@ BEGIN_RS_FUNC(vma)
         if (need_mapped < vma->addr + vma->length)
             SYS_PRINTF("vma %p-%p cannot be allocated!\n", need_mapped,
                        vma->addr + vma->length);
+
+        if (dirty || from_chain) {
+            if ((ret = __restore_dirty_pages(vma, dirty, from_chain, rebase)) < 0)
+                return ret;
+            SAVE_PROFILE_INTERVAL(vma_copy_dirty);
+        }
+
+        /* the memory migrated from the parent was allocated without the
+         * huge-page hint, so apply it to the whole vma */
+        if (!vma->file && vma_huge_pages(vma->length, vma->flags))
+            DkVirtualMemoryAdvise(vma->addr, vma->length, PAL_ALLOC_HUGEPAGE);
     }
 
     if (vma->file)
@@ -1229,36 +1572,16 @@ END_RS_FUNC(vma)
 
 BEGIN_CP_FUNC(all_vmas)
 {
-    size_t count = DEFAULT_VMA_COUNT;
-    struct shim_vma_val * vmas = malloc(sizeof(*vmas) * count);
-    int ret;
+    struct shim_vma_val * vmas;
     __UNUSED(obj);
     __UNUSED(size);
     __UNUSED(objp);
 
-    if (!vmas)
-        return -ENOMEM;
-
-    while (true) {
-        ret = dump_all_vmas(vmas, count);
-        if (ret != -EOVERFLOW)
-            break;
-
-        struct shim_vma_val * new_vmas
-            = malloc(sizeof(*new_vmas) * count * 2);
-        if (!new_vmas) {
-            free(vmas);
-            return -ENOMEM;
-        }
-        free(vmas);
-        vmas = new_vmas;
-        count *= 2;
-    }
-
+    int ret = __dump_all_vmas_alloc(&vmas);
     if (ret < 0)
         return ret;
 
-    count = ret;
+    size_t count = ret;
     for (struct shim_vma_val * vma = &vmas[count - 1] ; vma >= vmas ; vma--)
         DO_CP(vma, vma, NULL);
 
@@ -135,6 +135,10 @@ struct link_map {
         struct textrel* next;
     } * textrels;
 
+    /* Trampolines for rewritten syscall instructions (see patch_syscall_sites()) */
+    ElfW(Addr) l_tramp_addr;
+    size_t l_tramp_size;
+
 #define MAX_LINKSYMS 32
     struct linksym {
         void* rel;
@@ -800,6 +804,9 @@ static int __free_elf_object(struct link_map* l) {
         ++c;
     }
 
+    if (l->l_tramp_addr)
+        shim_do_munmap((void*)l->l_tramp_addr, l->l_tramp_size);
+
     __remove_elf_object(l);
 
     return 0;
@@ -964,6 +971,189 @@ static void replace_link_map(struct link_map* new, struct link_map* old) {
         loaded_libraries = new;
 }
 
+/*
+ * Statically linked binaries (and any code not going through the patched glibc) issue raw
+ * "syscall" instructions. Linux PAL lets them escape to the host, Linux-SGX PAL emulates them
+ * through SIGILL (see illegal_upcall()). If "sys.patch_syscalls" is enabled, the loader looks
+ * for the common "mov $nr, %eax; syscall" sequence in the executable segments of the program
+ * and its interpreter, and replaces the 5-byte mov with a jump to a per-site trampoline:
+ *
+ *     mov $nr, %eax
+ *     lea site+7(%rip), %rcx
+ *     jmp *entry(%rip)
+ *
+ * where "entry" is a slot at the start of the trampoline area holding syscall_patch_entry.
+ * The original "syscall" instruction is left in place, so code that jumps directly onto it
+ * still takes the old path. The scan is byte-based, so it is only enabled on request.
+ */
+#define SYSCALL_SITE_SIZE    7  /* b8 imm32 0f 05 */
+#define SYSCALL_TRAMP_SIZE   18 /* b8 imm32 48 8d 0d rel32 ff 25 rel32 */
+#define SYSCALL_TRAMP_HDR    16
+#define SYSCALL_TRAMP_WINDOW (1UL << 30)
+
+extern void syscall_patch_entry(void);
+
+static int patch_syscalls = -1;
+
+static bool syscall_patching_enabled(void) {
+    if (patch_syscalls < 0) {
+        char cfg[2];
+        ssize_t len = root_config ? get_config(root_config, "sys.patch_syscalls", cfg,
+                                               sizeof(cfg)) : 0;
+        patch_syscalls = (len == 1 && cfg[0] == '1');
+    }
+    return patch_syscalls;
+}
+
+/* Instructions are not decoded, so this also matches the same bytes in data embedded in code or
+ * inside a longer instruction, and such bytes get overwritten. This is why patching is opt-in (see
+ * sys.patch_syscalls in Documentation/manifest-syntax.rst). */
+static bool is_syscall_site(const uint8_t* p) {
+    if (p[0] != 0xb8 || p[5] != 0x0f || p[6] != 0x05)
+        return false;
+
+    uint32_t sysnr;
+    memcpy(&sysnr, p + 1, sizeof(sysnr));
+    return sysnr < LIBOS_SYSCALL_BOUND && shim_table[sysnr];
+}
+
+static size_t scan_syscall_sites(struct link_map* l, uint8_t* tramp) {
+    size_t count = 0;
+
+    for (struct loadcmd* c = l->loadcmds; c < &l->loadcmds[l->nloadcmds]; c++) {
+        if (!(c->prot & PROT_EXEC) || c->dataend <= c->mapstart)
+            continue;
+
+        uint8_t* start = (uint8_t*)RELOCATE(l, c->mapstart);
+        uint8_t* end   = (uint8_t*)RELOCATE(l, c->dataend);
+
+        for (uint8_t* p = start; p + SYSCALL_SITE_SIZE <= end; p++) {
+            if (!is_syscall_site(p))
+                continue;
+
+            if (tramp) {
+                uint8_t* t = tramp + SYSCALL_TRAMP_HDR + count * SYSCALL_TRAMP_SIZE;
+                int32_t rel;
+
+                /* mov $nr, %eax */
+                memcpy(t, p, 5);
+                /* lea site+7(%rip), %rcx */
+                rel = (p + SYSCALL_SITE_SIZE) - (t + 12);
+                t[5] = 0x48;
+                t[6] = 0x8d;
+                t[7] = 0x0d;
+                memcpy(t + 8, &rel, sizeof(rel));
+                /* jmp *entry(%rip) */
+                rel = tramp - (t + 18);
+                t[12] = 0xff;
+                t[13] = 0x25;
+                memcpy(t + 14, &rel, sizeof(rel));
+
+                /* jmp trampoline */
+                rel = t - (p + 5);
+                p[0] = 0xe9;
+                memcpy(p + 1, &rel, sizeof(rel));
+            }
+
+            count++;
+            p += SYSCALL_SITE_SIZE - 1;
+        }
+    }
+
+    return count;
+}
+
+static int set_text_writable(struct link_map* l, bool writable) {
+    for (struct loadcmd* c = l->loadcmds; c < &l->loadcmds[l->nloadcmds]; c++) {
+        if (!(c->prot & PROT_EXEC) || c->mapend <= c->mapstart)
+            continue;
+
+        void* addr   = (void*)RELOCATE(l, c->mapstart);
+        size_t size  = c->mapend - c->mapstart;
+        int prot     = writable ? c->prot | PROT_WRITE : c->prot;
+
+        /* patched text differs from the file, so it has to be checkpointed (VMA_TAINTED) */
+        bkeep_mprotect(addr, size, prot, 0);
+        if (!DkVirtualMemoryProtect(addr, size, PAL_PROT(prot, 0)))
+            return -PAL_ERRNO;
+    }
+    return 0;
+}
+
+static int patch_syscall_sites(struct link_map* l) {
+    if (!syscall_patching_enabled() || l->l_tramp_addr)
+        return 0;
+
+    if (l->l_map_end - l->l_map_start >= SYSCALL_TRAMP_WINDOW)
+        return 0;
+
+    size_t count = scan_syscall_sites(l, NULL);
+    if (!count)
+        return 0;
+
+    /* trampolines have to be reachable from every site with a 32-bit displacement */
+    void* top    = PAL_CB(user_address.end);
+    void* bottom = PAL_CB(user_address.start);
+    if (l->l_map_start + SYSCALL_TRAMP_WINDOW < (ElfW(Addr))top)
+        top = (void*)(l->l_map_start + SYSCALL_TRAMP_WINDOW);
+    if (l->l_map_end > SYSCALL_TRAMP_WINDOW &&
+        l->l_map_end - SYSCALL_TRAMP_WINDOW > (ElfW(Addr))bottom)
+        bottom = (void*)(l->l_map_end - SYSCALL_TRAMP_WINDOW);
+    if (top <= bottom)
+        return 0;
+
+    size_t size = ALLOC_ALIGN_UP(SYSCALL_TRAMP_HDR + count * SYSCALL_TRAMP_SIZE);
+    void* tramp = bkeep_unmapped(top, bottom, size, PROT_READ | PROT_EXEC,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, 0, "syscalls");
+    if (!tramp) {
+        debug("no space for syscall trampolines of %s\n", l->l_name);
+        return 0;
+    }
+
+    if (!DkVirtualMemoryAlloc(tramp, size, 0, PAL_PROT_READ | PAL_PROT_WRITE)) {
+        bkeep_munmap(tramp, size, 0);
+        return -PAL_ERRNO;
+    }
+
+    *(void**)tramp = &syscall_patch_entry;
+
+    int ret = set_text_writable(l, true);
+    if (ret < 0)
+        return ret;
+
+    scan_syscall_sites(l, tramp);
+
+    if ((ret = set_text_writable(l, false)) < 0)
+        return ret;
+
+    if (!DkVirtualMemoryProtect(tramp, size, PAL_PROT_READ | PAL_PROT_EXEC))
+        return -PAL_ERRNO;
+
+    l->l_tramp_addr = (ElfW(Addr))tramp;
+    l->l_tramp_size = size;
+
+    debug("patched %lu syscall sites in %s\n", count, l->l_name);
+    return 0;
+}
+
+/* libsysdb.so may be loaded at a different address after migration */
+int syscall_trampolines_migrate(void) {
+    for (struct link_map* l = loaded_libraries; l; l = l->l_next) {
+        if (!l->l_tramp_addr)
+            continue;
+
+        void* tramp = (void*)l->l_tramp_addr;
+        if (!DkVirtualMemoryProtect(tramp, l->l_tramp_size, PAL_PROT_READ | PAL_PROT_WRITE))
+            return -PAL_ERRNO;
+
+        *(void**)tramp = &syscall_patch_entry;
+
+        if (!DkVirtualMemoryProtect(tramp, l->l_tramp_size, PAL_PROT_READ | PAL_PROT_EXEC))
+            return -PAL_ERRNO;
+    }
+    return 0;
+}
+
 static int do_relocate_object(struct link_map* l);
 
 static int __load_elf_object(struct shim_handle* file, void* addr, int type,
@@ -987,6 +1177,11 @@ static int __load_elf_object(struct shim_handle* file, void* addr, int type,
     if (type != OBJECT_INTERNAL && type != OBJECT_VDSO)
         do_relocate_object(map);
 
+    if (type == OBJECT_LOAD || type == OBJECT_MAPPED) {
+        if ((ret = patch_syscall_sites(map)) < 0)
+            goto out;
+    }
+
     if (internal_map) {
         map->l_resolved     = true;
         map->l_resolved_map = internal_map->l_addr;
@@ -1399,7 +1594,7 @@ static const struct {
     ElfW(Addr)** func;
 } vsyms[] = {{
                  .name  = "__vdso_shim_clock_gettime",
-                 .value = (ElfW(Addr))&__shim_clock_gettime,
+                 .value = (ElfW(Addr))&vdso_clock_gettime,
                  .func  = &__vdso_shim_clock_gettime,
              },
              {
@@ -1414,7 +1609,7 @@ static const struct {
              },
              {
                  .name  = "__vdso_shim_getcpu",
-                 .value = (ElfW(Addr))&__shim_getcpu,
+                 .value = (ElfW(Addr))&vdso_getcpu,
                  .func  = &__vdso_shim_getcpu,
              }};
 
@@ -720,6 +720,78 @@ out:
     return ret;
 }
 
+static ssize_t chroot_pread (struct shim_handle * hdl, void * buf, size_t count, off_t pos)
+{
+    ssize_t ret;
+
+    if (count == 0)
+        return 0;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_READ))
+        return -EBADF;
+
+    if (hdl->info.file.type == FILE_TTY)
+        return -ESPIPE;
+
+    off_t dummy_off_t;
+    if (__builtin_add_overflow(pos, count, &dummy_off_t))
+        return -EFBIG;
+
+    PAL_NUM pal_ret = DkStreamRead(hdl->pal_handle, pos, count, buf, NULL, 0);
+    if (pal_ret == PAL_STREAM_ERROR)
+        return PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+
+    if (__builtin_add_overflow(pal_ret, 0, &ret))
+        BUG();
+    return ret;
+}
+
+static ssize_t chroot_pwrite (struct shim_handle * hdl, const void * buf, size_t count, off_t pos)
+{
+    ssize_t ret;
+
+    if (count == 0)
+        return 0;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_WRITE))
+        return -EBADF;
+
+    struct shim_file_handle * file = &hdl->info.file;
+
+    if (file->type == FILE_TTY)
+        return -ESPIPE;
+
+    off_t end;
+    if (__builtin_add_overflow(pos, count, &end))
+        return -EFBIG;
+
+    PAL_NUM pal_ret = DkStreamWrite(hdl->pal_handle, pos, count, (void *) buf, NULL);
+    if (pal_ret == PAL_STREAM_ERROR)
+        return PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+
+    if (__builtin_add_overflow(pal_ret, 0, &ret))
+        BUG();
+
+    /* only writes which extend the file need the handle lock, to update the cached size */
+    end = pos + ret;
+    if (end > file->size) {
+        lock(&hdl->lock);
+        if (end > file->size) {
+            file->size = end;
+            chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+        }
+        unlock(&hdl->lock);
+    }
+
+    return ret;
+}
+
 static int chroot_mmap (struct shim_handle * hdl, void ** addr, size_t size,
                         int prot, int flags, off_t offset)
 {
@@ -1154,6 +1226,8 @@ struct shim_fs_ops chroot_fs_ops = {
         .close       = &chroot_close,
         .read        = &chroot_read,
         .write       = &chroot_write,
+        .pread       = &chroot_pread,
+        .pwrite      = &chroot_pwrite,
         .mmap        = &chroot_mmap,
         .seek        = &chroot_seek,
         .hstat       = &chroot_hstat,
@@ -40,6 +40,10 @@
 #include <shim_thread.h>
 
 static ssize_t pipe_read(struct shim_handle* hdl, void* buf, size_t count) {
+    ssize_t ret;
+    if (ring_pipe_read(hdl, buf, count, &ret))
+        return ret;
+
     PAL_NUM bytes = DkStreamRead(hdl->pal_handle, 0, count, buf, NULL, 0);
 
     if (bytes == PAL_STREAM_ERROR)
@@ -49,6 +53,10 @@ static ssize_t pipe_read(struct shim_handle* hdl, void* buf, size_t count) {
 }
 
 static ssize_t pipe_write(struct shim_handle* hdl, const void* buf, size_t count) {
+    ssize_t ret;
+    if (ring_pipe_write(hdl, buf, count, &ret))
+        return ret;
+
     PAL_NUM bytes = DkStreamWrite(hdl->pal_handle, 0, count, (void*)buf, NULL);
 
     if (bytes == PAL_STREAM_ERROR)
@@ -87,12 +95,21 @@ static int pipe_hstat(struct shim_handle* hdl, struct stat* stat) {
 
 static int pipe_checkout(struct shim_handle* hdl) {
     hdl->fs = NULL;
+    ring_pipe_checkout(hdl);
+    return 0;
+}
+
+static int pipe_close(struct shim_handle* hdl) {
+    ring_pipe_close(hdl);
     return 0;
 }
 
 static off_t pipe_poll(struct shim_handle* hdl, int poll_type) {
     off_t ret = 0;
 
+    if (ring_pipe_poll(hdl, poll_type, &ret))
+        return ret;
+
     lock(&hdl->lock);
 
     if (!hdl->pal_handle) {
@@ -156,6 +173,7 @@ struct shim_fs_ops pipe_fs_ops = {
     .write    = &pipe_write,
     .hstat    = &pipe_hstat,
     .checkout = &pipe_checkout,
+    .close    = &pipe_close,
     .poll     = &pipe_poll,
     .setflags = &pipe_setflags,
 };
@@ -132,6 +132,33 @@ retry:
     return ret;
 }
 
+/* Number of CPUs (hyperthreads) in the package of `cpu` */
+static size_t package_cpus(size_t cpu) {
+    size_t count = 0;
+    for (size_t i = 0; i < pal_control.cpu_info.cpu_num; i++)
+        if (get_cpu_package(i) == get_cpu_package(cpu))
+            count++;
+    return count;
+}
+
+/* Number of distinct cores in the package of `cpu` */
+static size_t package_cores(size_t cpu) {
+    size_t count = 0;
+    for (size_t i = 0; i < pal_control.cpu_info.cpu_num; i++) {
+        if (get_cpu_package(i) != get_cpu_package(cpu))
+            continue;
+
+        /* count each core at its first CPU only */
+        size_t j;
+        for (j = 0; j < i; j++)
+            if (get_cpu_package(j) == get_cpu_package(i) && get_cpu_core(j) == get_cpu_core(i))
+                break;
+        if (j == i)
+            count++;
+    }
+    return count;
+}
+
 static int proc_cpuinfo_open(struct shim_handle* hdl, const char* name, int flags) {
     // This function only serves one file
     __UNUSED(name);
@@ -164,8 +191,10 @@ static int proc_cpuinfo_open(struct shim_handle* hdl, const char* name, int flag
         ADD_INFO("model\t\t: %lu\n", pal_control.cpu_info.cpu_model);
         ADD_INFO("model name\t: %s\n", pal_control.cpu_info.cpu_brand);
         ADD_INFO("stepping\t: %lu\n", pal_control.cpu_info.cpu_stepping);
-        ADD_INFO("core id\t\t: %lu\n", n);
-        ADD_INFO("cpu cores\t: %lu\n", pal_control.cpu_info.cpu_num);
+        ADD_INFO("physical id\t: %lu\n", get_cpu_package(n));
+        ADD_INFO("siblings\t: %lu\n", package_cpus(n));
+        ADD_INFO("core id\t\t: %lu\n", get_cpu_core(n));
+        ADD_INFO("cpu cores\t: %lu\n", package_cores(n));
         double bogomips = pal_control.cpu_info.cpu_bogomips;
         // Apparently graphene snprintf cannot into floats.
         ADD_INFO("bogomips\t: %lu.%02lu\n",
@@ -623,6 +623,115 @@ static const struct pseudo_fs_ops fs_thread_maps = {
     .stat = &proc_thread_maps_stat,
 };
 
+/* Prints a set of CPUs or NUMA nodes as both a mask and a list, the way status reports the
+ * allowed ones */
+static int print_allowed(char* buf, size_t size, const char* key, const unsigned long* bitmap,
+                         size_t count) {
+    int len = 0;
+    int ret = snprintf(buf, size, "%s:\t", key);
+    if (ret < 0 || (size_t)ret >= size)
+        return -ENOMEM;
+    len += ret;
+
+    if ((ret = pseudo_print_mask(buf + len, size - len, bitmap, count)) < 0)
+        return ret;
+    len += ret;
+
+    ret = snprintf(buf + len, size - len, "\n%s_list:\t", key);
+    if (ret < 0 || (size_t)ret >= size - len)
+        return -ENOMEM;
+    len += ret;
+
+    if ((ret = pseudo_print_list(buf + len, size - len, bitmap, count)) < 0)
+        return ret;
+    len += ret;
+
+    if ((size_t)len + 1 >= size)
+        return -ENOMEM;
+    buf[len++] = '\n';
+    buf[len]   = '\0';
+    return len;
+}
+
+static int proc_thread_status_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    IDTYPE pid;
+    int ret = parse_thread_name(name, &pid, NULL, NULL, NULL);
+    if (ret < 0)
+        return ret;
+
+    struct shim_thread* thread = lookup_thread(pid);
+    if (!thread)
+        return -ENOENT;
+
+    size_t cpus  = PAL_CB(cpu_info.cpu_num);
+    size_t nodes = get_numa_node_count();
+    size_t words = (MAX(cpus, nodes) + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long));
+    size_t size  = 128 + (cpus / 32 * 9 + 12 * cpus + 64) + (nodes / 32 * 9 + 12 * nodes + 64);
+
+    char* str = malloc(size);
+    unsigned long* bitmap = malloc(words * sizeof(unsigned long));
+    if (!str || !bitmap) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    lock(&thread->lock);
+    int len = snprintf(str, size, "Tgid:\t%u\nPid:\t%u\nPPid:\t%u\n", thread->tgid,
+                       thread->tid, thread->ppid);
+    unlock(&thread->lock);
+
+    if ((ret = get_thread_cpu_affinity(thread, bitmap, words * sizeof(unsigned long))) < 0)
+        goto err;
+    if ((ret = print_allowed(str + len, size - len, "Cpus_allowed", bitmap, cpus)) < 0)
+        goto err;
+    len += ret;
+
+    /* memory may come from all nodes: policies restrict it per thread or mapping only */
+    memset(bitmap, 0, words * sizeof(unsigned long));
+    for (size_t i = 0; i < nodes; i++)
+        bitmap[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+    if ((ret = print_allowed(str + len, size - len, "Mems_allowed", bitmap, nodes)) < 0)
+        goto err;
+    len += ret;
+
+    free(bitmap);
+    put_thread(thread);
+    return pseudo_str_open(hdl, flags, str, len);
+
+err:
+    free(bitmap);
+    free(str);
+    put_thread(thread);
+    return ret;
+}
+
+static int proc_thread_status_mode(const char* name, mode_t* mode) {
+    // Only used by one file
+    __UNUSED(name);
+    *mode = FILE_R_MODE;
+    return 0;
+}
+
+static int proc_thread_status_stat(const char* name, struct stat* buf) {
+    // Only used by one file
+    __UNUSED(name);
+    memset(buf, 0, sizeof(struct stat));
+
+    buf->st_dev = buf->st_ino = 1;
+    buf->st_mode              = FILE_R_MODE | S_IFREG;
+
+    return 0;
+}
+
+static const struct pseudo_fs_ops fs_thread_status = {
+    .open = &proc_thread_status_open,
+    .mode = &proc_thread_status_mode,
+    .stat = &proc_thread_status_stat,
+};
+
 static int proc_thread_dir_open(struct shim_handle* hdl, const char* name, int flags) {
     __UNUSED(hdl);
     __UNUSED(name);
@@ -751,7 +860,7 @@ const struct pseudo_fs_ops fs_thread = {
 };
 
 const struct pseudo_dir dir_thread = {
-    .size = 5,
+    .size = 6,
     .ent  = {
               { .name   = "cwd",
                 .fs_ops = &fs_thread_link,
@@ -768,5 +877,8 @@ const struct pseudo_dir dir_thread = {
               { .name   = "maps",
                 .fs_ops = &fs_thread_maps,
                 .type   = LINUX_DT_REG },
+              { .name   = "status",
+                .fs_ops = &fs_thread_status,
+                .type   = LINUX_DT_REG },
         }
 };
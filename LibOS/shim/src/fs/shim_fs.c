@@ -37,7 +37,7 @@ struct shim_fs {
     struct shim_d_ops* d_ops;
 };
 
-#define NUM_MOUNTABLE_FS 3
+#define NUM_MOUNTABLE_FS 4
 
 struct shim_fs mountable_fs[NUM_MOUNTABLE_FS] = {
     {
@@ -55,9 +55,14 @@ struct shim_fs mountable_fs[NUM_MOUNTABLE_FS] = {
         .fs_ops = &dev_fs_ops,
         .d_ops  = &dev_d_ops,
     },
+    {
+        .name   = "sys",
+        .fs_ops = &sys_fs_ops,
+        .d_ops  = &sys_d_ops,
+    },
 };
 
-#define NUM_BUILTIN_FS 5
+#define NUM_BUILTIN_FS 8
 
 struct shim_mount* builtin_fs[NUM_BUILTIN_FS] = {
     &chroot_builtin_fs,
@@ -65,6 +70,9 @@ struct shim_mount* builtin_fs[NUM_BUILTIN_FS] = {
     &socket_builtin_fs,
     &epoll_builtin_fs,
     &eventfd_builtin_fs,
+    &shm_builtin_fs,
+    &timerfd_builtin_fs,
+    &signalfd_builtin_fs,
 };
 
 static struct shim_lock mount_mgr_lock;
@@ -134,6 +142,19 @@ static int __mount_sys(struct shim_dentry* root) {
         return ret;
     }
 
+    /* the emulated /sys only has the CPU and memory topology, so it would hide the rest of the
+     * host /sys (e.g. with the host root filesystem); mount it only if asked to */
+    char cfg[2];
+    if (root_config && get_config(root_config, "fs.emulate_sys", cfg, sizeof(cfg)) == 1 &&
+            cfg[0] == '1') {
+        debug("mounting as sys filesystem: /sys\n");
+
+        if ((ret = mount_fs("sys", NULL, "/sys", root, NULL, 0)) < 0) {
+            debug("mounting sys filesystem failed (%d)\n", ret);
+            return ret;
+        }
+    }
+
     debug("mounting as dev filesystem: /dev\n");
 
     struct shim_dentry* dev_dent = NULL;
@@ -347,3 +347,105 @@ int pseudo_follow_link(struct shim_dentry* dent, struct shim_qstr* link,
 
     return ent->fs_ops->follow_link(rel_path, link);
 }
+
+/*! Generic helper to back an opened pseudo-file by the string \p str (taking its ownership). */
+int pseudo_str_open(struct shim_handle* hdl, int flags, char* str, size_t len) {
+    struct shim_str_data* data = calloc(1, sizeof(struct shim_str_data));
+    if (!data) {
+        free(str);
+        return -ENOMEM;
+    }
+
+    data->str          = str;
+    data->len          = len;
+    hdl->type          = TYPE_STR;
+    hdl->flags         = flags & ~O_RDONLY;
+    hdl->acc_mode      = MAY_READ;
+    hdl->info.str.data = data;
+    return 0;
+}
+
+#define BITMAP_WORD_BITS        (8 * sizeof(unsigned long))
+#define BITMAP_TEST(bitmap, i)  ((bitmap)[(i) / BITMAP_WORD_BITS] & \
+                                 (1UL << ((i) % BITMAP_WORD_BITS)))
+
+/*!
+ * \brief Print a set of CPUs or NUMA nodes in the list format of Linux, e.g. "0-3,8".
+ *
+ * \param[out] buf     Buffer to print to, a size of `12 * count + 1` is always enough.
+ * \param[in]  size    Size of \p buf.
+ * \param[in]  bitmap  Set to print.
+ * \param[in]  count   Number of bits in \p bitmap.
+ * \return             Length of the printed string, -ENOMEM if \p buf is too small.
+ */
+int pseudo_print_list(char* buf, size_t size, const unsigned long* bitmap, size_t count) {
+    size_t len = 0;
+
+    if (!size)
+        return -ENOMEM;
+    buf[0] = '\0';
+
+    for (size_t i = 0; i < count; i++) {
+        if (!BITMAP_TEST(bitmap, i))
+            continue;
+
+        size_t last = i;
+        while (last + 1 < count && BITMAP_TEST(bitmap, last + 1))
+            last++;
+
+        int ret = (last == i) ? snprintf(buf + len, size - len, "%s%lu", len ? "," : "", i)
+                              : snprintf(buf + len, size - len, "%s%lu-%lu", len ? "," : "", i,
+                                         last);
+        if (ret < 0 || (size_t)ret >= size - len)
+            return -ENOMEM;
+
+        len += ret;
+        i = last;
+    }
+    return len;
+}
+
+/*!
+ * \brief Print a set of CPUs or NUMA nodes in the mask format of Linux, e.g. "00000000,0000010f".
+ *
+ * \param[out] buf     Buffer to print to, a size of `count / 32 * 9 + 10` is always enough.
+ * \param[in]  size    Size of \p buf.
+ * \param[in]  bitmap  Set to print.
+ * \param[in]  count   Number of bits in \p bitmap.
+ * \return             Length of the printed string, -ENOMEM if \p buf is too small.
+ */
+int pseudo_print_mask(char* buf, size_t size, const unsigned long* bitmap, size_t count) {
+    size_t len    = 0;
+    size_t groups = count ? (count + 31) / 32 : 1;
+
+    for (size_t i = groups; i-- > 0;) {
+        unsigned int group = count ? bitmap[i * 32 / BITMAP_WORD_BITS] >>
+                                     (i * 32 % BITMAP_WORD_BITS) : 0;
+
+        int ret = snprintf(buf + len, size - len, "%08x%s", group, i ? "," : "");
+        if (ret < 0 || (size_t)ret >= size - len)
+            return -ENOMEM;
+
+        len += ret;
+    }
+    return len;
+}
+
+/*! Generic helper to open a pseudo-file holding a set of CPUs or NUMA nodes (see above). */
+int pseudo_bitmap_open(struct shim_handle* hdl, int flags, const unsigned long* bitmap,
+                       size_t count, bool mask) {
+    size_t size = mask ? count / 32 * 9 + 11 : 12 * count + 2;
+    char* str = malloc(size);
+    if (!str)
+        return -ENOMEM;
+
+    int len = mask ? pseudo_print_mask(str, size - 1, bitmap, count)
+                   : pseudo_print_list(str, size - 1, bitmap, count);
+    if (len < 0) {
+        free(str);
+        return len;
+    }
+
+    str[len++] = '\n';
+    return pseudo_str_open(hdl, flags, str, len);
+}
@@ -0,0 +1,437 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_fs_ring.c
+ *
+ * In-process data path of pipes and socketpairs. As long as both ends of a pipe or socketpair
+ * live in the process which created them, read() and write() move the data through ring buffers
+ * in LibOS memory and wake up blocked threads with thread_wakeup(), without calling into the host.
+ *
+ * The host stream is still created with the pipe, so that the ring can be abandoned at any time:
+ * checkpointing either end (fork, execve), waiting on it with poll/select/epoll, copying through it
+ * with sendfile/splice, or using a socket call other than read/write migrates the pair to the
+ * host. Migration writes the unread data into the host stream, after which both ends use it for
+ * good. The host stream is written without the ring lock, waiting for it to drain if needed;
+ * meanwhile, the other threads wait for the flush to finish before using either the ring or the
+ * host stream, so that no data is lost or reordered.
+ */
+
+#include <atomic.h>
+#include <errno.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_thread.h>
+
+#define RING_PIPE_SIZE   65536 /* default capacity of Linux pipes */
+#define RING_PIPE_ATOMIC 4096  /* PIPE_BUF: writes up to this size are never split */
+#define RING_PIPE_SPINS  2000  /* checks of the ring before the thread goes to sleep */
+
+DEFINE_LIST(ring_waiter);
+struct ring_waiter {
+    struct shim_thread* thread;
+    LIST_TYPE(ring_waiter) list;
+};
+DEFINE_LISTP(ring_waiter);
+
+struct ring_buf {
+    char* data; /* allocated on first write */
+    size_t start;
+    size_t len;
+};
+
+struct shim_ring_pipe {
+    REFTYPE ref_count; /* one per open end */
+    struct shim_lock lock;
+    bool on_host;      /* migrated to the host stream, for good */
+    bool flushing;     /* the unread data is being written to the host stream */
+    uint64_t seq;      /* bumped on every change, threads spin on it before sleeping */
+    struct shim_handle* ends[2];    /* NULL once closed */
+    struct ring_buf bufs[2];        /* bufs[i] holds the data to be read by ends[i] */
+    LISTP_TYPE(ring_waiter) waiters;
+};
+
+int ring_pipe_create(struct shim_handle* hdl1, struct shim_handle* hdl2) {
+    struct shim_ring_pipe* ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return -ENOMEM;
+
+    if (!create_lock(&ring->lock)) {
+        free(ring);
+        return -ENOMEM;
+    }
+
+    REF_SET(ring->ref_count, 2);
+    INIT_LISTP(&ring->waiters);
+    ring->ends[0] = hdl1;
+    ring->ends[1] = hdl2;
+
+    hdl1->ring = ring;
+    hdl2->ring = ring;
+    return 0;
+}
+
+static int ring_end(struct shim_ring_pipe* ring, struct shim_handle* hdl) {
+    assert(ring->ends[0] == hdl || ring->ends[1] == hdl);
+    return ring->ends[1] == hdl;
+}
+
+/* should be called with ring->lock held */
+static void ring_changed(struct shim_ring_pipe* ring) {
+    assert(locked(&ring->lock));
+
+    __atomic_store_n(&ring->seq, ring->seq + 1, __ATOMIC_RELEASE);
+
+    struct ring_waiter* waiter;
+    struct ring_waiter* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(waiter, tmp, &ring->waiters, list) {
+        LISTP_DEL_INIT(waiter, &ring->waiters, list);
+        thread_wakeup(waiter->thread);
+    }
+}
+
+/* Waits until the ring changes: spins for a while, then sleeps. Should be called with ring->lock
+ * held, which is released meanwhile. Returns -EINTR if interrupted, -EINVAL if the calling thread
+ * cannot sleep (internal threads). */
+static int wait_ring_pipe(struct shim_ring_pipe* ring) {
+    assert(locked(&ring->lock));
+
+    struct shim_thread* cur = get_cur_thread();
+    if (!cur || !cur->scheduler_event)
+        return -EINVAL;
+
+    uint64_t seq = ring->seq;
+    unlock(&ring->lock);
+    for (int i = 0; i < RING_PIPE_SPINS; i++) {
+        if (__atomic_load_n(&ring->seq, __ATOMIC_ACQUIRE) != seq)
+            break;
+        CPU_RELAX();
+    }
+    lock(&ring->lock);
+    if (ring->seq != seq)
+        return 0;
+
+    struct ring_waiter waiter;
+    thread_setwait(&waiter.thread, NULL);
+    INIT_LIST_HEAD(&waiter, list);
+    LISTP_ADD_TAIL(&waiter, &ring->waiters, list);
+    unlock(&ring->lock);
+
+    int ret = thread_sleep(NO_TIMEOUT);
+
+    lock(&ring->lock);
+    if (!LIST_EMPTY(&waiter, list))
+        LISTP_DEL_INIT(&waiter, &ring->waiters, list);
+    put_thread(waiter.thread);
+    return ret < 0 ? -EINTR : 0;
+}
+
+/* Waits until the ring changes, also in threads which cannot sleep. Should be called with
+ * ring->lock held, which is released meanwhile. */
+static void wait_ring_flush(struct shim_ring_pipe* ring) {
+    if (wait_ring_pipe(ring) == -EINVAL) {
+        unlock(&ring->lock);
+        DkThreadYieldExecution();
+        lock(&ring->lock);
+    }
+}
+
+/* Writes all of `buf` into the host stream `pal_handle`, waiting for it to drain if it is
+ * nonblocking. Returns false if the stream fails, e.g., its reader is gone. */
+static bool ring_flush_to_host(PAL_HANDLE pal_handle, const char* buf, size_t count) {
+    while (count) {
+        PAL_NUM bytes = DkStreamWrite(pal_handle, 0, count, (void*)buf, NULL);
+        if (bytes == PAL_STREAM_ERROR) {
+            if (PAL_NATIVE_ERRNO == PAL_ERROR_INTERRUPTED)
+                continue;
+            if (PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN)
+                return false;
+
+            PAL_FLG events     = PAL_WAIT_WRITE;
+            PAL_FLG ret_events = 0;
+            if (!DkStreamsWaitEvents(1, &pal_handle, &events, &ret_events, NO_TIMEOUT) &&
+                PAL_NATIVE_ERRNO != PAL_ERROR_INTERRUPTED && PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN)
+                return false;
+            continue;
+        }
+        buf   += bytes;
+        count -= bytes;
+    }
+    return true;
+}
+
+static size_t ring_buf_read(struct ring_buf* rb, void* buf, size_t count) {
+    size_t n     = count < rb->len ? count : rb->len;
+    size_t first = RING_PIPE_SIZE - rb->start < n ? RING_PIPE_SIZE - rb->start : n;
+
+    memcpy(buf, rb->data + rb->start, first);
+    memcpy(buf + first, rb->data, n - first);
+    rb->start = (rb->start + n) % RING_PIPE_SIZE;
+    rb->len  -= n;
+    return n;
+}
+
+static size_t ring_buf_write(struct ring_buf* rb, const void* buf, size_t count) {
+    size_t space = RING_PIPE_SIZE - rb->len;
+    size_t n     = count < space ? count : space;
+    size_t tail  = (rb->start + rb->len) % RING_PIPE_SIZE;
+    size_t first = RING_PIPE_SIZE - tail < n ? RING_PIPE_SIZE - tail : n;
+
+    memcpy(rb->data + tail, buf, first);
+    memcpy(rb->data, buf + first, n - first);
+    rb->len += n;
+    return n;
+}
+
+/* Should be called with ring->lock held, which is released while the unread data is written to
+ * the host stream. Once this returns, the data is in the host stream. */
+static void __ring_pipe_migrate(struct shim_ring_pipe* ring) {
+    assert(locked(&ring->lock));
+
+    while (ring->flushing)
+        wait_ring_flush(ring);
+
+    if (ring->on_host)
+        return;
+
+    ring->flushing = true;
+
+    for (int i = 0; i < 2; i++) {
+        struct ring_buf* rb        = &ring->bufs[i];
+        struct shim_handle* reader = ring->ends[i];
+        struct shim_handle* writer = ring->ends[!i];
+
+        /* ring_pipe_close() migrates before an end with unread data is closed, and waits for the
+         * flush, so the writer of the unread data is always there */
+        if (rb->len && reader && writer) {
+            PAL_HANDLE pal_handle = writer->pal_handle;
+            size_t first = RING_PIPE_SIZE - rb->start < rb->len ? RING_PIPE_SIZE - rb->start
+                                                                : rb->len;
+
+            /* no other thread touches the buffers while `flushing` is set */
+            unlock(&ring->lock);
+            bool flushed = ring_flush_to_host(pal_handle, rb->data + rb->start, first) &&
+                           ring_flush_to_host(pal_handle, rb->data, rb->len - first);
+            lock(&ring->lock);
+
+            if (!flushed)
+                debug("ring pipe: host stream failed on migration, dropped %lu bytes\n",
+                      rb->len);
+        }
+
+        free(rb->data);
+        rb->data  = NULL;
+        rb->start = 0;
+        rb->len   = 0;
+    }
+
+    /* set only after the flush, so that no thread writes to the host stream before it */
+    __atomic_store_n(&ring->on_host, true, __ATOMIC_RELEASE);
+    ring->flushing = false;
+    ring_changed(ring);
+}
+
+void ring_pipe_migrate(struct shim_handle* hdl) {
+    struct shim_ring_pipe* ring = hdl->ring;
+    if (!ring || __atomic_load_n(&ring->on_host, __ATOMIC_ACQUIRE))
+        return;
+
+    lock(&ring->lock);
+    __ring_pipe_migrate(ring);
+    unlock(&ring->lock);
+}
+
+bool ring_pipe_read(struct shim_handle* hdl, void* buf, size_t count, ssize_t* ret) {
+    struct shim_ring_pipe* ring = hdl->ring;
+    if (!ring || __atomic_load_n(&ring->on_host, __ATOMIC_ACQUIRE))
+        return false;
+
+    lock(&ring->lock);
+    int end             = ring_end(ring, hdl);
+    struct ring_buf* rb = &ring->bufs[end];
+
+    while (!ring->on_host) {
+        if (ring->flushing) {
+            wait_ring_flush(ring);
+            continue;
+        }
+
+        if (!count) {
+            *ret = 0;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        if (rb->len) {
+            *ret = ring_buf_read(rb, buf, count);
+            ring_changed(ring);
+            unlock(&ring->lock);
+            return true;
+        }
+
+        if (!ring->ends[!end]) {
+            /* end of stream */
+            *ret = 0;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        if (hdl->flags & O_NONBLOCK) {
+            *ret = -EAGAIN;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        int err = wait_ring_pipe(ring);
+        if (err == -EINVAL) {
+            __ring_pipe_migrate(ring);
+        } else if (err < 0) {
+            *ret = err;
+            unlock(&ring->lock);
+            return true;
+        }
+    }
+
+    unlock(&ring->lock);
+    return false;
+}
+
+bool ring_pipe_write(struct shim_handle* hdl, const void* buf, size_t count, ssize_t* ret) {
+    struct shim_ring_pipe* ring = hdl->ring;
+    if (!ring || __atomic_load_n(&ring->on_host, __ATOMIC_ACQUIRE))
+        return false;
+
+    lock(&ring->lock);
+    int end             = ring_end(ring, hdl);
+    struct ring_buf* rb = &ring->bufs[!end];
+    size_t written      = 0;
+
+    while (!ring->on_host) {
+        if (ring->flushing) {
+            wait_ring_flush(ring);
+            continue;
+        }
+
+        if (!ring->ends[!end]) {
+            *ret = written ? (ssize_t)written : -EPIPE;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        if (!rb->data && !(rb->data = malloc(RING_PIPE_SIZE))) {
+            *ret = written ? (ssize_t)written : -ENOMEM;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        size_t left  = count - written;
+        size_t space = RING_PIPE_SIZE - rb->len;
+        if (space && (left > RING_PIPE_ATOMIC || space >= left)) {
+            written += ring_buf_write(rb, buf + written, left);
+            ring_changed(ring);
+        }
+
+        if (written == count || (hdl->flags & O_NONBLOCK)) {
+            *ret = written ? (ssize_t)written : -EAGAIN;
+            unlock(&ring->lock);
+            return true;
+        }
+
+        int err = wait_ring_pipe(ring);
+        if (err == -EINVAL) {
+            __ring_pipe_migrate(ring);
+        } else if (err < 0) {
+            *ret = written ? (ssize_t)written : err;
+            unlock(&ring->lock);
+            return true;
+        }
+    }
+
+    unlock(&ring->lock);
+
+    if (written) {
+        /* the rest goes through the host stream; report a short write like an interrupted one */
+        *ret = written;
+        return true;
+    }
+    return false;
+}
+
+bool ring_pipe_poll(struct shim_handle* hdl, int poll_type, off_t* ret) {
+    struct shim_ring_pipe* ring = hdl->ring;
+    if (!ring || __atomic_load_n(&ring->on_host, __ATOMIC_ACQUIRE))
+        return false;
+
+    lock(&ring->lock);
+    if (ring->on_host || ring->flushing) {
+        unlock(&ring->lock);
+        return false;
+    }
+
+    int end = ring_end(ring, hdl);
+    struct ring_buf* rb = &ring->bufs[end];
+    bool peer_open      = ring->ends[!end] != NULL;
+
+    if (poll_type == FS_POLL_SZ) {
+        *ret = rb->len;
+    } else {
+        *ret = peer_open ? 0 : FS_POLL_ER;
+        if ((poll_type & FS_POLL_RD) && (rb->len || !peer_open))
+            *ret |= FS_POLL_RD;
+        if ((poll_type & FS_POLL_WR) && peer_open && ring->bufs[!end].len < RING_PIPE_SIZE)
+            *ret |= FS_POLL_WR;
+    }
+
+    unlock(&ring->lock);
+    return true;
+}
+
+void ring_pipe_close(struct shim_handle* hdl) {
+    struct shim_ring_pipe* ring = hdl->ring;
+    if (!ring)
+        return;
+
+    lock(&ring->lock);
+    int end = ring_end(ring, hdl);
+
+    /* the data written by this end must reach the host stream while it is still open, in case the
+     * other end migrates later; a flush in progress may also be writing through this end */
+    if (ring->flushing || (ring->bufs[!end].len && ring->ends[!end]))
+        __ring_pipe_migrate(ring);
+
+    ring->ends[end] = NULL;
+    hdl->ring       = NULL;
+    ring_changed(ring);
+    unlock(&ring->lock);
+
+    if (!REF_DEC(ring->ref_count)) {
+        destroy_lock(&ring->lock);
+        free(ring->bufs[0].data);
+        free(ring->bufs[1].data);
+        free(ring);
+    }
+}
+
+void ring_pipe_checkout(struct shim_handle* hdl) {
+    /* `hdl` is the checkpointed copy: migrate the original pair, the copy only gets the host
+     * stream */
+    ring_pipe_migrate(hdl);
+    hdl->ring = NULL;
+}
@@ -37,8 +37,7 @@
 #include <shim_profile.h>
 
 static int socket_close(struct shim_handle* hdl) {
-    /* XXX: Shouldn't this do something? */
-    __UNUSED(hdl);
+    ring_pipe_close(hdl);
     return 0;
 }
 
@@ -63,6 +62,10 @@ static ssize_t socket_read(struct shim_handle* hdl, void* buf, size_t count) {
 
     unlock(&hdl->lock);
 
+    ssize_t ret;
+    if (ring_pipe_read(hdl, buf, count, &ret))
+        return ret;
+
     PAL_NUM bytes = DkStreamRead(hdl->pal_handle, 0, count, buf, NULL, 0);
 
     if (bytes == PAL_STREAM_ERROR)
@@ -102,6 +105,16 @@ static ssize_t socket_write(struct shim_handle* hdl, const void* buf, size_t cou
 
     unlock(&hdl->lock);
 
+    ssize_t ret;
+    if (ring_pipe_write(hdl, buf, count, &ret)) {
+        if (ret == -EPIPE) {
+            lock(&hdl->lock);
+            sock->error = EPIPE;
+            unlock(&hdl->lock);
+        }
+        return ret;
+    }
+
     PAL_NUM bytes = DkStreamWrite(hdl->pal_handle, 0, count, (void*)buf, NULL);
 
     if (bytes == PAL_STREAM_ERROR) {
@@ -127,15 +140,21 @@ static int socket_hstat(struct shim_handle* hdl, struct stat* stat) {
     if (!stat)
         return 0;
 
-    PAL_STREAM_ATTR attr;
+    /* the unread data of a socketpair may still be in the ring rather than in the host stream */
+    off_t size;
+    if (!ring_pipe_poll(hdl, FS_POLL_SZ, &size)) {
+        PAL_STREAM_ATTR attr;
 
-    if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr))
-        return -PAL_ERRNO;
+        if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr))
+            return -PAL_ERRNO;
+
+        size = (off_t)attr.pending_size;
+    }
 
     memset(stat, 0, sizeof(struct stat));
 
     stat->st_ino  = 0;
-    stat->st_size = (off_t)attr.pending_size;
+    stat->st_size = size;
     stat->st_mode = S_IFSOCK;
 
     return 0;
@@ -143,6 +162,7 @@ static int socket_hstat(struct shim_handle* hdl, struct stat* stat) {
 
 static int socket_checkout(struct shim_handle* hdl) {
     hdl->fs = NULL;
+    ring_pipe_checkout(hdl);
     return 0;
 }
 
@@ -187,6 +207,9 @@ static off_t socket_poll(struct shim_handle* hdl, int poll_type) {
         goto out;
     }
 
+    if (ring_pipe_poll(hdl, poll_type, &ret))
+        goto out;
+
     PAL_STREAM_ATTR attr;
     if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr)) {
         ret = -PAL_ERRNO;
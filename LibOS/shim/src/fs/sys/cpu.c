@@ -0,0 +1,238 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*!
+ * \file
+ *
+ * This file contains the implementation of `/sys/devices/system/cpu`, which describes the CPUs
+ * reported by the PAL and their core and package topology.
+ */
+
+#include "shim_fs.h"
+
+#define BITMAP_WORD_BITS    (8 * sizeof(unsigned long))
+#define BITMAP_WORDS(count) (((count) + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS)
+
+#define CPU_DIR_PREFIX      "devices/system/cpu/"
+
+/* Parses "cpu<N>" at the start of `name`, followed by the end of string or a slash */
+static int parse_cpu_name(const char* name, size_t* cpu) {
+    if (!strstartswith_static(name, "cpu"))
+        return -ENOENT;
+
+    const char* p = name + static_strlen("cpu");
+    size_t n = 0;
+
+    if (*p < '0' || *p > '9')
+        return -ENOENT;
+
+    for (; *p && *p != '/'; p++) {
+        if (*p < '0' || *p > '9')
+            return -ENOENT;
+        n = n * 10 + *p - '0';
+        if (n >= PAL_CB(cpu_info.cpu_num))
+            return -ENOENT;
+    }
+
+    *cpu = n;
+    return 0;
+}
+
+static int cpu_info_mode(const char* name, mode_t* mode) {
+    __UNUSED(name);
+    *mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+static int cpu_info_stat(const char* name, struct stat* buf) {
+    __UNUSED(name);
+    memset(buf, 0, sizeof(struct stat));
+    buf->st_dev  = 1;    /* dummy ID of device containing file */
+    buf->st_ino  = 1;    /* dummy inode number */
+    buf->st_mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+/* "online", "possible" and "present" list the same CPUs: the LibOS only knows the online ones */
+static int cpu_list_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    size_t cpus = PAL_CB(cpu_info.cpu_num);
+    unsigned long* bitmap = calloc(BITMAP_WORDS(cpus) ?: 1, sizeof(unsigned long));
+    if (!bitmap)
+        return -ENOMEM;
+
+    for (size_t i = 0; i < cpus; i++)
+        bitmap[i / BITMAP_WORD_BITS] |= 1UL << (i % BITMAP_WORD_BITS);
+
+    int ret = pseudo_bitmap_open(hdl, flags, bitmap, cpus, /*mask=*/false);
+    free(bitmap);
+    return ret;
+}
+
+static int cpu_topology_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    if (!strstartswith_static(name, CPU_DIR_PREFIX))
+        return -ENOENT;
+
+    size_t cpu;
+    int ret = parse_cpu_name(name + static_strlen(CPU_DIR_PREFIX), &cpu);
+    if (ret < 0)
+        return ret;
+
+    const char* file = name + strlen(name);
+    while (file > name && *(file - 1) != '/')
+        file--;
+
+    bool core_id = !strcmp_static(file, "core_id");
+    if (core_id || !strcmp_static(file, "physical_package_id")) {
+        char* str = malloc(32);
+        if (!str)
+            return -ENOMEM;
+
+        int len = snprintf(str, 32, "%lu\n", core_id ? get_cpu_core(cpu) : get_cpu_package(cpu));
+        return pseudo_str_open(hdl, flags, str, len);
+    }
+
+    /* thread siblings share the core, core siblings share the package */
+    size_t file_len = strlen(file);
+    bool thread = strstartswith_static(file, "thread_siblings");
+    bool list   = file_len > static_strlen("_list") &&
+                  !strcmp_static(file + file_len - static_strlen("_list"), "_list");
+
+    size_t cpus = PAL_CB(cpu_info.cpu_num);
+    unsigned long* bitmap = calloc(BITMAP_WORDS(cpus) ?: 1, sizeof(unsigned long));
+    if (!bitmap)
+        return -ENOMEM;
+
+    for (size_t i = 0; i < cpus; i++) {
+        if (get_cpu_package(i) != get_cpu_package(cpu))
+            continue;
+        if (thread && get_cpu_core(i) != get_cpu_core(cpu))
+            continue;
+        bitmap[i / BITMAP_WORD_BITS] |= 1UL << (i % BITMAP_WORD_BITS);
+    }
+
+    ret = pseudo_bitmap_open(hdl, flags, bitmap, cpus, /*mask=*/!list);
+    free(bitmap);
+    return ret;
+}
+
+static int cpu_match_name(const char* name) {
+    size_t cpu;
+    return parse_cpu_name(name, &cpu) == 0 ? 1 : 0;
+}
+
+static int cpu_list_name(const char* name, struct shim_dirent** buf, int count) {
+    __UNUSED(name);
+    struct shim_dirent* dirent = *buf;
+    void* buf_end = (void*)*buf + count;
+
+    for (size_t i = 0; i < PAL_CB(cpu_info.cpu_num); i++) {
+        char cpu_name[16];
+        int len = snprintf(cpu_name, sizeof(cpu_name), "cpu%lu", i);
+
+        if ((void*)(dirent + 1) + len + 1 > buf_end)
+            return -ENOMEM;
+
+        memcpy(dirent->name, cpu_name, len + 1);
+        dirent->next = (void*)(dirent + 1) + len + 1;
+        dirent->ino  = 1;
+        dirent->type = LINUX_DT_DIR;
+        dirent       = dirent->next;
+    }
+
+    *buf = dirent;
+    return 0;
+}
+
+static const struct pseudo_name_ops nm_cpu = {
+    .match_name = &cpu_match_name,
+    .list_name  = &cpu_list_name,
+};
+
+static const struct pseudo_fs_ops fs_cpu_dir = {
+    .open = &pseudo_dir_open,
+    .mode = &pseudo_dir_mode,
+    .stat = &pseudo_dir_stat,
+};
+
+static const struct pseudo_fs_ops fs_cpu_list = {
+    .mode = &cpu_info_mode,
+    .stat = &cpu_info_stat,
+    .open = &cpu_list_open,
+};
+
+static const struct pseudo_fs_ops fs_cpu_topology = {
+    .mode = &cpu_info_mode,
+    .stat = &cpu_info_stat,
+    .open = &cpu_topology_open,
+};
+
+static const struct pseudo_dir dir_topology = {
+    .size = 6,
+    .ent  = {
+              { .name   = "core_id",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "physical_package_id",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "core_siblings",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "core_siblings_list",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "thread_siblings",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "thread_siblings_list",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+            }
+};
+
+static const struct pseudo_dir dir_each_cpu = {
+    .size = 1,
+    .ent  = {
+              { .name   = "topology",
+                .fs_ops = &fs_cpu_dir,
+                .dir    = &dir_topology },
+            }
+};
+
+const struct pseudo_dir dir_cpu = {
+    .size = 4,
+    .ent  = {
+              { .name   = "online",
+                .fs_ops = &fs_cpu_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "possible",
+                .fs_ops = &fs_cpu_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "present",
+                .fs_ops = &fs_cpu_list,
+                .type   = LINUX_DT_REG },
+              { .name_ops = &nm_cpu,
+                .fs_ops   = &fs_cpu_dir,
+                .dir      = &dir_each_cpu },
+            }
+};
@@ -0,0 +1,112 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*!
+ * \file
+ *
+ * This file contains the implementation of `/sys` pseudo-filesystem. Only the parts describing
+ * the CPU and memory topology are emulated.
+ */
+
+#include "shim_fs.h"
+
+extern const struct pseudo_dir dir_cpu;
+extern const struct pseudo_dir dir_node;
+
+static const struct pseudo_fs_ops sys_dir_fs = {
+    .open = &pseudo_dir_open,
+    .mode = &pseudo_dir_mode,
+    .stat = &pseudo_dir_stat,
+};
+
+static const struct pseudo_dir sys_system_dir = {
+    .size = 2,
+    .ent  = {
+              { .name   = "cpu",
+                .fs_ops = &sys_dir_fs,
+                .dir    = &dir_cpu },
+              { .name   = "node",
+                .fs_ops = &sys_dir_fs,
+                .dir    = &dir_node },
+            }
+};
+
+static const struct pseudo_dir sys_devices_dir = {
+    .size = 1,
+    .ent  = {
+              { .name   = "system",
+                .fs_ops = &sys_dir_fs,
+                .dir    = &sys_system_dir },
+            }
+};
+
+static const struct pseudo_dir sys_root_dir = {
+    .size = 1,
+    .ent  = {
+              { .name   = "devices",
+                .fs_ops = &sys_dir_fs,
+                .dir    = &sys_devices_dir },
+            }
+};
+
+static const struct pseudo_ent sys_root_ent = {
+    .name   = "",
+    .fs_ops = &sys_dir_fs,
+    .dir    = &sys_root_dir,
+};
+
+static int sys_mode(struct shim_dentry* dent, mode_t* mode) {
+    return pseudo_mode(dent, mode, &sys_root_ent);
+}
+
+static int sys_lookup(struct shim_dentry* dent) {
+    return pseudo_lookup(dent, &sys_root_ent);
+}
+
+static int sys_open(struct shim_handle* hdl, struct shim_dentry* dent, int flags) {
+    return pseudo_open(hdl, dent, flags, &sys_root_ent);
+}
+
+static int sys_readdir(struct shim_dentry* dent, struct shim_dirent** dirent) {
+    return pseudo_readdir(dent, dirent, &sys_root_ent);
+}
+
+static int sys_stat(struct shim_dentry* dent, struct stat* buf) {
+    return pseudo_stat(dent, buf, &sys_root_ent);
+}
+
+static int sys_hstat(struct shim_handle* hdl, struct stat* buf) {
+    return pseudo_hstat(hdl, buf, &sys_root_ent);
+}
+
+struct shim_fs_ops sys_fs_ops = {
+    .mount   = &pseudo_mount,
+    .unmount = &pseudo_unmount,
+    .close   = &str_close,
+    .read    = &str_read,
+    .write   = &str_write,
+    .seek    = &str_seek,
+    .flush   = &str_flush,
+    .hstat   = &sys_hstat,
+};
+
+struct shim_d_ops sys_d_ops = {
+    .open    = &sys_open,
+    .stat    = &sys_stat,
+    .mode    = &sys_mode,
+    .lookup  = &sys_lookup,
+    .readdir = &sys_readdir,
+};
@@ -0,0 +1,295 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*!
+ * \file
+ *
+ * This file contains the implementation of `/sys/devices/system/node`, which describes the NUMA
+ * nodes reported by the PAL (or a single node with all CPUs and memory if there are none).
+ */
+
+#include "shim_fs.h"
+
+#define BITMAP_WORD_BITS    (8 * sizeof(unsigned long))
+#define BITMAP_WORDS(count) (((count) + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS)
+
+/* Parses "node<N>" at the start of `name`, followed by the end of string or a slash */
+static int parse_node_name(const char* name, size_t* node) {
+    if (!strstartswith_static(name, "node"))
+        return -ENOENT;
+
+    const char* p = name + static_strlen("node");
+    size_t n = 0;
+
+    if (*p < '0' || *p > '9')
+        return -ENOENT;
+
+    for (; *p && *p != '/'; p++) {
+        if (*p < '0' || *p > '9')
+            return -ENOENT;
+        n = n * 10 + *p - '0';
+        if (n >= get_numa_node_count())
+            return -ENOENT;
+    }
+
+    *node = n;
+    return 0;
+}
+
+/* Finds the node of a path like "devices/system/node/node1/cpulist" */
+static int parse_node_path(const char* path, size_t* node) {
+    const char* p = path + strlen(path);
+
+    /* skip the file name and the slash before it */
+    while (p > path && *(p - 1) != '/')
+        p--;
+    if (p == path)
+        return -ENOENT;
+    p--;
+
+    while (p > path && *(p - 1) != '/')
+        p--;
+    return parse_node_name(p, node);
+}
+
+static int node_info_mode(const char* name, mode_t* mode) {
+    __UNUSED(name);
+    *mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+static int node_info_stat(const char* name, struct stat* buf) {
+    __UNUSED(name);
+    memset(buf, 0, sizeof(struct stat));
+    buf->st_dev  = 1;    /* dummy ID of device containing file */
+    buf->st_ino  = 1;    /* dummy inode number */
+    buf->st_mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+/* "online", "possible", "has_cpu" and "has_memory" list the same nodes: there are no offline or
+ * hotplugged ones */
+static int node_list_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    size_t nodes = get_numa_node_count();
+    unsigned long* bitmap = calloc(BITMAP_WORDS(nodes), sizeof(unsigned long));
+    if (!bitmap)
+        return -ENOMEM;
+
+    for (size_t i = 0; i < nodes; i++)
+        bitmap[i / BITMAP_WORD_BITS] |= 1UL << (i % BITMAP_WORD_BITS);
+
+    int ret = pseudo_bitmap_open(hdl, flags, bitmap, nodes, /*mask=*/false);
+    free(bitmap);
+    return ret;
+}
+
+static int node_cpus_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    size_t node;
+    int ret = parse_node_path(name, &node);
+    if (ret < 0)
+        return ret;
+
+    size_t cpus = PAL_CB(cpu_info.cpu_num);
+    unsigned long* bitmap = calloc(BITMAP_WORDS(cpus) ?: 1, sizeof(unsigned long));
+    if (!bitmap)
+        return -ENOMEM;
+
+    for (size_t i = 0; i < cpus; i++)
+        if (get_numa_node_of_cpu(i) == node)
+            bitmap[i / BITMAP_WORD_BITS] |= 1UL << (i % BITMAP_WORD_BITS);
+
+    size_t len = strlen(name);
+    bool mask  = len >= static_strlen("cpumap") &&
+                 !strcmp_static(name + len - static_strlen("cpumap"), "cpumap");
+
+    ret = pseudo_bitmap_open(hdl, flags, bitmap, cpus, mask);
+    free(bitmap);
+    return ret;
+}
+
+static int node_meminfo_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    size_t node;
+    int ret = parse_node_path(name, &node);
+    if (ret < 0)
+        return ret;
+
+    unsigned long total = PAL_CB(mem_info.mem_total);
+    unsigned long free_mem = DkMemoryAvailableQuota();
+
+    if (PAL_CB(numa_info.node_num)) {
+        /* the free memory is only known in total, so split it in proportion to the node sizes */
+        unsigned long all_nodes = 0;
+        for (size_t i = 0; i < PAL_CB(numa_info.node_num); i++)
+            all_nodes += PAL_CB(numa_info.node_mem)[i];
+
+        total = PAL_CB(numa_info.node_mem)[node];
+        free_mem = all_nodes / 1024 ? (free_mem / 1024) * (total / 1024) / (all_nodes / 1024) * 1024
+                                    : 0;
+        if (free_mem > total)
+            free_mem = total;
+    }
+
+    size_t size = 256;
+    char* str = malloc(size);
+    if (!str)
+        return -ENOMEM;
+
+    /* the format matches Linux's drivers/base/node.c */
+    int len = snprintf(str, size,
+                       "Node %lu MemTotal:       %8lu kB\n"
+                       "Node %lu MemFree:        %8lu kB\n"
+                       "Node %lu MemUsed:        %8lu kB\n",
+                       node, total / 1024, node, free_mem / 1024, node, (total - free_mem) / 1024);
+
+    return pseudo_str_open(hdl, flags, str, len);
+}
+
+static int node_distance_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    size_t node;
+    int ret = parse_node_path(name, &node);
+    if (ret < 0)
+        return ret;
+
+    size_t nodes = get_numa_node_count();
+    size_t size  = nodes * 11 + 1;
+    char* str = malloc(size);
+    if (!str)
+        return -ENOMEM;
+
+    size_t len = 0;
+    for (size_t i = 0; i < nodes; i++) {
+        unsigned int distance = PAL_CB(numa_info.node_num) ?
+                                PAL_CB(numa_info.distance)[node * nodes + i] : 10;
+        len += snprintf(str + len, size - len, "%u%c", distance, i == nodes - 1 ? '\n' : ' ');
+    }
+
+    return pseudo_str_open(hdl, flags, str, len);
+}
+
+static int node_match_name(const char* name) {
+    size_t node;
+    return parse_node_name(name, &node) == 0 ? 1 : 0;
+}
+
+static int node_list_name(const char* name, struct shim_dirent** buf, int count) {
+    __UNUSED(name);
+    struct shim_dirent* dirent = *buf;
+    void* buf_end = (void*)*buf + count;
+
+    for (size_t i = 0; i < get_numa_node_count(); i++) {
+        char node_name[16];
+        int len = snprintf(node_name, sizeof(node_name), "node%lu", i);
+
+        if ((void*)(dirent + 1) + len + 1 > buf_end)
+            return -ENOMEM;
+
+        memcpy(dirent->name, node_name, len + 1);
+        dirent->next = (void*)(dirent + 1) + len + 1;
+        dirent->ino  = 1;
+        dirent->type = LINUX_DT_DIR;
+        dirent       = dirent->next;
+    }
+
+    *buf = dirent;
+    return 0;
+}
+
+static const struct pseudo_name_ops nm_node = {
+    .match_name = &node_match_name,
+    .list_name  = &node_list_name,
+};
+
+static const struct pseudo_fs_ops fs_node = {
+    .open = &pseudo_dir_open,
+    .mode = &pseudo_dir_mode,
+    .stat = &pseudo_dir_stat,
+};
+
+static const struct pseudo_fs_ops fs_node_list = {
+    .mode = &node_info_mode,
+    .stat = &node_info_stat,
+    .open = &node_list_open,
+};
+
+static const struct pseudo_fs_ops fs_node_cpus = {
+    .mode = &node_info_mode,
+    .stat = &node_info_stat,
+    .open = &node_cpus_open,
+};
+
+static const struct pseudo_fs_ops fs_node_meminfo = {
+    .mode = &node_info_mode,
+    .stat = &node_info_stat,
+    .open = &node_meminfo_open,
+};
+
+static const struct pseudo_fs_ops fs_node_distance = {
+    .mode = &node_info_mode,
+    .stat = &node_info_stat,
+    .open = &node_distance_open,
+};
+
+static const struct pseudo_dir dir_each_node = {
+    .size = 4,
+    .ent  = {
+              { .name   = "cpumap",
+                .fs_ops = &fs_node_cpus,
+                .type   = LINUX_DT_REG },
+              { .name   = "cpulist",
+                .fs_ops = &fs_node_cpus,
+                .type   = LINUX_DT_REG },
+              { .name   = "meminfo",
+                .fs_ops = &fs_node_meminfo,
+                .type   = LINUX_DT_REG },
+              { .name   = "distance",
+                .fs_ops = &fs_node_distance,
+                .type   = LINUX_DT_REG },
+            }
+};
+
+const struct pseudo_dir dir_node = {
+    .size = 5,
+    .ent  = {
+              { .name   = "online",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "possible",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "has_cpu",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "has_memory",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name_ops = &nm_node,
+                .fs_ops   = &fs_node,
+                .dir      = &dir_each_node },
+            }
+};
@@ -9,6 +9,8 @@ void dummy(void)
 {
     OFFSET_T(SHIM_TCB_OFFSET, PAL_TCB, libos_tcb);
     OFFSET_T(TCB_REGS, shim_tcb_t, context.regs);
+    OFFSET_T(TCB_TID, shim_tcb_t, tid);
+    OFFSET_T(TCB_TGID, shim_tcb_t, tgid);
     OFFSET(SHIM_REGS_RSP, shim_regs, rsp);
     OFFSET(SHIM_REGS_R15, shim_regs, r15);
     OFFSET(SHIM_REGS_RIP, shim_regs, rip);
@@ -317,7 +317,9 @@ void init_ipc_msg_duplex(struct shim_ipc_msg_duplex* msg, int code, size_t size,
     msg->private = NULL;
 }
 
-int send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+/* Send `msg` over the stream of `port`. Does not delete the port on failure, so that it can be
+ * called with port->msgs_lock held. */
+int __send_ipc_message_stream(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
     assert(msg->size >= IPC_MSG_MINIMAL_SIZE);
 
     msg->src = cur_process.vmid;
@@ -334,8 +336,6 @@ int send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
             if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN || PAL_ERRNO == EWOULDBLOCK)
                 continue;
 
-            debug("Port %p (handle %p) was removed during sending\n", port, port->pal_handle);
-            del_ipc_port_fini(port, -ECHILD);
             return -PAL_ERRNO;
         }
 
@@ -345,6 +345,43 @@ int send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
     return 0;
 }
 
+static int __send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port,
+                              bool use_ring) {
+    int ret;
+
+    if (!ipc_rings_enabled()) {
+        ret = __send_ipc_message_stream(msg, port);
+    } else {
+        /* The choice of the ring or the stream and the sending itself are done under msgs_lock,
+         * which the IPC helper also holds to install the ring, so the peer receives messages in
+         * the order they were sent (see shim_ipc_ring.c). */
+        lock(&port->msgs_lock);
+        ret = -EAGAIN;
+        if (use_ring && port->ring_out) {
+            msg->src = cur_process.vmid;
+            ret = ipc_ring_send(msg, port);
+        }
+        /* the ring is full or the message is too large for it */
+        if (ret == -EAGAIN)
+            ret = __send_ipc_message_stream(msg, port);
+        unlock(&port->msgs_lock);
+    }
+
+    if (ret < 0) {
+        debug("Port %p (handle %p) was removed during sending\n", port, port->pal_handle);
+        del_ipc_port_fini(port, -ECHILD);
+    }
+    return ret;
+}
+
+int send_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    return __send_ipc_message(msg, port, /*use_ring=*/true);
+}
+
+int send_ipc_message_stream(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    return __send_ipc_message(msg, port, /*use_ring=*/false);
+}
+
 struct shim_ipc_msg_duplex* pop_ipc_msg_duplex(struct shim_ipc_port* port, unsigned long seq) {
     struct shim_ipc_msg_duplex* found = NULL;
 
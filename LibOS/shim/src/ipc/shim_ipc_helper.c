@@ -34,6 +34,10 @@
 
 #define IPC_HELPER_STACK_SIZE (g_pal_alloc_align * 4)
 
+/* number of times IPC helper polls the shared-memory rings before it goes to sleep; it only polls
+ * after it found messages in the rings, so an idle process does not spin */
+#define IPC_RING_SPIN 100
+
 static struct shim_lock ipc_port_mgr_lock;
 
 #define SYSTEM_LOCK()   lock(&ipc_port_mgr_lock)
@@ -61,6 +65,8 @@ static int ipc_resp_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* por
 static ipc_callback ipc_callbacks[IPC_CODE_NUM] = {
     /* RESP             */ &ipc_resp_callback,
     /* CHECKPOINT       */ &ipc_checkpoint_callback,
+    /* RING_OFFER       */ &ipc_ring_offer_callback,
+    /* RING_KICK        */ &ipc_ring_kick_callback,
 
     /* parents and children */
     /* CLD_EXIT         */ &ipc_cld_exit_callback,
@@ -182,6 +188,8 @@ int init_ipc_ports(void) {
         return -ENOMEM;
 
     int ret;
+    if ((ret = init_ipc_rings()) < 0)
+        return ret;
     if ((ret = init_self_ipc_port()) < 0)
         return ret;
     if ((ret = init_parent_ipc_port()) < 0)
@@ -218,8 +226,10 @@ static struct shim_ipc_port* __create_ipc_port(PAL_HANDLE hdl) {
     if (!port)
         return NULL;
 
-    memset(port, 0, sizeof(struct shim_ipc_port));
+    memset(port, 0, offsetof(struct shim_ipc_port, recv_inline));
     port->pal_handle = hdl;
+    port->recv_buf = port->recv_inline;
+    port->recv_bufsize = sizeof(port->recv_inline);
     INIT_LIST_HEAD(port, list);
     INIT_LISTP(&port->msgs);
     REF_SET(port->ref_count, 0);
@@ -238,6 +248,9 @@ static void __free_ipc_port(struct shim_ipc_port* port) {
         port->pal_handle = NULL;
     }
 
+    ipc_ring_fini(port);
+    if (port->recv_buf != port->recv_inline)
+        free(port->recv_buf);
     destroy_lock(&port->msgs_lock);
     free_mem_obj_to_mgr(port_mgr, port);
 }
@@ -554,95 +567,156 @@ int send_response_ipc_message(struct shim_ipc_port* port, IDTYPE dest, int ret,
     return send_ipc_message(resp_msg, port);
 }
 
-static int receive_ipc_message(struct shim_ipc_port* port) {
+static int handle_ipc_message(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    debug(
+        "Received IPC message from port %p (handle %p): code=%d size=%lu "
+        "src=%u dst=%u seq=%lx\n",
+        port, port->pal_handle, msg->code, msg->size, msg->src & 0xFFFF, msg->dst & 0xFFFF,
+        msg->seq);
+
+    /* skip messages coming from myself (in case of broadcast) */
+    if (msg->src == cur_process.vmid)
+        return 0;
+
+    if (msg->code < IPC_CODE_NUM && ipc_callbacks[msg->code]) {
+        /* invoke callback to this msg */
+        int ret = (*ipc_callbacks[msg->code])(msg, port);
+        if ((ret < 0 || ret == RESPONSE_CALLBACK) && msg->seq) {
+            /* send IPC_RESP message to sender of this msg */
+            ret = send_response_ipc_message(port, msg->src, ret, msg->seq);
+            if (ret < 0) {
+                debug("Sending IPC_RESP msg on port %p (handle %p) to %u failed\n", port,
+                      port->pal_handle, msg->src & 0xFFFF);
+                return -PAL_ERRNO;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Handle all messages in the shared-memory ring of `port`. Messages are handled in place and only
+ * then removed from the ring, so no buffer is allocated and nothing is copied. Returns the number
+ * of messages handled. */
+static int receive_ipc_ring_messages(struct shim_ipc_port* port) {
+    struct shim_ipc_msg* msg;
+    int handled = 0;
     int ret;
-    size_t readahead = IPC_MSG_MINIMAL_SIZE * 2;
-    size_t bufsize   = IPC_MSG_MINIMAL_SIZE + readahead;
 
-    struct shim_ipc_msg* msg = malloc(bufsize);
-    if (!msg) {
-        return -ENOMEM;
+    while ((ret = ipc_ring_peek(port, &msg)) > 0) {
+        /* NOTE: IPC helper thread does not handle failures currently, keep going */
+        handle_ipc_message(msg, port);
+        ipc_ring_consume(port, msg);
+        handled++;
     }
-    size_t expected_size     = IPC_MSG_MINIMAL_SIZE;
-    size_t bytes             = 0;
-
-    do {
-        while (bytes < expected_size) {
-            /* grow msg buffer to accommodate bigger messages */
-            if (expected_size + readahead > bufsize) {
-                while (expected_size + readahead > bufsize)
-                    bufsize *= 2;
-                void* tmp_buf = malloc(bufsize);
-                if (!tmp_buf) {
-                    ret = -ENOMEM;
-                    goto out;
-                }
-                memcpy(tmp_buf, msg, bytes);
-                free(msg);
-                msg = tmp_buf;
-            }
 
-            PAL_NUM read =
-                DkStreamRead(port->pal_handle, /*offset=*/0, expected_size - bytes + readahead,
-                             (void*)msg + bytes, NULL, 0);
+    if (ret < 0) {
+        debug("Port %p (handle %p) has a corrupted IPC ring\n", port, port->pal_handle);
+        del_ipc_port_fini(port, -ECHILD);
+    }
+    return handled;
+}
 
-            if (read == PAL_STREAM_ERROR) {
-                if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN || PAL_ERRNO == EWOULDBLOCK)
-                    continue;
+/* Receive messages on the stream of `port`. One read brings in as many messages as fit into the
+ * port's receive buffer, and all complete messages are handled in place, so no memory is allocated
+ * per message. A trailing partial message is kept in the buffer until its rest arrives; only a
+ * message larger than the buffer makes the buffer grow for the time it is received. */
+static int receive_ipc_message(struct shim_ipc_port* port) {
+    int ret = 0;
+    PAL_NUM read;
 
-                debug("Port %p (handle %p) closed while receiving IPC message\n", port,
-                      port->pal_handle);
-                del_ipc_port_fini(port, -ECHILD);
-                ret = -PAL_ERRNO;
-                goto out;
-            }
+    while (true) {
+        read = DkStreamRead(port->pal_handle, /*offset=*/0, port->recv_bufsize - port->recv_bytes,
+                            port->recv_buf + port->recv_bytes, NULL, 0);
+        if (read != PAL_STREAM_ERROR)
+            break;
+
+        if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN || PAL_ERRNO == EWOULDBLOCK)
+            continue;
 
-            bytes += read;
+        debug("Port %p (handle %p) closed while receiving IPC message\n", port,
+              port->pal_handle);
+        port->recv_bytes = 0;
+        del_ipc_port_fini(port, -ECHILD);
+        return -PAL_ERRNO;
+    }
+
+    if (!read) {
+        /* the peer closed the stream (e.g. it exited), nothing will ever arrive on this port */
+        debug("Port %p (handle %p) closed while receiving IPC message\n", port,
+              port->pal_handle);
+        port->recv_bytes = 0;
+        del_ipc_port_fini(port, -ECHILD);
+        return -ECONNRESET;
+    }
+
+    port->recv_bytes += read;
 
-            /* extract actual msg size from msg header and continue reading msg body */
-            if (bytes >= IPC_MSG_MINIMAL_SIZE)
-                expected_size = msg->size;
+    size_t off = 0;
+    while (port->recv_bytes - off >= IPC_MSG_MINIMAL_SIZE) {
+        struct shim_ipc_msg* msg = (struct shim_ipc_msg*)(port->recv_buf + off);
+        size_t size = msg->size;
+
+        if (size < IPC_MSG_MINIMAL_SIZE) {
+            debug("Port %p (handle %p) received malformed IPC message\n", port,
+                  port->pal_handle);
+            port->recv_bytes = 0;
+            del_ipc_port_fini(port, -ECHILD);
+            return -EINVAL;
         }
 
-        debug(
-            "Received IPC message from port %p (handle %p): code=%d size=%lu "
-            "src=%u dst=%u seq=%lx\n",
-            port, port->pal_handle, msg->code, msg->size, msg->src & 0xFFFF, msg->dst & 0xFFFF,
-            msg->seq);
-
-        /* skip messages coming from myself (in case of broadcast) */
-        if (msg->src != cur_process.vmid) {
-            if (msg->code < IPC_CODE_NUM && ipc_callbacks[msg->code]) {
-                /* invoke callback to this msg */
-                ret = (*ipc_callbacks[msg->code])(msg, port);
-                if ((ret < 0 || ret == RESPONSE_CALLBACK) && msg->seq) {
-                    /* send IPC_RESP message to sender of this msg */
-                    ret = send_response_ipc_message(port, msg->src, ret, msg->seq);
-                    if (ret < 0) {
-                        debug("Sending IPC_RESP msg on port %p (handle %p) to %u failed\n", port,
-                              port->pal_handle, msg->src & 0xFFFF);
-                        ret = -PAL_ERRNO;
-                        goto out;
-                    }
-                }
-            }
+        if (size > port->recv_bytes - off)
+            break;
+
+        if (!IS_ALIGNED(off, sizeof(long))) {
+            /* message bodies are accessed as regular structs, so keep them aligned */
+            memmove(port->recv_buf, msg, port->recv_bytes - off);
+            port->recv_bytes -= off;
+            off = 0;
+            msg = (struct shim_ipc_msg*)port->recv_buf;
         }
 
-        bytes -= expected_size;  /* one message was received and handled */
+        /* the peer put the messages in its ring before it fell back to the stream */
+        receive_ipc_ring_messages(port);
+
+        /* NOTE: IPC helper thread does not handle failures currently, keep going */
+        int err = handle_ipc_message(msg, port);
+        if (err < 0)
+            ret = err;
+        off += size;
+    }
+
+    /* keep the partial message (if any) at the beginning of the buffer */
+    port->recv_bytes -= off;
+    if (port->recv_bytes)
+        memmove(port->recv_buf, port->recv_buf + off, port->recv_bytes);
 
-        if (bytes > 0) {
-            /* we may have started reading the next message, move this message to beginning of msg
-             * buffer and reset expected size */
-            memmove(msg, (void*)msg + expected_size, bytes);
-            expected_size = IPC_MSG_MINIMAL_SIZE;
-            if (bytes >= IPC_MSG_MINIMAL_SIZE)
-                expected_size = msg->size;
+    size_t next_size = port->recv_bytes >= IPC_MSG_MINIMAL_SIZE
+                       ? ((struct shim_ipc_msg*)port->recv_buf)->size
+                       : 0;
+
+    if (next_size > port->recv_bufsize) {
+        /* grow the buffer to receive a large message */
+        char* buf = malloc(next_size);
+        if (!buf) {
+            port->recv_bytes = 0;
+            return -ENOMEM;
         }
-    } while (bytes > 0);
+        memcpy(buf, port->recv_buf, port->recv_bytes);
+        if (port->recv_buf != port->recv_inline)
+            free(port->recv_buf);
+        port->recv_buf     = buf;
+        port->recv_bufsize = next_size;
+    } else if (port->recv_buf != port->recv_inline &&
+               port->recv_bytes <= sizeof(port->recv_inline) &&
+               next_size <= sizeof(port->recv_inline)) {
+        /* the large message was handled, go back to the inline buffer */
+        memcpy(port->recv_inline, port->recv_buf, port->recv_bytes);
+        free(port->recv_buf);
+        port->recv_buf     = port->recv_inline;
+        port->recv_bufsize = sizeof(port->recv_inline);
+    }
 
-    ret = 0;
-out:
-    free(msg);
     return ret;
 }
 
@@ -763,8 +837,37 @@ noreturn static void shim_ipc_helper(void* dummy) {
 
         unlock(&ipc_helper_lock);
 
+        /* With shared-memory rings, messages in the rings are handled ahead of the streams. If the
+         * rings were busy, IPC helper polls them briefly before it sleeps on the streams, and tells
+         * the senders to kick it over the streams while it sleeps. */
+        bool rings_pending = false;
+        if (ipc_rings_enabled()) {
+            int rings_handled = 0;
+            for (size_t i = 0; i < ports_cnt; i++) {
+                if (!ports[i]->ring_offered && !(ports[i]->type & IPC_PORT_SERVER)) {
+                    ports[i]->ring_offered = true;
+                    ipc_ring_offer_send(ports[i]);
+                }
+                rings_handled += receive_ipc_ring_messages(ports[i]);
+            }
+
+            for (int spin = 0; rings_handled && spin < IPC_RING_SPIN && !rings_pending; spin++) {
+                for (size_t i = 0; i < ports_cnt && !rings_pending; i++)
+                    rings_pending = ipc_ring_pending(ports[i]);
+                CPU_RELAX();
+            }
+
+            for (size_t i = 0; i < ports_cnt && !rings_pending; i++)
+                rings_pending = !ipc_ring_arm(ports[i]);
+        }
+
         /* wait on collected ports' PAL handles + install_new_event_pal */
-        PAL_BOL polled = DkStreamsWaitEvents(ports_cnt + 1, pals, pal_events, ret_events, NO_TIMEOUT);
+        PAL_BOL polled = DkStreamsWaitEvents(ports_cnt + 1, pals, pal_events, ret_events,
+                                             rings_pending ? 0 : NO_TIMEOUT);
+
+        if (ipc_rings_enabled())
+            for (size_t i = 0; i < ports_cnt; i++)
+                ipc_ring_disarm(ports[i]);
 
         for (size_t i = 0; polled && i < ports_cnt + 1; i++) {
             if (ret_events[i]) {
@@ -44,6 +44,7 @@
 #define NS_CAP_STR XSTRINGIFY(NS_CAP)
 
 #define RANGE_SIZE CONCAT2(NS_CAP, RANGE_SIZE)
+#define CACHE_TIME CONCAT2(NS_CAP, CACHE_TIME)
 
 #define BITS (sizeof(unsigned char) * 8)
 
@@ -51,9 +52,12 @@ struct idx_bitmap {
     unsigned char map[RANGE_SIZE / BITS];
 };
 
+/* Ranges and subranges learned from an ANSWER of another process are only cached: they are
+ * trusted until their lease expires (or the owner goes away), and then looked up again. */
 struct subrange {
     struct shim_ipc_info* owner;
     LEASETYPE lease;
+    bool cached;
 };
 
 struct sub_map {
@@ -67,6 +71,7 @@ struct range {
     IDTYPE offset;
     struct shim_ipc_info* owner;
     LEASETYPE lease;
+    bool cached;
     struct idx_bitmap* used;
     struct sub_map* subranges;
 };
@@ -107,10 +112,17 @@ struct ns_query {
 DEFINE_LISTP(ns_query);
 static LISTP_TYPE(ns_query) ns_queries;
 
+/* Resolve owners through the parent before asking the leader (sys.ipc_leaderless) */
+static bool leaderless;
+
 static inline LEASETYPE get_lease(void) {
     return DkSystemTimeQuery() + CONCAT2(NS_CAP, LEASE_TIME);
 }
 
+static inline LEASETYPE get_cache_lease(void) {
+    return DkSystemTimeQuery() + CACHE_TIME;
+}
+
 void CONCAT3(debug_print, NS, ranges)(void) {
     lock(&range_map_lock);
     SYS_PRINTF(NS_STR " ranges in process %010u:\n", cur_process.vmid);
@@ -146,8 +158,9 @@ void CONCAT3(debug_print, NS, ranges)(void) {
             IDTYPE base             = RANGE_SIZE * off + 1;
             struct shim_ipc_info* p = r->owner;
 
-            SYS_PRINTF("%04u - %04u: owner %010u, port \"%s\" lease %lu\n", base,
-                       base + RANGE_SIZE - 1, p->vmid, qstrgetstr(&p->uri), r->lease);
+            if (p)
+                SYS_PRINTF("%04u - %04u: owner %010u, port \"%s\" lease %lu\n", base,
+                           base + RANGE_SIZE - 1, p->vmid, qstrgetstr(&p->uri), r->lease);
 
             if (!r->subranges)
                 continue;
@@ -264,6 +277,7 @@ static int __add_range(struct range* r, IDTYPE off, IDTYPE owner, const char* ur
     r->owner     = NULL;
     r->offset    = off;
     r->lease     = lease;
+    r->cached    = false;
     r->used      = NULL;
     r->subranges = NULL;
 
@@ -327,7 +341,71 @@ static int __add_range(struct range* r, IDTYPE off, IDTYPE owner, const char* ur
     return 0;
 }
 
-int CONCAT3(add, NS, range)(IDTYPE base, IDTYPE owner, const char* uri, LEASETYPE lease) {
+static void CONCAT3(__del, NS, subrange)(struct subrange** ptr) {
+    struct subrange* s = *ptr;
+    *ptr               = NULL;
+    put_ipc_info(s->owner);
+    free(s);
+    nsubed--;
+}
+
+/* Forget the owner of a cached range; the range itself goes away once it has no subranges. */
+static void __uncache_range(struct range* r) {
+    assert(locked(&range_map_lock));
+    assert(r->cached);
+
+    put_ipc_info_in_list(r->owner);
+    r->owner  = NULL;
+    r->cached = false;
+
+    if (r->subranges) {
+        for (IDTYPE i = 0; i < RANGE_SIZE; i++)
+            if (r->subranges->map[i])
+                return;
+        free(r->subranges);
+    }
+
+    __set_range_bitmap(r->offset, true);
+    LISTP_DEL(r, range_table + RANGE_HASH(r->offset), hlist);
+    LISTP_DEL(r, &offered_ranges, list);
+    noffered--;
+
+    if (r->used)
+        free(r->used);
+    free(r);
+}
+
+/* Forget all ranges and subranges cached for process vmid. Returns whether anything was cached. */
+static bool CONCAT3(__forget, NS, owner)(IDTYPE vmid) {
+    assert(locked(&range_map_lock));
+    bool forgot = false;
+
+    for (int i = 0; i < RANGE_HASH_NUM; i++) {
+        struct range* r;
+        struct range* n;
+
+        LISTP_FOR_EACH_ENTRY_SAFE(r, n, &range_table[i], hlist) {
+            if (r->subranges)
+                for (IDTYPE j = 0; j < RANGE_SIZE; j++) {
+                    struct subrange* s = r->subranges->map[j];
+                    if (s && s->cached && s->owner->vmid == vmid) {
+                        CONCAT3(__del, NS, subrange)(&r->subranges->map[j]);
+                        forgot = true;
+                    }
+                }
+
+            if (r->cached && r->owner->vmid == vmid) {
+                __uncache_range(r);
+                forgot = true;
+            }
+        }
+    }
+
+    return forgot;
+}
+
+static int CONCAT3(__add, NS, range)(IDTYPE base, IDTYPE owner, const char* uri, LEASETYPE lease,
+                                     bool cached) {
     IDTYPE off = (base - 1) / RANGE_SIZE;
     int ret;
 
@@ -336,23 +414,40 @@ int CONCAT3(add, NS, range)(IDTYPE base, IDTYPE owner, const char* uri, LEASETYP
         return -ENOMEM;
 
     lock(&range_map_lock);
+
+    if (cached) {
+        struct range* old = __get_range(off);
+
+        /* what we know first-hand is never replaced by a cached answer */
+        if (old && old->owner && !old->cached) {
+            unlock(&range_map_lock);
+            free(r);
+            return 0;
+        }
+
+        /* an answer for the range is followed by all its subranges, so drop the stale ones */
+        if (old && old->subranges)
+            for (IDTYPE i = 0; i < RANGE_SIZE; i++)
+                if (old->subranges->map[i] && old->subranges->map[i]->cached)
+                    CONCAT3(__del, NS, subrange)(&old->subranges->map[i]);
+    }
+
     r->owner = NULL;
     ret      = __add_range(r, off, owner, uri, lease);
     if (ret < 0)
         free(r);
+    else
+        r->cached = cached && owner != cur_process.vmid;
     unlock(&range_map_lock);
     return ret;
 }
 
-static void CONCAT3(__del, NS, subrange)(struct subrange** ptr) {
-    struct subrange* s = *ptr;
-    *ptr               = NULL;
-    put_ipc_info(s->owner);
-    free(s);
-    nsubed--;
+int CONCAT3(add, NS, range)(IDTYPE base, IDTYPE owner, const char* uri, LEASETYPE lease) {
+    return CONCAT3(__add, NS, range)(base, owner, uri, lease, false);
 }
 
-int CONCAT3(add, NS, subrange)(IDTYPE idx, IDTYPE owner, const char* uri, LEASETYPE* lease) {
+static int CONCAT3(__add, NS, subrange)(IDTYPE idx, IDTYPE owner, const char* uri,
+                                        LEASETYPE* lease, bool cached) {
     IDTYPE off         = (idx - 1) / RANGE_SIZE;
     IDTYPE base        = off * RANGE_SIZE + 1;
     int err            = 0;
@@ -369,7 +464,8 @@ int CONCAT3(add, NS, subrange)(IDTYPE idx, IDTYPE owner, const char* uri, LEASET
         goto failed;
     }
 
-    s->lease = (lease && (*lease)) ? (*lease) : get_lease();
+    s->lease  = (lease && (*lease)) ? (*lease) : get_lease();
+    s->cached = cached && owner != cur_process.vmid;
 
     struct range* r = __get_range(off);
     if (!r) {
@@ -395,8 +491,11 @@ int CONCAT3(add, NS, subrange)(IDTYPE idx, IDTYPE owner, const char* uri, LEASET
 
     struct subrange** m = &r->subranges->map[idx - base];
 
-    if (*m)
+    if (*m) {
+        if (cached && !(*m)->cached)
+            goto failed; /* keep what we know first-hand */
         CONCAT3(__del, NS, subrange)(m);
+    }
 
     (*m) = s;
     nsubed++;
@@ -416,6 +515,10 @@ failed:
     return err;
 }
 
+int CONCAT3(add, NS, subrange)(IDTYPE idx, IDTYPE owner, const char* uri, LEASETYPE* lease) {
+    return CONCAT3(__add, NS, subrange)(idx, owner, uri, lease, false);
+}
+
 int CONCAT3(alloc, NS, range)(IDTYPE owner, const char* uri, IDTYPE* base, LEASETYPE* lease) {
     struct range* r = malloc(sizeof(struct range));
     if (!r)
@@ -474,13 +577,22 @@ int CONCAT3(get, NS, range)(IDTYPE idx, struct CONCAT2(NS, range) * range,
     IDTYPE sz               = RANGE_SIZE;
     LEASETYPE l             = r->lease;
     struct shim_ipc_info* p = r->owner;
+    struct subrange** m     = r->subranges ? &r->subranges->map[idx - base] : NULL;
+
+    /* cached answers are only trusted until their lease expires */
+    if (m && *m && (*m)->cached && (*m)->lease < DkSystemTimeQuery())
+        CONCAT3(__del, NS, subrange)(m);
 
-    if (r->subranges && r->subranges->map[idx - base]) {
-        struct subrange* s = r->subranges->map[idx - base];
+    if (m && *m) {
+        struct subrange* s = *m;
         base               = idx;
         sz                 = 1;
         l                  = s->lease;
         p                  = s->owner;
+    } else if (r->cached && r->lease < DkSystemTimeQuery()) {
+        __uncache_range(r);
+        unlock(&range_map_lock);
+        return -ESRCH;
     }
 
     if (!p) {
@@ -704,6 +816,10 @@ static inline int init_namespace(void) {
     if (!create_lock(&range_map_lock)) {
         return -ENOMEM;
     }
+
+    char cfg[2];
+    if (root_config && get_config(root_config, "sys.ipc_leaderless", cfg, sizeof(cfg)) == 1)
+        leaderless = (cfg[0] == '1');
     return 0;
 }
 
@@ -890,9 +1006,21 @@ int CONCAT3(prepare, NS, leader)(void) {
     return 0;
 }
 
+static void ipc_owner_exit(struct shim_ipc_port* port, IDTYPE vmid, unsigned int exitcode) {
+    __UNUSED(port);
+    __UNUSED(exitcode);
+
+    lock(&range_map_lock);
+    CONCAT3(__forget, NS, owner)(vmid);
+    unlock(&range_map_lock);
+}
+
 static int connect_owner(IDTYPE idx, struct shim_ipc_port** portptr, IDTYPE* owner) {
     struct shim_ipc_info* info = NULL;
     struct CONCAT2(NS, range) range;
+    bool retried = false;
+
+retry:
     memset(&range, 0, sizeof(struct CONCAT2(NS, range)));
 
     int ret = CONCAT3(get, NS, range)(idx, &range, &info);
@@ -922,10 +1050,22 @@ static int connect_owner(IDTYPE idx, struct shim_ipc_port** portptr, IDTYPE* own
 
         if (!pal_handle) {
             ret = -PAL_ERRNO ?: -EACCES;
+
+            /* the owner may have gone away since we cached its answer, so ask again */
+            lock(&range_map_lock);
+            bool forgot = CONCAT3(__forget, NS, owner)(range.owner);
+            unlock(&range_map_lock);
+
+            if (forgot && !retried) {
+                put_ipc_info(info);
+                info    = NULL;
+                retried = true;
+                goto retry;
+            }
             goto out;
         }
 
-        add_ipc_port_by_id(range.owner, pal_handle, type, NULL, &range.port);
+        add_ipc_port_by_id(range.owner, pal_handle, type, &ipc_owner_exit, &range.port);
         assert(range.port);
     }
 
@@ -1336,6 +1476,19 @@ int NS_CALLBACK(sublease)(IPC_CALLBACK_ARGS) {
 DEFINE_PROFILE_INTERVAL(NS_SEND(query), ipc);
 DEFINE_PROFILE_INTERVAL(NS_CALLBACK(query), ipc);
 
+static int send_query(struct shim_ipc_port* port, IDTYPE dest, IDTYPE idx) {
+    size_t total_msg_size           = get_ipc_msg_duplex_size(sizeof(NS_MSG_TYPE(query)));
+    struct shim_ipc_msg_duplex* msg = __alloca(total_msg_size);
+    init_ipc_msg_duplex(msg, NS_CODE(QUERY), total_msg_size, dest);
+
+    NS_MSG_TYPE(query)* msgin = (void*)&msg->msg.msg;
+    msgin->idx                = idx;
+
+    debug("ipc send to %u: " NS_CODE_STR(QUERY) "(%u)\n", dest, idx);
+
+    return send_ipc_message_duplex(msg, port, NULL, NULL);
+}
+
 int NS_SEND(query)(IDTYPE idx) {
     BEGIN_PROFILE_INTERVAL();
     struct CONCAT2(NS, range) range;
@@ -1347,6 +1500,29 @@ int NS_SEND(query)(IDTYPE idx) {
     if (!CONCAT3(get, NS, range)(idx, &range, NULL))
         goto out;
 
+    /* In leaderless mode, the parent answers first: it knows its own ranges, the IDs subleased to
+     * its children (e.g., the worker processes of a server) and what it has cached itself. */
+    if (leaderless) {
+        IDTYPE parent = 0;
+
+        lock(&cur_process.lock);
+        if (cur_process.parent && cur_process.parent->port) {
+            parent = cur_process.parent->vmid;
+            port   = cur_process.parent->port;
+            get_ipc_port(port);
+        }
+        unlock(&cur_process.lock);
+
+        if (port) {
+            ret = send_query(port, parent, idx);
+            put_ipc_port(port);
+            port = NULL;
+
+            if (!ret && !CONCAT3(get, NS, range)(idx, &range, NULL))
+                goto out;
+        }
+    }
+
     if ((ret = connect_ns(&leader, &port)) < 0)
         goto out;
 
@@ -1355,16 +1531,7 @@ int NS_SEND(query)(IDTYPE idx) {
         goto out;
     }
 
-    size_t total_msg_size           = get_ipc_msg_duplex_size(sizeof(NS_MSG_TYPE(query)));
-    struct shim_ipc_msg_duplex* msg = __alloca(total_msg_size);
-    init_ipc_msg_duplex(msg, NS_CODE(QUERY), total_msg_size, leader);
-
-    NS_MSG_TYPE(query)* msgin = (void*)&msg->msg.msg;
-    msgin->idx                = idx;
-
-    debug("ipc send to %u: " NS_CODE_STR(QUERY) "(%u)\n", leader, idx);
-
-    ret = send_ipc_message_duplex(msg, port, NULL, NULL);
+    ret = send_query(port, leader, idx);
 out:
     if (port)
         put_ipc_port(port);
@@ -1390,18 +1557,67 @@ int NS_CALLBACK(query)(IPC_CALLBACK_ARGS) {
     assert(range.owner);
     assert(!qstrempty(&range.uri));
 
-    struct ipc_ns_offered ans;
-    ans.base                    = range.base;
-    ans.size                    = range.size;
-    ans.lease                   = range.lease;
-    ans.owner_offset            = 0;
-    int ownerdatasz             = sizeof(struct ipc_ns_client) + range.uri.len;
-    struct ipc_ns_client* owner = __alloca(ownerdatasz);
-    owner->vmid                 = range.owner;
-    assert(!qstrempty(&range.uri));
-    memcpy(owner->uri, qstrgetstr(&range.uri), range.uri.len + 1);
+    /* Answer with the whole range and all its subranges, so that the owners of the neighbouring
+     * IDs (e.g., sibling processes) are cached by the querying process in one round trip. */
+    IDTYPE off                       = (msgin->idx - 1) / RANGE_SIZE;
+    IDTYPE base                      = off * RANGE_SIZE + 1;
+    struct ipc_ns_offered* answers   = __alloca(sizeof(struct ipc_ns_offered) * (RANGE_SIZE + 1));
+    struct ipc_ns_client** ownerdata = __alloca(sizeof(struct ipc_ns_client*) * (RANGE_SIZE + 1));
+    int* ownerdatasz                 = __alloca(sizeof(int) * (RANGE_SIZE + 1));
+    int nanswers = 0, owner_offset = 0;
+
+    lock(&range_map_lock);
 
-    ret = NS_SEND(answer)(port, msg->src, 1, &ans, 1, &owner, &ownerdatasz, msg->seq);
+    struct range* r = __get_range(off);
+    if (!r) {
+        unlock(&range_map_lock);
+        ret = -ESRCH;
+        goto out;
+    }
+
+    LEASETYPE now = DkSystemTimeQuery();
+
+    for (int i = -1; i < RANGE_SIZE; i++) {
+        struct shim_ipc_info* p;
+        LEASETYPE lease;
+        bool cached;
+
+        if (i < 0) {
+            p      = r->owner;
+            lease  = r->lease;
+            cached = r->cached;
+        } else {
+            struct subrange* s = r->subranges ? r->subranges->map[i] : NULL;
+            if (!s)
+                continue;
+            p      = s->owner;
+            lease  = s->lease;
+            cached = s->cached;
+        }
+
+        if (!p || qstrempty(&p->uri) || (cached && lease < now))
+            continue;
+
+        int datasz                  = sizeof(struct ipc_ns_client) + p->uri.len;
+        struct ipc_ns_client* owner = __alloca(datasz);
+        owner->vmid                 = p->vmid;
+        memcpy(owner->uri, qstrgetstr(&p->uri), p->uri.len + 1);
+
+        answers[nanswers].base         = i < 0 ? base : base + i;
+        answers[nanswers].size         = i < 0 ? RANGE_SIZE : 1;
+        answers[nanswers].lease        = lease;
+        answers[nanswers].owner_offset = owner_offset;
+        ownerdata[nanswers]            = owner;
+        ownerdatasz[nanswers]          = datasz;
+        nanswers++;
+
+        owner_offset += datasz;
+    }
+
+    unlock(&range_map_lock);
+
+    ret = NS_SEND(answer)(port, msg->src, nanswers, answers, nanswers, ownerdata, ownerdatasz,
+                          msg->seq);
 out:
     SAVE_PROFILE_INTERVAL(NS_CALLBACK(query));
     return ret;
@@ -1455,15 +1671,22 @@ int NS_CALLBACK(queryall)(IPC_CALLBACK_ARGS) {
 
 retry:
     LISTP_FOR_EACH_ENTRY(r, list, list) {
-        struct shim_ipc_info* p     = r->owner;
-        int datasz                  = sizeof(struct ipc_ns_client) + p->uri.len;
-        struct ipc_ns_client* owner = __alloca(datasz);
+        struct shim_ipc_info* p = r->owner;
+        IDTYPE base             = r->offset * RANGE_SIZE + 1;
+        int datasz;
+        struct ipc_ns_client* owner;
+
+        /* ranges which only hold subranges have no owner */
+        if (!p)
+            goto subranges;
+
+        datasz = sizeof(struct ipc_ns_client) + p->uri.len;
+        owner  = __alloca(datasz);
 
         assert(!qstrempty(&p->uri));
         owner->vmid = p->vmid;
         memcpy(owner->uri, qstrgetstr(&p->uri), p->uri.len + 1);
 
-        IDTYPE base                    = r->offset * RANGE_SIZE + 1;
         answers[nanswers].base         = base;
         answers[nanswers].size         = RANGE_SIZE;
         answers[nanswers].lease        = r->lease;
@@ -1476,6 +1699,7 @@ retry:
 
         owner_offset += datasz;
 
+subranges:
         if (!r->subranges)
             continue;
 
@@ -1574,16 +1798,19 @@ int NS_CALLBACK(answer)(IPC_CALLBACK_ARGS) {
         debug("ipc callback from %u: " NS_CODE_STR(ANSWER) "([%u, %u], ...)\n", msg->src,
               msgin->answers[0].base, msgin->answers[0].size);
 
+    /* the leases in the answer are the ones granted by the leader; we cache for CACHE_TIME */
+    LEASETYPE lease = get_cache_lease();
+
     for (int i = 0; i < msgin->nanswers; i++) {
         struct ipc_ns_offered* ans  = &msgin->answers[i];
         struct ipc_ns_client* owner = (void*)msgin + ans->owner_offset;
 
         switch (ans->size) {
             case RANGE_SIZE:
-                CONCAT3(add, NS, range)(ans->base, owner->vmid, owner->uri, ans->lease);
+                CONCAT3(__add, NS, range)(ans->base, owner->vmid, owner->uri, lease, true);
                 break;
             case 1:
-                CONCAT3(add, NS, subrange)(ans->base, owner->vmid, owner->uri, &ans->lease);
+                CONCAT3(__add, NS, subrange)(ans->base, owner->vmid, owner->uri, &lease, true);
                 break;
             default:
                 break;
@@ -32,6 +32,7 @@
 
 #define PID_RANGE_SIZE 32
 #define PID_LEASE_TIME 1000
+#define PID_CACHE_TIME 1000000
 
 #define NS     pid
 #define NS_CAP PID
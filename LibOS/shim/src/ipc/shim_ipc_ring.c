@@ -0,0 +1,412 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_ipc_ring.c
+ *
+ * This file contains the shared-memory transport for IPC messages (enabled with
+ * sys.ipc_shared_memory in the manifest).
+ *
+ * Each IPC port may carry two single-producer/single-consumer rings in host shared memory, one per
+ * direction. The receiving side of a ring creates it in a host file, maps it and offers it to the
+ * peer with IPC_RING_OFFER over the port stream. The peer maps the ring and installs it under
+ * port->msgs_lock, which serializes all sending on the port.
+ *
+ * Messages keep their order although they travel over two channels. Every record in the ring is
+ * tagged with an epoch, and the receiver only takes records whose epoch was announced with
+ * IPC_RING_KICK over the stream, i.e. after it handled all messages sent over the stream before.
+ * The first kick (epoch 1) is sent when the ring is installed. A sender never waits for the ring:
+ * a message which does not fit goes over the stream, and before it handles a stream message, the
+ * receiver drains the ring, which holds the messages sent before. After such a fallback, the sender
+ * starts a new epoch with another kick before it puts messages into the ring again.
+ *
+ * Only the IPC helper thread consumes the rings, handling the messages in place. Before the helper
+ * blocks on the port streams, it sets the `waiting` flag of each ring; a producer which finds the
+ * flag set clears it and rings the "doorbell", i.e. sends IPC_RING_KICK over the stream. The host
+ * streams (which the IPC helper waits on anyway) thus play the role of a futex, and are only
+ * touched when the receiver actually sleeps.
+ */
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_utils.h>
+#include <shim_vma.h>
+
+#define IPC_RING_SIZE   (64 * 1024) /* must be a power of two */
+#define IPC_RING_MAGIC  0x676e697263706967UL /* "gipcring" */
+
+struct shim_ipc_ring {
+    unsigned long magic;
+    unsigned long size;
+
+    /* written by the producer */
+    unsigned long head __attribute__((aligned(64)));
+
+    /* written by the consumer; the producer clears `waiting` when it rings the doorbell */
+    unsigned long tail __attribute__((aligned(64)));
+    unsigned int waiting;
+
+    char data[] __attribute__((aligned(64)));
+};
+
+/* each message in the ring is preceded by its padded length (zero means "wrap around") and the
+ * epoch it was sent in */
+struct ring_rec_hdr {
+    unsigned int size;
+    unsigned int epoch;
+};
+
+#define RING_REC_HDR    sizeof(struct ring_rec_hdr)
+#define RING_REC_SIZE(msg_size) (RING_REC_HDR + ALIGN_UP((msg_size), RING_REC_HDR))
+
+#define RING_MAP_FLAGS  (MAP_SHARED|MAP_ANONYMOUS|VMA_INTERNAL)
+
+static bool use_ipc_rings;
+
+int init_ipc_rings(void) {
+    char cfg[2];
+
+    if (!root_config)
+        return 0;
+
+    /* memory mapped from host files is not shared between enclaves */
+    if (!strcmp_static(PAL_CB(host_type), "Linux-SGX"))
+        return 0;
+
+    ssize_t len = get_config(root_config, "sys.ipc_shared_memory", cfg, sizeof(cfg));
+    use_ipc_rings = (len == 1 && cfg[0] == '1');
+    return 0;
+}
+
+static size_t ipc_ring_map_size(void) {
+    return ALLOC_ALIGN_UP(sizeof(struct shim_ipc_ring) + IPC_RING_SIZE);
+}
+
+static struct shim_ipc_ring* map_ipc_ring(PAL_HANDLE file) {
+    size_t size = ipc_ring_map_size();
+
+    void* addr = bkeep_unmapped_any(size, PROT_READ|PROT_WRITE, RING_MAP_FLAGS, 0, "ipc ring");
+    if (!addr)
+        return NULL;
+
+    void* mapped = DkStreamMap(file, addr, PAL_PROT_READ|PAL_PROT_WRITE, 0, size);
+    if (!mapped) {
+        bkeep_munmap(addr, size, RING_MAP_FLAGS);
+        return NULL;
+    }
+
+    assert(mapped == addr);
+    return addr;
+}
+
+static void unmap_ipc_ring(struct shim_ipc_ring* ring) {
+    size_t size = ipc_ring_map_size();
+
+    DkStreamUnmap(ring, size);
+    bkeep_munmap(ring, size, RING_MAP_FLAGS);
+}
+
+/* Create the ring for messages from the peer of `port` and offer it over the port stream. Called by
+ * the IPC helper once for each port it listens on. */
+int ipc_ring_offer_send(struct shim_ipc_port* port) {
+    int ret;
+
+    if (!use_ipc_rings || port->ring_in)
+        return 0;
+
+    unsigned long rand;
+    ret = DkRandomBitsRead(&rand, sizeof(rand));
+    if (ret < 0)
+        return -convert_pal_errno(-ret);
+
+    char uri[64];
+    size_t len = snprintf(uri, sizeof(uri), URI_PREFIX_FILE "/dev/shm/graphene-ipc-%016lx", rand);
+    if (len >= sizeof(uri))
+        return -ERANGE;
+
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, PAL_SHARE_OWNER_R|PAL_SHARE_OWNER_W,
+                                   PAL_CREATE_ALWAYS, 0);
+    if (!file)
+        return -PAL_ERRNO;
+
+    PAL_NUM rv = DkStreamSetLength(file, ipc_ring_map_size());
+    if (rv) {
+        ret = -((int)rv);
+        goto err;
+    }
+
+    struct shim_ipc_ring* ring = map_ipc_ring(file);
+    if (!ring) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    ring->size    = IPC_RING_SIZE;
+    ring->head    = 0;
+    ring->tail    = 0;
+    ring->waiting = 0;
+    ring->magic   = IPC_RING_MAGIC;
+
+    port->ring_in      = ring;
+    port->ring_in_file = file;
+
+    size_t total_msg_size    = get_ipc_msg_size(sizeof(struct shim_ipc_ring_offer) + len + 1);
+    struct shim_ipc_msg* msg = __alloca(total_msg_size);
+    init_ipc_msg(msg, IPC_RING_OFFER, total_msg_size, port->vmid);
+
+    struct shim_ipc_ring_offer* msgin = (struct shim_ipc_ring_offer*)&msg->msg;
+    memcpy(msgin->uri, uri, len + 1);
+
+    debug("IPC send to %u: IPC_RING_OFFER(%s)\n", port->vmid & 0xFFFF, uri);
+    /* the ring stays unused if the offer is not taken; it is released with the port */
+    return send_ipc_message_stream(msg, port);
+
+err:
+    DkStreamDelete(file, 0);
+    DkObjectClose(file);
+    return ret;
+}
+
+/* should be called with port->msgs_lock held */
+static int send_ipc_ring_kick(struct shim_ipc_port* port) {
+    assert(locked(&port->msgs_lock));
+
+    size_t total_msg_size    = get_ipc_msg_size(sizeof(struct shim_ipc_ring_kick));
+    struct shim_ipc_msg* msg = __alloca(total_msg_size);
+    init_ipc_msg(msg, IPC_RING_KICK, total_msg_size, port->vmid);
+
+    struct shim_ipc_ring_kick* msgin = (struct shim_ipc_ring_kick*)&msg->msg;
+    msgin->epoch = port->ring_out_epoch;
+    return __send_ipc_message_stream(msg, port);
+}
+
+/* The peer offers a ring for our messages: map it and switch sending on this port to the ring. */
+int ipc_ring_offer_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    struct shim_ipc_ring_offer* msgin = (struct shim_ipc_ring_offer*)&msg->msg;
+    int ret = 0;
+
+    debug("IPC callback from %u: IPC_RING_OFFER(%s)\n", msg->src & 0xFFFF, msgin->uri);
+
+    if (!use_ipc_rings || port->ring_out)
+        return 0;
+
+    PAL_HANDLE file = DkStreamOpen(msgin->uri, PAL_ACCESS_RDWR, 0, 0, 0);
+    if (!file)
+        return -PAL_ERRNO;
+
+    struct shim_ipc_ring* ring = map_ipc_ring(file);
+    DkObjectClose(file);
+    if (!ring)
+        return -ENOMEM;
+
+    if (ring->magic != IPC_RING_MAGIC || ring->size != IPC_RING_SIZE) {
+        unmap_ipc_ring(ring);
+        return -EINVAL;
+    }
+
+    /* the kick is ordered after all messages sent over the stream so far */
+    lock(&port->msgs_lock);
+    if (port->ring_out) {
+        unlock(&port->msgs_lock);
+        unmap_ipc_ring(ring);
+        return 0;
+    }
+    port->ring_out_epoch  = 1;
+    port->ring_out_paused = false;
+    ret = send_ipc_ring_kick(port);
+    if (ret < 0) {
+        unlock(&port->msgs_lock);
+        unmap_ipc_ring(ring);
+        del_ipc_port_fini(port, -ECHILD);
+        return ret;
+    }
+    port->ring_out = ring;
+    unlock(&port->msgs_lock);
+    return 0;
+}
+
+/* The peer (re)starts using the ring, or we are woken up to drain the ring. All messages the peer
+ * sent over the stream before this kick are handled, so the records of the announced epoch can be
+ * taken from the ring. */
+int ipc_ring_kick_callback(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    struct shim_ipc_ring_kick* msgin = (struct shim_ipc_ring_kick*)&msg->msg;
+
+    if (!port->ring_in)
+        return 0;
+
+    if (msgin->epoch > port->ring_in_epoch)
+        port->ring_in_epoch = msgin->epoch;
+
+    if (port->ring_in_file) {
+        debug("IPC ring of port %p (handle %p) attached by %u\n", port, port->pal_handle,
+              msg->src & 0xFFFF);
+        /* the peer has the ring mapped, so the backing file is no longer needed */
+        DkStreamDelete(port->ring_in_file, 0);
+        DkObjectClose(port->ring_in_file);
+        port->ring_in_file = NULL;
+    }
+
+    return 0;
+}
+
+/* Put `msg` into the ring of `port`. Returns -EAGAIN if the ring is full or `msg` is too large for
+ * it; the caller then sends `msg` over the stream. Should be called with port->msgs_lock held. */
+int ipc_ring_send(struct shim_ipc_msg* msg, struct shim_ipc_port* port) {
+    assert(locked(&port->msgs_lock));
+
+    struct shim_ipc_ring* ring = port->ring_out;
+    size_t rec_size = RING_REC_SIZE(msg->size);
+    int ret = 0;
+
+    unsigned long head = ring->head;
+    size_t off = head & (IPC_RING_SIZE - 1);
+    size_t skip = (off + rec_size > IPC_RING_SIZE) ? IPC_RING_SIZE - off : 0;
+
+    if (rec_size > IPC_RING_SIZE / 2 ||
+        head + skip + rec_size - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > IPC_RING_SIZE) {
+        /* the receiver drains the ring before it handles the message from the stream */
+        if (__atomic_exchange_n(&ring->waiting, 0, __ATOMIC_ACQ_REL))
+            send_ipc_ring_kick(port);
+        port->ring_out_paused = true;
+        return -EAGAIN;
+    }
+
+    if (port->ring_out_paused) {
+        /* the messages sent over the stream meanwhile must be handled first */
+        port->ring_out_epoch++;
+        if ((ret = send_ipc_ring_kick(port)) < 0)
+            return ret;
+        port->ring_out_paused = false;
+    }
+
+    if (skip) {
+        ((struct ring_rec_hdr*)&ring->data[off])->size = 0;
+        head += skip;
+        off = 0;
+    }
+
+    struct ring_rec_hdr* rec = (struct ring_rec_hdr*)&ring->data[off];
+    rec->size  = rec_size;
+    rec->epoch = port->ring_out_epoch;
+    memcpy(&ring->data[off + RING_REC_HDR], msg, msg->size);
+    __atomic_store_n(&ring->head, head + rec_size, __ATOMIC_RELEASE);
+
+    /* pairs with the fence in ipc_ring_arm() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&ring->waiting, 0, __ATOMIC_ACQ_REL))
+        ret = send_ipc_ring_kick(port);
+    return ret;
+}
+
+/* Return the oldest message in the ring of `port` without removing it; returns 0 if the ring is
+ * empty, not used yet, or the message belongs to an epoch not announced yet. A malformed record
+ * yields -EINVAL. */
+int ipc_ring_peek(struct shim_ipc_port* port, struct shim_ipc_msg** msg) {
+    struct shim_ipc_ring* ring = port->ring_in;
+
+    /* messages go to the ring only after the first kick */
+    if (!ring || !port->ring_in_epoch)
+        return 0;
+
+    unsigned long tail = ring->tail;
+    unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return 0;
+
+    size_t off = tail & (IPC_RING_SIZE - 1);
+    struct ring_rec_hdr* rec = (struct ring_rec_hdr*)&ring->data[off];
+    if (!rec->size) {
+        /* wrap around */
+        tail += IPC_RING_SIZE - off;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        if (head == tail)
+            return 0;
+        off = 0;
+        rec = (struct ring_rec_hdr*)&ring->data[0];
+    }
+
+    /* the peer sent messages over the stream before this one; wait for its next kick */
+    if (rec->epoch > port->ring_in_epoch)
+        return 0;
+
+    size_t rec_size = rec->size;
+
+    struct shim_ipc_msg* m = (struct shim_ipc_msg*)&ring->data[off + RING_REC_HDR];
+    if (rec_size > head - tail || rec_size > IPC_RING_SIZE - off ||
+        m->size < IPC_MSG_MINIMAL_SIZE || RING_REC_SIZE(m->size) != rec_size)
+        return -EINVAL;
+
+    *msg = m;
+    return 1;
+}
+
+/* Remove the message returned by ipc_ring_peek() from the ring. */
+void ipc_ring_consume(struct shim_ipc_port* port, struct shim_ipc_msg* msg) {
+    struct shim_ipc_ring* ring = port->ring_in;
+    __atomic_store_n(&ring->tail, ring->tail + RING_REC_SIZE(msg->size), __ATOMIC_RELEASE);
+}
+
+/* Return true if there is a message in the ring of `port` which can be handled now. Messages of an
+ * epoch not announced yet are not counted: their kick is on the way over the stream. */
+bool ipc_ring_pending(struct shim_ipc_port* port) {
+    struct shim_ipc_msg* msg;
+    return ipc_ring_peek(port, &msg) != 0;
+}
+
+/* Tell the producer that the IPC helper is about to sleep on the stream of `port`. Returns false if
+ * the ring is not empty anymore, so the helper must not sleep. */
+bool ipc_ring_arm(struct shim_ipc_port* port) {
+    struct shim_ipc_ring* ring = port->ring_in;
+
+    if (!ring || !port->ring_in_epoch)
+        return true;
+
+    __atomic_store_n(&ring->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return !ipc_ring_pending(port);
+}
+
+void ipc_ring_disarm(struct shim_ipc_port* port) {
+    struct shim_ipc_ring* ring = port->ring_in;
+
+    if (ring && port->ring_in_epoch)
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+}
+
+void ipc_ring_fini(struct shim_ipc_port* port) {
+    if (port->ring_in_file) {
+        DkStreamDelete(port->ring_in_file, 0);
+        DkObjectClose(port->ring_in_file);
+        port->ring_in_file = NULL;
+    }
+
+    if (port->ring_in) {
+        unmap_ipc_ring(port->ring_in);
+        port->ring_in = NULL;
+    }
+
+    if (port->ring_out) {
+        unmap_ipc_ring(port->ring_out);
+        port->ring_out = NULL;
+    }
+}
+
+bool ipc_rings_enabled(void) {
+    return use_ipc_rings;
+}
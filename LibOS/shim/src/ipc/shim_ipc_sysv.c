@@ -31,6 +31,7 @@
 
 #define SYSV_RANGE_SIZE 128
 #define SYSV_LEASE_TIME 1000
+#define SYSV_CACHE_TIME 1000000
 
 #define KEY_HASH(k)      ((k)->key)
 #define KEY_COMP(k1, k2) ((k1)->key != (k2)->key || (k1)->type != (k2)->type)
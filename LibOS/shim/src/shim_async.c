@@ -37,6 +37,7 @@ struct async_event {
     void* arg;
     PAL_HANDLE object;     /* handle (async IO) to wait on */
     uint64_t expire_time;  /* alarm/timer to wait on */
+    bool is_alarm;         /* alarm() or setitimer(): cancelled by the next one installed */
 };
 DEFINE_LISTP(async_event);
 static LISTP_TYPE(async_event) async_list;
@@ -66,8 +67,9 @@ static int create_async_helper(void);
  * Function returns remaining usecs for alarm/timer events (same as alarm())
  * or 0 for async IO events. On error, it returns a negated error code.
  */
-int64_t install_async_event(PAL_HANDLE object, uint64_t time,
-                            void (*callback)(IDTYPE caller, void* arg), void* arg) {
+static int64_t __install_async_event(PAL_HANDLE object, uint64_t time,
+                                     void (*callback)(IDTYPE caller, void* arg), void* arg,
+                                     bool is_alarm) {
     /* if event happens on object, time must be zero */
     assert(!object || (object && !time));
 
@@ -88,16 +90,17 @@ int64_t install_async_event(PAL_HANDLE object, uint64_t time,
     event->caller             = get_cur_tid();
     event->object             = object;
     event->expire_time        = time ? now + time : 0;
+    event->is_alarm           = is_alarm;
 
     lock(&async_helper_lock);
 
-    if (callback != &cleanup_thread && !object) {
+    if (is_alarm) {
         /* This is alarm() or setitimer() emulation, treat both according to
          * alarm() syscall semantics: cancel any pending alarm/timer. */
         struct async_event* tmp;
         struct async_event* n;
         LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            if (tmp->expire_time) {
+            if (tmp->is_alarm) {
                 /* this is a pending alarm/timer, cancel it and save its expiration time */
                 if (max_prev_expire_time < tmp->expire_time)
                     max_prev_expire_time = tmp->expire_time;
@@ -134,6 +137,35 @@ int64_t install_async_event(PAL_HANDLE object, uint64_t time,
     return max_prev_expire_time - now;
 }
 
+int64_t install_async_event(PAL_HANDLE object, uint64_t time,
+                            void (*callback)(IDTYPE caller, void* arg), void* arg) {
+    return __install_async_event(object, time, callback, arg,
+                                 callback != &cleanup_thread && !object);
+}
+
+/* Installs a one-shot timer firing after `time` usecs. Unlike install_async_event(), it does not
+ * cancel other pending timers, so any number of them may coexist (used by timerfd). */
+int install_async_timer(uint64_t time, void (*callback)(IDTYPE caller, void* arg), void* arg) {
+    assert(time);
+    int64_t ret = __install_async_event(NULL, time, callback, arg, /*is_alarm=*/false);
+    return ret < 0 ? (int)ret : 0;
+}
+
+/* Cancels pending timers installed by install_async_timer() with the same `callback` and `arg`.
+ * Timers already handed over to the callback are not affected. */
+void cancel_async_timer(void (*callback)(IDTYPE caller, void* arg), void* arg) {
+    lock(&async_helper_lock);
+    struct async_event* tmp;
+    struct async_event* n;
+    LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
+        if (tmp->expire_time && !tmp->is_alarm && tmp->callback == callback && tmp->arg == arg) {
+            LISTP_DEL(tmp, &async_list, list);
+            free(tmp);
+        }
+    }
+    unlock(&async_helper_lock);
+}
+
 int init_async(void) {
     /* early enough in init, can write global vars without the lock */
     async_helper_state = HELPER_NOTALIVE;
@@ -290,6 +322,9 @@ static void shim_async_helper(void* arg) {
         /* wait on async IO events + install_new_event + next expiring alarm/timer */
         PAL_BOL polled = DkStreamsWaitEvents(pals_cnt + 1, pals, pal_events, ret_events, sleep_time);
 
+        /* piggyback on the wakeup to keep the TSC clock anchored to the host clocks */
+        update_tsc_clock();
+
         now = DkSystemTimeQuery();
         if ((int64_t)now < 0) {
             debug("DkSystemTimeQuery failed with: %ld\n", (int64_t)now);
@@ -215,12 +215,31 @@ END_CP_FUNC(palhdl)
 BEGIN_RS_FUNC(palhdl)
 {
     __UNUSED(offset);
-    __UNUSED(rebase);
 
     struct shim_palhdl_entry * ent = (void *) (base + GET_CP_FUNC_ENTRY());
 
-    if (ent->phandle && !ent->phandle && ent->uri) {
-        /* XXX: reopen the stream */
+    /* ent->uri points to the qstr of the object owning the handle, which is
+     * checkpointed (and its oflow string restored) before this entry */
+    CP_REBASE(ent->uri);
+
+    if (ent->phandle && !*ent->phandle && ent->uri) {
+        /* The handle was not passed by the parent (e.g., restoring from a snapshot file), so
+         * reopen the stream by its URI. Only files and devices can be reopened this way;
+         * pipes and sockets are left closed. */
+        const char * uri = qstrgetstr(ent->uri);
+        if (!strstartswith_static(uri, URI_PREFIX_FILE) &&
+            !strstartswith_static(uri, URI_PREFIX_DEV)) {
+            debug("cannot reopen stream %s, leaving it closed\n", uri);
+            return 0;
+        }
+
+        PAL_HANDLE hdl = DkStreamOpen(uri, PAL_ACCESS_RDWR, 0, 0, 0);
+        if (!hdl)
+            hdl = DkStreamOpen(uri, PAL_ACCESS_RDONLY, 0, 0, 0);
+        if (!hdl)
+            debug("failed reopening stream %s (ignored)\n", uri);
+
+        *ent->phandle = hdl;
     }
 }
 END_RS_FUNC(palhdl)
@@ -333,11 +352,223 @@ BEGIN_RS_FUNC(qstr)
 }
 END_RS_FUNC(qstr)
 
+/*
+ * The memory regions follow the checkpoint data on the stream, in the order
+ * of their entries, as chunks. Runs of zero pages are not sent at all, and
+ * with "sys.compress_checkpoint = 1" in the manifest other chunks are
+ * compressed with LZ4 if that makes them smaller.
+ */
+struct shim_mem_chunk {
+    uint32_t size;   /* bytes of memory in the chunk */
+    uint32_t csize;  /* bytes that follow: 0 for zero pages, or size if the
+                        chunk is not compressed */
+};
+
+#define CP_MAX_CHUNK_SIZE   (1UL << 30)
+
+static int compress_enabled = -1;
+
+static bool checkpoint_compression_enabled (void)
+{
+    if (compress_enabled < 0) {
+        if (!root_config)
+            return false;
+
+        char cfg[2];
+        ssize_t len = get_config(root_config, "sys.compress_checkpoint",
+                                 cfg, sizeof(cfg));
+        compress_enabled = (len == 1 && cfg[0] == '1');
+    }
+
+    return compress_enabled;
+}
+
+static int write_to_stream (PAL_HANDLE stream, PAL_NUM * stream_off,
+                            const void * buf, size_t size)
+{
+    size_t bytes = 0;
+
+    while (bytes < size) {
+        PAL_NUM ret = DkStreamWrite(stream, stream_off ? *stream_off : 0,
+                                    size - bytes, (void *) buf + bytes, NULL);
+
+        if (ret == PAL_STREAM_ERROR) {
+            if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN ||
+                PAL_ERRNO == EWOULDBLOCK)
+                continue;
+            return -PAL_ERRNO;
+        }
+
+        bytes += ret;
+        if (stream_off)
+            *stream_off += ret;
+    }
+
+    ADD_PROFILE_OCCURENCE(migrate_send_on_stream, size);
+    return 0;
+}
+
+static int read_from_stream (PAL_HANDLE stream, PAL_NUM * stream_off,
+                             void * buf, size_t size)
+{
+    size_t bytes = 0;
+
+    while (bytes < size) {
+        PAL_NUM ret = DkStreamRead(stream, stream_off ? *stream_off : 0,
+                                   size - bytes, buf + bytes, NULL, 0);
+
+        if (ret == PAL_STREAM_ERROR) {
+            if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN ||
+                PAL_ERRNO == EWOULDBLOCK)
+                continue;
+            return -PAL_ERRNO;
+        }
+
+        if (!ret)
+            return -EIO;
+
+        bytes += ret;
+        if (stream_off)
+            *stream_off += ret;
+    }
+
+    return 0;
+}
+
+static bool is_zero_memory (const void * addr, size_t size)
+{
+    const unsigned long * p = addr;
+
+    for (; size >= sizeof(*p) ; size -= sizeof(*p))
+        if (*p++)
+            return false;
+
+    for (const char * c = (const char *) p ; size ; size--)
+        if (*c++)
+            return false;
+
+    return true;
+}
+
+/*
+ * Send a memory region in chunks. Pages are scanned one by one, so that a
+ * run of zero pages becomes a chunk without data. If @cbuf is given, chunks
+ * with data are at most LZ4_MAX_INPUT bytes and compressed into @cbuf.
+ */
+static int send_memory_on_stream (PAL_HANDLE stream, PAL_NUM * stream_off,
+                                  void * addr, size_t size, void * cbuf)
+{
+    size_t max_chunk = cbuf ? LZ4_MAX_INPUT : CP_MAX_CHUNK_SIZE;
+    void * end = addr + size;
+    int ret;
+
+    while (addr < end) {
+        struct shim_mem_chunk chunk;
+        void * start = addr;
+        bool zero = true;
+
+        while (addr < end) {
+            size_t limit = zero ? CP_MAX_CHUNK_SIZE : max_chunk;
+            if ((size_t) (addr - start) >= limit)
+                break;
+
+            size_t piece = ALLOC_ALIGNMENT;
+            if (piece > (size_t) (end - addr))
+                piece = end - addr;
+            if (piece > limit - (addr - start))
+                piece = limit - (addr - start);
+
+            bool piece_zero = is_zero_memory(addr, piece);
+            if (addr > start && piece_zero != zero)
+                break;
+
+            zero = piece_zero;
+            addr += piece;
+        }
+
+        chunk.size  = addr - start;
+        chunk.csize = zero ? 0 : chunk.size;
+
+        if (!zero && cbuf) {
+            size_t csize = lz4_compress(start, chunk.size, cbuf,
+                                        chunk.size - 1);
+            if (csize)
+                chunk.csize = csize;
+        }
+
+        if ((ret = write_to_stream(stream, stream_off, &chunk,
+                                   sizeof(chunk))) < 0)
+            return ret;
+
+        if (chunk.csize &&
+            (ret = write_to_stream(stream, stream_off,
+                                   chunk.csize < chunk.size ? cbuf : start,
+                                   chunk.csize)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Receive a memory region sent by send_memory_on_stream(). The region has
+ * just been allocated, so chunks of zero pages are skipped.
+ */
+static int receive_memory_on_stream (PAL_HANDLE stream, PAL_NUM * stream_off,
+                                     void * addr, size_t size, void ** cbuf)
+{
+    int ret;
+
+    while (size) {
+        struct shim_mem_chunk chunk;
+
+        if ((ret = read_from_stream(stream, stream_off, &chunk,
+                                    sizeof(chunk))) < 0)
+            return ret;
+
+        if (!chunk.size || chunk.size > size || chunk.csize > chunk.size)
+            return -EINVAL;
+
+        if (chunk.csize == chunk.size) {
+            if ((ret = read_from_stream(stream, stream_off, addr,
+                                        chunk.size)) < 0)
+                return ret;
+        } else if (chunk.csize) {
+            if (chunk.size > LZ4_MAX_INPUT)
+                return -EINVAL;
+
+            if (!*cbuf && !(*cbuf = malloc(LZ4_MAX_INPUT)))
+                return -ENOMEM;
+
+            if ((ret = read_from_stream(stream, stream_off, *cbuf,
+                                        chunk.csize)) < 0)
+                return ret;
+
+            if ((ret = lz4_decompress(*cbuf, chunk.csize, addr,
+                                      chunk.size)) < 0)
+                return ret;
+        }
+
+        addr += chunk.size;
+        size -= chunk.size;
+    }
+
+    return 0;
+}
+
+/*
+ * Send the checkpoint data and the memory regions on a stream.
+ *
+ * @stream_off: NULL for pipe-like streams; for seekable streams (files), the offset to write at,
+ *              which is advanced past the written data.
+ */
 static int send_checkpoint_on_stream (PAL_HANDLE stream,
-                                      struct shim_cp_store * store)
+                                      struct shim_cp_store * store,
+                                      PAL_NUM * stream_off)
 {
     int mem_nentries = store->mem_nentries;
     struct shim_mem_entry ** mem_entries;
+    int ret;
 
     if (mem_nentries) {
         mem_entries = __alloca(sizeof(struct shim_mem_entry *) * mem_nentries);
@@ -361,24 +592,14 @@ static int send_checkpoint_on_stream (PAL_HANDLE stream,
         }
     }
 
-    size_t total_bytes = store->offset;
-    size_t bytes = 0;
-
-    do {
-        PAL_NUM ret = DkStreamWrite(stream, 0, total_bytes - bytes,
-                                   (void *) store->base + bytes, NULL);
-
-        if (ret == PAL_STREAM_ERROR) {
-            if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN ||
-                PAL_ERRNO == EWOULDBLOCK)
-                continue;
-            return -PAL_ERRNO;
-        }
-
-        bytes += ret;
-    } while (bytes < total_bytes);
+    if ((ret = write_to_stream(stream, stream_off, (void *) store->base,
+                               store->offset)) < 0)
+        return ret;
 
-    ADD_PROFILE_OCCURENCE(migrate_send_on_stream, total_bytes);
+    void * cbuf = NULL;
+    if (mem_nentries && checkpoint_compression_enabled() &&
+        !(cbuf = malloc(LZ4_MAX_INPUT)))
+        return -ENOMEM;
 
     for (int i = 0 ; i < mem_nentries ; i++) {
         size_t mem_size = mem_entries[i]->size;
@@ -386,42 +607,122 @@ static int send_checkpoint_on_stream (PAL_HANDLE stream,
 
         if (!(mem_entries[i]->prot & PAL_PROT_READ) && mem_size > 0) {
             /* Make the area readable */
-            if (!DkVirtualMemoryProtect(mem_addr, mem_size, mem_entries[i]->prot | PAL_PROT_READ))
-                return -PAL_ERRNO;
-        }
-
-        bytes = 0;
-        int error = 0;
-        do {
-            PAL_NUM ret = DkStreamWrite(stream, 0, mem_size - bytes,
-                                       mem_addr + bytes, NULL);
-            if (ret == PAL_STREAM_ERROR) {
-                if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN ||
-                    PAL_ERRNO == EWOULDBLOCK)
-                    continue;
-                error = -PAL_ERRNO;
+            if (!DkVirtualMemoryProtect(mem_addr, mem_size, mem_entries[i]->prot | PAL_PROT_READ)) {
+                ret = -PAL_ERRNO;
                 break;
             }
+        }
 
-            bytes += ret;
-        } while (bytes < mem_entries[i]->size);
+        ret = send_memory_on_stream(stream, stream_off, mem_addr, mem_size, cbuf);
 
         if (!(mem_entries[i]->prot & PAL_PROT_READ) && mem_size > 0) {
             /* the area was made readable above; revert to original permissions */
             if (!DkVirtualMemoryProtect(mem_addr, mem_size, mem_entries[i]->prot)) {
-                if (!error) {
-                    error = -PAL_ERRNO;
+                if (!ret) {
+                    ret = -PAL_ERRNO;
                 }
             }
         }
-        if (error < 0)
-            return error;
+        if (ret < 0)
+            break;
+    }
 
-        mem_entries[i]->size = mem_size;
-        ADD_PROFILE_OCCURENCE(migrate_send_on_stream, mem_size);
+    free(cbuf);
+    return ret;
+}
+
+/*
+ * Receive the checkpoint data and the memory regions sent by
+ * send_checkpoint_on_stream() into @base. Each memory region is restored in
+ * place as soon as it arrives, while the sender is still sending the next
+ * ones; restore_checkpoint() only handles the regions kept in the checkpoint.
+ *
+ * @stream_off: same as for send_checkpoint_on_stream()
+ * @in_place: if false, all memory regions are kept in the checkpoint (e.g.,
+ *            for the snapshots an incremental snapshot was taken after)
+ */
+static int receive_checkpoint_on_stream (PAL_HANDLE stream,
+                                         struct newproc_cp_header * hdr,
+                                         void * base, PAL_NUM * stream_off,
+                                         bool in_place)
+{
+    long rebase = (long) ((uintptr_t) base - (uintptr_t) hdr->hdr.addr);
+    int mem_nentries = hdr->mem.nentries;
+    int ret;
+
+    if (hdr->mem.dataoffset > hdr->hdr.size)
+        return -EINVAL;
+
+    if ((ret = read_from_stream(stream, stream_off, base,
+                                hdr->mem.dataoffset)) < 0)
+        return ret;
+
+    if (!mem_nentries)
+        return 0;
+
+    struct shim_mem_entry ** mem_entries =
+            malloc(sizeof(struct shim_mem_entry *) * mem_nentries);
+    if (!mem_entries)
+        return -ENOMEM;
+
+    struct shim_mem_entry * entry = base + hdr->mem.entoffset;
+    for (int i = mem_nentries - 1 ; i >= 0 ; i--) {
+        if (!entry) {
+            free(mem_entries);
+            return -EINVAL;
+        }
+        mem_entries[i] = entry;
+        entry = entry->prev ? (void *) entry->prev + rebase : NULL;
     }
 
-    return 0;
+    void * cbuf = NULL;
+    for (int i = 0 ; i < mem_nentries ; i++) {
+        entry = mem_entries[i];
+
+        if (entry->paddr || !in_place) {
+            /* kept in the checkpoint, where the sender reserved space */
+            void * data = entry->data + rebase;
+            if (data < base + hdr->mem.dataoffset ||
+                data + entry->size > base + hdr->hdr.size) {
+                ret = -EINVAL;
+                break;
+            }
+
+            if ((ret = receive_memory_on_stream(stream, stream_off, data,
+                                                entry->size, &cbuf)) < 0)
+                break;
+            continue;
+        }
+
+        PAL_PTR addr = ALLOC_ALIGN_DOWN_PTR(entry->addr);
+        PAL_NUM size = ALLOC_ALIGN_UP_PTR(entry->addr + entry->size) - (void*)addr;
+        PAL_FLG prot = entry->prot;
+
+        debug("memory entry [%p]: %p-%p\n", entry, entry->addr,
+              entry->addr + entry->size);
+
+        if (!DkVirtualMemoryAlloc(addr, size, 0, prot|PAL_PROT_WRITE)) {
+            debug("failed allocating %p-%p\n", addr, addr + size);
+            ret = -PAL_ERRNO;
+            break;
+        }
+
+        if ((ret = receive_memory_on_stream(stream, stream_off, entry->addr,
+                                            entry->size, &cbuf)) < 0)
+            break;
+
+        if (!(entry->prot & PAL_PROT_WRITE) &&
+            !DkVirtualMemoryProtect(addr, size, prot)) {
+            debug("failed protecting %p-%p (ignored)\n", addr, addr + size);
+        }
+
+        /* restored already */
+        entry->data = NULL;
+    }
+
+    free(cbuf);
+    free(mem_entries);
+    return ret;
 }
 
 int restore_checkpoint (struct cp_header * cphdr, struct mem_header * memhdr,
@@ -449,7 +750,7 @@ int restore_checkpoint (struct cp_header * cphdr, struct mem_header * memhdr,
 
             if (entry->paddr) {
                 *entry->paddr = entry->data;
-            } else {
+            } else if (entry->data) {
                 debug("memory entry [%p]: %p-%p\n", entry, entry->addr,
                       entry->addr + entry->size);
 
@@ -599,6 +900,287 @@ out:
     return ret;
 }
 
+/*
+ * The snapshots an incremental snapshot was taken after, oldest first. They
+ * are kept in memory until the checkpoint is restored, to fill the anonymous
+ * memory which was not written since (see restore_snapshot_chain()).
+ */
+struct snapshot_link {
+    struct snapshot_link * next;
+    struct newproc_cp_header checkpoint;
+    void * base;
+    PAL_PTR mapaddr;
+    PAL_NUM mapsize;
+};
+
+static struct snapshot_link * snapshot_chain;
+static struct snapshot_link ** snapshot_chain_tail = &snapshot_chain;
+
+/* The snapshot written or restored last, after which the pages written are
+ * tracked; empty if there is none, or if the writes are not tracked. */
+static char last_snapshot_uri[SNAPSHOT_URI_MAX];
+static unsigned long last_snapshot_depth;
+
+static int incremental_enabled = -1;
+
+static bool incremental_snapshot_enabled (void)
+{
+    if (incremental_enabled < 0) {
+        if (!root_config)
+            return false;
+
+        char cfg[2];
+        ssize_t len = get_config(root_config, "sys.incremental_snapshot",
+                                 cfg, sizeof(cfg));
+        incremental_enabled = (len == 1 && cfg[0] == '1');
+    }
+
+    return incremental_enabled;
+}
+
+static void free_snapshot_chain (void)
+{
+    struct snapshot_link * link = snapshot_chain;
+
+    while (link) {
+        struct snapshot_link * next = link->next;
+        DkVirtualMemoryFree(link->mapaddr, link->mapsize);
+        bkeep_munmap((void *) link->mapaddr, link->mapsize, CP_VMA_FLAGS);
+        free(link);
+        link = next;
+    }
+
+    snapshot_chain = NULL;
+    snapshot_chain_tail = &snapshot_chain;
+}
+
+/*
+ * Load the checkpoint data of a snapshot file written by do_snapshot_process().
+ * If it is an incremental snapshot, the snapshots it was taken after are
+ * loaded first, and added to snapshot_chain.
+ *
+ * @uri: host URI of the snapshot file
+ * @depth: number of snapshots expected before this one, or -1 if any
+ * @in_place: restore the memory regions in place (see
+ *            receive_checkpoint_on_stream())
+ * @hdr: returning the checkpoint header
+ * @baseptr: returning the pointer of the loaded checkpoint
+ * @mapaddrptr, @mapsizeptr: returning the memory holding the checkpoint
+ * @depthptr: returning the number of snapshots before this one
+ */
+static int load_snapshot (const char * uri, long depth, bool in_place,
+                          struct newproc_cp_header * hdr, void ** baseptr,
+                          PAL_PTR * mapaddrptr, PAL_NUM * mapsizeptr,
+                          unsigned long * depthptr)
+{
+    struct snapshot_header snap;
+    void * base = NULL;
+    PAL_PTR mapaddr = NULL;
+    PAL_NUM mapsize = 0;
+    int ret = 0;
+
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDONLY, 0, 0, 0);
+    if (!file)
+        return -PAL_ERRNO;
+
+    PAL_NUM bytes = DkStreamRead(file, 0, sizeof(snap), &snap, NULL, 0);
+    if (bytes == PAL_STREAM_ERROR) {
+        ret = -PAL_ERRNO;
+        goto out;
+    }
+
+    if (bytes < sizeof(snap) || snap.magic != SNAPSHOT_MAGIC ||
+        !IS_ALLOC_ALIGNED(snap.data_offset) || !snap.checkpoint.hdr.size ||
+        snap.parent[sizeof(snap.parent) - 1] ||
+        snap.chain_depth >= SNAPSHOT_MAX_CHAIN ||
+        !snap.chain_depth != !snap.parent[0] ||
+        (depth >= 0 && snap.chain_depth != (unsigned long) depth)) {
+        SYS_PRINTF("%s is not a valid snapshot\n", uri);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    size_t size = snap.checkpoint.hdr.size;
+    debug("restore snapshot %s (%lu bytes)\n", uri, size);
+
+    if (snap.parent[0]) {
+        struct snapshot_link * link = malloc(sizeof(*link));
+        if (!link) {
+            ret = -ENOMEM;
+            goto out;
+        }
+
+        /* the depth decreases along the chain, so it cannot loop */
+        unsigned long parent_depth;
+        ret = load_snapshot(snap.parent, snap.chain_depth - 1, false,
+                            &link->checkpoint, &link->base, &link->mapaddr,
+                            &link->mapsize, &parent_depth);
+        if (ret < 0) {
+            free(link);
+            goto out;
+        }
+
+        link->next = NULL;
+        *snapshot_chain_tail = link;
+        snapshot_chain_tail = &link->next;
+    }
+
+#if CPSTORE_DERANDOMIZATION == 1
+    if (in_place && snap.checkpoint.hdr.addr
+        && lookup_overlap_vma(snap.checkpoint.hdr.addr, size, NULL) == -ENOENT) {
+        base = snap.checkpoint.hdr.addr;
+        mapaddr = (PAL_PTR)ALLOC_ALIGN_DOWN_PTR(base);
+        mapsize = (PAL_PTR)ALLOC_ALIGN_UP_PTR(base + size) - mapaddr;
+
+        if (bkeep_mmap((void *) mapaddr, mapsize, PROT_READ|PROT_WRITE,
+                       CP_VMA_FLAGS, NULL, 0, "cpstore") < 0)
+            base = NULL;
+    }
+#endif
+
+    if (!base) {
+        base = bkeep_unmapped_any(ALLOC_ALIGN_UP(size), PROT_READ|PROT_WRITE,
+                                  CP_VMA_FLAGS, 0, "cpstore");
+        if (!base) {
+            ret = -ENOMEM;
+            goto out;
+        }
+
+        mapaddr = (PAL_PTR)base;
+        mapsize = (PAL_NUM)ALLOC_ALIGN_UP(size);
+    }
+
+    /* the memory is stored in chunks (see send_checkpoint_on_stream()), so
+     * the snapshot is read rather than mapped */
+    PAL_PTR mapped = DkVirtualMemoryAlloc(mapaddr, mapsize, 0,
+                                          PAL_PROT_READ|PAL_PROT_WRITE);
+    if (!mapped) {
+        ret = -PAL_ERRNO;
+        bkeep_munmap((void *) mapaddr, mapsize, CP_VMA_FLAGS);
+        goto out;
+    }
+
+    assert(mapaddr == mapped);
+
+    PAL_NUM stream_off = snap.data_offset;
+    ret = receive_checkpoint_on_stream(file, &snap.checkpoint, base,
+                                       &stream_off, in_place);
+    if (ret < 0) {
+        SYS_PRINTF("failed reading snapshot %s (%d)\n", uri, ret);
+        DkVirtualMemoryFree(mapaddr, mapsize);
+        bkeep_munmap((void *) mapaddr, mapsize, CP_VMA_FLAGS);
+        goto out;
+    }
+
+    *hdr = snap.checkpoint;
+    *baseptr = base;
+    *mapaddrptr = mapaddr;
+    *mapsizeptr = mapsize;
+    *depthptr = snap.chain_depth;
+out:
+    DkObjectClose(file);
+    return ret;
+}
+
+/*
+ * Load the checkpoint data of a snapshot file written by do_snapshot_process()
+ *
+ * @uri: host URI of the snapshot file
+ * @hdr: returning the checkpoint header
+ * @cpptr: returning the pointer of the loaded checkpoint
+ */
+int restore_from_snapshot (const char * uri, struct newproc_cp_header * hdr,
+                           void ** cpptr)
+{
+    void * base;
+    PAL_PTR mapaddr;
+    PAL_NUM mapsize;
+
+    /* snapshot files are neither encrypted nor integrity-protected */
+    if (!strcmp_static(PAL_CB(host_type), "Linux-SGX"))
+        return -ENOSYS;
+
+    unsigned long depth;
+    int ret = load_snapshot(uri, -1, true, hdr, &base, &mapaddr, &mapsize,
+                            &depth);
+    if (ret < 0) {
+        free_snapshot_chain();
+        return ret;
+    }
+
+    long rebase = (long) ((uintptr_t) base - (uintptr_t) hdr->hdr.addr);
+
+    /* The PAL handles saved in the snapshot belong to the dead instance;
+     * drop them so rs_palhdl reopens the streams by URI instead. */
+    struct shim_palhdl_entry * entry = hdr->palhdl.nentries ?
+            (void *) base + hdr->palhdl.entoffset : NULL;
+
+    for ( ; entry ; entry = entry->prev) {
+        CP_REBASE(entry->prev);
+        CP_REBASE(entry->phandle);
+        if (entry->phandle)
+            *entry->phandle = NULL;
+    }
+
+    /* the next incremental snapshot can be taken after this one */
+    size_t len = strlen(uri);
+    if (len < sizeof(last_snapshot_uri)) {
+        memcpy(last_snapshot_uri, uri, len + 1);
+        last_snapshot_depth = depth;
+    }
+
+    *cpptr = base;
+    migrated_memory_start = (void *) mapaddr;
+    migrated_memory_end = (void *) mapaddr + mapsize;
+    return 0;
+}
+
+/*
+ * Fill [addr, addr + size) from the snapshots the restored incremental
+ * snapshot was taken after, oldest first, so each page gets the contents it
+ * was saved with last. Called for the anonymous memory, of which an
+ * incremental snapshot only saves the pages written since the previous one.
+ * The memory must be writable.
+ */
+void restore_snapshot_chain (void * addr, size_t size)
+{
+    void * end = addr + size;
+
+    for (struct snapshot_link * link = snapshot_chain ; link ;
+         link = link->next) {
+        long rebase = (long) ((uintptr_t) link->base -
+                              (uintptr_t) link->checkpoint.hdr.addr);
+        struct shim_mem_entry * entry = link->checkpoint.mem.nentries ?
+                link->base + link->checkpoint.mem.entoffset : NULL;
+
+        for ( ; entry ;
+             entry = entry->prev ? (void *) entry->prev + rebase : NULL) {
+            void * start = entry->addr > addr ? entry->addr : addr;
+            void * stop  = entry->addr + entry->size < end ?
+                           entry->addr + entry->size : end;
+            if (start < stop)
+                memcpy(start, entry->data + rebase + (start - entry->addr),
+                       stop - start);
+        }
+    }
+}
+
+/*
+ * Called once the checkpoint of a new process is restored: free the snapshots
+ * loaded for an incremental snapshot, and track the pages written from now on,
+ * for the next incremental snapshot.
+ */
+int finish_snapshot_restore (void)
+{
+    free_snapshot_chain();
+
+    if (last_snapshot_uri[0] &&
+        (!incremental_snapshot_enabled() || !DkVirtualMemoryTrackWrites()))
+        last_snapshot_uri[0] = '\0';
+
+    return 0;
+}
+
 int send_handles_on_stream (PAL_HANDLE stream, struct shim_cp_store * store)
 {
     int nentries = store->palhdl_nentries;
@@ -728,6 +1310,52 @@ static void * cp_alloc (struct shim_cp_store * store, void * addr, size_t size)
     return addr;
 }
 
+static int init_cp_store (struct shim_cp_store * store)
+{
+    memset(store, 0, sizeof(*store));
+    store->alloc = cp_alloc;
+    store->bound = CP_INIT_VMA_SIZE;
+
+    while (1) {
+        /*
+         * Try allocating a space of a certain size. If the allocation fails,
+         * continue to try with smaller sizes.
+         */
+        store->base = (ptr_t) cp_alloc(store, 0, store->bound);
+        if (store->base)
+            break;
+
+        store->bound >>= 1;
+        if (store->bound < g_pal_alloc_align)
+            break;
+    }
+
+    if (!store->base) {
+        debug("failed creating checkpoint store\n");
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+static void fill_cp_header (struct newproc_cp_header * hdr,
+                            struct shim_cp_store * store)
+{
+    hdr->hdr.addr = (void *) store->base;
+    hdr->hdr.size = store->offset + store->mem_size;
+    hdr->mem.dataoffset = store->offset;
+
+    if (store->mem_nentries) {
+        hdr->mem.entoffset = (ptr_t) store->last_mem_entry - store->base;
+        hdr->mem.nentries  = store->mem_nentries;
+    }
+
+    if (store->palhdl_nentries) {
+        hdr->palhdl.entoffset = (ptr_t) store->last_palhdl_entry - store->base;
+        hdr->palhdl.nentries  = store->palhdl_nentries;
+    }
+}
+
 DEFINE_PROFILE_CATEGORY(migrate_proc, migrate);
 DEFINE_PROFILE_INTERVAL(migrate_create_process,   migrate_proc);
 DEFINE_PROFILE_INTERVAL(migrate_connect_ipc,      migrate_proc);
@@ -785,8 +1413,12 @@ int do_migrate_process (int (*migrate) (struct shim_cp_store *,
 
     SAVE_PROFILE_INTERVAL(migrate_create_process);
 
+    /* The execve of a vfork child creates a real child process, which gets
+     * a new identity like in the fork case */
+    bool child_process = !exec || thread->dummy;
+
     /* Create process and IPC bookkeepings */
-    new_process = create_process(exec ? /*execve case*/ true : /*fork case*/ false);
+    new_process = create_process(child_process ? /*fork case*/ false : /*execve case*/ true);
     if (!new_process) {
         ret = -EACCES;
         goto out;
@@ -796,29 +1428,8 @@ int do_migrate_process (int (*migrate) (struct shim_cp_store *,
 
     /* Allocate a space for dumping the checkpoint data. */
     struct shim_cp_store cpstore;
-    memset(&cpstore, 0, sizeof(cpstore));
-    cpstore.alloc    = cp_alloc;
-    cpstore.bound    = CP_INIT_VMA_SIZE;
-
-    while (1) {
-        /*
-         * Try allocating a space of a certain size. If the allocation fails,
-         * continue to try with smaller sizes.
-         */
-        cpstore.base = (ptr_t) cp_alloc(&cpstore, 0, cpstore.bound);
-        if (cpstore.base)
-            break;
-
-        cpstore.bound >>= 1;
-        if (cpstore.bound < g_pal_alloc_align)
-            break;
-    }
-
-    if (!cpstore.base) {
-        ret = -ENOMEM;
-        debug("failed creating checkpoint store\n");
+    if ((ret = init_cp_store(&cpstore)) < 0)
         goto out;
-    }
 
     SAVE_PROFILE_INTERVAL(migrate_init_checkpoint);
 
@@ -842,20 +1453,7 @@ int do_migrate_process (int (*migrate) (struct shim_cp_store *,
     debug("checkpoint of %lu bytes created, %lu microsecond is spent.\n",
           checkpoint_size, checkpoint_time);
 
-    hdr.checkpoint.hdr.addr = (void *) cpstore.base;
-    hdr.checkpoint.hdr.size = checkpoint_size;
-
-    if (cpstore.mem_nentries) {
-        hdr.checkpoint.mem.entoffset =
-                    (ptr_t) cpstore.last_mem_entry - cpstore.base;
-        hdr.checkpoint.mem.nentries  = cpstore.mem_nentries;
-    }
-
-    if (cpstore.palhdl_nentries) {
-        hdr.checkpoint.palhdl.entoffset =
-                    (ptr_t) cpstore.last_palhdl_entry - cpstore.base;
-        hdr.checkpoint.palhdl.nentries  = cpstore.palhdl_nentries;
-    }
+    fill_cp_header(&hdr.checkpoint, &cpstore);
 
 #ifdef PROFILE
     hdr.begin_create_time  = begin_create_time;
@@ -880,7 +1478,7 @@ int do_migrate_process (int (*migrate) (struct shim_cp_store *,
     ADD_PROFILE_OCCURENCE(migrate_send_on_stream, bytes);
     SAVE_PROFILE_INTERVAL(migrate_send_header);
 
-    ret = send_checkpoint_on_stream(proc, &cpstore);
+    ret = send_checkpoint_on_stream(proc, &cpstore, NULL);
 
     if (ret < 0) {
         debug("failed sending checkpoint (ret = %d)\n", ret);
@@ -935,7 +1533,7 @@ int do_migrate_process (int (*migrate) (struct shim_cp_store *,
 
     /* exec != NULL implies the execve case so the new process "replaces"
      * this current process: no need to notify the leader or establish IPC */
-    if (!exec) {
+    if (child_process) {
         /* fork/clone case: new process is an actual child process for this
          * current process, so notify the leader regarding subleasing of TID
          * (child must create self-pipe with convention of pipe:child-vmid) */
@@ -969,6 +1567,152 @@ out:
     return ret;
 }
 
+/*
+ * Save the process states into a snapshot file, from which a later Graphene
+ * instance can be started (see restore_from_snapshot()).
+ *
+ * @migrate: migration function defined by the caller
+ * @file: PAL handle of the snapshot file, opened for writing
+ * @uri: host URI of the snapshot file
+ * @thread: thread to be resumed when the snapshot is restored
+ *
+ * The remaining arguments are passed into the migration function.
+ *
+ * With "sys.incremental_snapshot = 1" in the manifest, the anonymous memory
+ * is only saved if written since the previous snapshot, which must be kept
+ * to restore this one.
+ */
+int do_snapshot_process (int (*migrate) (struct shim_cp_store *,
+                                         struct shim_thread *,
+                                         struct shim_process *, va_list),
+                         PAL_HANDLE file, const char * uri,
+                         struct shim_thread * thread, ...)
+{
+    struct snapshot_header hdr;
+    struct shim_cp_store cpstore;
+    PAL_NUM bytes;
+    int ret;
+
+    memset(&hdr, 0, sizeof(hdr));
+
+    /*
+     * Like a forked child, the restored process picks up a new VMID and
+     * creates its own IPC port. It starts a new Graphene instance though, so
+     * it has no parent and becomes the leader of its own namespaces: the IPC
+     * infos of this instance cannot be reached from there.
+     */
+    struct shim_process * new_process = create_process(false);
+    if (!new_process)
+        return -ENOMEM;
+
+    if (new_process->parent) {
+        put_ipc_info(new_process->parent);
+        new_process->parent = NULL;
+    }
+    for (int i = 0 ; i < TOTAL_NS ; i++)
+        if (new_process->ns[i]) {
+            put_ipc_info(new_process->ns[i]);
+            new_process->ns[i] = NULL;
+        }
+
+    if ((ret = init_cp_store(&cpstore)) < 0) {
+        free_process(new_process);
+        return ret;
+    }
+
+    cpstore.copy_shared_memory = true;
+
+    bool incremental = incremental_snapshot_enabled();
+    size_t uri_len = strlen(uri);
+
+    /* The previous snapshot is overwritten if it is the same file. A chain
+     * that cannot grow any longer is ended by a complete snapshot. So is the
+     * snapshot of a process with other threads: they cannot be stopped, and a
+     * page they write between the capture and the reset of the tracking below
+     * would be missing from both this snapshot and the next one. */
+    if (incremental && last_snapshot_uri[0] &&
+        strcmp(last_snapshot_uri, uri) &&
+        last_snapshot_depth + 1 < SNAPSHOT_MAX_CHAIN &&
+        !check_last_thread(thread)) {
+        /* the written pages must be captured before the tracking is reset
+         * below, not while the vmas are checkpointed after it */
+        if ((ret = capture_written_pages(&cpstore.written)) < 0) {
+            debug("cannot capture written pages (ret = %d), "
+                  "snapshot is complete\n", ret);
+        } else {
+            cpstore.incremental = true;
+            hdr.chain_depth = last_snapshot_depth + 1;
+            memcpy(hdr.parent, last_snapshot_uri, sizeof(hdr.parent));
+            debug("snapshot taken after %s\n", hdr.parent);
+        }
+    }
+
+    /* Any page written from here on goes into the next snapshot, even if it
+     * is saved in this one (the memory is only read while checkpointing and
+     * sending it). If this snapshot fails, the next one is complete. */
+    bool tracking = false;
+    if (incremental) {
+        last_snapshot_uri[0] = '\0';
+        tracking = uri_len < sizeof(last_snapshot_uri) &&
+                   DkVirtualMemoryTrackWrites();
+        if (!tracking)
+            debug("cannot track written pages, next snapshot is complete\n");
+    }
+
+    va_list ap;
+    va_start(ap, thread);
+    ret = (*migrate) (&cpstore, thread, new_process, ap);
+    va_end(ap);
+    if (ret < 0) {
+        debug("failed creating snapshot (ret = %d)\n", ret);
+        goto out;
+    }
+
+    hdr.data_offset = ALLOC_ALIGN_UP(sizeof(hdr));
+    fill_cp_header(&hdr.checkpoint, &cpstore);
+
+    PAL_NUM rv = DkStreamSetLength(file, 0);
+    if (rv) {
+        ret = -((int)rv);
+        goto out;
+    }
+
+    PAL_NUM stream_off = hdr.data_offset;
+    if ((ret = send_checkpoint_on_stream(file, &cpstore, &stream_off)) < 0) {
+        debug("failed writing snapshot (ret = %d)\n", ret);
+        goto out;
+    }
+
+    /* PAL handles cannot be stored in a file; they are reopened by URI on
+     * restore (see rs_palhdl). The header is written last so a partially
+     * written snapshot is never picked up. */
+    hdr.magic = SNAPSHOT_MAGIC;
+    bytes = DkStreamWrite(file, 0, sizeof(hdr), &hdr, NULL);
+    if (bytes == PAL_STREAM_ERROR) {
+        ret = -PAL_ERRNO;
+        goto out;
+    } else if (bytes < sizeof(hdr)) {
+        ret = -EIO;
+        goto out;
+    }
+
+    DkStreamFlush(file);
+    debug("snapshot of %lu bytes written\n", hdr.checkpoint.hdr.size);
+
+    if (tracking) {
+        memcpy(last_snapshot_uri, uri, uri_len + 1);
+        last_snapshot_depth = hdr.chain_depth;
+    }
+    ret = 0;
+out:
+    free_written_pages(cpstore.written);
+    if (bkeep_munmap((void *) cpstore.base, cpstore.bound, CP_VMA_FLAGS) < 0)
+        BUG();
+    DkVirtualMemoryFree((PAL_PTR) cpstore.base, cpstore.bound);
+    free_process(new_process);
+    return ret;
+}
+
 /*
  * Loading the checkpoint from the parent process or a checkpoint file
  *
@@ -1037,23 +1781,13 @@ int do_migration (struct newproc_cp_header * hdr, void ** cpptr)
      */
     rebase = (long) ((uintptr_t) base - (uintptr_t) hdr->hdr.addr);
 
-    size_t total_bytes = 0;
-    while (total_bytes < size) {
-        PAL_NUM bytes = DkStreamRead(PAL_CB(parent_process), 0, size - total_bytes,
-                                     (void*)base + total_bytes, NULL, 0);
-
-        if (bytes == PAL_STREAM_ERROR) {
-            if (PAL_ERRNO == EINTR || PAL_ERRNO == EAGAIN ||
-                    PAL_ERRNO == EWOULDBLOCK)
-                continue;
-            return -PAL_ERRNO;
-        }
-
-        total_bytes += bytes;
-    }
+    ret = receive_checkpoint_on_stream(PAL_CB(parent_process), hdr, base, NULL,
+                                       true);
+    if (ret < 0)
+        return ret;
 
     SAVE_PROFILE_INTERVAL(child_load_checkpoint_on_pipe);
-    debug("%lu bytes read on stream\n", total_bytes);
+    debug("checkpoint received on stream\n");
 
     /* Receive socket or RPC handles from the parent process. */
     ret = receive_handles_on_stream(&hdr->palhdl, (ptr_t) base, rebase);
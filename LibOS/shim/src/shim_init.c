@@ -593,11 +593,14 @@ DEFINE_PROFILE_INTERVAL(init_newproc,               init);
 DEFINE_PROFILE_INTERVAL(init_mount_root,            init);
 DEFINE_PROFILE_INTERVAL(init_from_checkpoint_file,  init);
 DEFINE_PROFILE_INTERVAL(restore_from_file,          init);
+DEFINE_PROFILE_INTERVAL(restore_from_snapshot,      init);
+DEFINE_PROFILE_INTERVAL(finish_snapshot_restore,    init);
 DEFINE_PROFILE_INTERVAL(init_manifest,              init);
 DEFINE_PROFILE_INTERVAL(init_ipc,                   init);
 DEFINE_PROFILE_INTERVAL(init_thread,                init);
 DEFINE_PROFILE_INTERVAL(init_important_handles,     init);
 DEFINE_PROFILE_INTERVAL(init_mount,                 init);
+DEFINE_PROFILE_INTERVAL(init_time,                  init);
 DEFINE_PROFILE_INTERVAL(init_async,                 init);
 DEFINE_PROFILE_INTERVAL(init_stack,                 init);
 DEFINE_PROFILE_INTERVAL(read_environs,              init);
@@ -703,14 +706,27 @@ noreturn void* shim_init (int argc, void * args)
             RUN_INIT(do_migration, &hdr.checkpoint, &cpaddr);
     }
 
+    if (!cpaddr && !PAL_CB(parent_process) && PAL_CB(manifest_handle)) {
+        /* A new instance may be warm-started from a snapshot taken by the
+         * snapshot() LibOS call; the manifest names it by its host URI. */
+        RUN_INIT(init_manifest, PAL_CB(manifest_handle));
+
+        char snapshot_uri[CONFIG_MAX];
+        if (get_config(root_config, "sys.snapshot", snapshot_uri, sizeof(snapshot_uri)) > 0) {
+            memset(&hdr, 0, sizeof(hdr));
+            RUN_INIT(restore_from_snapshot, snapshot_uri, &hdr.checkpoint, &cpaddr);
+        }
+    }
+
     if (cpaddr) {
         thread_start_event = DkNotificationEventCreate(PAL_FALSE);
         RUN_INIT(restore_checkpoint,
                  &hdr.checkpoint.hdr, &hdr.checkpoint.mem,
                  (ptr_t) cpaddr, 0);
+        RUN_INIT(finish_snapshot_restore);
     }
 
-    if (PAL_CB(manifest_handle))
+    if (PAL_CB(manifest_handle) && !root_config)
         RUN_INIT(init_manifest, PAL_CB(manifest_handle));
 
     RUN_INIT(init_mount_root);
@@ -718,6 +734,7 @@ noreturn void* shim_init (int argc, void * args)
     RUN_INIT(init_thread);
     RUN_INIT(init_mount);
     RUN_INIT(init_important_handles);
+    RUN_INIT(init_time);
     RUN_INIT(init_async);
     RUN_INIT(init_stack, argv, envp, &argcp, &argp, &auxp);
     RUN_INIT(init_loader);
@@ -776,6 +793,7 @@ noreturn void* shim_init (int argc, void * args)
 
     if (cur_tcb->context.regs && cur_tcb->context.regs->rsp) {
         vdso_map_migrate();
+        syscall_trampolines_migrate();
         restore_context(&cur_tcb->context);
     }
 
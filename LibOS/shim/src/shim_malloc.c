@@ -71,8 +71,11 @@ void* __system_malloc(size_t size) {
     if (!addr)
         return NULL;
 
+    int pal_alloc_type = vma_huge_pages(alloc_size, flags) ? PAL_ALLOC_HUGEPAGE : 0;
+
     do {
-        ret_addr = DkVirtualMemoryAlloc(addr, alloc_size, 0, PAL_PROT_WRITE | PAL_PROT_READ);
+        ret_addr = DkVirtualMemoryAlloc(addr, alloc_size, pal_alloc_type,
+                                        PAL_PROT_WRITE | PAL_PROT_READ);
 
         if (!ret_addr) {
             /* If the allocation is interrupted by signal, try to handle the
@@ -289,8 +289,8 @@ struct parser_table {
         {.slow = 0, .parser = {NULL}},                      /* sched_getaffinity */
         {.slow = 0, .parser = {NULL}},                      /* set_thread_area */
         {.slow = 0, .parser = {NULL}},                      /* io_setup */
-        {.slow = 0, .parser = {NULL}},                      /* io_destroy */
-        {.slow = 0, .parser = {NULL}},                      /* io_getevents */
+        {.slow = 1, .parser = {NULL}},                      /* io_destroy */
+        {.slow = 1, .parser = {NULL}},                      /* io_getevents */
         {.slow = 0, .parser = {NULL}},                      /* io_submit */
         {.slow = 0, .parser = {NULL}},                      /* io_cancel */
         {.slow = 0, .parser = {NULL}},                      /* get_thread_area */
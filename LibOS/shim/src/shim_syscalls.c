@@ -215,7 +215,8 @@ SHIM_SYSCALL_PASSTHROUGH(msync, 3, int, void*, start, size_t, len, int, flags)
 DEFINE_SHIM_SYSCALL(mincore, 3, shim_do_mincore, int, void*, start, size_t, len, unsigned char*,
                     vec)
 
-SHIM_SYSCALL_PASSTHROUGH(madvise, 3, int, void*, start, size_t, len, int, behavior)
+/* madvise: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(madvise, 3, shim_do_madvise, int, void*, start, size_t, len, int, behavior)
 
 SHIM_SYSCALL_PASSTHROUGH(shmget, 3, int, key_t, key, size_t, size, int, shmflg)
 
@@ -728,17 +729,23 @@ SHIM_SYSCALL_PASSTHROUGH(set_thread_area, 1, int, struct user_desc*, u_info)
 
 /* no glibc wrapper */
 
-SHIM_SYSCALL_PASSTHROUGH(io_setup, 2, int, unsigned, nr_reqs, aio_context_t*, ctx)
+/* io_setup: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_setup, 2, shim_do_io_setup, int, unsigned, nr_reqs, aio_context_t*, ctx)
 
-SHIM_SYSCALL_PASSTHROUGH(io_destroy, 1, int, aio_context_t, ctx)
+/* io_destroy: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_destroy, 1, shim_do_io_destroy, int, aio_context_t, ctx)
 
-SHIM_SYSCALL_PASSTHROUGH(io_getevents, 5, int, aio_context_t, ctx_id, long, min_nr, long, nr,
-                         struct io_event*, events, struct timespec*, timeout)
+/* io_getevents: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_getevents, 5, shim_do_io_getevents, int, aio_context_t, ctx_id, long,
+                    min_nr, long, nr, struct io_event*, events, struct timespec*, timeout)
 
-SHIM_SYSCALL_PASSTHROUGH(io_submit, 3, int, aio_context_t, ctx_id, long, nr, struct iocb**, iocbpp)
+/* io_submit: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_submit, 3, shim_do_io_submit, int, aio_context_t, ctx_id, long, nr,
+                    struct iocb**, iocbpp)
 
-SHIM_SYSCALL_PASSTHROUGH(io_cancel, 3, int, aio_context_t, ctx_id, struct iocb*, iocb,
-                         struct io_event*, result)
+/* io_cancel: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_cancel, 3, shim_do_io_cancel, int, aio_context_t, ctx_id, struct iocb*,
+                    iocb, struct io_event*, result)
 
 SHIM_SYSCALL_PASSTHROUGH(get_thread_area, 1, int, struct user_desc*, u_info)
 
@@ -819,11 +826,13 @@ SHIM_SYSCALL_PASSTHROUGH(utimes, 2, int, char*, filename, struct timeval*, utime
 DEFINE_SHIM_SYSCALL(mbind, 6, shim_do_mbind, int, void*, start, unsigned long, len, int, mode,
                     unsigned long*, nmask, unsigned long, maxnode, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(set_mempolicy, 3, int, int, mode, unsigned long*, nmask, unsigned long,
-                         maxnode)
+/* set_mempolicy: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(set_mempolicy, 3, shim_do_set_mempolicy, int, int, mode, unsigned long*, nmask,
+                    unsigned long, maxnode)
 
-SHIM_SYSCALL_PASSTHROUGH(get_mempolicy, 5, int, int*, policy, unsigned long*, nmask, unsigned long,
-                         maxnode, unsigned long, addr, unsigned long, flags)
+/* get_mempolicy: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(get_mempolicy, 5, shim_do_get_mempolicy, int, int*, policy, unsigned long*,
+                    nmask, unsigned long, maxnode, void*, addr, unsigned long, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(mq_open, 4, int, const char*, name, int, oflag, mode_t, mode,
                          struct __kernel_mq_attr*, attr)
@@ -942,8 +951,9 @@ DEFINE_SHIM_SYSCALL(set_robust_list, 2, shim_do_set_robust_list, int, struct rob
 DEFINE_SHIM_SYSCALL(get_robust_list, 3, shim_do_get_robust_list, int, pid_t, pid,
                     struct robust_list_head**, head, size_t*, len)
 
-SHIM_SYSCALL_PASSTHROUGH(splice, 6, int, int, fd_in, loff_t*, off_in, int, fd_out, loff_t*, off_out,
-                         size_t, len, int, flags)
+/* splice: sys/shim_fs.c */
+DEFINE_SHIM_SYSCALL(splice, 6, shim_do_splice, ssize_t, int, fd_in, loff_t*, off_in, int, fd_out,
+                    loff_t*, off_out, size_t, len, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(tee, 4, int, int, fdin, int, fdout, size_t, len, unsigned int, flags)
 
@@ -953,8 +963,9 @@ SHIM_SYSCALL_PASSTHROUGH(sync_file_range, 4, int, int, fd, loff_t, offset, loff_
 SHIM_SYSCALL_PASSTHROUGH(vmsplice, 4, int, int, fd, const struct iovec*, iov, unsigned long,
                          nr_segs, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(move_pages, 6, int, pid_t, pid, unsigned long, nr_pages, void**, pages,
-                         const int*, nodes, int*, status, int, flags)
+/* move_pages: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(move_pages, 6, shim_do_move_pages, int, pid_t, pid, unsigned long, nr_pages,
+                    void**, pages, const int*, nodes, int*, status, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(utimensat, 4, int, int, dfd, const char*, filename, struct timespec*,
                          utimes, int, flags)
@@ -963,23 +974,30 @@ DEFINE_SHIM_SYSCALL(epoll_pwait, 6, shim_do_epoll_pwait, int, int, epfd,
                     struct __kernel_epoll_event*, events, int, maxevents, int, timeout_ms,
                     const __sigset_t*, sigmask, size_t, sigsetsize)
 
-SHIM_SYSCALL_PASSTHROUGH(signalfd, 3, int, int, ufd, __sigset_t*, user_mask, size_t, sizemask)
+/* signalfd: sys/shim_signalfd.c */
+DEFINE_SHIM_SYSCALL(signalfd, 3, shim_do_signalfd, int, int, ufd, __sigset_t*, user_mask, size_t,
+                    sizemask)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_create, 2, int, int, clockid, int, flags)
+/* timerfd_create: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_create, 2, shim_do_timerfd_create, int, int, clockid, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(fallocate, 4, int, int, fd, int, mode, loff_t, offset, loff_t, len)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_settime, 4, int, int, ufd, int, flags,
-                         const struct __kernel_itimerspec*, utmr, struct __kernel_itimerspec*, otmr)
+/* timerfd_settime: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_settime, 4, shim_do_timerfd_settime, int, int, ufd, int, flags,
+                    const struct __kernel_itimerspec*, utmr, struct __kernel_itimerspec*, otmr)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_gettime, 2, int, int, ufd, struct __kernel_itimerspec*, otmr)
+/* timerfd_gettime: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_gettime, 2, shim_do_timerfd_gettime, int, int, ufd,
+                    struct __kernel_itimerspec*, otmr)
 
 /* accept4: sys/shim_socket.c */
 DEFINE_SHIM_SYSCALL(accept4, 4, shim_do_accept4, int, int, sockfd, struct sockaddr*, addr,
                     socklen_t*, addrlen, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(signalfd4, 4, int, int, ufd, __sigset_t*, user_mask, size_t, sizemask, int,
-                         flags)
+/* signalfd4: sys/shim_signalfd.c */
+DEFINE_SHIM_SYSCALL(signalfd4, 4, shim_do_signalfd4, int, int, ufd, __sigset_t*, user_mask, size_t,
+                    sizemask, int, flags)
 
 DEFINE_SHIM_SYSCALL(eventfd, 1, shim_do_eventfd, int, unsigned int, count)
 
@@ -997,11 +1015,13 @@ DEFINE_SHIM_SYSCALL(pipe2, 2, shim_do_pipe2, int, int*, fildes, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(inotify_init1, 1, int, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(preadv, 5, int, unsigned long, fd, const struct iovec*, vec, unsigned long,
-                         vlen, unsigned long, pos_l, unsigned long, pos_h)
+/* preadv: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(preadv, 5, shim_do_preadv, ssize_t, unsigned long, fd, const struct iovec*, vec,
+                    unsigned long, vlen, unsigned long, pos_l, unsigned long, pos_h)
 
-SHIM_SYSCALL_PASSTHROUGH(pwritev, 5, int, unsigned long, fd, const struct iovec*, vec,
-                         unsigned long, vlen, unsigned long, pos_l, unsigned long, pos_h)
+/* pwritev: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(pwritev, 5, shim_do_pwritev, ssize_t, unsigned long, fd, const struct iovec*,
+                    vec, unsigned long, vlen, unsigned long, pos_l, unsigned long, pos_h)
 
 SHIM_SYSCALL_PASSTHROUGH(rt_tgsigqueueinfo, 4, int, pid_t, tgid, pid_t, pid, int, sig, siginfo_t*,
                          uinfo)
@@ -1035,8 +1055,13 @@ DEFINE_SHIM_SYSCALL(sendmmsg, 4, shim_do_sendmmsg, ssize_t, int, fd, struct mmsg
 
 SHIM_SYSCALL_PASSTHROUGH(setns, 2, int, int, fd, int, nstype)
 
-SHIM_SYSCALL_PASSTHROUGH(getcpu, 3, int, unsigned*, cpu, unsigned*, node, struct getcpu_cache*,
-                         cache)
+/* getcpu: sys/shim_sched.c */
+DEFINE_SHIM_SYSCALL(getcpu, 3, shim_do_getcpu, int, unsigned*, cpu, unsigned*, node,
+                    struct getcpu_cache*, cache)
+
+/* copy_file_range: sys/shim_fs.c */
+DEFINE_SHIM_SYSCALL(copy_file_range, 6, shim_do_copy_file_range, ssize_t, int, fd_in, loff_t*,
+                    off_in, int, fd_out, loff_t*, off_out, size_t, len, unsigned int, flags)
 
 /* libos calls */
 
@@ -1051,3 +1076,5 @@ DEFINE_SHIM_SYSCALL(send_rpc, 3, shim_do_send_rpc, size_t, pid_t, pid, const voi
 DEFINE_SHIM_SYSCALL(recv_rpc, 3, shim_do_recv_rpc, size_t, pid_t*, pid, void*, buf, size_t, size)
 
 DEFINE_SHIM_SYSCALL(checkpoint, 1, shim_do_checkpoint, int, const char*, filename)
+
+DEFINE_SHIM_SYSCALL(snapshot, 1, shim_do_snapshot, int, const char*, filename)
@@ -0,0 +1,660 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_aio.c
+ *
+ * Implementation of system calls "io_setup", "io_destroy", "io_submit", "io_getevents" and
+ * "io_cancel" (the native Linux AIO used by libaio).
+ *
+ * An AIO context queues the submitted iocbs, and up to AIO_MAX_WORKERS internal threads of the
+ * context run them with the positional reads and writes of the file systems. Completions stay in
+ * the event ring of the context until io_getevents() reaps them; iocbs with IOCB_FLAG_RESFD also
+ * add 1 to their eventfd. As on Linux, child processes do not inherit the contexts.
+ */
+
+#include <errno.h>
+#include <linux/aio_abi.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+#define AIO_MAX_WORKERS 4
+#define AIO_MAX_EVENTS  65536 /* the default of /proc/sys/fs/aio-max-nr */
+#define AIO_MAX_IOV     1024
+
+DEFINE_LIST(shim_aio_req);
+struct shim_aio_req {
+    struct iocb* user_iocb;
+    struct iocb iocb;           /* copied at submission, like the iovecs */
+    struct iovec* iov;
+    struct shim_handle* hdl;
+    struct shim_handle* resfd;
+    LIST_TYPE(shim_aio_req) list;
+};
+DEFINE_LISTP(shim_aio_req);
+
+DEFINE_LIST(shim_aio_waiter);
+struct shim_aio_waiter {
+    struct shim_thread* thread;
+    LIST_TYPE(shim_aio_waiter) list;
+};
+DEFINE_LISTP(shim_aio_waiter);
+
+DEFINE_LIST(shim_aio_ctx);
+struct shim_aio_ctx {
+    /* libaio reads the context as the struct aio_ring of the kernel to reap events without a
+     * system call; a header without AIO_RING_MAGIC makes it always call io_getevents() */
+    uint32_t ring_header[8];
+    REFTYPE ref_count;
+    struct shim_lock lock;
+    bool dead;
+    unsigned int max_reqs;
+    unsigned int inflight;      /* requests queued, running, or completed and not reaped yet */
+    unsigned int running;
+    unsigned int workers;
+    unsigned int idle_workers;
+    PAL_HANDLE work_event;      /* synchronization event waking up one idle worker */
+    LISTP_TYPE(shim_aio_req) queue;
+    LISTP_TYPE(shim_aio_waiter) waiters;
+    struct io_event* events;    /* ring of max_reqs completions */
+    unsigned int head;
+    unsigned int completed;
+    LIST_TYPE(shim_aio_ctx) list;
+};
+DEFINE_LISTP(shim_aio_ctx);
+
+struct shim_aio_worker_args {
+    struct shim_thread* thread;
+    struct shim_aio_ctx* ctx;
+};
+
+static LISTP_TYPE(shim_aio_ctx) aio_ctx_list = LISTP_INIT;
+static struct shim_lock aio_ctx_list_lock;
+
+static void put_aio_ctx(struct shim_aio_ctx* ctx) {
+    if (REF_DEC(ctx->ref_count))
+        return;
+
+    assert(LISTP_EMPTY(&ctx->queue) && !ctx->running && !ctx->workers);
+    destroy_lock(&ctx->lock);
+    DkObjectClose(ctx->work_event);
+    free(ctx->events);
+    free(ctx);
+}
+
+static struct shim_aio_ctx* get_aio_ctx(aio_context_t id, bool unlink) {
+    if (!create_lock_runtime(&aio_ctx_list_lock))
+        return NULL;
+
+    struct shim_aio_ctx* ctx = NULL;
+    struct shim_aio_ctx* tmp;
+
+    lock(&aio_ctx_list_lock);
+    LISTP_FOR_EACH_ENTRY(tmp, &aio_ctx_list, list) {
+        if ((aio_context_t)tmp == id) {
+            REF_INC(tmp->ref_count);
+            if (unlink)
+                LISTP_DEL_INIT(tmp, &aio_ctx_list, list);
+            ctx = tmp;
+            break;
+        }
+    }
+    unlock(&aio_ctx_list_lock);
+    return ctx;
+}
+
+static void free_aio_req(struct shim_aio_req* req) {
+    put_handle(req->hdl);
+    if (req->resfd)
+        put_handle(req->resfd);
+    free(req->iov);
+    free(req);
+}
+
+/* should be called with ctx->lock held */
+static void wake_aio_waiters(struct shim_aio_ctx* ctx) {
+    assert(locked(&ctx->lock));
+
+    struct shim_aio_waiter* waiter;
+    struct shim_aio_waiter* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(waiter, tmp, &ctx->waiters, list) {
+        LISTP_DEL_INIT(waiter, &ctx->waiters, list);
+        thread_wakeup(waiter->thread);
+    }
+}
+
+/* Sleeps until a worker wakes up the waiters of `ctx`; returns the result of thread_sleep(). This
+ * should be called with ctx->lock held, which is released while sleeping. */
+static int wait_aio_ctx(struct shim_aio_ctx* ctx, uint64_t timeout_us) {
+    assert(locked(&ctx->lock));
+
+    struct shim_aio_waiter waiter;
+    thread_setwait(&waiter.thread, NULL);
+    INIT_LIST_HEAD(&waiter, list);
+    LISTP_ADD_TAIL(&waiter, &ctx->waiters, list);
+    unlock(&ctx->lock);
+
+    int ret = thread_sleep(timeout_us);
+
+    lock(&ctx->lock);
+    if (!LIST_EMPTY(&waiter, list))
+        LISTP_DEL_INIT(&waiter, &ctx->waiters, list);
+    put_thread(waiter.thread);
+    return ret;
+}
+
+/* should be called with ctx->lock held */
+static void post_aio_event(struct shim_aio_ctx* ctx, struct shim_aio_req* req, int64_t res) {
+    assert(locked(&ctx->lock));
+    assert(ctx->completed < ctx->inflight);
+
+    struct io_event* event = &ctx->events[(ctx->head + ctx->completed) % ctx->max_reqs];
+    event->data = req->iocb.aio_data;
+    event->obj  = (uint64_t)req->user_iocb;
+    event->res  = res;
+    event->res2 = 0;
+    ctx->completed++;
+    wake_aio_waiters(ctx);
+}
+
+static int64_t run_aio_req(struct shim_aio_req* req) {
+    struct iocb* iocb = &req->iocb;
+    void* buf         = (void*)iocb->aio_buf;
+
+    switch (iocb->aio_lio_opcode) {
+        case IOCB_CMD_PREAD:
+            return do_handle_pread(req->hdl, buf, iocb->aio_nbytes, iocb->aio_offset);
+        case IOCB_CMD_PWRITE:
+            return do_handle_pwrite(req->hdl, buf, iocb->aio_nbytes, iocb->aio_offset);
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+            return do_handle_fsync(req->hdl);
+    }
+
+    /* IOCB_CMD_PREADV and IOCB_CMD_PWRITEV: stop at the first short transfer */
+    bool is_read  = iocb->aio_lio_opcode == IOCB_CMD_PREADV;
+    off_t pos     = iocb->aio_offset;
+    int64_t total = 0;
+
+    for (size_t i = 0; i < iocb->aio_nbytes; i++) {
+        struct iovec* iov = &req->iov[i];
+        ssize_t ret = is_read ? do_handle_pread(req->hdl, iov->iov_base, iov->iov_len, pos)
+                              : do_handle_pwrite(req->hdl, iov->iov_base, iov->iov_len, pos);
+        if (ret < 0)
+            return total ? total : ret;
+
+        total += ret;
+        pos += ret;
+        if ((size_t)ret < iov->iov_len)
+            break;
+    }
+
+    return total;
+}
+
+static void shim_aio_worker(void* arg) {
+    struct shim_aio_worker_args* args = (struct shim_aio_worker_args*)arg;
+    struct shim_thread* self = args->thread;
+    struct shim_aio_ctx* ctx = args->ctx;
+
+    shim_tcb_init();
+    set_cur_thread(self);
+    update_fs_base(0);
+    debug_setbuf(shim_get_tcb(), true);
+    free(args);
+
+    debug("AIO worker started for context %p\n", ctx);
+
+    lock(&ctx->lock);
+    while (true) {
+        if (LISTP_EMPTY(&ctx->queue)) {
+            if (ctx->dead)
+                break;
+
+            ctx->idle_workers++;
+            unlock(&ctx->lock);
+            DkSynchronizationObjectWait(ctx->work_event, NO_TIMEOUT);
+            lock(&ctx->lock);
+            ctx->idle_workers--;
+            continue;
+        }
+
+        struct shim_aio_req* req = LISTP_FIRST_ENTRY(&ctx->queue, struct shim_aio_req, list);
+        LISTP_DEL(req, &ctx->queue, list);
+        ctx->running++;
+
+        /* pass the wakeup on, so that the queued requests run in parallel */
+        if (!LISTP_EMPTY(&ctx->queue) && ctx->idle_workers)
+            DkEventSet(ctx->work_event);
+        unlock(&ctx->lock);
+
+        int64_t res = run_aio_req(req);
+
+        lock(&ctx->lock);
+        ctx->running--;
+        bool posted = !ctx->dead;
+        if (posted)
+            post_aio_event(ctx, req, res);
+        else
+            wake_aio_waiters(ctx);
+        unlock(&ctx->lock);
+
+        if (posted && req->resfd) {
+            uint64_t one = 1;
+            do_handle_write(req->resfd, &one, sizeof(one));
+        }
+        free_aio_req(req);
+
+        lock(&ctx->lock);
+    }
+
+    /* the context is destroyed: let the other idle workers exit too */
+    ctx->workers--;
+    if (ctx->idle_workers)
+        DkEventSet(ctx->work_event);
+    unlock(&ctx->lock);
+
+    debug("AIO worker for context %p terminated\n", ctx);
+    put_aio_ctx(ctx);
+
+    __disable_preempt(self->shim_tcb);
+    put_thread(self);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+}
+
+/* should be called with ctx->lock held */
+static int create_aio_worker(struct shim_aio_ctx* ctx) {
+    assert(locked(&ctx->lock));
+
+    struct shim_aio_worker_args* args = malloc(sizeof(*args));
+    if (!args)
+        return -ENOMEM;
+
+    struct shim_thread* new = get_new_internal_thread();
+    if (!new) {
+        free(args);
+        return -ENOMEM;
+    }
+
+    args->thread = new;
+    args->ctx    = ctx;
+    REF_INC(ctx->ref_count);
+    ctx->workers++;
+
+    PAL_HANDLE handle = thread_create(shim_aio_worker, args);
+    if (!handle) {
+        ctx->workers--;
+        REF_DEC(ctx->ref_count);
+        put_thread(new);
+        free(args);
+        return -PAL_ERRNO;
+    }
+
+    new->pal_handle = handle;
+    return 0;
+}
+
+int shim_do_io_setup(unsigned nr_reqs, aio_context_t* ctxp) {
+    if (!ctxp || test_user_memory(ctxp, sizeof(*ctxp), true))
+        return -EFAULT;
+
+    if (*ctxp || !nr_reqs)
+        return -EINVAL;
+
+    if (nr_reqs > AIO_MAX_EVENTS)
+        return -EAGAIN;
+
+    if (!create_lock_runtime(&aio_ctx_list_lock))
+        return -ENOMEM;
+
+    struct shim_aio_ctx* ctx = malloc(sizeof(*ctx));
+    if (!ctx)
+        return -ENOMEM;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->max_reqs = nr_reqs;
+    ctx->events   = malloc(sizeof(*ctx->events) * nr_reqs);
+    if (!ctx->events) {
+        free(ctx);
+        return -ENOMEM;
+    }
+
+    if (!create_lock(&ctx->lock)) {
+        free(ctx->events);
+        free(ctx);
+        return -ENOMEM;
+    }
+
+    ctx->work_event = DkSynchronizationEventCreate(PAL_FALSE);
+    if (!ctx->work_event) {
+        destroy_lock(&ctx->lock);
+        free(ctx->events);
+        free(ctx);
+        return -PAL_ERRNO;
+    }
+
+    REF_SET(ctx->ref_count, 1);
+    INIT_LISTP(&ctx->queue);
+    INIT_LISTP(&ctx->waiters);
+    INIT_LIST_HEAD(ctx, list);
+
+    lock(&aio_ctx_list_lock);
+    LISTP_ADD_TAIL(ctx, &aio_ctx_list, list);
+    unlock(&aio_ctx_list_lock);
+
+    *ctxp = (aio_context_t)ctx;
+    return 0;
+}
+
+int shim_do_io_destroy(aio_context_t ctx_id) {
+    struct shim_aio_ctx* ctx = get_aio_ctx(ctx_id, /*unlink=*/true);
+    if (!ctx)
+        return -EINVAL;
+
+    lock(&ctx->lock);
+    ctx->dead = true;
+
+    struct shim_aio_req* req;
+    struct shim_aio_req* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &ctx->queue, list) {
+        LISTP_DEL(req, &ctx->queue, list);
+        free_aio_req(req);
+    }
+
+    if (ctx->idle_workers)
+        DkEventSet(ctx->work_event);
+    wake_aio_waiters(ctx);
+
+    /* like Linux, wait for the requests that are already running */
+    while (ctx->running)
+        wait_aio_ctx(ctx, NO_TIMEOUT);
+    unlock(&ctx->lock);
+
+    /* drop the references of the lookup and of the context list */
+    put_aio_ctx(ctx);
+    put_aio_ctx(ctx);
+    return 0;
+}
+
+static int submit_aio_req(struct shim_aio_ctx* ctx, struct iocb* user_iocb) {
+    if (!user_iocb || test_user_memory(user_iocb, sizeof(*user_iocb), false))
+        return -EFAULT;
+
+    struct shim_aio_req* req = malloc(sizeof(*req));
+    if (!req)
+        return -ENOMEM;
+
+    memset(req, 0, sizeof(*req));
+    req->user_iocb   = user_iocb;
+    req->iocb        = *user_iocb;
+    struct iocb* iocb = &req->iocb;
+    void* buf         = (void*)iocb->aio_buf;
+    int ret;
+
+    if (iocb->aio_reserved2) {
+        ret = -EINVAL;
+        goto out_free;
+    }
+
+    if (iocb->aio_rw_flags) {
+        ret = -EOPNOTSUPP;
+        goto out_free;
+    }
+
+    int acc_mode = 0;
+    switch (iocb->aio_lio_opcode) {
+        case IOCB_CMD_PREAD:
+        case IOCB_CMD_PWRITE:
+            acc_mode = iocb->aio_lio_opcode == IOCB_CMD_PREAD ? MAY_READ : MAY_WRITE;
+            if (test_user_memory(buf, iocb->aio_nbytes, acc_mode == MAY_READ)) {
+                ret = -EFAULT;
+                goto out_free;
+            }
+            break;
+
+        case IOCB_CMD_PREADV:
+        case IOCB_CMD_PWRITEV:
+            acc_mode = iocb->aio_lio_opcode == IOCB_CMD_PREADV ? MAY_READ : MAY_WRITE;
+            if (iocb->aio_nbytes > AIO_MAX_IOV) {
+                ret = -EINVAL;
+                goto out_free;
+            }
+
+            size_t iov_size = sizeof(struct iovec) * iocb->aio_nbytes;
+            if (test_user_memory(buf, iov_size, false)) {
+                ret = -EFAULT;
+                goto out_free;
+            }
+
+            if (!(req->iov = malloc(iov_size ?: 1))) {
+                ret = -ENOMEM;
+                goto out_free;
+            }
+            memcpy(req->iov, buf, iov_size);
+
+            for (size_t i = 0; i < iocb->aio_nbytes; i++) {
+                if (test_user_memory(req->iov[i].iov_base, req->iov[i].iov_len,
+                                     acc_mode == MAY_READ)) {
+                    ret = -EFAULT;
+                    goto out_free;
+                }
+            }
+            break;
+
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+            break;
+
+        default:
+            ret = -EINVAL;
+            goto out_free;
+    }
+
+    if (!(req->hdl = get_fd_handle(iocb->aio_fildes, NULL, NULL))) {
+        ret = -EBADF;
+        goto out_free;
+    }
+
+    if (acc_mode && !(req->hdl->acc_mode & acc_mode)) {
+        ret = -EBADF;
+        goto out_free;
+    }
+
+    if (iocb->aio_flags & IOCB_FLAG_RESFD) {
+        if (!(req->resfd = get_fd_handle(iocb->aio_resfd, NULL, NULL))) {
+            ret = -EBADF;
+            goto out_free;
+        }
+        if (req->resfd->type != TYPE_EVENTFD) {
+            ret = -EINVAL;
+            goto out_free;
+        }
+    }
+
+    lock(&ctx->lock);
+    if (ctx->inflight == ctx->max_reqs) {
+        unlock(&ctx->lock);
+        ret = -EAGAIN;
+        goto out_free;
+    }
+
+    if (!ctx->idle_workers && ctx->workers < AIO_MAX_WORKERS) {
+        ret = create_aio_worker(ctx);
+        if (ret < 0 && !ctx->workers) {
+            unlock(&ctx->lock);
+            goto out_free;
+        }
+    }
+
+    INIT_LIST_HEAD(req, list);
+    LISTP_ADD_TAIL(req, &ctx->queue, list);
+    ctx->inflight++;
+    if (ctx->idle_workers)
+        DkEventSet(ctx->work_event);
+    unlock(&ctx->lock);
+    return 0;
+
+out_free:
+    if (req->hdl)
+        free_aio_req(req);
+    else {
+        free(req->iov);
+        free(req);
+    }
+    return ret;
+}
+
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp) {
+    if (nr < 0)
+        return -EINVAL;
+
+    struct shim_aio_ctx* ctx = get_aio_ctx(ctx_id, /*unlink=*/false);
+    if (!ctx)
+        return -EINVAL;
+
+    if (nr > ctx->max_reqs)
+        nr = ctx->max_reqs;
+
+    long i   = 0;
+    int  ret = 0;
+
+    if (!iocbpp || test_user_memory(iocbpp, sizeof(*iocbpp) * nr, false)) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    for (; i < nr; i++)
+        if ((ret = submit_aio_req(ctx, iocbpp[i])) < 0)
+            break;
+
+out:
+    put_aio_ctx(ctx);
+    return i ? i : ret;
+}
+
+/* should be called with ctx->lock held */
+static long reap_aio_events(struct shim_aio_ctx* ctx, struct io_event* events, long nr) {
+    assert(locked(&ctx->lock));
+
+    long n = 0;
+    for (; n < nr && ctx->completed; n++) {
+        events[n] = ctx->events[ctx->head];
+        ctx->head = (ctx->head + 1) % ctx->max_reqs;
+        ctx->completed--;
+        ctx->inflight--;
+    }
+    return n;
+}
+
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout) {
+    if (min_nr < 0 || nr < 0 || min_nr > nr)
+        return -EINVAL;
+
+    if (nr && (!events || test_user_memory(events, sizeof(*events) * nr, true)))
+        return -EFAULT;
+
+    uint64_t timeout_us = NO_TIMEOUT;
+    uint64_t end        = 0;
+    if (timeout) {
+        if (test_user_memory(timeout, sizeof(*timeout), false))
+            return -EFAULT;
+        if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+            return -EINVAL;
+
+        timeout_us = timeout->tv_sec * 1000000ULL + timeout->tv_nsec / 1000;
+        end        = DkSystemTimeQuery() + timeout_us;
+    }
+
+    struct shim_aio_ctx* ctx = get_aio_ctx(ctx_id, /*unlink=*/false);
+    if (!ctx)
+        return -EINVAL;
+
+    long reaped = 0;
+    int ret     = 0;
+
+    lock(&ctx->lock);
+    while (true) {
+        reaped += reap_aio_events(ctx, events + reaped, nr - reaped);
+        if (reaped >= min_nr || ctx->dead)
+            break;
+
+        if (timeout) {
+            uint64_t now = DkSystemTimeQuery();
+            if (now >= end)
+                break;
+            timeout_us = end - now;
+        }
+
+        ret = wait_aio_ctx(ctx, timeout_us);
+        if (ret < 0 && ret != -EAGAIN) {
+            /* interrupted by a signal */
+            reaped += reap_aio_events(ctx, events + reaped, nr - reaped);
+            break;
+        }
+        ret = 0;
+    }
+    unlock(&ctx->lock);
+
+    put_aio_ctx(ctx);
+    return reaped ? reaped : ret;
+}
+
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result) {
+    __UNUSED(result);
+
+    struct shim_aio_ctx* ctx = get_aio_ctx(ctx_id, /*unlink=*/false);
+    if (!ctx)
+        return -EINVAL;
+
+    /* only requests which are still queued can be cancelled; like Linux, their completion with
+     * -ECANCELED is then reaped with io_getevents() */
+    struct shim_aio_req* found = NULL;
+    struct shim_aio_req* req;
+
+    lock(&ctx->lock);
+    LISTP_FOR_EACH_ENTRY(req, &ctx->queue, list) {
+        if (req->user_iocb == iocb) {
+            found = req;
+            break;
+        }
+    }
+
+    if (found) {
+        LISTP_DEL(found, &ctx->queue, list);
+        post_aio_event(ctx, found, -ECANCELED);
+    }
+    unlock(&ctx->lock);
+
+    put_aio_ctx(ctx);
+
+    if (!found)
+        return -EINVAL;
+
+    if (found->resfd) {
+        uint64_t one = 1;
+        do_handle_write(found->resfd, &one, sizeof(one));
+    }
+    free_aio_req(found);
+    return -EINPROGRESS;
+}
@@ -53,7 +53,7 @@ void __attribute__((weak)) syscall_wrapper_after_syscalldb(void)
  * child thread can _not_ use parent stack. So return right after syscall
  * instruction as if syscall_wrapper is executed.
  */
-static void fixup_child_context(struct shim_regs * regs)
+void fixup_child_context(struct shim_regs * regs)
 {
     if (regs->rip == (unsigned long)&syscall_wrapper_after_syscalldb) {
         /*
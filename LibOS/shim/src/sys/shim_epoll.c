@@ -195,7 +195,8 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                 goto out;
             }
             /* note that pipe and socket may not have pal_handle yet (e.g. before bind()) */
-            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD) {
+            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD &&
+                hdl->type != TYPE_TIMERFD && hdl->type != TYPE_SIGNALFD) {
                 ret = -EPERM;
                 put_handle(hdl);
                 goto out;
@@ -206,6 +207,9 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                 goto out;
             }
 
+            /* epoll waits on the host stream of in-process pipes and socketpairs */
+            ring_pipe_migrate(hdl);
+
             epoll_item = malloc(sizeof(struct shim_epoll_item));
             if (!epoll_item) {
                 ret = -ENOMEM;
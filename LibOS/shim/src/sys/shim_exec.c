@@ -453,7 +453,8 @@ reopen:
 
     SAVE_PROFILE_INTERVAL(open_file_for_exec);
 
-    bool use_same_process = check_last_thread(cur_thread) == 0;
+    /* the child of vfork() shares the process of its parent, so it always moves to a new one */
+    bool use_same_process = !cur_thread->dummy && check_last_thread(cur_thread) == 0;
     if (use_same_process && !strcmp_static(PAL_CB(host_type), "Linux-SGX")) {
         /* for SGX PALs, can use same process only if it is the same executable (because a different
          * executable has a different measurement and thus requires a new enclave); this special
@@ -524,6 +525,20 @@ reopen:
         return ret;
     }
 
+    if (cur_thread->dummy) {
+        /* the new process is a child of the parent of vfork(), which resumes now; the handles
+         * and the executable now belong to the new process */
+        struct shim_handle_map* handle_map = cur_thread->handle_map;
+        cur_thread->handle_map = NULL;
+        cur_thread->exec       = NULL;
+        unlock(&cur_thread->lock);
+
+        if (handle_map)
+            put_handle_map(handle_map);
+        put_handle(exec);
+        switch_dummy_thread(cur_thread);
+    }
+
     /* this "temporary" process must die quietly, not sending any messages to not confuse the parent
      * and the execve'ed child, but it must still be around until the child finally exits (because
      * its parent in turn may wait on it, e.g., `bash -c ls`) */
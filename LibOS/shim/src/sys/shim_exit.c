@@ -127,10 +127,30 @@ int thread_exit(struct shim_thread* self, bool send_ipc) {
     return 0;
 }
 
+/* The child of vfork() exits on the host thread of its suspended parent, which
+ * then resumes; the exit code is reported like the one of a remote child. Does
+ * nothing if the current thread is not a vfork child. This must come before
+ * anything that tears down the process, as the process is the parent's. */
+void exit_vfork_child(struct shim_thread* cur_thread, int error_code, int term_signal) {
+    if (!cur_thread->dummy)
+        return;
+
+    lock(&cur_thread->lock);
+    cur_thread->exit_code   = error_code;
+    cur_thread->term_signal = term_signal;
+    cur_thread->in_vm       = false;
+    unlock(&cur_thread->lock);
+
+    thread_exit(cur_thread, false);
+    switch_dummy_thread(cur_thread);
+}
+
 /* note that term_signal argument may contain WCOREDUMP bit (0x80) */
 noreturn void thread_or_process_exit(int error_code, int term_signal) {
     struct shim_thread * cur_thread = get_cur_thread();
 
+    exit_vfork_child(cur_thread, error_code, term_signal);
+
     cur_thread->exit_code = -error_code;
     cur_thread->term_signal = term_signal;
 
@@ -175,6 +195,8 @@ noreturn int shim_do_exit_group (int error_code)
     struct shim_thread * cur_thread = get_cur_thread();
     assert(!is_internal(cur_thread));
 
+    exit_vfork_child(cur_thread, error_code, 0);
+
     /* If exit_group() is invoked multiple times, only a single invocation proceeds past this
      * point. Kill signals are delivered asynchronously, which will eventually kick the execution
      * out of this loop.*/
@@ -187,14 +209,6 @@ noreturn int shim_do_exit_group (int error_code)
     if (debug_handle)
         sysparser_printf("---- shim_exit_group (returning %d)\n", error_code);
 
-#ifndef ALIAS_VFORK_AS_FORK
-    if (cur_thread->dummy) {
-        cur_thread->term_signal = 0;
-        thread_exit(cur_thread, true);
-        switch_dummy_thread(cur_thread);
-    }
-#endif
-
     debug("now kill other threads in the process\n");
     do_kill_proc(cur_thread->tgid, cur_thread->tgid, SIGKILL, false);
     while (check_last_thread(cur_thread)) {
@@ -221,14 +235,6 @@ noreturn int shim_do_exit (int error_code)
     if (debug_handle)
         sysparser_printf("---- shim_exit (returning %d)\n", error_code);
 
-#ifndef ALIAS_VFORK_AS_FORK
-    if (cur_thread->dummy) {
-        cur_thread->term_signal = 0;
-        thread_exit(cur_thread, true);
-        switch_dummy_thread(cur_thread);
-    }
-#endif
-
 #ifdef PROFILE
     if (ENTER_TIME)
         SAVE_PROFILE_INTERVAL_SINCE(syscall_exit, ENTER_TIME);
@@ -330,6 +330,82 @@ int shim_do_fchown(int fd, uid_t uid, gid_t gid) {
 #define MAP_SIZE (g_pal_alloc_align * 4)
 #define BUF_SIZE 2048
 
+/* Handles whose data lives in a host stream, so the PAL can move it without the LibOS seeing it:
+ * regular files, pipes and stream sockets. */
+static bool is_host_stream(struct shim_handle* hdl) {
+    switch (hdl->type) {
+        case TYPE_FILE:
+            return hdl->info.file.type == FILE_REGULAR && !(hdl->flags & O_APPEND);
+        case TYPE_PIPE:
+            return true;
+        case TYPE_SOCK:
+            return hdl->info.sock.sock_type == SOCK_STREAM;
+        default:
+            return false;
+    }
+}
+
+/* Copy through DkStreamTransfer(). Returns -EOPNOTSUPP if the host cannot do it, in which case
+ * nothing has been copied. */
+static ssize_t handle_copy_host(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
+                                off_t* offseto, size_t count) {
+    struct shim_fs_ops* fsi = hdli->fs->fs_ops;
+    struct shim_fs_ops* fso = hdlo->fs->fs_ops;
+    bool filei = hdli->type == TYPE_FILE;
+    bool fileo = hdlo->type == TYPE_FILE;
+    off_t offi = 0, offo = 0, sizeo = 0;
+
+    if (filei) {
+        if (!fsi->seek)
+            return -EOPNOTSUPP;
+        offi = offseti ? *offseti : fsi->seek(hdli, 0, SEEK_CUR);
+        if (offi < 0)
+            return offi;
+    }
+
+    if (fileo) {
+        if (!fso->seek || !fso->poll || !fso->truncate)
+            return -EOPNOTSUPP;
+        offo = offseto ? *offseto : fso->seek(hdlo, 0, SEEK_CUR);
+        if (offo < 0)
+            return offo;
+        if ((sizeo = fso->poll(hdlo, FS_POLL_SZ)) < 0)
+            return sizeo;
+    }
+
+    if (!hdli->pal_handle || !hdlo->pal_handle)
+        return -EOPNOTSUPP;
+
+    PAL_NUM bytes = DkStreamTransfer(hdlo->pal_handle, offo, hdli->pal_handle, offi, count);
+    if (bytes == PAL_STREAM_ERROR) {
+        if (PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT)
+            return -EOPNOTSUPP;
+        return PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+    }
+
+    if (filei) {
+        offi += bytes;
+        if (offseti)
+            *offseti = offi;
+        else
+            fsi->seek(hdli, offi, SEEK_SET);
+    }
+
+    if (fileo) {
+        offo += bytes;
+        /* the host file has grown behind the back of the file system */
+        if (offo > sizeo)
+            fso->truncate(hdlo, offo);
+        if (offseto)
+            *offseto = offo;
+        else
+            fso->seek(hdlo, offo, SEEK_SET);
+    }
+
+    debug("transferred %lu bytes on the host\n", bytes);
+    return bytes;
+}
+
 static ssize_t handle_copy(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
                            off_t* offseto, ssize_t count) {
     struct shim_mount* fsi = hdli->fs;
@@ -341,6 +417,15 @@ static ssize_t handle_copy(struct shim_handle* hdli, off_t* offseti, struct shim
     if (!fsi || !fsi->fs_ops || !fso || !fso->fs_ops)
         return -EACCES;
 
+    if (count > 0 && is_host_stream(hdli) && is_host_stream(hdlo)) {
+        /* the host moves the data behind the back of in-process rings, which have to go first */
+        ring_pipe_migrate(hdli);
+        ring_pipe_migrate(hdlo);
+        ssize_t ret = handle_copy_host(hdli, offseti, hdlo, offseto, count);
+        if (ret != -EOPNOTSUPP)
+            return ret;
+    }
+
     bool do_mapi  = fsi->fs_ops->mmap != NULL;
     bool do_mapo  = fso->fs_ops->mmap != NULL;
     bool do_marki = false;
@@ -656,35 +741,129 @@ out:
     return ret;
 }
 
+/* Copy between two handles, at the given offsets without moving the file positions (like
+ * pread/pwrite), or at the file positions if no offset is given. */
+static ssize_t copy_handles(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
+                            off_t* offseto, size_t count) {
+    off_t old_offseti = 0, old_offseto = 0;
+
+    if (offseti) {
+        if (!hdli->fs || !hdli->fs->fs_ops || !hdli->fs->fs_ops->seek)
+            return -EACCES;
+
+        old_offseti = hdli->fs->fs_ops->seek(hdli, 0, SEEK_CUR);
+        if (old_offseti < 0)
+            return old_offseti;
+    }
+
+    if (offseto) {
+        if (!hdlo->fs || !hdlo->fs->fs_ops || !hdlo->fs->fs_ops->seek)
+            return -EACCES;
+
+        old_offseto = hdlo->fs->fs_ops->seek(hdlo, 0, SEEK_CUR);
+        if (old_offseto < 0)
+            return old_offseto;
+    }
+
+    ssize_t ret = handle_copy(hdli, offseti, hdlo, offseto, count);
+
+    if (ret >= 0 && offseti)
+        hdli->fs->fs_ops->seek(hdli, old_offseti, SEEK_SET);
+    if (ret >= 0 && offseto)
+        hdlo->fs->fs_ops->seek(hdlo, old_offseto, SEEK_SET);
+
+    return ret;
+}
+
 ssize_t shim_do_sendfile(int ofd, int ifd, off_t* offset, size_t count) {
+    if (offset && test_user_memory(offset, sizeof(*offset), true))
+        return -EFAULT;
+
     struct shim_handle* hdli = get_fd_handle(ifd, NULL, NULL);
     struct shim_handle* hdlo = get_fd_handle(ofd, NULL, NULL);
+    ssize_t ret = -EBADF;
 
     if (!hdli || !hdlo)
-        return -EBADF;
+        goto out;
+
+    ret = copy_handles(hdli, offset, hdlo, NULL, count);
+out:
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
+    return ret;
+}
 
-    off_t old_offset = 0;
-    int ret = -EACCES;
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       int flags) {
+    __UNUSED(flags);
 
-    if (offset) {
-        if (!hdli->fs || !hdli->fs->fs_ops || !hdli->fs->fs_ops->seek)
-            goto out;
+    if ((off_in && test_user_memory(off_in, sizeof(*off_in), true)) ||
+        (off_out && test_user_memory(off_out, sizeof(*off_out), true)))
+        return -EFAULT;
 
-        old_offset = hdli->fs->fs_ops->seek(hdli, 0, SEEK_CUR);
-        if (old_offset < 0) {
-            ret = old_offset;
-            goto out;
-        }
+    struct shim_handle* hdli = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdlo = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdli || !hdlo)
+        goto out;
+
+    /* one of the ends has to be a pipe, and pipes have no offsets */
+    ret = -EINVAL;
+    if (hdli->type != TYPE_PIPE && hdlo->type != TYPE_PIPE)
+        goto out;
+
+    ret = -ESPIPE;
+    if ((off_in && hdli->type == TYPE_PIPE) || (off_out && hdlo->type == TYPE_PIPE))
+        goto out;
+
+    if (!len) {
+        ret = 0;
+        goto out;
     }
 
-    ret = handle_copy(hdli, offset, hdlo, NULL, count);
+    ret = copy_handles(hdli, (off_t*)off_in, hdlo, (off_t*)off_out, len);
+out:
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
+    return ret;
+}
+
+ssize_t shim_do_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out,
+                                size_t len, unsigned int flags) {
+    if (flags)
+        return -EINVAL;
+
+    if ((off_in && test_user_memory(off_in, sizeof(*off_in), true)) ||
+        (off_out && test_user_memory(off_out, sizeof(*off_out), true)))
+        return -EFAULT;
+
+    struct shim_handle* hdli = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdlo = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdli || !hdlo)
+        goto out;
+
+    ret = -EINVAL;
+    if (hdli->type != TYPE_FILE || hdlo->type != TYPE_FILE)
+        goto out;
 
-    if (ret >= 0 && offset)
-        hdli->fs->fs_ops->seek(hdli, old_offset, SEEK_SET);
+    if (!len) {
+        ret = 0;
+        goto out;
+    }
 
+    ret = copy_handles(hdli, (off_t*)off_in, hdlo, (off_t*)off_out, len);
 out:
-    put_handle(hdli);
-    put_handle(hdlo);
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
     return ret;
 }
 
@@ -363,6 +363,7 @@ int shim_do_ioctl(int fd, unsigned long cmd, unsigned long arg) {
             ret = 0;
             break;
         case FIOASYNC:
+            ring_pipe_migrate(hdl);
             ret = install_async_event(hdl->pal_handle, 0, &signal_io, NULL);
             break;
         case TIOCSERCONFIG:
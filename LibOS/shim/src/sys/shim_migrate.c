@@ -238,7 +238,8 @@ static int finish_checkpoint(struct cp_session* cpsession) {
     struct shim_cp_store* cpstore = &cpsession->cpstore;
     int ret;
 
-    cpstore->alloc = file_alloc;
+    cpstore->alloc              = file_alloc;
+    cpstore->copy_shared_memory = true;
 
     if ((ret = START_MIGRATE(cpstore, checkpoint)) < 0)
         return ret;
@@ -283,3 +284,61 @@ int shim_do_checkpoint(const char* filename) {
 
     return 0;
 }
+
+static BEGIN_MIGRATION_DEF(snapshot, struct shim_thread* thread, struct shim_process* process) {
+    DEFINE_MIGRATE(process, process, sizeof(struct shim_process));
+    DEFINE_MIGRATE(all_mounts, NULL, 0);
+    DEFINE_MIGRATE(all_vmas, NULL, 0);
+    DEFINE_MIGRATE(running_thread, thread, sizeof(struct shim_thread));
+    DEFINE_MIGRATE(handle_map, thread->handle_map, sizeof(struct shim_handle_map));
+    DEFINE_MIGRATE(migratable, NULL, 0);
+    DEFINE_MIGRATE(brk, NULL, 0);
+    DEFINE_MIGRATE(loaded_libraries, NULL, 0);
+#ifdef DEBUG
+    DEFINE_MIGRATE(gdb_map, NULL, 0);
+#endif
+}
+END_MIGRATION_DEF(snapshot)
+
+static int migrate_snapshot(struct shim_cp_store* store, struct shim_thread* thread,
+                            struct shim_process* process, va_list ap) {
+    __UNUSED(ap);
+    return START_MIGRATE(store, snapshot, thread, process);
+}
+
+/* Write a snapshot of the current process to `filename`. A Graphene instance whose manifest sets
+ * `sys.snapshot` to this file resumes from here, skipping loading and initialization of the
+ * application. As with fork(), only the calling thread is resumed. */
+int shim_do_snapshot(const char* filename) {
+    if (!filename || test_user_string(filename))
+        return -EFAULT;
+
+    /* snapshot files are neither encrypted nor integrity-protected */
+    if (!strcmp_static(PAL_CB(host_type), "Linux-SGX"))
+        return -ENOSYS;
+
+    struct shim_thread* cur_thread = get_cur_thread();
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    int ret = open_namei(hdl, NULL, filename, O_CREAT | O_TRUNC | O_RDWR, 0600, NULL);
+    if (ret < 0)
+        goto out;
+
+    if (hdl->type != TYPE_FILE || !hdl->pal_handle) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    ret = do_snapshot_process(&migrate_snapshot, hdl->pal_handle, qstrgetstr(&hdl->uri),
+                              cur_thread);
+    if (ret < 0)
+        goto out;
+
+    debug("snapshot written to %s\n", qstrgetstr(&hdl->uri));
+    ret = 1;
+out:
+    put_handle(hdl);
+    return ret;
+}
@@ -21,6 +21,7 @@
  */
 
 #include <errno.h>
+#include <linux/mempolicy.h>
 #include <pal.h>
 #include <pal_error.h>
 #include <shim_fs.h>
@@ -28,12 +29,59 @@
 #include <shim_internal.h>
 #include <shim_profile.h>
 #include <shim_table.h>
+#include <shim_thread.h>
 #include <shim_vma.h>
 #include <stdatomic.h>
 #include <sys/mman.h>
 
 DEFINE_PROFILE_OCCURENCE(mmap, memory);
 
+static int shm_mmap(struct shim_handle* hdl, void** addr, size_t size, int prot, int flags,
+                    off_t offset) {
+    void* alloc_addr = DkStreamMap(hdl->pal_handle, *addr, PAL_PROT(prot, flags), offset, size);
+    if (!alloc_addr)
+        return -PAL_ERRNO;
+
+    *addr = alloc_addr;
+    return 0;
+}
+
+static struct shim_fs_ops shm_fs_ops = {
+    .mmap = &shm_mmap,
+};
+
+struct shim_mount shm_builtin_fs = {
+    .type   = "shm",
+    .fs_ops = &shm_fs_ops,
+};
+
+/* Shared anonymous memory is backed by a host shared memory object, which the VMA keeps like a
+ * mapped file; children of fork() receive the object and map it again instead of copying the
+ * memory. Returns NULL if the host cannot share memory (e.g., on SGX), and the memory is then
+ * private to each process. */
+static struct shim_handle* create_shared_anon(size_t length) {
+    PAL_HANDLE pal_hdl = DkSharedMemoryCreate(length);
+    if (!pal_hdl) {
+        debug("mmap: no host shared memory (error %ld), MAP_SHARED memory is private\n",
+              PAL_ERRNO);
+        return NULL;
+    }
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl) {
+        DkObjectClose(pal_hdl);
+        return NULL;
+    }
+
+    hdl->type       = TYPE_SHM;
+    hdl->flags      = O_RDWR;
+    hdl->acc_mode   = MAY_READ | MAY_WRITE;
+    hdl->pal_handle = pal_hdl;
+    set_handle_fs(hdl, &shm_builtin_fs);
+    qstrsetstr(&hdl->path, "/dev/zero (deleted)", static_strlen("/dev/zero (deleted)"));
+    return hdl;
+}
+
 void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
     struct shim_handle* hdl = NULL;
     long ret                = 0;
@@ -58,6 +106,10 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
     if ((flags & (MAP_32BIT | MAP_FIXED)) == (MAP_32BIT | MAP_FIXED))
         flags &= ~MAP_32BIT;
 
+    /* the huge page size encoded in the upper bits overlaps with the VMA flags; the host decides
+     * the size, so only keep MAP_HUGETLB as a request for huge pages */
+    flags &= ~(MAP_HUGE_MASK << MAP_HUGE_SHIFT);
+
     assert(!(flags & (VMA_UNMAPPED | VMA_TAINTED)));
 
     int pal_alloc_type = 0;
@@ -97,6 +149,9 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
             put_handle(hdl);
             return (void*)-ENODEV;
         }
+    } else if (flags & MAP_SHARED) {
+        hdl    = create_shared_anon(length);
+        offset = 0;
     }
 
     if (addr) {
@@ -119,6 +174,9 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
     /* addr needs to be kept for bkeep_munmap() below */
     void* ret_addr = addr;
     if (!hdl) {
+        if (vma_huge_pages(length, flags))
+            pal_alloc_type |= PAL_ALLOC_HUGEPAGE;
+
         ret_addr = (void*)DkVirtualMemoryAlloc(ret_addr, length, pal_alloc_type, PAL_PROT(prot, 0));
 
         if (!ret_addr) {
@@ -203,6 +261,43 @@ int shim_do_munmap(void* addr, size_t length) {
     return 0;
 }
 
+int shim_do_madvise(void* start, size_t len, int behavior) {
+    if (!IS_ALLOC_ALIGNED_PTR(start))
+        return -EINVAL;
+
+    if (!IS_ALLOC_ALIGNED(len))
+        len = ALLOC_ALIGN_UP(len);
+
+    if (!access_ok(start, len))
+        return -EINVAL;
+
+    switch (behavior) {
+        case MADV_NORMAL:
+        case MADV_RANDOM:
+        case MADV_SEQUENTIAL:
+        case MADV_WILLNEED:
+            /* hints about the access pattern are not worth a host call */
+            return 0;
+        case MADV_HUGEPAGE:
+        case MADV_NOHUGEPAGE:
+            break;
+        default:
+            debug("madvise: advice %d is not supported\n", behavior);
+            return -ENOSYS;
+    }
+
+    if (!len)
+        return 0;
+
+    if (!is_in_adjacent_vmas(start, len))
+        return -ENOMEM;
+
+    if (!DkVirtualMemoryAdvise(start, len, behavior == MADV_HUGEPAGE ? PAL_ALLOC_HUGEPAGE : 0))
+        return -PAL_ERRNO;
+
+    return 0;
+}
+
 /* This emulation of mincore() always tells that pages are _NOT_ in RAM
  * pessimistically due to lack of a good way to know it.
  * Possibly it may cause performance(or other) issue due to this lying.
@@ -249,14 +344,249 @@ int shim_do_mincore(void* addr, size_t len, unsigned char* vec) {
 }
 
 
+/* Linux never supports more nodes than this, so larger user masks are only checked for
+ * stray bits */
+#define MAX_NUMA_NODES      1024
+#define NODEMASK_WORDS      (MAX_NUMA_NODES / (8 * sizeof(PAL_NUM)))
+#define NODEMASK_BITS       (8 * sizeof(unsigned long))
+
+/* Copies a user node mask of `maxnode - 1` bits (the Linux convention) into `mask`, dropping
+ * nodes which do not exist. Sets `*empty_user_mask` if the user did not set any bit at all. */
+static int copy_nodemask_from_user(PAL_NUM* mask, const unsigned long* nmask,
+                                   unsigned long maxnode, bool* empty_user_mask) {
+    size_t nodes = get_numa_node_count();
+    unsigned long bits = (nmask && maxnode) ? maxnode - 1 : 0;
+    size_t words = ALIGN_UP(bits, NODEMASK_BITS) / NODEMASK_BITS;
+
+    memset(mask, 0, NODEMASK_WORDS * sizeof(PAL_NUM));
+    *empty_user_mask = true;
+
+    if (!words)
+        return 0;
+
+    if (test_user_memory((void*)nmask, words * sizeof(unsigned long), false))
+        return -EFAULT;
+
+    for (size_t i = 0; i < words; i++) {
+        unsigned long word = nmask[i];
+        if (i == words - 1 && bits % NODEMASK_BITS)
+            word &= (1UL << (bits % NODEMASK_BITS)) - 1;
+        if (!word)
+            continue;
+        if (i >= NODEMASK_WORDS)
+            return -EINVAL;
+
+        *empty_user_mask = false;
+        if (nodes >= (i + 1) * NODEMASK_BITS)
+            mask[i] = word;
+        else if (nodes > i * NODEMASK_BITS)
+            mask[i] = word & ((1UL << (nodes - i * NODEMASK_BITS)) - 1);
+    }
+    return 0;
+}
+
+static int copy_nodemask_to_user(unsigned long* nmask, unsigned long maxnode,
+                                 const PAL_NUM* mask) {
+    unsigned long bits = maxnode - 1;
+    size_t words = ALIGN_UP(bits, NODEMASK_BITS) / NODEMASK_BITS;
+
+    if (test_user_memory(nmask, words * sizeof(unsigned long), true))
+        return -EFAULT;
+
+    memset(nmask, 0, words * sizeof(unsigned long));
+    for (size_t i = 0; i < words && i < NODEMASK_WORDS; i++)
+        nmask[i] = mask[i];
+
+    /* clear the bits beyond maxnode that the last word may have copied */
+    if (bits % NODEMASK_BITS && words <= NODEMASK_WORDS)
+        nmask[words - 1] &= (1UL << (bits % NODEMASK_BITS)) - 1;
+    return 0;
+}
+
+/* Checks the mode and node mask of mbind() or set_mempolicy() the way Linux does. The optional
+ * mode flags only matter when the set of allowed nodes changes, which never happens here. */
+static int check_mempolicy(int* mode, PAL_NUM* mask, const unsigned long* nmask,
+                           unsigned long maxnode) {
+    bool empty_user_mask;
+    int ret = copy_nodemask_from_user(mask, nmask, maxnode, &empty_user_mask);
+    if (ret < 0)
+        return ret;
+
+    if ((*mode & MPOL_F_STATIC_NODES) && (*mode & MPOL_F_RELATIVE_NODES))
+        return -EINVAL;
+    *mode &= ~MPOL_MODE_FLAGS;
+
+    bool empty_mask = true;
+    for (size_t i = 0; i < NODEMASK_WORDS; i++)
+        if (mask[i])
+            empty_mask = false;
+
+    switch (*mode) {
+        case MPOL_DEFAULT:
+        case MPOL_LOCAL:
+            return empty_user_mask ? 0 : -EINVAL;
+        case MPOL_PREFERRED:
+            /* an empty mask means "local allocation", but a mask of only missing nodes is wrong */
+            return (empty_mask && !empty_user_mask) ? -EINVAL : 0;
+        case MPOL_BIND:
+        case MPOL_INTERLEAVE:
+            return empty_mask ? -EINVAL : 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+/* Hosts which cannot place memory (e.g. SGX enclaves) only have one node to offer anyway, so the
+ * policy is accepted and silently has no effect there. */
+static bool mempolicy_unsupported(void) {
+    return PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT || PAL_NATIVE_ERRNO == PAL_ERROR_NOTIMPLEMENTED;
+}
+
 int shim_do_mbind(void* start, unsigned long len, int mode, unsigned long* nmask,
                   unsigned long maxnode, int flags) {
-    /* dummy implementation, always return success */
-    __UNUSED(start);
-    __UNUSED(len);
-    __UNUSED(mode);
-    __UNUSED(nmask);
-    __UNUSED(maxnode);
-    __UNUSED(flags);
+    PAL_NUM mask[NODEMASK_WORDS];
+
+    if (!IS_ALLOC_ALIGNED_PTR(start))
+        return -EINVAL;
+
+    if (flags & ~(MPOL_MF_STRICT | MPOL_MF_MOVE | MPOL_MF_MOVE_ALL))
+        return -EINVAL;
+
+    int ret = check_mempolicy(&mode, mask, nmask, maxnode);
+    if (ret < 0)
+        return ret;
+
+    len = ALLOC_ALIGN_UP(len);
+    if (!len)
+        return 0;
+
+    if (!access_ok(start, len) || !is_in_adjacent_vmas(start, len))
+        return -EFAULT;
+
+    /* there is no other process sharing the pages, so moving all of them is the same as moving
+     * the ones of this process */
+    int pal_flags = ((flags & MPOL_MF_STRICT) ? PAL_MEMBIND_STRICT : 0) |
+                    ((flags & (MPOL_MF_MOVE | MPOL_MF_MOVE_ALL)) ? PAL_MEMBIND_MOVE : 0);
+
+    if (!DkVirtualMemoryBind(start, len, mode, mask, MAX_NUMA_NODES, pal_flags) &&
+            !mempolicy_unsupported())
+        return -PAL_ERRNO;
+
+    return 0;
+}
+
+int shim_do_set_mempolicy(int mode, unsigned long* nmask, unsigned long maxnode) {
+    PAL_NUM mask[NODEMASK_WORDS];
+
+    int ret = check_mempolicy(&mode, mask, nmask, maxnode);
+    if (ret < 0)
+        return ret;
+
+    if (!DkThreadSetMemoryPolicy(mode, mask, MAX_NUMA_NODES) && !mempolicy_unsupported())
+        return -PAL_ERRNO;
+
+    return 0;
+}
+
+int shim_do_get_mempolicy(int* policy, unsigned long* nmask, unsigned long maxnode, void* addr,
+                          unsigned long flags) {
+    PAL_NUM mask[NODEMASK_WORDS];
+    PAL_FLG mode = MPOL_DEFAULT;
+
+    memset(mask, 0, sizeof(mask));
+
+    if (flags & ~(MPOL_F_NODE | MPOL_F_ADDR | MPOL_F_MEMS_ALLOWED))
+        return -EINVAL;
+
+    if (nmask && maxnode < get_numa_node_count())
+        return -EINVAL;
+
+    if (policy && test_user_memory(policy, sizeof(*policy), true))
+        return -EFAULT;
+
+    if (flags & MPOL_F_MEMS_ALLOWED) {
+        if (flags & (MPOL_F_NODE | MPOL_F_ADDR))
+            return -EINVAL;
+        for (size_t i = 0; i < get_numa_node_count(); i++)
+            mask[i / NODEMASK_BITS] |= 1UL << (i % NODEMASK_BITS);
+    } else if (flags & MPOL_F_ADDR) {
+        struct shim_vma_val vma;
+        if (lookup_overlap_vma(addr, 1, &vma) < 0)
+            return -EFAULT;
+        if (vma.file)
+            put_handle(vma.file);
+
+        if (flags & MPOL_F_NODE) {
+            /* report the node the page resides on, faulting it in like Linux does */
+            void* page = ALLOC_ALIGN_DOWN_PTR(addr);
+            int status = 0;
+            if (test_user_memory(page, 1, false))
+                return -EFAULT;
+            if (!DkVirtualMemoryMovePages(1, &page, NULL, &status)) {
+                if (!mempolicy_unsupported())
+                    return -PAL_ERRNO;
+                status = 0;
+            }
+            if (status < 0)
+                return -convert_pal_errno(-status);
+            mode = status;
+        } else if (!DkMemoryPolicyQuery(addr, &mode, mask, MAX_NUMA_NODES) &&
+                   !mempolicy_unsupported()) {
+            return -PAL_ERRNO;
+        }
+    } else if (flags & MPOL_F_NODE) {
+        /* the next node of an interleaving policy is not tracked by the host interfaces */
+        return -EINVAL;
+    } else if (!DkMemoryPolicyQuery(NULL, &mode, mask, MAX_NUMA_NODES) &&
+               !mempolicy_unsupported()) {
+        return -PAL_ERRNO;
+    }
+
+    if (nmask && maxnode) {
+        int ret = copy_nodemask_to_user(nmask, maxnode, mask);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (policy)
+        *policy = mode;
+    return 0;
+}
+
+int shim_do_move_pages(pid_t pid, unsigned long nr_pages, void** pages, const int* nodes,
+                       int* status, int flags) {
+    /* pages of other processes are out of reach of this one */
+    if (pid && (IDTYPE)pid != get_cur_thread()->tgid)
+        return -EPERM;
+
+    if (flags & ~(MPOL_MF_MOVE | MPOL_MF_MOVE_ALL))
+        return -EINVAL;
+
+    if (!nr_pages)
+        return 0;
+
+    if (test_user_memory(pages, nr_pages * sizeof(*pages), false) ||
+            test_user_memory(status, nr_pages * sizeof(*status), true) ||
+            (nodes && test_user_memory((void*)nodes, nr_pages * sizeof(*nodes), false)))
+        return -EFAULT;
+
+    if (nodes)
+        for (unsigned long i = 0; i < nr_pages; i++)
+            if (nodes[i] < 0 || (size_t)nodes[i] >= get_numa_node_count())
+                return -ENODEV;
+
+    if (DkVirtualMemoryMovePages(nr_pages, pages, nodes, status)) {
+        for (unsigned long i = 0; i < nr_pages; i++)
+            if (status[i] < 0)
+                status[i] = -convert_pal_errno(-status[i]);
+        return 0;
+    }
+
+    if (!mempolicy_unsupported())
+        return -PAL_ERRNO;
+
+    /* with a single node, every page already is where it was asked to be */
+    for (unsigned long i = 0; i < nr_pages; i++)
+        status[i] = 0;
     return 0;
 }
@@ -35,6 +35,7 @@
 #include <shim_sysv.h>
 #include <shim_unistd.h>
 #include <shim_utils.h>
+#include <shim_vma.h>
 
 #define MSGQ_HASH_LEN  8
 #define MSGQ_HASH_NUM  (1 << MSGQ_HASH_LEN)
@@ -264,6 +265,334 @@ int del_msg_handle(struct shim_msg_handle* msgq) {
     return ret;
 }
 
+/*
+ * Message queues in host shared memory (enabled with sys.ipc_shared_memory in the manifest).
+ *
+ * The process which creates a queue also creates a host file under /dev/shm holding the queue
+ * (struct shim_msgq_shared); every other process maps the file the first time it uses the queue.
+ * All processes then send and receive by themselves, under a futex-based mutex in the shared
+ * memory, instead of forwarding each message to the owner's IPC helper. Blocked senders and
+ * receivers sleep on the `seq` word, which is bumped on every change of the queue.
+ *
+ * Processes which failed to map the file still go through the owner, which serves their requests
+ * from the shared queue without blocking. Shared queues are never migrated or persisted; like a
+ * host System V queue, the file lives until the queue is removed with IPC_RMID.
+ */
+
+#define MSGQ_SHARED_MAP_SIZE                                    \
+    ALLOC_ALIGN_UP(sizeof(struct shim_msgq_shared) +            \
+                   sizeof(struct msgq_shared_slot) * DEFAULT_MSG_QUEUE_SIZE)
+#define MSGQ_SHARED_MAP_FLAGS (MAP_SHARED | MAP_ANONYMOUS | VMA_INTERNAL)
+#define MSGQ_SHARED_DATA_SIZE sizeof(((struct msgq_shared_slot*)0)->data)
+
+static int msgq_shared_uri(char* uri, size_t size, IDTYPE creator, IDTYPE msqid) {
+    size_t len = snprintf(uri, size, URI_PREFIX_FILE "/dev/shm/graphene-msgq-%u-%u", creator,
+                          msqid);
+    return len < size ? 0 : -ERANGE;
+}
+
+static void msgq_shared_lock(struct shim_msgq_shared* q) {
+    unsigned int c = 0;
+    if (__atomic_compare_exchange_n(&q->lock, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+
+    if (c != 2)
+        c = __atomic_exchange_n(&q->lock, 2, __ATOMIC_ACQUIRE);
+    while (c) {
+        DkFutexWait(&q->lock, 2, NO_TIMEOUT);
+        c = __atomic_exchange_n(&q->lock, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void msgq_shared_unlock(struct shim_msgq_shared* q) {
+    if (__atomic_fetch_sub(&q->lock, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&q->lock, 0, __ATOMIC_RELEASE);
+        DkFutexWake(&q->lock, 1);
+    }
+}
+
+/* Sleep until the queue changes; called and returns with the queue locked. */
+static void __msgq_shared_wait(struct shim_msgq_shared* q) {
+    unsigned int seq = __atomic_load_n(&q->seq, __ATOMIC_RELAXED);
+    q->nwaiters++;
+    msgq_shared_unlock(q);
+    DkFutexWait(&q->seq, seq, NO_TIMEOUT);
+    msgq_shared_lock(q);
+    q->nwaiters--;
+}
+
+/* Senders and receivers of all types sleep on the same word, so wake up all of them. */
+static void __msgq_shared_notify(struct shim_msgq_shared* q) {
+    __atomic_add_fetch(&q->seq, 1, __ATOMIC_RELEASE);
+    if (q->nwaiters)
+        DkFutexWake(&q->seq, q->nwaiters);
+}
+
+static struct msgq_shared_type* __msgq_shared_find_type(struct shim_msgq_shared* q, long type,
+                                                        bool alloc) {
+    struct msgq_shared_type* unused = NULL;
+    for (struct msgq_shared_type* t = q->types; t < &q->types[MSGQ_SHARED_TYPES]; t++) {
+        if (t->head == -1) {
+            if (!unused)
+                unused = t;
+        } else if (t->type == type) {
+            return t;
+        }
+    }
+    return alloc ? unused : NULL;
+}
+
+static int msgq_shared_send(struct shim_msgq_shared* q, long type, size_t size, const void* data,
+                            int flags) {
+    int nslots = MSGQ_SHARED_SLOTS(size);
+    struct msgq_shared_type* mtype;
+    int ret = 0;
+
+    msgq_shared_lock(q);
+
+    while (1) {
+        if (q->deleted) {
+            ret = -EIDRM;
+            goto out;
+        }
+
+        mtype = __msgq_shared_find_type(q, type, true);
+        if (mtype && q->nfree >= nslots)
+            break;
+
+        if (flags & IPC_NOWAIT) {
+            ret = -EAGAIN;
+            goto out;
+        }
+
+        __msgq_shared_wait(q);
+    }
+
+    int first = q->freed;
+    int last  = first;
+    for (size_t copied = 0; nslots--; copied += MSGQ_SHARED_DATA_SIZE) {
+        last = q->freed;
+        struct msgq_shared_slot* slot = &q->slots[last];
+        q->freed = slot->next;
+        q->nfree--;
+
+        size_t sz = size - copied < MSGQ_SHARED_DATA_SIZE ? size - copied : MSGQ_SHARED_DATA_SIZE;
+        memcpy(slot->data, data + copied, sz);
+        slot->next = nslots ? q->freed : -1;
+    }
+    q->slots[first].size = size;
+
+    if (mtype->head == -1) {
+        mtype->type = type;
+        mtype->head = first;
+    } else {
+        q->slots[mtype->tail].next = first;
+    }
+    mtype->tail = last;
+
+    q->nmsgs++;
+    q->currentsize += size;
+    __msgq_shared_notify(q);
+out:
+    msgq_shared_unlock(q);
+    return ret;
+}
+
+static int msgq_shared_recv(struct shim_msgq_shared* q, long type, size_t size, void* data,
+                            int flags) {
+    struct msgq_shared_type* mtype;
+    int ret;
+
+    msgq_shared_lock(q);
+
+    while (1) {
+        if (q->deleted) {
+            ret = -EIDRM;
+            goto out;
+        }
+
+        mtype = __msgq_shared_find_type(q, type, false);
+        if (mtype) {
+            if (q->slots[mtype->head].size > size && !(flags & MSG_NOERROR)) {
+                ret = -E2BIG;
+                goto out;
+            }
+            break;
+        }
+
+        if (flags & IPC_NOWAIT) {
+            ret = -ENOMSG;
+            goto out;
+        }
+
+        __msgq_shared_wait(q);
+    }
+
+    int idx         = mtype->head;
+    size_t msgsize  = q->slots[idx].size;
+    size_t copysize = msgsize < size ? msgsize : size;
+    int nslots      = MSGQ_SHARED_SLOTS(msgsize);
+
+    for (size_t copied = 0; nslots--; copied += MSGQ_SHARED_DATA_SIZE) {
+        struct msgq_shared_slot* slot = &q->slots[idx];
+        if (copied < copysize)
+            memcpy(data + copied, slot->data,
+                   copysize - copied < MSGQ_SHARED_DATA_SIZE ? copysize - copied
+                                                             : MSGQ_SHARED_DATA_SIZE);
+
+        bool last  = idx == mtype->tail;
+        int next   = slot->next;
+        slot->next = q->freed;
+        q->freed   = idx;
+        q->nfree++;
+        idx = last ? -1 : next;
+    }
+    mtype->head = idx;
+
+    q->nmsgs--;
+    q->currentsize -= msgsize;
+    __msgq_shared_notify(q);
+    ret = copysize;
+out:
+    msgq_shared_unlock(q);
+    return ret;
+}
+
+static struct shim_msgq_shared* map_msgq_shared(PAL_HANDLE file) {
+    size_t size = MSGQ_SHARED_MAP_SIZE;
+
+    void* addr = bkeep_unmapped_any(size, PROT_READ | PROT_WRITE, MSGQ_SHARED_MAP_FLAGS, 0,
+                                    "msg queue");
+    if (!addr)
+        return NULL;
+
+    void* mapped = DkStreamMap(file, addr, PAL_PROT_READ | PAL_PROT_WRITE, 0, size);
+    if (!mapped) {
+        bkeep_munmap(addr, size, MSGQ_SHARED_MAP_FLAGS);
+        return NULL;
+    }
+
+    assert(mapped == addr);
+    return addr;
+}
+
+void detach_msg_shared(struct shim_msg_handle* msgq) {
+    if (!msgq->shared)
+        return;
+
+    DkStreamUnmap(msgq->shared, MSGQ_SHARED_MAP_SIZE);
+    bkeep_munmap(msgq->shared, MSGQ_SHARED_MAP_SIZE, MSGQ_SHARED_MAP_FLAGS);
+    msgq->shared = NULL;
+}
+
+/* Called by the creator of the queue; on failure, the queue stays private to the owner. */
+static int __create_msg_shared(struct shim_msg_handle* msgq) {
+    char uri[64];
+    int ret = msgq_shared_uri(uri, sizeof(uri), cur_process.vmid, msgq->msqid);
+    if (ret < 0)
+        return ret;
+
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W,
+                                   PAL_CREATE_ALWAYS, 0);
+    if (!file)
+        return -PAL_ERRNO;
+
+    PAL_NUM rv = DkStreamSetLength(file, MSGQ_SHARED_MAP_SIZE);
+    if (rv) {
+        ret = -((int)rv);
+        goto err;
+    }
+
+    struct shim_msgq_shared* q = map_msgq_shared(file);
+    if (!q) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    q->creator = cur_process.vmid;
+    q->nslots  = DEFAULT_MSG_QUEUE_SIZE;
+    for (int i = 0; i < q->nslots; i++)
+        q->slots[i].next = i + 1 < q->nslots ? i + 1 : -1;
+    q->freed = 0;
+    q->nfree = q->nslots;
+    for (int i = 0; i < MSGQ_SHARED_TYPES; i++)
+        q->types[i].head = -1;
+    q->magic = MSGQ_SHARED_MAGIC;
+
+    DkObjectClose(file);
+    msgq->shared = q;
+    return 0;
+
+err:
+    DkStreamDelete(file, 0);
+    DkObjectClose(file);
+    return ret;
+}
+
+/* Map the queue created by another process; only tried once per handle. */
+static void __attach_msg_shared(struct shim_msg_handle* msgq) {
+    struct sysv_range range;
+    char uri[64];
+    int ret;
+
+    if (msgq->shared || msgq->shared_failed || !ipc_rings_enabled())
+        return;
+
+    msgq->shared_failed = true;
+
+    ret = get_sysv_range(msgq->msqid, &range, NULL);
+    if (ret == -ESRCH && ipc_sysv_query_send(msgq->msqid) >= 0)
+        ret = get_sysv_range(msgq->msqid, &range, NULL);
+    if (ret < 0)
+        return;
+
+    if (range.port)
+        put_ipc_port(range.port);
+    qstrfree(&range.uri);
+
+    if (msgq_shared_uri(uri, sizeof(uri), range.owner, msgq->msqid) < 0)
+        return;
+
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, 0, 0, 0);
+    if (!file)
+        return;
+
+    struct shim_msgq_shared* q = map_msgq_shared(file);
+    DkObjectClose(file);
+    if (!q)
+        return;
+
+    if (q->magic != MSGQ_SHARED_MAGIC) {
+        DkStreamUnmap(q, MSGQ_SHARED_MAP_SIZE);
+        bkeep_munmap(q, MSGQ_SHARED_MAP_SIZE, MSGQ_SHARED_MAP_FLAGS);
+        return;
+    }
+
+    debug("mapped shared msg queue %u created by process %u\n", msgq->msqid, range.owner);
+    msgq->shared        = q;
+    msgq->shared_failed = false;
+}
+
+/* Mark the shared queue deleted for all processes and remove its host file. */
+static void remove_msg_shared(struct shim_msg_handle* msgq) {
+    struct shim_msgq_shared* q = msgq->shared;
+
+    msgq_shared_lock(q);
+    q->deleted = 1;
+    __msgq_shared_notify(q);
+    msgq_shared_unlock(q);
+
+    char uri[64];
+    if (msgq_shared_uri(uri, sizeof(uri), q->creator, msgq->msqid) < 0)
+        return;
+
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, 0, 0, 0);
+    if (file) {
+        DkStreamDelete(file, 0);
+        DkObjectClose(file);
+    }
+}
+
 int shim_do_msgget(key_t key, int msgflg) {
     INC_PROFILE_OCCURENCE(syscall_use_ipc);
     IDTYPE msgid = 0;
@@ -301,6 +630,18 @@ int shim_do_msgget(key_t key, int msgflg) {
         }
 
         add_msg_handle(key, msgid, true);
+
+        struct shim_msg_handle* msgq;
+        if (ipc_rings_enabled() && (msgq = get_msg_handle_by_id(msgid))) {
+            struct shim_handle* hdl = MSG_TO_HANDLE(msgq);
+            lock(&hdl->lock);
+            if ((ret = __create_msg_shared(msgq)) < 0) {
+                debug("failed to create shared msg queue %u: %d\n", msgid, ret);
+                msgq->shared_failed = true;
+            }
+            unlock(&hdl->lock);
+            put_msg_handle(msgq);
+        }
     } else {
         /* query the manager with the key to find the
            corresponding sysvkey */
@@ -338,6 +679,13 @@ static int connect_msg_handle(int msqid, struct shim_msg_handle** msgqp) {
     if (msgq->deleted)
         return -EIDRM;
 
+    if (!msgq->shared && !msgq->shared_failed) {
+        struct shim_handle* hdl = MSG_TO_HANDLE(msgq);
+        lock(&hdl->lock);
+        __attach_msg_shared(msgq);
+        unlock(&hdl->lock);
+    }
+
     *msgqp = msgq;
     return 0;
 }
@@ -363,8 +711,7 @@ out:
 int shim_do_msgsnd(int msqid, const void* msgp, size_t msgsz, int msgflg) {
     INC_PROFILE_OCCURENCE(syscall_use_ipc);
     // Issue #755 - https://github.com/oscarlab/graphene/issues/755
-    __UNUSED(msgflg);
-
+    // (msgflg is only honored for queues in shared memory)
     int ret;
 
     if (msgsz > MSGMAX)
@@ -387,7 +734,10 @@ int shim_do_msgsnd(int msqid, const void* msgp, size_t msgsz, int msgflg) {
     if ((ret = connect_msg_handle(msqid, &msgq)) < 0)
         return ret;
 
-    ret = add_sysv_msg(msgq, msgbuf->mtype, msgsz, msgbuf->mtext, NULL);
+    if (msgq->shared)
+        ret = msgq_shared_send(msgq->shared, msgbuf->mtype, msgsz, msgbuf->mtext, msgflg);
+    else
+        ret = add_sysv_msg(msgq, msgbuf->mtype, msgsz, msgbuf->mtext, NULL);
     put_msg_handle(msgq);
     return ret;
 }
@@ -415,7 +765,10 @@ int shim_do_msgrcv(int msqid, void* msgp, size_t msgsz, long msgtype, int msgflg
     if ((ret = connect_msg_handle(msqid, &msgq)) < 0)
         return ret;
 
-    ret = get_sysv_msg(msgq, msgtype, msgsz, msgbuf->mtext, msgflg, NULL);
+    if (msgq->shared)
+        ret = msgq_shared_recv(msgq->shared, msgtype, msgsz, msgbuf->mtext, msgflg);
+    else
+        ret = get_sysv_msg(msgq, msgtype, msgsz, msgbuf->mtext, msgflg, NULL);
     put_msg_handle(msgq);
     return ret;
 }
@@ -440,10 +793,15 @@ int shim_do_msgctl(int msqid, int cmd, struct msqid_ds* buf) {
         case IPC_RMID:
             if (!msgq->owned) {
                 ret = ipc_sysv_delres_send(NULL, 0, msgq->msqid, SYSV_MSGQ);
-                if (ret < 0)
+                /* the owner may be gone, but the shared queue can still be removed */
+                if (ret < 0 && !msgq->shared)
                     break;
+                ret = 0;
             }
 
+            if (msgq->shared)
+                remove_msg_shared(msgq);
+
             del_msg_handle(msgq);
             break;
 
@@ -593,6 +951,13 @@ int add_sysv_msg(struct shim_msg_handle* msgq, long type, size_t size, const voi
         goto out_locked;
     }
 
+    if (msgq->shared) {
+        /* a request from a process which did not map the queue; the IPC helper must not block */
+        unlock(&hdl->lock);
+        ret = msgq_shared_send(msgq->shared, type, size, data, IPC_NOWAIT);
+        goto out;
+    }
+
     if (!msgq->owned) {
         unlock(&hdl->lock);
         ret = ipc_sysv_msgsnd_send(src->port, src->vmid, msgq->msqid, type, data, size, src->seq);
@@ -668,6 +1033,12 @@ int get_sysv_msg(struct shim_msg_handle* msgq, long type, size_t size, void* dat
         goto out_locked;
     }
 
+    if (msgq->shared) {
+        unlock(&hdl->lock);
+        ret = msgq_shared_recv(msgq->shared, type, size, data, flags | IPC_NOWAIT);
+        goto out;
+    }
+
 #if MIGRATE_SYSV_MSG == 1
     if (msgq->owned) {
         __balance_sysv_score(&msg_policy, hdl, msgq->scores, MAX_SYSV_CLIENTS, src, MSG_RCV_SCORE);
@@ -749,7 +1120,8 @@ out:
 static int __store_msg_persist(struct shim_msg_handle* msgq) {
     int ret = 0;
 
-    if (msgq->deleted)
+    /* shared queues outlive their owner in host shared memory */
+    if (msgq->deleted || msgq->shared)
         goto out;
 
     debug("store msgq %d to persistent store\n", msgq->msqid);
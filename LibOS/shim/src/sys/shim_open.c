@@ -206,60 +206,84 @@ out:
     return ret;
 }
 
-ssize_t shim_do_pread64 (int fd, char * buf, size_t count, loff_t pos)
+/* Positional I/O goes through the pread/pwrite operations of the file system, which neither take
+ * the handle lock nor move the file marker; file systems without them fall back to seeking the
+ * shared marker back and forth. */
+ssize_t do_handle_pread (struct shim_handle * hdl, void * buf, size_t count, off_t pos)
 {
-    if (!buf || test_user_memory(buf, count, true))
-        return -EFAULT;
+    struct shim_mount * fs = hdl->fs;
 
-    if (pos < 0)
-        return -EINVAL;
+    if (!fs || !fs->fs_ops)
+        return -EACCES;
 
-    struct shim_handle * hdl = get_fd_handle(fd, NULL, NULL);
-    if (!hdl)
-        return -EBADF;
+    if (!fs->fs_ops->seek)
+        return -ESPIPE;
+
+    if (hdl->type == TYPE_DIR)
+        return -EISDIR;
+
+    if (fs->fs_ops->pread)
+        return fs->fs_ops->pread(hdl, buf, count, pos);
 
+    if (!fs->fs_ops->read)
+        return -EACCES;
+
+    off_t offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
+    if (offset < 0)
+        return offset;
+
+    ssize_t ret = fs->fs_ops->seek(hdl, pos, SEEK_SET);
+    if (ret < 0)
+        return ret;
+
+    ssize_t bytes = fs->fs_ops->read(hdl, buf, count);
+
+    ret = fs->fs_ops->seek(hdl, offset, SEEK_SET);
+    if (ret < 0)
+        return ret;
+
+    return bytes;
+}
+
+ssize_t do_handle_pwrite (struct shim_handle * hdl, const void * buf, size_t count, off_t pos)
+{
     struct shim_mount * fs = hdl->fs;
-    ssize_t ret = -EACCES;
 
     if (!fs || !fs->fs_ops)
-        goto out;
+        return -EACCES;
 
-    if (!fs->fs_ops->seek) {
-        ret = -ESPIPE;
-        goto out;
-    }
-
-    if (!fs->fs_ops->read)
-        goto out;
+    if (!fs->fs_ops->seek)
+        return -ESPIPE;
 
     if (hdl->type == TYPE_DIR)
-        goto out;
+        return -EISDIR;
 
-    int offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
-    if (offset < 0) {
-        ret = offset;
-        goto out;
-    }
+    if (fs->fs_ops->pwrite)
+        return fs->fs_ops->pwrite(hdl, buf, count, pos);
 
-    ret = fs->fs_ops->seek(hdl, pos, SEEK_SET);
+    if (!fs->fs_ops->write)
+        return -EACCES;
+
+    off_t offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
+    if (offset < 0)
+        return offset;
+
+    ssize_t ret = fs->fs_ops->seek(hdl, pos, SEEK_SET);
     if (ret < 0)
-        goto out;
+        return ret;
 
-    int bytes = fs->fs_ops->read(hdl, buf, count);
+    ssize_t bytes = fs->fs_ops->write(hdl, buf, count);
 
     ret = fs->fs_ops->seek(hdl, offset, SEEK_SET);
     if (ret < 0)
-        goto out;
+        return ret;
 
-    ret = bytes;
-out:
-    put_handle(hdl);
-    return ret;
+    return bytes;
 }
 
-ssize_t shim_do_pwrite64 (int fd, char * buf, size_t count, loff_t pos)
+ssize_t shim_do_pread64 (int fd, char * buf, size_t count, loff_t pos)
 {
-    if (!buf || test_user_memory(buf, count, false))
+    if (!buf || test_user_memory(buf, count, true))
         return -EFAULT;
 
     if (pos < 0)
@@ -269,41 +293,24 @@ ssize_t shim_do_pwrite64 (int fd, char * buf, size_t count, loff_t pos)
     if (!hdl)
         return -EBADF;
 
-    struct shim_mount * fs = hdl->fs;
-    ssize_t ret = -EACCES;
-
-    if (!fs || !fs->fs_ops)
-        goto out;
-
-    if (!fs->fs_ops->seek) {
-        ret = -ESPIPE;
-        goto out;
-    }
-
-    if (!fs->fs_ops->write)
-        goto out;
-
-    if (hdl->type == TYPE_DIR)
-        goto out;
-
-    int offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
-    if (offset < 0) {
-        ret = offset;
-        goto out;
-    }
+    ssize_t ret = do_handle_pread(hdl, buf, count, pos);
+    put_handle(hdl);
+    return ret;
+}
 
-    ret = fs->fs_ops->seek(hdl, pos, SEEK_SET);
-    if (ret < 0)
-        goto out;
+ssize_t shim_do_pwrite64 (int fd, char * buf, size_t count, loff_t pos)
+{
+    if (!buf || test_user_memory(buf, count, false))
+        return -EFAULT;
 
-    int bytes = fs->fs_ops->write(hdl, buf, count);
+    if (pos < 0)
+        return -EINVAL;
 
-    ret = fs->fs_ops->seek(hdl, offset, SEEK_SET);
-    if (ret < 0)
-        goto out;
+    struct shim_handle * hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
 
-    ret = bytes;
-out:
+    ssize_t ret = do_handle_pwrite(hdl, buf, count, pos);
     put_handle(hdl);
     return ret;
 }
@@ -534,28 +541,29 @@ out:
     return ret;
 }
 
-int shim_do_fsync (int fd)
+int do_handle_fsync (struct shim_handle * hdl)
 {
-    struct shim_handle * hdl = get_fd_handle(fd, NULL, NULL);
-    if (!hdl)
-        return -EBADF;
-
-    int ret = -EACCES;
     struct shim_mount * fs = hdl->fs;
 
     if (!fs || !fs->fs_ops)
-        goto out;
+        return -EACCES;
 
     if (hdl->type == TYPE_DIR)
-        goto out;
+        return -EACCES;
 
-    if (!fs->fs_ops->flush) {
-        ret = -EROFS;
-        goto out;
-    }
+    if (!fs->fs_ops->flush)
+        return -EROFS;
 
-    ret = fs->fs_ops->flush(hdl);
-out:
+    return fs->fs_ops->flush(hdl);
+}
+
+int shim_do_fsync (int fd)
+{
+    struct shim_handle * hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    int ret = do_handle_fsync(hdl);
     put_handle(hdl);
     return ret;
 }
@@ -89,12 +89,12 @@ int shim_do_pipe2(int* filedes, int flags) {
 
     hdl1->type = TYPE_PIPE;
     set_handle_fs(hdl1, &pipe_builtin_fs);
-    hdl1->flags    = O_RDONLY;
+    hdl1->flags    = O_RDONLY | (flags & O_NONBLOCK);
     hdl1->acc_mode = MAY_READ;
 
     hdl2->type = TYPE_PIPE;
     set_handle_fs(hdl2, &pipe_builtin_fs);
-    hdl2->flags    = O_WRONLY;
+    hdl2->flags    = O_WRONLY | (flags & O_NONBLOCK);
     hdl2->acc_mode = MAY_WRITE;
 
     ret = create_pipes(&hdl1->pal_handle, &hdl2->pal_handle, flags, hdl1->info.pipe.name,
@@ -105,6 +105,11 @@ int shim_do_pipe2(int* filedes, int flags) {
     memcpy(hdl2->info.pipe.name, hdl1->info.pipe.name, sizeof(hdl2->info.pipe.name));
     qstrcopy(&hdl2->uri, &hdl1->uri);
 
+    /* data goes through LibOS memory until an end leaves this process */
+    ret = ring_pipe_create(hdl1, hdl2);
+    if (ret < 0)
+        goto out;
+
     flags    = flags & O_CLOEXEC ? FD_CLOEXEC : 0;
     int vfd1 = set_new_fd_handle(hdl1, flags, NULL);
     int vfd2 = set_new_fd_handle(hdl2, flags, NULL);
@@ -142,7 +147,7 @@ int shim_do_socketpair(int domain, int type, int protocol, int* sv) {
     if (domain != AF_UNIX)
         return -EAFNOSUPPORT;
 
-    if (type != SOCK_STREAM)
+    if ((type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)) != SOCK_STREAM)
         return -EPROTONOSUPPORT;
 
     if (!sv || test_user_memory(sv, 2 * sizeof(int), true))
@@ -186,6 +191,15 @@ int shim_do_socketpair(int domain, int type, int protocol, int* sv) {
     memcpy(sock2->addr.un.name, sock1->addr.un.name, sizeof(sock2->addr.un.name));
     qstrcopy(&hdl2->uri, &hdl1->uri);
 
+    ret = ring_pipe_create(hdl1, hdl2);
+    if (ret < 0)
+        goto out;
+
+    if (type & SOCK_NONBLOCK) {
+        hdl1->flags |= O_NONBLOCK;
+        hdl2->flags |= O_NONBLOCK;
+    }
+
     int flags = type & SOCK_CLOEXEC ? FD_CLOEXEC : 0;
     int vfd1  = set_new_fd_handle(hdl1, flags, NULL);
     int vfd2  = set_new_fd_handle(hdl2, flags, NULL);
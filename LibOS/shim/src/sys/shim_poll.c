@@ -57,40 +57,47 @@ typedef long int __fd_mask;
 
 #define POLL_NOTIMEOUT ((uint64_t)-1)
 
-int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
-    if (!fds || test_user_memory(fds, sizeof(*fds) * nfds, true))
-        return -EFAULT;
+/* FD sets up to this size are polled with scratch space on the stack */
+#define POLL_STACK_FDS 8
+
+/* for bookkeeping, need to have a mapping FD -> {shim handle, index-in-pals} */
+struct fds_mapping_t {
+    struct shim_handle* hdl; /* NULL if no mapping (handle is not used in polling) */
+    nfds_t idx;              /* index from fds array to pals array */
+};
+
+/* scratch space to poll `nfds` FDs: PAL handles, FD mappings and two PAL_FLG arrays (events and
+ * revents), in this order to keep each array aligned */
+#define POLL_SCRATCH_SIZE(nfds) \
+    ((nfds) * (sizeof(PAL_HANDLE) + sizeof(struct fds_mapping_t) + 2 * sizeof(PAL_FLG)))
+
+/* Returns the current thread's scratch buffer, grown to at least `size` bytes. The buffer is kept
+ * for later calls, so event loops polling large FD sets do not go through malloc every time. */
+static void* get_poll_buf(size_t size) {
+    struct shim_thread* cur = get_cur_thread();
+
+    if (size > cur->poll_buf_size) {
+        size_t new_size = MAX(cur->poll_buf_size * 2, size);
+        void* buf = malloc(new_size);
+        if (!buf)
+            return NULL;
+
+        free(cur->poll_buf);
+        cur->poll_buf      = buf;
+        cur->poll_buf_size = new_size;
+    }
 
-    if ((uint64_t)nfds > get_rlimit_cur(RLIMIT_NOFILE))
-        return -EINVAL;
+    return cur->poll_buf;
+}
 
+/* `scratch` must hold POLL_SCRATCH_SIZE(nfds) bytes */
+static int do_poll(struct pollfd* fds, nfds_t nfds, uint64_t timeout_us, void* scratch) {
     struct shim_handle_map* map = get_cur_thread()->handle_map;
 
-    uint64_t timeout_us = timeout_ms < 0 ? POLL_NOTIMEOUT : timeout_ms * 1000ULL;
-
     /* nfds is the upper limit for actual number of handles */
-    PAL_HANDLE* pals = malloc(nfds * sizeof(PAL_HANDLE));
-    if (!pals)
-        return -ENOMEM;
-
-    /* for bookkeeping, need to have a mapping FD -> {shim handle, index-in-pals} */
-    struct fds_mapping_t {
-        struct shim_handle* hdl; /* NULL if no mapping (handle is not used in polling) */
-        nfds_t idx;              /* index from fds array to pals array */
-    };
-    struct fds_mapping_t* fds_mapping = malloc(nfds * sizeof(struct fds_mapping_t));
-    if (!fds_mapping) {
-        free(pals);
-        return -ENOMEM;
-    }
-
-    /* allocate one memory region to hold two PAL_FLG arrays: events and revents */
-    PAL_FLG* pal_events = malloc(nfds * sizeof(PAL_FLG) * 2);
-    if (!pal_events) {
-        free(pals);
-        free(fds_mapping);
-        return -ENOMEM;
-    }
+    PAL_HANDLE* pals = scratch;
+    struct fds_mapping_t* fds_mapping = (struct fds_mapping_t*)(pals + nfds);
+    PAL_FLG* pal_events = (PAL_FLG*)(fds_mapping + nfds);
     PAL_FLG* ret_events = pal_events + nfds;
 
     nfds_t pal_cnt  = 0;
@@ -151,6 +158,9 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
             continue;
         }
 
+        /* waiting needs the host stream of in-process pipes and socketpairs */
+        ring_pipe_migrate(hdl);
+
         get_handle(hdl);
         fds_mapping[i].hdl = hdl;
         fds_mapping[i].idx = pal_cnt;
@@ -162,14 +172,16 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
 
     unlock(&map->lock);
 
-    PAL_BOL polled = DkStreamsWaitEvents(pal_cnt, pals, pal_events, ret_events, timeout_us);
+    PAL_BOL polled = pal_cnt ? DkStreamsWaitEvents(pal_cnt, pals, pal_events, ret_events,
+                                                   timeout_us)
+                             : PAL_FALSE;
 
-    /* update fds.revents, but only if something was actually polled */
-    if (polled) {
-        for (nfds_t i = 0; i < nfds; i++) {
-            if (!fds_mapping[i].hdl)
-                continue;
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (!fds_mapping[i].hdl)
+            continue;
 
+        /* update fds.revents, but only if something was actually polled */
+        if (polled) {
             fds[i].revents = 0;
             if (ret_events[fds_mapping[i].idx] & PAL_WAIT_ERROR)
                 fds[i].revents |= POLLERR | POLLHUP;
@@ -180,18 +192,35 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
 
             if (fds[i].revents)
                 nrevents++;
-
-            put_handle(fds_mapping[i].hdl);
         }
-    }
 
-    free(pals);
-    free(pal_events);
-    free(fds_mapping);
+        put_handle(fds_mapping[i].hdl);
+    }
 
     return nrevents;
 }
 
+int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
+    if (!fds || test_user_memory(fds, sizeof(*fds) * nfds, true))
+        return -EFAULT;
+
+    if ((uint64_t)nfds > get_rlimit_cur(RLIMIT_NOFILE))
+        return -EINVAL;
+
+    uint64_t timeout_us = timeout_ms < 0 ? POLL_NOTIMEOUT : timeout_ms * 1000ULL;
+
+    if (nfds <= POLL_STACK_FDS) {
+        char scratch[POLL_SCRATCH_SIZE(POLL_STACK_FDS)] __attribute__((aligned(8)));
+        return do_poll(fds, nfds, timeout_us, scratch);
+    }
+
+    void* scratch = get_poll_buf(POLL_SCRATCH_SIZE(nfds));
+    if (!scratch)
+        return -ENOMEM;
+
+    return do_poll(fds, nfds, timeout_us, scratch);
+}
+
 int shim_do_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __sigset_t* sigmask,
                   size_t sigsetsize) {
     __UNUSED(sigmask);
@@ -225,13 +254,28 @@ int shim_do_select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds
         nfds = __NFDBITS;
     }
 
-    /* nfds is the upper limit for actual number of fds for poll */
-    struct pollfd* fds_poll = malloc(nfds * sizeof(struct pollfd));
-    if (!fds_poll)
-        return -ENOMEM;
+    /* count the FDs to poll first, to size the pollfd array */
+    nfds_t nfds_poll = 0;
+    for (int fd = 0; fd < nfds; fd++) {
+        if ((readfds && __FD_ISSET(fd, readfds)) || (writefds && __FD_ISSET(fd, writefds)))
+            nfds_poll++;
+    }
+
+    struct pollfd fds_stack[POLL_STACK_FDS];
+    char scratch_stack[POLL_SCRATCH_SIZE(POLL_STACK_FDS)] __attribute__((aligned(8)));
+    struct pollfd* fds_poll = fds_stack;
+    void* scratch = scratch_stack;
+
+    if (nfds_poll > POLL_STACK_FDS) {
+        /* the pollfd array goes first in the per-thread buffer, followed by poll scratch space */
+        fds_poll = get_poll_buf(nfds_poll * sizeof(struct pollfd) + POLL_SCRATCH_SIZE(nfds_poll));
+        if (!fds_poll)
+            return -ENOMEM;
+        scratch = fds_poll + nfds_poll;
+    }
 
     /* populate array of pollfd's based on user-supplied readfds & writefds */
-    nfds_t nfds_poll = 0;
+    nfds_poll = 0;
     for (int fd = 0; fd < nfds; fd++) {
         short events = 0;
         if (readfds && __FD_ISSET(fd, readfds))
@@ -256,20 +300,16 @@ int shim_do_select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds
         struct shim_handle* hdl = __get_fd_handle(fds_poll[i].fd, NULL, map);
         if (!hdl || !hdl->fs || !hdl->fs->fs_ops) {
             /* the corresponding handle doesn't exist or doesn't provide FS-like semantics */
-            free(fds_poll);
             unlock(&map->lock);
             return -EBADF;
         }
     }
     unlock(&map->lock);
 
-    uint64_t timeout_ms = tsv ? tsv->tv_sec * 1000ULL + tsv->tv_usec / 1000 : POLL_NOTIMEOUT;
-    int ret = shim_do_poll(fds_poll, nfds_poll, timeout_ms);
-
-    if (ret < 0) {
-        free(fds_poll);
+    uint64_t timeout_us = tsv ? tsv->tv_sec * 1000000ULL + tsv->tv_usec : POLL_NOTIMEOUT;
+    int ret = do_poll(fds_poll, nfds_poll, timeout_us, scratch);
+    if (ret < 0)
         return ret;
-    }
 
     /* modify readfds, writefds, and errorfds in-place with returned events */
     if (readfds)
@@ -295,7 +335,6 @@ int shim_do_select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds
         }
     }
 
-    free(fds_poll);
     return ret;
 }
 
@@ -20,7 +20,7 @@
  * Implementation of system calls "sched_yield", "setpriority", "getpriority",
  * "sched_setparam", "sched_getparam", "sched_setscheduler", "sched_getscheduler",
  * "sched_get_priority_max", "sched_get_priority_min", "sched_rr_get_interval",
- * "sched_setaffinity", "sched_getaffinity".
+ * "sched_setaffinity", "sched_getaffinity", "getcpu".
  */
 
 #include <api.h>
@@ -30,6 +30,8 @@
 #include <pal.h>
 #include <shim_internal.h>
 #include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_vdso.h>
 
 int shim_do_sched_yield(void) {
     DkThreadYieldExecution();
@@ -168,32 +170,180 @@ static int check_affinity_params(int ncpus, size_t len, __kernel_cpu_set_t* user
     return bitmask_size_in_bytes;
 }
 
-/* dummy implementation: ignore user-supplied mask and return success */
+/* The host rejects masks smaller than its number of possible CPUs, which may be more than the
+ * online ones known to the LibOS, so the masks passed to the PAL are at least as big as the
+ * cpu_set_t of glibc */
+#define PAL_CPUMASK_MIN_SIZE    128UL
+#define CPUMASK_WORD_BITS       (8 * sizeof(unsigned long))
+
+static bool pal_affinity_unsupported(void) {
+    return PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT || PAL_NATIVE_ERRNO == PAL_ERROR_NOTIMPLEMENTED;
+}
+
+static struct shim_thread* lookup_affinity_thread(pid_t pid) {
+    if (!pid) {
+        struct shim_thread* cur = get_cur_thread();
+        get_thread(cur);
+        return cur;
+    }
+
+    /* threads of other processes are not reachable from here */
+    return lookup_thread(pid);
+}
+
+int get_thread_cpu_affinity(struct shim_thread* thread, unsigned long* bitmap, size_t size) {
+    size_t ncpus    = PAL_CB(cpu_info.cpu_num);
+    size_t pal_size = ALIGN_UP(MAX(size, PAL_CPUMASK_MIN_SIZE), sizeof(unsigned long));
+
+    unsigned long* pal_mask = malloc(pal_size);
+    if (!pal_mask)
+        return -ENOMEM;
+
+    memset(bitmap, 0, size);
+
+    bool all = true;
+    if (thread->pal_handle && DkThreadGetCpuAffinity(thread->pal_handle, pal_size, pal_mask)) {
+        all = false;
+    } else if (thread->pal_handle && !pal_affinity_unsupported()) {
+        free(pal_mask);
+        return -PAL_ERRNO;
+    }
+
+    /* hosts which do not expose affinity let the thread run everywhere */
+    for (size_t i = 0; i < ncpus && i < size * 8; i++)
+        if (all || (pal_mask[i / CPUMASK_WORD_BITS] & (1UL << (i % CPUMASK_WORD_BITS))))
+            bitmap[i / CPUMASK_WORD_BITS] |= 1UL << (i % CPUMASK_WORD_BITS);
+
+    free(pal_mask);
+    return 0;
+}
+
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
     int ncpus = PAL_CB(cpu_info.cpu_num);
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
-    return 0;
+    size_t pal_size = MAX((size_t)bitmask_size_in_bytes, PAL_CPUMASK_MIN_SIZE);
+    unsigned long* pal_mask = calloc(1, pal_size);
+    if (!pal_mask)
+        return -ENOMEM;
+
+    /* CPUs the LibOS does not know about are dropped, but at least one must remain (like Linux
+     * intersects the mask with the online CPUs) */
+    const unsigned long* user_mask = (const unsigned long*)user_mask_ptr;
+    bool any = false;
+    for (int i = 0; i < ncpus; i++)
+        if (user_mask[i / CPUMASK_WORD_BITS] & (1UL << (i % CPUMASK_WORD_BITS))) {
+            pal_mask[i / CPUMASK_WORD_BITS] |= 1UL << (i % CPUMASK_WORD_BITS);
+            any = true;
+        }
+
+    int ret = 0;
+    if (!any) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    struct shim_thread* thread = lookup_affinity_thread(pid);
+    if (!thread) {
+        ret = -ESRCH;
+        goto out;
+    }
+
+    if (thread->pal_handle && !DkThreadSetCpuAffinity(thread->pal_handle, pal_size, pal_mask) &&
+            !pal_affinity_unsupported())
+        ret = -PAL_ERRNO;
+
+    put_thread(thread);
+out:
+    free(pal_mask);
+    return ret;
 }
 
-/* dummy implementation: always return all-ones (as many as there are host CPUs)  */
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
     int ncpus = PAL_CB(cpu_info.cpu_num);
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
+    struct shim_thread* thread = lookup_affinity_thread(pid);
+    if (!thread)
+        return -ESRCH;
+
     memset(user_mask_ptr, 0, len);
-    for (int i = 0; i < ncpus; i++) {
-        ((uint8_t*)user_mask_ptr)[i / 8] |= 1 << (i % 8);
-    }
+    int ret = get_thread_cpu_affinity(thread, (unsigned long*)user_mask_ptr,
+                                      bitmask_size_in_bytes);
+    put_thread(thread);
+    if (ret < 0)
+        return ret;
+
     /* imitate the Linux kernel implementation
      * See SYSCALL_DEFINE3(sched_getaffinity) */
     return bitmask_size_in_bytes;
 }
+
+/* Linux programs IA32_TSC_AUX with (node << 12) | cpu on every CPU, so RDTSCP tells which CPU the
+ * thread is running on without leaving the process. RDTSCP is not allowed inside SGX enclaves. */
+static int rdtscp_usable = -1;
+
+static bool read_tsc_aux(uint32_t* aux) {
+    int usable = __atomic_load_n(&rdtscp_usable, __ATOMIC_RELAXED);
+
+    if (usable < 0) {
+        uint32_t eax, ebx, ecx, edx;
+        usable = 0;
+        if (strcmp_static(PAL_CB(host_type), "Linux-SGX")) {
+            __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                                     : "a"(0x80000000), "c"(0));
+            if (eax >= 0x80000001) {
+                __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                                         : "a"(0x80000001), "c"(0));
+                usable = !!(edx & (1 << 27));
+            }
+        }
+        __atomic_store_n(&rdtscp_usable, usable, __ATOMIC_RELAXED);
+    }
+
+    if (!usable)
+        return false;
+
+    uint32_t lo, hi;
+    __asm__ volatile("rdtscp" : "=a"(lo), "=d"(hi), "=c"(*aux));
+    return true;
+}
+
+static void get_cur_cpu(unsigned* cpu, unsigned* node) {
+    uint32_t aux;
+
+    /* without RDTSCP, pretend to always run on the first CPU */
+    if (!read_tsc_aux(&aux))
+        aux = 0;
+
+    if (cpu)
+        *cpu = aux & 0xfff;
+    if (node)
+        *node = aux >> 12;
+}
+
+int shim_do_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused) {
+    __UNUSED(unused);
+
+    if (cpu && test_user_memory(cpu, sizeof(*cpu), true))
+        return -EFAULT;
+
+    if (node && test_user_memory(node, sizeof(*node), true))
+        return -EFAULT;
+
+    get_cur_cpu(cpu, node);
+    return 0;
+}
+
+/* vDSO entry: like the kernel's, it does not validate the user pointers */
+long vdso_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused) {
+    __UNUSED(unused);
+    get_cur_cpu(cpu, node);
+    return 0;
+}
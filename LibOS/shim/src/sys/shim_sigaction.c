@@ -257,8 +257,21 @@ struct walk_arg {
     IDTYPE id;
     int sig;
     bool use_ipc;
+    /* a signal watched by a signalfd is queued to one thread of each process only, so that it is
+     * read once (see shim_signalfd.c) */
+    bool once;
 };
 
+static inline void init_walk_arg(struct walk_arg* warg, struct shim_thread* cur, IDTYPE sender,
+                                 IDTYPE id, int sig, bool use_ipc) {
+    warg->current = cur;
+    warg->sender  = sender;
+    warg->id      = id;
+    warg->sig     = sig;
+    warg->use_ipc = use_ipc;
+    warg->once    = sig > 0 && signalfd_watches(sig);
+}
+
 // Need to hold thread->lock
 static inline void __append_signal(struct shim_thread* thread, int sig, IDTYPE sender) {
     assert(locked(&thread->lock));
@@ -271,6 +284,18 @@ static inline void __append_signal(struct shim_thread* thread, int sig, IDTYPE s
     append_signal(thread, sig, &info, true);
 }
 
+// Need to hold thread->lock and thread_list_lock
+static inline void __append_walk_signal(struct shim_thread* thread, struct walk_arg* warg) {
+    if (warg->sig <= 0)
+        return;
+
+    /* the other threads of the process skip it, like Linux does */
+    if (warg->once && __get_signal_thread(thread->tgid, warg->sig) != thread->tid)
+        return;
+
+    __append_signal(thread, warg->sig, warg->sender);
+}
+
 static int __kill_proc(struct shim_thread* thread, void* arg, bool* unlocked) {
     struct walk_arg* warg = (struct walk_arg*)arg;
     int srched = 0;
@@ -302,8 +327,7 @@ static int __kill_proc(struct shim_thread* thread, void* arg, bool* unlocked) {
             goto out_locked;
 
         if (thread->in_vm) {
-            if (warg->sig > 0)
-                __append_signal(thread, warg->sig, warg->sender);
+            __append_walk_signal(thread, warg);
             srched = 1;
         } else {
             /* This double-check case is probably unnecessary, but keep it for now */
@@ -348,11 +372,7 @@ int do_kill_proc(IDTYPE sender, IDTYPE tgid, int sig, bool use_ipc) {
     }
 
     struct walk_arg arg;
-    arg.current = cur;
-    arg.sender  = sender;
-    arg.id      = tgid;
-    arg.sig     = sig;
-    arg.use_ipc = use_ipc;
+    init_walk_arg(&arg, cur, sender, tgid, sig, use_ipc);
 
     bool srched = false;
 
@@ -391,8 +411,7 @@ static int __kill_pgroup(struct shim_thread* thread, void* arg, bool* unlocked)
         goto out;
 
     if (thread->in_vm) {
-        if (warg->sig > 0)
-            __append_signal(thread, warg->sig, warg->sender);
+        __append_walk_signal(thread, warg);
 
         srched = 1;
     } else {
@@ -435,11 +454,7 @@ int do_kill_pgroup(IDTYPE sender, IDTYPE pgid, int sig, bool use_ipc) {
     }
 
     struct walk_arg arg;
-    arg.current = cur;
-    arg.sender  = sender;
-    arg.id      = pgid;
-    arg.sig     = sig;
-    arg.use_ipc = use_ipc;
+    init_walk_arg(&arg, cur, sender, pgid, sig, use_ipc);
 
     bool srched = false;
 
@@ -464,7 +479,8 @@ static int __kill_all_threads(struct shim_thread* thread, void* arg, bool* unloc
     int srched = 0;
     struct walk_arg* warg = (struct walk_arg*)arg;
 
-    if (thread->tgid != thread->tid)
+    /* one thread of each process; if a signalfd watches the signal, the one which takes it */
+    if (!warg->once && thread->tgid != thread->tid)
         return 0;
 
     if (warg->current == thread)
@@ -473,7 +489,7 @@ static int __kill_all_threads(struct shim_thread* thread, void* arg, bool* unloc
     lock(&thread->lock);
 
     if (thread->in_vm) {
-        __append_signal(thread, warg->sig, warg->sender);
+        __append_walk_signal(thread, warg);
         srched = 1;
     }
 
@@ -483,11 +499,7 @@ static int __kill_all_threads(struct shim_thread* thread, void* arg, bool* unloc
 
 int kill_all_threads(struct shim_thread* cur, IDTYPE sender, int sig) {
     struct walk_arg arg;
-    arg.current = cur;
-    arg.sender  = sender;
-    arg.id      = 0;
-    arg.sig     = sig;
-    arg.use_ipc = false;
+    init_walk_arg(&arg, cur, sender, 0, sig, false);
     walk_thread_list(__kill_all_threads, &arg);
     return 0;
 }
@@ -535,11 +547,19 @@ int shim_do_kill(pid_t pid, int sig) {
         if (ret == -ESRCH)
             ret = 0;
         if (sig) {
-            siginfo_t info;
-            memset(&info, 0, sizeof(siginfo_t));
-            info.si_signo = sig;
-            info.si_pid   = cur->tid;
-            deliver_signal(&info, NULL);
+            /* a signal watched by a signalfd was queued to the thread which takes it, unless this
+             * is the one */
+            if (!signalfd_watches(sig) || get_signal_thread(cur->tgid, sig) == cur->tid) {
+                siginfo_t info;
+                memset(&info, 0, sizeof(siginfo_t));
+                info.si_signo = sig;
+                info.si_pid   = cur->tid;
+                deliver_signal(&info, NULL);
+                /* deliver_signal() also runs in upcalls, which may interrupt a locked section, so
+                 * it does not notify the signalfds itself */
+                if (__sigismember(&cur->signal_mask, sig))
+                    notify_signalfds(sig);
+            }
         }
     }
 
@@ -0,0 +1,373 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_signalfd.c
+ *
+ * Implementation of system calls "signalfd" and "signalfd4".
+ *
+ * append_signal() notifies the signalfds whose mask contains the new signal, which marks them
+ * readable by writing a byte to the PAL pipe in hdl->pal_handle, so that poll() and epoll() can
+ * wait on them. read() dequeues the pending signals of the calling thread first, then those of the
+ * other threads of the process: the LibOS queues a signal to one thread only (e.g., SIGCHLD to
+ * the thread that forked the child), while Linux lets any thread read the signals sent to the
+ * process. A signal sent to the process and watched by a signalfd is queued to one of its threads
+ * only (see do_kill_proc()), so that it is read once.
+ */
+
+#include <errno.h>
+#include <linux/signalfd.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+struct shim_mount signalfd_builtin_fs;
+
+DEFINE_LISTP(shim_signalfd_handle);
+static LISTP_TYPE(shim_signalfd_handle) signalfd_list = LISTP_INIT;
+static struct shim_lock signalfd_list_lock;
+
+/* must be called with signalfd_list_lock held */
+static void signalfd_set_ready(struct shim_signalfd_handle* signalfd) {
+    struct shim_handle* hdl = container_of(signalfd, struct shim_handle, info.signalfd);
+
+    if (!signalfd->ready) {
+        char byte = 0;
+        signalfd->ready = true;
+        DkStreamWrite(hdl->pal_handle, 0, 1, &byte, NULL);
+    }
+}
+
+/* must be called with signalfd_list_lock held */
+static void signalfd_clear_ready(struct shim_signalfd_handle* signalfd) {
+    struct shim_handle* hdl = container_of(signalfd, struct shim_handle, info.signalfd);
+
+    if (signalfd->ready) {
+        char bytes[16];
+        signalfd->ready = false;
+        while (DkStreamRead(hdl->pal_handle, 0, sizeof(bytes), bytes, NULL, 0) == sizeof(bytes))
+            ;
+    }
+}
+
+bool signalfd_watches(int sig) {
+    /* the list is populated only after the lock is created */
+    if (LISTP_EMPTY(&signalfd_list))
+        return false;
+
+    bool watched = false;
+    struct shim_signalfd_handle* signalfd;
+
+    lock(&signalfd_list_lock);
+    LISTP_FOR_EACH_ENTRY(signalfd, &signalfd_list, list) {
+        if (__sigismember(&signalfd->mask, sig)) {
+            watched = true;
+            break;
+        }
+    }
+    unlock(&signalfd_list_lock);
+    return watched;
+}
+
+void notify_signalfds(int sig) {
+    if (LISTP_EMPTY(&signalfd_list))
+        return;
+
+    struct shim_signalfd_handle* signalfd;
+
+    lock(&signalfd_list_lock);
+    LISTP_FOR_EACH_ENTRY(signalfd, &signalfd_list, list) {
+        if (__sigismember(&signalfd->mask, sig))
+            signalfd_set_ready(signalfd);
+    }
+    unlock(&signalfd_list_lock);
+}
+
+static void fill_signalfd_siginfo(struct signalfd_siginfo* ssi, int sig,
+                                  const struct shim_signal* signal) {
+    const siginfo_t* info = &signal->info;
+
+    memset(ssi, 0, sizeof(*ssi));
+    ssi->ssi_signo = sig;
+    ssi->ssi_errno = info->si_errno;
+    ssi->ssi_code  = info->si_code;
+
+    switch (sig) {
+        case SIGCHLD:
+            ssi->ssi_pid    = info->si_pid;
+            ssi->ssi_uid    = info->si_uid;
+            ssi->ssi_status = info->si_status;
+            break;
+        case SIGSEGV:
+        case SIGBUS:
+        case SIGILL:
+        case SIGFPE:
+            ssi->ssi_addr = (uint64_t)info->si_addr;
+            break;
+        default:
+            ssi->ssi_pid = info->si_pid;
+            ssi->ssi_uid = info->si_uid;
+            ssi->ssi_int = info->si_int;
+            ssi->ssi_ptr = (uint64_t)info->si_ptr;
+            break;
+    }
+}
+
+struct signalfd_walk {
+    struct shim_thread* cur;
+    const __sigset_t* mask;
+    struct signalfd_siginfo* ssi; /* NULL to only count the pending signals */
+    size_t cnt;
+    size_t max_cnt;
+};
+
+static void signalfd_walk_one(struct shim_thread* thread, struct signalfd_walk* walk) {
+    if (!thread->signal_logs)
+        return;
+
+    if (!walk->ssi) {
+        for (int sig = 1; sig < NUM_SIGS && walk->cnt < walk->max_cnt; sig++)
+            if (__sigismember(walk->mask, sig) && signal_logs_pending(thread->signal_logs, sig))
+                walk->cnt++;
+        return;
+    }
+
+    struct shim_signal* signal;
+    int sig;
+    while (walk->cnt < walk->max_cnt &&
+           (signal = fetch_pending_signal(thread, walk->mask, &sig))) {
+        fill_signalfd_siginfo(&walk->ssi[walk->cnt++], sig, signal);
+        free(signal);
+    }
+}
+
+static int signalfd_walk_thread(struct shim_thread* thread, void* arg, bool* unlocked) {
+    __UNUSED(unlocked);
+    struct signalfd_walk* walk = arg;
+
+    if (thread == walk->cur || thread->tgid != walk->cur->tgid || !thread->in_vm)
+        return 0;
+
+    if (walk->cnt < walk->max_cnt)
+        signalfd_walk_one(thread, walk);
+    return 0;
+}
+
+/* Dequeues up to `max_cnt` signals in `mask` into `ssi`, or only counts them if `ssi` is NULL;
+ * returns the number of signals. Must not be called with signalfd_list_lock held,
+ * which append_signal() takes with the thread locks held. */
+static size_t signalfd_dequeue(const __sigset_t* mask, struct signalfd_siginfo* ssi,
+                               size_t max_cnt) {
+    struct signalfd_walk walk = {
+        .cur     = get_cur_thread(),
+        .mask    = mask,
+        .ssi     = ssi,
+        .cnt     = 0,
+        .max_cnt = max_cnt,
+    };
+
+    signalfd_walk_one(walk.cur, &walk);
+    if (walk.cnt < max_cnt)
+        walk_thread_list(&signalfd_walk_thread, &walk);
+    return walk.cnt;
+}
+
+static bool signalfd_pending(const __sigset_t* mask) {
+    return signalfd_dequeue(mask, NULL, 1) > 0;
+}
+
+int shim_do_signalfd4(int fd, __sigset_t* mask, size_t sizemask, int flags) {
+    if (sizemask != sizeof(__sigset_t))
+        return -EINVAL;
+
+    if (flags & ~(SFD_CLOEXEC | SFD_NONBLOCK))
+        return -EINVAL;
+
+    if (!mask || test_user_memory(mask, sizemask, false))
+        return -EFAULT;
+
+    __sigset_t new_mask = *mask;
+    /* SIGKILL and SIGSTOP cannot be read through a signalfd, Linux silently ignores them; SIGCP is
+     * internal to the LibOS */
+    __sigdelset(&new_mask, SIGKILL);
+    __sigdelset(&new_mask, SIGSTOP);
+    __sigdelset(&new_mask, SIGCP);
+
+    if (!create_lock_runtime(&signalfd_list_lock))
+        return -ENOMEM;
+
+    if (fd != -1) {
+        struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+        if (!hdl)
+            return -EBADF;
+
+        if (hdl->type != TYPE_SIGNALFD) {
+            put_handle(hdl);
+            return -EINVAL;
+        }
+
+        bool pending = signalfd_pending(&new_mask);
+        lock(&signalfd_list_lock);
+        hdl->info.signalfd.mask = new_mask;
+        if (pending)
+            signalfd_set_ready(&hdl->info.signalfd);
+        unlock(&signalfd_list_lock);
+
+        put_handle(hdl);
+        return fd;
+    }
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_SIGNALFD;
+    set_handle_fs(hdl, &signalfd_builtin_fs);
+    hdl->flags    = O_RDONLY | (flags & SFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+
+    hdl->pal_handle = DkStreamOpen(URI_PREFIX_PIPE, PAL_ACCESS_RDWR, 0, 0, PAL_OPTION_NONBLOCK);
+    if (!hdl->pal_handle) {
+        put_handle(hdl);
+        return -PAL_ERRNO;
+    }
+
+    struct shim_signalfd_handle* signalfd = &hdl->info.signalfd;
+    signalfd->mask  = new_mask;
+    signalfd->ready = false;
+
+    bool pending = signalfd_pending(&new_mask);
+    lock(&signalfd_list_lock);
+    INIT_LIST_HEAD(signalfd, list);
+    LISTP_ADD_TAIL(signalfd, &signalfd_list, list);
+    if (pending)
+        signalfd_set_ready(signalfd);
+    unlock(&signalfd_list_lock);
+
+    int ret = set_new_fd_handle(hdl, flags & SFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_signalfd(int fd, __sigset_t* mask, size_t sizemask) {
+    return shim_do_signalfd4(fd, mask, sizemask, 0);
+}
+
+static ssize_t signalfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    struct shim_signalfd_handle* signalfd = &hdl->info.signalfd;
+    struct signalfd_siginfo* ssi = buf;
+    size_t max_cnt = count / sizeof(*ssi);
+
+    if (!max_cnt)
+        return -EINVAL;
+
+    while (true) {
+        lock(&signalfd_list_lock);
+        __sigset_t mask = signalfd->mask;
+        signalfd_clear_ready(signalfd);
+        unlock(&signalfd_list_lock);
+
+        size_t cnt = signalfd_dequeue(&mask, ssi, max_cnt);
+
+        /* signals left in the queues keep the signalfd readable; the ones appended meanwhile
+         * notify it themselves */
+        if (signalfd_pending(&mask)) {
+            lock(&signalfd_list_lock);
+            signalfd_set_ready(signalfd);
+            unlock(&signalfd_list_lock);
+        }
+
+        if (cnt)
+            return cnt * sizeof(*ssi);
+
+        if (hdl->flags & O_NONBLOCK)
+            return -EAGAIN;
+
+        PAL_FLG events = PAL_WAIT_READ;
+        PAL_FLG ret_events = 0;
+        if (!DkStreamsWaitEvents(1, &hdl->pal_handle, &events, &ret_events, NO_TIMEOUT) &&
+            PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN)
+            return -PAL_ERRNO;
+    }
+}
+
+static off_t signalfd_poll(struct shim_handle* hdl, int poll_type) {
+    off_t ret = 0;
+
+    lock(&signalfd_list_lock);
+    __sigset_t mask = hdl->info.signalfd.mask;
+    unlock(&signalfd_list_lock);
+
+    bool pending = signalfd_pending(&mask);
+
+    if (poll_type == FS_POLL_SZ)
+        ret = pending ? sizeof(struct signalfd_siginfo) : 0;
+    else if ((poll_type & FS_POLL_RD) && pending)
+        ret = FS_POLL_RD;
+
+    return ret;
+}
+
+static int signalfd_close(struct shim_handle* hdl) {
+    lock(&signalfd_list_lock);
+    if (!LIST_EMPTY(&hdl->info.signalfd, list))
+        LISTP_DEL_INIT(&hdl->info.signalfd, &signalfd_list, list);
+    unlock(&signalfd_list_lock);
+    return 0;
+}
+
+static int signalfd_checkout(struct shim_handle* hdl) {
+    /* the child gets its own readiness pipe */
+    hdl->pal_handle = NULL;
+    hdl->info.signalfd.ready = false;
+    INIT_LIST_HEAD(&hdl->info.signalfd, list);
+    return 0;
+}
+
+static int signalfd_checkin(struct shim_handle* hdl) {
+    if (!create_lock_runtime(&signalfd_list_lock))
+        return -ENOMEM;
+
+    hdl->pal_handle = DkStreamOpen(URI_PREFIX_PIPE, PAL_ACCESS_RDWR, 0, 0, PAL_OPTION_NONBLOCK);
+    if (!hdl->pal_handle)
+        return -PAL_ERRNO;
+
+    lock(&signalfd_list_lock);
+    LISTP_ADD_TAIL(&hdl->info.signalfd, &signalfd_list, list);
+    unlock(&signalfd_list_lock);
+    return 0;
+}
+
+struct shim_fs_ops signalfd_fs_ops = {
+    .read     = &signalfd_read,
+    .poll     = &signalfd_poll,
+    .close    = &signalfd_close,
+    .checkout = &signalfd_checkout,
+    .checkin  = &signalfd_checkin,
+};
+
+/* the type is at most 7 characters, see shim_handle::fs_type */
+struct shim_mount signalfd_builtin_fs = {
+    .type   = "sigfd",
+    .fs_ops = &signalfd_fs_ops,
+};
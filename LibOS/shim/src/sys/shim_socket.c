@@ -1004,127 +1004,156 @@ int shim_do_accept4(int fd, struct sockaddr* addr, socklen_t* addrlen, int flags
     return ret;
 }
 
-static ssize_t do_sendmsg(int fd, struct iovec* bufs, int nbufs, int flags,
-                          const struct sockaddr* addr, socklen_t addrlen) {
-    // Issue #752 - https://github.com/oscarlab/graphene/issues/752
-    __UNUSED(flags);
-
-    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
-    if (!hdl)
-        return -EBADF;
+/* Datagrams handed to the PAL in one DkStreamWriteBatch()/DkStreamReadBatch() call */
+#define MMSG_BATCH 16
 
-    ssize_t ret = -ENOTSOCK;
-    if (hdl->type != TYPE_SOCK)
-        goto out;
-
-    struct shim_sock_handle* sock = &hdl->info.sock;
-
-    ret = -EFAULT;
-    if (addr && test_user_memory((void*)addr, addrlen, false))
-        goto out;
+#ifndef UIO_MAXIOV
+#define UIO_MAXIOV 1024
+#endif
 
+static bool test_user_iov(struct iovec* bufs, int nbufs, bool write) {
     if (!bufs || test_user_memory(bufs, sizeof(*bufs) * nbufs, false))
-        goto out;
+        return true;
 
     for (int i = 0; i < nbufs; i++) {
-        if (!bufs[i].iov_base || test_user_memory(bufs[i].iov_base, bufs[i].iov_len, false))
-            goto out;
+        if (!bufs[i].iov_base || test_user_memory(bufs[i].iov_base, bufs[i].iov_len, write))
+            return true;
     }
 
-    lock(&hdl->lock);
+    return false;
+}
 
-    PAL_HANDLE pal_hdl = hdl->pal_handle;
-    char* uri          = NULL;
+/* Only IP datagram sockets go through DkStreamWriteBatch()/DkStreamReadBatch() */
+static bool is_batchable(struct shim_sock_handle* sock) {
+    return sock->sock_type == SOCK_DGRAM && (sock->domain == AF_INET || sock->domain == AF_INET6);
+}
+
+/* Checks that `hdl` may send and returns the PAL handle to send on. `*need_uri` is set if every
+ * datagram needs its own destination URI. Must be called with hdl->lock held. */
+static int check_send_state(struct shim_handle* hdl, PAL_HANDLE* pal_hdl, bool* need_uri) {
+    struct shim_sock_handle* sock = &hdl->info.sock;
+
+    *pal_hdl  = hdl->pal_handle;
+    *need_uri = false;
 
     /* Data gram sock need not be conneted or bound at all */
     if (sock->sock_type == SOCK_STREAM && sock->sock_state != SOCK_CONNECTED &&
-        sock->sock_state != SOCK_BOUNDCONNECTED && sock->sock_state != SOCK_ACCEPTED) {
-        ret = -ENOTCONN;
-        goto out_locked;
-    }
+        sock->sock_state != SOCK_BOUNDCONNECTED && sock->sock_state != SOCK_ACCEPTED)
+        return -ENOTCONN;
 
-    if (sock->sock_type == SOCK_DGRAM && sock->sock_state == SOCK_SHUTDOWN) {
-        ret = -ENOTCONN;
-        goto out_locked;
-    }
+    if (sock->sock_type == SOCK_DGRAM && sock->sock_state == SOCK_SHUTDOWN)
+        return -ENOTCONN;
 
-    if (!(hdl->acc_mode & MAY_WRITE)) {
-        ret = -ECONNRESET;
-        goto out_locked;
-    }
+    if (!(hdl->acc_mode & MAY_WRITE))
+        return -ECONNRESET;
 
     if (sock->sock_type == SOCK_DGRAM && sock->sock_state != SOCK_BOUNDCONNECTED &&
         sock->sock_state != SOCK_CONNECTED) {
-        if (!addr) {
-            ret = -EDESTADDRREQ;
-            goto out_locked;
-        }
-
-        if (sock->sock_state == SOCK_CREATED && !pal_hdl) {
-            pal_hdl = DkStreamOpen(URI_PREFIX_UDP, 0, 0, 0, hdl->flags & O_NONBLOCK);
-            if (!pal_hdl) {
-                ret = -PAL_ERRNO;
-                goto out_locked;
-            }
+        if (sock->sock_state == SOCK_CREATED && !*pal_hdl) {
+            *pal_hdl = DkStreamOpen(URI_PREFIX_UDP, 0, 0, 0, hdl->flags & O_NONBLOCK);
+            if (!*pal_hdl)
+                return -PAL_ERRNO;
 
-            hdl->pal_handle = pal_hdl;
+            hdl->pal_handle = *pal_hdl;
         }
 
-        if (addr && addr->sa_family != sock->domain) {
-            ret = -EINVAL;
-            goto out_locked;
-        }
-
-        uri = __alloca(SOCK_URI_SIZE);
+        *need_uri = true;
     }
 
-    unlock(&hdl->lock);
+    return 0;
+}
 
-    if (uri) {
-        struct addr_inet addr_buf;
-        inet_save_addr(sock->domain, &addr_buf, addr);
-        inet_rebase_port(false, sock->domain, &addr_buf, false);
-        size_t prefix_len = static_strlen(URI_PREFIX_UDP);
-        memcpy(uri, URI_PREFIX_UDP, prefix_len + 1);
-        if ((ret = inet_translate_addr(sock->domain,
-                                       uri + prefix_len,
-                                       SOCK_URI_SIZE - prefix_len,
-                                       &addr_buf)) < 0) {
-            lock(&hdl->lock);
-            goto out_locked;
-        }
+/* Builds in `uri` (of SOCK_URI_SIZE bytes) the PAL URI of destination `addr` */
+static int make_send_uri(struct shim_sock_handle* sock, const struct sockaddr* addr, char* uri) {
+    if (!addr)
+        return -EDESTADDRREQ;
 
-        debug("next packet send to %s\n", uri);
-    }
+    if (addr->sa_family != sock->domain)
+        return -EINVAL;
 
-    int bytes = 0;
-    ret       = 0;
+    struct addr_inet addr_buf;
+    inet_save_addr(sock->domain, &addr_buf, addr);
+    inet_rebase_port(false, sock->domain, &addr_buf, false);
+    size_t prefix_len = static_strlen(URI_PREFIX_UDP);
+    memcpy(uri, URI_PREFIX_UDP, prefix_len + 1);
+    ssize_t ret = inet_translate_addr(sock->domain, uri + prefix_len, SOCK_URI_SIZE - prefix_len,
+                                      &addr_buf);
+    return ret < 0 ? ret : 0;
+}
+
+static ssize_t send_iov(PAL_HANDLE pal_hdl, struct iovec* bufs, int nbufs, const char* uri) {
+    ssize_t bytes = 0;
 
     for (int i = 0; i < nbufs; i++) {
         PAL_NUM pal_ret = DkStreamWrite(pal_hdl, 0, bufs[i].iov_len, bufs[i].iov_base, uri);
 
         if (pal_ret == PAL_STREAM_ERROR) {
-            ret = (PAL_NATIVE_ERRNO == PAL_ERROR_STREAMEXIST) ? -ECONNABORTED : -PAL_ERRNO;
-            break;
+            if (bytes)
+                break;
+            return (PAL_NATIVE_ERRNO == PAL_ERROR_STREAMEXIST) ? -ECONNABORTED : -PAL_ERRNO;
         }
 
         bytes += pal_ret;
     }
 
-    if (bytes)
-        ret = bytes;
-    if (ret < 0) {
-        lock(&hdl->lock);
-        goto out_locked;
-    }
-    goto out;
+    return bytes;
+}
 
-out_locked:
+static ssize_t __do_sendmsg(struct shim_handle* hdl, struct iovec* bufs, int nbufs, int flags,
+                            const struct sockaddr* addr, socklen_t addrlen) {
+    // Issue #752 - https://github.com/oscarlab/graphene/issues/752
+    __UNUSED(flags);
+
+    if (hdl->type != TYPE_SOCK)
+        return -ENOTSOCK;
+
+    /* socket calls other than read/write use the host stream of socketpairs */
+    ring_pipe_migrate(hdl);
+
+    struct shim_sock_handle* sock = &hdl->info.sock;
+
+    if (addr && test_user_memory((void*)addr, addrlen, false))
+        return -EFAULT;
+
+    if (test_user_iov(bufs, nbufs, false))
+        return -EFAULT;
+
+    PAL_HANDLE pal_hdl;
+    bool need_uri;
+    char* uri = NULL;
+
+    lock(&hdl->lock);
+    ssize_t ret = check_send_state(hdl, &pal_hdl, &need_uri);
+    unlock(&hdl->lock);
     if (ret < 0)
-        sock->error = -ret;
+        goto err;
+
+    if (need_uri) {
+        uri = __alloca(SOCK_URI_SIZE);
+        if ((ret = make_send_uri(sock, addr, uri)) < 0)
+            goto err;
+
+        debug("next packet send to %s\n", uri);
+    }
 
+    ret = send_iov(pal_hdl, bufs, nbufs, uri);
+    if (ret >= 0)
+        return ret;
+
+err:
+    lock(&hdl->lock);
+    sock->error = -ret;
     unlock(&hdl->lock);
-out:
+    return ret;
+}
+
+static ssize_t do_sendmsg(int fd, struct iovec* bufs, int nbufs, int flags,
+                          const struct sockaddr* addr, socklen_t addrlen) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    ssize_t ret = __do_sendmsg(hdl, bufs, nbufs, flags, addr, addrlen);
     put_handle(hdl);
     return ret;
 }
@@ -1144,39 +1173,122 @@ ssize_t shim_do_sendmsg(int sockfd, struct msghdr* msg, int flags) {
 }
 
 ssize_t shim_do_sendmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags) {
-    ssize_t total = 0;
+    if (vlen > UIO_MAXIOV)
+        vlen = UIO_MAXIOV;
 
-    for (size_t i = 0; i * sizeof(struct mmsghdr) < vlen; i++) {
-        struct msghdr* m = &msg[i].msg_hdr;
+    if (test_user_memory(msg, sizeof(*msg) * vlen, true))
+        return -EFAULT;
 
-        ssize_t bytes =
-            do_sendmsg(sockfd, m->msg_iov, m->msg_iovlen, flags, m->msg_name, m->msg_namelen);
-        if (bytes < 0)
-            return total > 0 ? total : bytes;
+    struct shim_handle* hdl = get_fd_handle(sockfd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
 
-        msg[i].msg_len = bytes;
-        total++;
+    size_t total = 0;
+    ssize_t ret  = -ENOTSOCK;
+    if (hdl->type != TYPE_SOCK)
+        goto out;
+
+    ring_pipe_migrate(hdl);
+
+    struct shim_sock_handle* sock = &hdl->info.sock;
+    /* like the per-message path, flags other than MSG_DONTWAIT are ignored */
+    bool batch = is_batchable(sock);
+    int options = (flags & MSG_DONTWAIT) ? PAL_BATCH_NONBLOCK : 0;
+    ret = 0;
+
+    if (batch) {
+        PAL_HANDLE pal_hdl;
+        bool need_uri;
+        PAL_DGRAM dgrams[MMSG_BATCH];
+        char uris[MMSG_BATCH][SOCK_URI_SIZE];
+
+        lock(&hdl->lock);
+        ret = check_send_state(hdl, &pal_hdl, &need_uri);
+        if (ret < 0)
+            sock->error = -ret;
+        unlock(&hdl->lock);
+
+        while (!ret && total < vlen) {
+            size_t count = 0;
+            for (; count < MMSG_BATCH && total + count < vlen; count++) {
+                struct msghdr* m = &msg[total + count].msg_hdr;
+
+                if ((m->msg_name && test_user_memory(m->msg_name, m->msg_namelen, false)) ||
+                    test_user_iov(m->msg_iov, m->msg_iovlen, false)) {
+                    ret = -EFAULT;
+                    break;
+                }
+
+                dgrams[count].iov     = (PAL_IOVEC*)m->msg_iov;
+                dgrams[count].iovcnt  = m->msg_iovlen;
+                dgrams[count].addr    = NULL;
+                dgrams[count].addrlen = 0;
+                dgrams[count].bytes   = 0;
+
+                if (need_uri) {
+                    if ((ret = make_send_uri(sock, m->msg_name, uris[count])) < 0)
+                        break;
+                    dgrams[count].addr    = uris[count];
+                    dgrams[count].addrlen = SOCK_URI_SIZE;
+                }
+            }
+
+            if (!count)
+                break;
+
+            PAL_NUM sent = DkStreamWriteBatch(pal_hdl, dgrams, count, options);
+            if (sent == PAL_STREAM_ERROR) {
+                if (PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT) {
+                    /* the host cannot batch, send the rest one by one */
+                    batch = false;
+                    ret   = 0;
+                    break;
+                }
+                ret = (PAL_NATIVE_ERRNO == PAL_ERROR_STREAMEXIST) ? -ECONNABORTED : -PAL_ERRNO;
+                break;
+            }
+
+            for (size_t i = 0; i < sent; i++)
+                msg[total + i].msg_len = dgrams[i].bytes;
+
+            total += sent;
+            if (sent < count)
+                break;
+        }
+    }
+
+    if (!batch) {
+        for (; total < vlen; total++) {
+            struct msghdr* m = &msg[total].msg_hdr;
+
+            ret = __do_sendmsg(hdl, m->msg_iov, m->msg_iovlen, flags, m->msg_name,
+                               m->msg_namelen);
+            if (ret < 0)
+                break;
+
+            msg[total].msg_len = ret;
+        }
     }
 
-    return total;
+out:
+    put_handle(hdl);
+    return total ? (ssize_t)total : ret;
 }
 
-static ssize_t do_recvmsg(int fd, struct iovec* bufs, int nbufs, int flags, struct sockaddr* addr,
-                          socklen_t* addrlen) {
+static ssize_t __do_recvmsg(struct shim_handle* hdl, struct iovec* bufs, int nbufs, int flags,
+                            struct sockaddr* addr, socklen_t* addrlen) {
     if (flags & ~MSG_PEEK) {
         debug("recvmsg()/recvmmsg()/recvfrom(): unknown flag (only MSG_PEEK is supported).\n");
         return -EOPNOTSUPP;
     }
 
-    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
-    if (!hdl)
-        return -EBADF;
-
     struct shim_peek_buffer* peek_buffer = NULL;
     int ret = -ENOTSOCK;
     if (hdl->type != TYPE_SOCK)
         goto out;
 
+    ring_pipe_migrate(hdl);
+
     struct shim_sock_handle* sock = &hdl->info.sock;
 
     if (addr) {
@@ -1379,6 +1491,16 @@ out_locked:
     unlock(&hdl->lock);
     free(peek_buffer);
 out:
+    return ret;
+}
+
+static ssize_t do_recvmsg(int fd, struct iovec* bufs, int nbufs, int flags, struct sockaddr* addr,
+                          socklen_t* addrlen) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    ssize_t ret = __do_recvmsg(hdl, bufs, nbufs, flags, addr, addrlen);
     put_handle(hdl);
     return ret;
 }
@@ -1399,8 +1521,6 @@ ssize_t shim_do_recvmsg(int sockfd, struct msghdr* msg, int flags) {
 
 ssize_t shim_do_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags,
                          struct __kernel_timespec* timeout) {
-    ssize_t total = 0;
-
     // Issue # 753 - https://github.com/oscarlab/graphene/issues/753
     /* TODO(donporter): timeout properly. For now, explicitly return an error. */
     if (timeout) {
@@ -1408,19 +1528,143 @@ ssize_t shim_do_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags
         return -EOPNOTSUPP;
     }
 
-    for (size_t i = 0; i * sizeof(struct mmsghdr) < vlen; i++) {
-        struct msghdr* m = &msg[i].msg_hdr;
+    if (vlen > UIO_MAXIOV)
+        vlen = UIO_MAXIOV;
 
-        ssize_t bytes =
-            do_recvmsg(sockfd, m->msg_iov, m->msg_iovlen, flags, m->msg_name, &m->msg_namelen);
-        if (bytes < 0)
-            return total > 0 ? total : bytes;
+    if (test_user_memory(msg, sizeof(*msg) * vlen, true))
+        return -EFAULT;
+
+    struct shim_handle* hdl = get_fd_handle(sockfd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    size_t total = 0;
+    ssize_t ret  = -ENOTSOCK;
+    if (hdl->type != TYPE_SOCK)
+        goto out;
 
-        msg[i].msg_len = bytes;
-        total++;
+    ring_pipe_migrate(hdl);
+
+    struct shim_sock_handle* sock = &hdl->info.sock;
+    PAL_HANDLE pal_hdl = NULL;
+    bool need_uri      = false;
+    bool batch         = false;
+    ret = 0;
+
+    /* peeked data and sockets not ready for reading are left to the per-message path */
+    if (!(flags & ~(MSG_DONTWAIT | MSG_WAITFORONE)) && is_batchable(sock)) {
+        lock(&hdl->lock);
+        batch = !sock->peek_buffer && (hdl->acc_mode & MAY_READ) &&
+                sock->sock_state != SOCK_CREATED;
+        pal_hdl  = hdl->pal_handle;
+        need_uri = sock->sock_state != SOCK_CONNECTED && sock->sock_state != SOCK_BOUNDCONNECTED;
+        unlock(&hdl->lock);
     }
 
-    return total;
+    if (batch) {
+        PAL_DGRAM dgrams[MMSG_BATCH];
+        char uris[MMSG_BATCH][SOCK_URI_SIZE];
+
+        while (!ret && total < vlen) {
+            size_t count = 0;
+            for (; count < MMSG_BATCH && total + count < vlen; count++) {
+                struct msghdr* m = &msg[total + count].msg_hdr;
+
+                if (m->msg_name && (m->msg_namelen < minimal_addrlen(sock->domain) ||
+                                    test_user_memory(m->msg_name, m->msg_namelen, true))) {
+                    ret = -EINVAL;
+                    break;
+                }
+
+                if (test_user_iov(m->msg_iov, m->msg_iovlen, true)) {
+                    ret = -EFAULT;
+                    break;
+                }
+
+                bool want_uri = need_uri && m->msg_name;
+                dgrams[count].iov     = (PAL_IOVEC*)m->msg_iov;
+                dgrams[count].iovcnt  = m->msg_iovlen;
+                dgrams[count].addr    = want_uri ? uris[count] : NULL;
+                dgrams[count].addrlen = want_uri ? SOCK_URI_SIZE : 0;
+                dgrams[count].bytes   = 0;
+            }
+
+            if (!count)
+                break;
+
+            /* with MSG_WAITFORONE, only the first datagram is waited for */
+            int options = 0;
+            if ((flags & MSG_DONTWAIT) || ((flags & MSG_WAITFORONE) && total))
+                options = PAL_BATCH_NONBLOCK;
+            else if (flags & MSG_WAITFORONE)
+                options = PAL_BATCH_WAITFORONE;
+
+            PAL_NUM received = DkStreamReadBatch(pal_hdl, dgrams, count, options);
+            if (received == PAL_STREAM_ERROR) {
+                if (PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT) {
+                    /* the host cannot batch, receive the rest one by one */
+                    batch = false;
+                    ret   = 0;
+                    break;
+                }
+                ret = (PAL_NATIVE_ERRNO == PAL_ERROR_STREAMNOTEXIST) ? -ECONNABORTED : -PAL_ERRNO;
+                break;
+            }
+
+            for (size_t i = 0; i < received; i++) {
+                struct msghdr* m = &msg[total].msg_hdr;
+                msg[total].msg_len = dgrams[i].bytes;
+
+                if (m->msg_name) {
+                    if (dgrams[i].addr) {
+                        struct addr_inet conn;
+
+                        /* the datagram is already received, so do not drop it for its address */
+                        if (inet_parse_addr(sock->domain, sock->sock_type, dgrams[i].addr, &conn,
+                                            NULL) < 0) {
+                            debug("recvmmsg(): cannot parse sender address %s\n", dgrams[i].addr);
+                            m->msg_namelen = 0;
+                        } else {
+                            inet_rebase_port(true, sock->domain, &conn, false);
+                            m->msg_namelen = inet_copy_addr(sock->domain, m->msg_name,
+                                                            m->msg_namelen, &conn);
+                        }
+                    } else {
+                        m->msg_namelen = inet_copy_addr(sock->domain, m->msg_name, m->msg_namelen,
+                                                        &sock->addr.in.conn);
+                    }
+                }
+
+                total++;
+            }
+
+            if (received < count)
+                break;
+        }
+    }
+
+    if (!batch) {
+        for (; total < vlen; total++) {
+            struct msghdr* m = &msg[total].msg_hdr;
+
+            ret = __do_recvmsg(hdl, m->msg_iov, m->msg_iovlen, flags & ~MSG_WAITFORONE,
+                               m->msg_name, &m->msg_namelen);
+            if (ret < 0)
+                break;
+
+            msg[total].msg_len = ret;
+
+            /* the per-message path cannot poll for more datagrams without blocking */
+            if (flags & MSG_WAITFORONE) {
+                total++;
+                break;
+            }
+        }
+    }
+
+out:
+    put_handle(hdl);
+    return total ? (ssize_t)total : ret;
 }
 
 #define SHUT_RD   0
@@ -1440,6 +1684,8 @@ int shim_do_shutdown(int sockfd, int how) {
         goto out;
     }
 
+    ring_pipe_migrate(hdl);
+
     lock(&hdl->lock);
 
     if (sock->sock_state != SOCK_LISTENED && sock->sock_state != SOCK_ACCEPTED &&
@@ -1741,6 +1987,8 @@ int shim_do_setsockopt(int fd, int level, int optname, char* optval, int optlen)
         goto out;
     }
 
+    ring_pipe_migrate(hdl);
+
     struct shim_sock_handle* sock = &hdl->info.sock;
     lock(&hdl->lock);
 
@@ -1792,6 +2040,8 @@ int shim_do_getsockopt(int fd, int level, int optname, char* optval, int* optlen
         goto out;
     }
 
+    ring_pipe_migrate(hdl);
+
     struct shim_sock_handle* sock = &hdl->info.sock;
     lock(&hdl->lock);
 
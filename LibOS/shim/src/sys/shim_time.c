@@ -21,12 +21,284 @@
  */
 
 #include <errno.h>
+#include <linux/time.h>
 #include <pal.h>
 #include <pal_error.h>
+#include <shim_checkpoint.h>
 #include <shim_fs.h>
 #include <shim_handle.h>
 #include <shim_internal.h>
 #include <shim_table.h>
+#include <shim_utils.h>
+#include <shim_vdso.h>
+
+/*
+ * CLOCK_REALTIME and CLOCK_MONOTONIC are served from the TSC, without a host call per read. Both
+ * are anchored to the host clocks at some TSC value, and the TSC rate is measured against the host
+ * monotonic clock over the whole run. Anchors are refreshed every TSC_RESYNC_NS by the async
+ * helper, or by the first reader that finds the anchor stale. If the TSC clock got ahead of the
+ * host, the monotonic clock is slewed back over the next interval instead of stepping backwards.
+ * If the TSC disagrees with the host by more than TSC_MAX_DRIFT_NS (or runs backwards), e.g. because
+ * the VM was migrated or the TSCs of the cores are not synchronized, the TSC clock is given up and
+ * all reads go to the host. Until the rate is calibrated, each read is a single host call.
+ * Readers never take a lock: updates are published under a sequence counter, which is odd while an
+ * update is in progress.
+ *
+ * The clock state is migratable, so that a child starts with its parent's rate instead of going
+ * to the host until it has calibrated its own.
+ */
+#define TSC_CALIBRATE_NS 10000000ULL   /* first rate estimate after 10ms */
+#define TSC_RESYNC_NS    1000000000ULL /* re-anchor to the host clocks every second */
+#define TSC_SAMPLES      3             /* host clock reads per anchor; the tightest one is kept */
+#define TSC_MAX_DRIFT_NS 5000000ULL    /* larger errors at an anchor mean the TSC is unusable */
+
+/* TSC ticks which take at least TSC_CALIBRATE_NS (the TSC runs at less than 10 GHz); calibration is
+ * not attempted before, as it cannot succeed yet */
+#define TSC_CALIBRATE_TICKS (TSC_CALIBRATE_NS * 10)
+
+static struct {
+    uint32_t seq;
+    uint32_t updating;   /* held by the thread re-anchoring the clock */
+    uint64_t tsc_base;   /* TSC value of the current anchor */
+    uint64_t mono_base;  /* monotonic time (ns) at tsc_base */
+    uint64_t real_base;  /* wall-clock time (ns) at tsc_base */
+    uint64_t tsc_resync; /* TSC value after which the anchor is stale */
+    uint64_t mult;       /* nanoseconds per tick in 32.32 fixed point, 0 if not calibrated */
+    uint64_t rate;       /* measured rate, of which mult is the slewed version */
+    uint64_t tsc_calib;  /* reference point the rate is measured from */
+    uint64_t mono_calib;
+    bool unstable;       /* the TSC disagreed with the host clocks; inherited by children */
+} tsc_clock __attribute_migratable;
+
+static bool tsc_clock_enabled;
+
+static inline uint64_t rdtsc_ordered(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("lfence; rdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* (hi:lo) / d; the quotient must fit in 64 bits */
+static inline uint64_t div128(uint64_t hi, uint64_t lo, uint64_t d) {
+    uint64_t q, r;
+    __asm__("divq %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+}
+
+static inline uint64_t ticks_to_ns(uint64_t ticks, uint64_t mult) {
+    return (uint64_t)(((unsigned __int128)ticks * mult) >> 32);
+}
+
+static bool has_invariant_tsc(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000), "c"(0));
+    if (eax < 0x80000007)
+        return false;
+
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000007), "c"(0));
+    return edx & (1 << 8);
+}
+
+/* Reads the monotonic or wall clock from the TSC. Fails if the TSC clock is disabled, not yet
+ * calibrated or due for re-anchoring; the caller must then go to the host. */
+static bool tsc_clock_read(bool monotonic, uint64_t* time_ns) {
+    if (!tsc_clock_enabled)
+        return false;
+
+    uint32_t seq;
+    uint64_t tsc, mult, resync, ns;
+
+    do {
+        while ((seq = __atomic_load_n(&tsc_clock.seq, __ATOMIC_ACQUIRE)) & 1)
+            CPU_RELAX();
+
+        mult   = tsc_clock.mult;
+        resync = tsc_clock.tsc_resync;
+        tsc    = rdtsc_ordered();
+        ns     = (monotonic ? tsc_clock.mono_base : tsc_clock.real_base) +
+                 ticks_to_ns(tsc - tsc_clock.tsc_base, mult);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (seq != __atomic_load_n(&tsc_clock.seq, __ATOMIC_RELAXED));
+
+    /* a TSC behind the anchor was read on a core whose TSC is not synchronized */
+    if (!mult || tsc >= resync || tsc < tsc_clock.tsc_base)
+        return false;
+
+    *time_ns = ns;
+    return true;
+}
+
+/* Re-anchors the TSC clock to the host clocks and refines its rate. Does nothing if the anchor is
+ * still fresh or another thread is already updating it. */
+void update_tsc_clock(void) {
+    if (!tsc_clock_enabled)
+        return;
+
+    if (tsc_clock.mult && rdtsc_ordered() < tsc_clock.tsc_resync)
+        return;
+
+    if (!tsc_clock.rate && rdtsc_ordered() - tsc_clock.tsc_calib < TSC_CALIBRATE_TICKS)
+        return;
+
+    if (__atomic_exchange_n(&tsc_clock.updating, 1, __ATOMIC_ACQUIRE))
+        return;
+
+    /* pair a TSC value with the host monotonic time, keeping the sample least disturbed by the
+     * latency of the host call */
+    uint64_t tsc = 0, mono = 0, best = UINT64_MAX;
+    for (int i = 0; i < TSC_SAMPLES; i++) {
+        uint64_t before = rdtsc_ordered();
+        uint64_t ns     = DkSystemClockQuery(PAL_CLOCK_MONOTONIC);
+        uint64_t after  = rdtsc_ordered();
+
+        if (ns && after - before < best) {
+            best = after - before;
+            tsc  = before + (after - before) / 2;
+            mono = ns;
+        }
+    }
+
+    uint64_t real = DkSystemClockQuery(PAL_CLOCK_REALTIME);
+    if (!mono || !real)
+        goto out;
+
+    uint64_t rate = tsc_clock.rate;
+    if (mono - tsc_clock.mono_calib >= TSC_CALIBRATE_NS && tsc > tsc_clock.tsc_calib) {
+        uint64_t ns_delta = mono - tsc_clock.mono_calib;
+        rate = div128(ns_delta >> 32, ns_delta << 32, tsc - tsc_clock.tsc_calib);
+    }
+
+    if (!rate)
+        goto out;
+
+    uint64_t mult = rate;
+    if (tsc_clock.mult) {
+        uint64_t cur = tsc_clock.mono_base + ticks_to_ns(tsc - tsc_clock.tsc_base, tsc_clock.mult);
+        if (tsc < tsc_clock.tsc_base ||
+            (cur > mono ? cur - mono : mono - cur) > TSC_MAX_DRIFT_NS) {
+            debug("TSC clock disabled: it is off the host clock by %ld ns\n", (long)(cur - mono));
+            __atomic_store_n(&tsc_clock.seq, tsc_clock.seq + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            tsc_clock.mult     = 0;
+            tsc_clock.unstable = true;
+            __atomic_store_n(&tsc_clock.seq, tsc_clock.seq + 1, __ATOMIC_RELEASE);
+            tsc_clock_enabled = false;
+            goto out;
+        }
+
+        /* never let the monotonic clock go backwards when moving the anchor: if it is ahead of the
+         * host, keep its current value and run it slower until the next anchor */
+        if (cur > mono) {
+            uint64_t ahead = MIN(cur - mono, TSC_RESYNC_NS / 2);
+            mult -= rate * ahead / TSC_RESYNC_NS;
+            mono = cur;
+        }
+    }
+
+    __atomic_store_n(&tsc_clock.seq, tsc_clock.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    tsc_clock.tsc_base   = tsc;
+    tsc_clock.mono_base  = mono;
+    tsc_clock.real_base  = real;
+    tsc_clock.mult       = mult;
+    tsc_clock.rate       = rate;
+    tsc_clock.tsc_resync = tsc + div128(TSC_RESYNC_NS >> 32, TSC_RESYNC_NS << 32, rate);
+
+    __atomic_store_n(&tsc_clock.seq, tsc_clock.seq + 1, __ATOMIC_RELEASE);
+
+out:
+    __atomic_store_n(&tsc_clock.updating, 0, __ATOMIC_RELEASE);
+}
+
+int init_time(void) {
+    /* SGX enclaves cannot execute RDTSC */
+    if (!strcmp_static(PAL_CB(host_type), "Linux-SGX") || !has_invariant_tsc())
+        return 0;
+
+    if (tsc_clock.unstable)
+        return 0;
+
+    uint64_t tsc  = rdtsc_ordered();
+    uint64_t mono = DkSystemClockQuery(PAL_CLOCK_MONOTONIC);
+    if (!mono)
+        return 0;
+
+    /* the state may come from the parent, possibly caught in the middle of an update */
+    tsc_clock.seq        = 0;
+    tsc_clock.updating   = 0;
+    tsc_clock.tsc_calib  = tsc;
+    tsc_clock.mono_calib = mono;
+    tsc_clock.tsc_resync = 0;
+    tsc_clock_enabled    = true;
+
+    /* with an inherited rate, anchor right away; otherwise wait for calibration */
+    if (tsc_clock.rate) {
+        tsc_clock.mult = 0;
+        update_tsc_clock();
+    }
+
+    debug("TSC clock enabled%s\n", tsc_clock.rate ? " (rate inherited)" : "");
+    return 0;
+}
+
+/* Reads `clock` (one of PAL_CLOCK_*) in nanoseconds */
+static int clock_read(int clock, uint64_t* time_ns) {
+    if (clock == PAL_CLOCK_REALTIME || clock == PAL_CLOCK_MONOTONIC) {
+        bool monotonic = clock == PAL_CLOCK_MONOTONIC;
+
+        if (tsc_clock_read(monotonic, time_ns))
+            return 0;
+
+        /* while the TSC is not calibrated, this returns without a host call */
+        update_tsc_clock();
+        if (tsc_clock_read(monotonic, time_ns))
+            return 0;
+    }
+
+    uint64_t ns = DkSystemClockQuery(clock);
+    if (!ns) {
+        /* the host cannot read this clock; fall back to the microsecond wall clock */
+        long time = DkSystemTimeQuery();
+        if (time == -1)
+            return -PAL_ERRNO;
+        ns = time * 1000ULL;
+    }
+
+    *time_ns = ns;
+    return 0;
+}
+
+/* Maps a Linux clock ID to the PAL clock serving it */
+static int pal_clock(clockid_t which_clock) {
+    if (which_clock < 0) {
+        /* CPU-time clock of a process or thread (see clock_getcpuclockid(3)); only the caller's own
+         * clocks can be read, so treat these as the current process or thread */
+        return (which_clock & 4) ? PAL_CLOCK_THREAD_CPUTIME : PAL_CLOCK_PROCESS_CPUTIME;
+    }
+
+    switch (which_clock) {
+        case CLOCK_REALTIME:
+        case CLOCK_REALTIME_COARSE:
+        case CLOCK_REALTIME_ALARM:
+        case CLOCK_TAI:
+            return PAL_CLOCK_REALTIME;
+        case CLOCK_MONOTONIC:
+        case CLOCK_MONOTONIC_RAW:
+        case CLOCK_MONOTONIC_COARSE:
+        case CLOCK_BOOTTIME:
+        case CLOCK_BOOTTIME_ALARM:
+            return PAL_CLOCK_MONOTONIC;
+        case CLOCK_PROCESS_CPUTIME_ID:
+            return PAL_CLOCK_PROCESS_CPUTIME;
+        case CLOCK_THREAD_CPUTIME_ID:
+            return PAL_CLOCK_THREAD_CPUTIME;
+        default:
+            return -EINVAL;
+    }
+}
 
 int shim_do_gettimeofday(struct __kernel_timeval* tv, struct __kernel_timezone* tz) {
     if (!tv)
@@ -38,26 +310,26 @@ int shim_do_gettimeofday(struct __kernel_timeval* tv, struct __kernel_timezone*
     if (tz && test_user_memory(tz, sizeof(*tz), true))
         return -EFAULT;
 
-    long time = DkSystemTimeQuery();
-
-    if (time == -1)
-        return -PAL_ERRNO;
+    uint64_t time;
+    int ret = clock_read(PAL_CLOCK_REALTIME, &time);
+    if (ret < 0)
+        return ret;
 
-    tv->tv_sec  = time / 1000000;
-    tv->tv_usec = time % 1000000;
+    tv->tv_sec  = time / 1000000000;
+    tv->tv_usec = (time % 1000000000) / 1000;
     return 0;
 }
 
 time_t shim_do_time(time_t* tloc) {
-    long time = DkSystemTimeQuery();
-
-    if (time == -1)
-        return -PAL_ERRNO;
+    uint64_t time;
+    int ret = clock_read(PAL_CLOCK_REALTIME, &time);
+    if (ret < 0)
+        return ret;
 
     if (tloc && test_user_memory(tloc, sizeof(*tloc), true))
         return -EFAULT;
 
-    time_t t = time / 1000000;
+    time_t t = time / 1000000000;
 
     if (tloc)
         *tloc = t;
@@ -66,8 +338,9 @@ time_t shim_do_time(time_t* tloc) {
 }
 
 int shim_do_clock_gettime(clockid_t which_clock, struct timespec* tp) {
-    /* all clock are the same */
-    __UNUSED(which_clock);
+    int clock = pal_clock(which_clock);
+    if (clock < 0)
+        return clock;
 
     if (!tp)
         return -EINVAL;
@@ -75,19 +348,35 @@ int shim_do_clock_gettime(clockid_t which_clock, struct timespec* tp) {
     if (test_user_memory(tp, sizeof(*tp), true))
         return -EFAULT;
 
-    long time = DkSystemTimeQuery();
-
-    if (time == -1)
-        return -PAL_ERRNO;
+    uint64_t time;
+    int ret = clock_read(clock, &time);
+    if (ret < 0)
+        return ret;
 
-    tp->tv_sec  = time / 1000000;
-    tp->tv_nsec = (time % 1000000) * 1000;
+    tp->tv_sec  = time / 1000000000;
+    tp->tv_nsec = time % 1000000000;
     return 0;
 }
 
+/* vDSO entry of clock_gettime(): reads the TSC clock directly and only goes through the system call
+ * path when the host has to be asked */
+int vdso_clock_gettime(clockid_t which_clock, struct timespec* tp) {
+    uint64_t time;
+
+    if (tp && (which_clock == CLOCK_REALTIME || which_clock == CLOCK_MONOTONIC) &&
+        tsc_clock_read(which_clock == CLOCK_MONOTONIC, &time)) {
+        tp->tv_sec  = time / 1000000000;
+        tp->tv_nsec = time % 1000000000;
+        return 0;
+    }
+
+    return __shim_clock_gettime(which_clock, (long)tp);
+}
+
 int shim_do_clock_getres(clockid_t which_clock, struct timespec* tp) {
-    /* all clock are the same */
-    __UNUSED(which_clock);
+    int clock = pal_clock(which_clock);
+    if (clock < 0)
+        return clock;
 
     if (!tp)
         return -EINVAL;
@@ -96,6 +385,6 @@ int shim_do_clock_getres(clockid_t which_clock, struct timespec* tp) {
         return -EFAULT;
 
     tp->tv_sec  = 0;
-    tp->tv_nsec = 1000;
+    tp->tv_nsec = (tsc_clock_enabled && clock <= PAL_CLOCK_MONOTONIC) ? 1 : 1000;
     return 0;
 }
@@ -0,0 +1,374 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_timerfd.c
+ *
+ * Implementation of system calls "timerfd_create", "timerfd_settime" and "timerfd_gettime".
+ *
+ * Timers are emulated inside the LibOS: expirations are scheduled on the async helper thread, and
+ * its callback counts them in the handle and marks the handle readable by writing a byte to the
+ * PAL pipe in hdl->pal_handle, so that read(), poll() and epoll() behave as on Linux. Child
+ * processes and execve() inherit the pending expirations of a timer but not the timer itself.
+ */
+
+#include <asm/fcntl.h>
+#include <errno.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_utils.h>
+
+/* linux/timerfd.h is missing on older hosts */
+#ifndef TFD_TIMER_ABSTIME
+#define TFD_TIMER_ABSTIME       (1 << 0)
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#define TFD_CLOEXEC             O_CLOEXEC
+#define TFD_NONBLOCK            O_NONBLOCK
+#endif
+
+struct shim_mount timerfd_builtin_fs;
+
+/* timerfds of this process; an expiration callback only touches a handle still in this list, so
+ * that closing a timerfd cannot race with its callback */
+DEFINE_LISTP(shim_timerfd_handle);
+static LISTP_TYPE(shim_timerfd_handle) timerfd_list = LISTP_INIT;
+static struct shim_lock timerfd_list_lock;
+
+static void timerfd_set_ready(struct shim_handle* hdl) {
+    char byte = 0;
+    DkStreamWrite(hdl->pal_handle, 0, 1, &byte, NULL);
+}
+
+static void timerfd_clear_ready(struct shim_handle* hdl) {
+    char bytes[16];
+    while (DkStreamRead(hdl->pal_handle, 0, sizeof(bytes), bytes, NULL, 0) == sizeof(bytes))
+        ;
+}
+
+static bool timerfd_listed(struct shim_timerfd_handle* timerfd) {
+    struct shim_timerfd_handle* tmp;
+    LISTP_FOR_EACH_ENTRY(tmp, &timerfd_list, list) {
+        if (tmp == timerfd)
+            return true;
+    }
+    return false;
+}
+
+static void timerfd_expire(IDTYPE caller, void* arg) {
+    __UNUSED(caller);
+    struct shim_handle* hdl = (struct shim_handle*)arg;
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    lock(&timerfd_list_lock);
+    if (!timerfd_listed(timerfd)) {
+        /* the timerfd was closed after this expiration was handed over to us */
+        unlock(&timerfd_list_lock);
+        return;
+    }
+
+    lock(&hdl->lock);
+    uint64_t now = DkSystemTimeQuery();
+
+    /* a stale expiration of a timer re-armed in the meantime is ignored */
+    if (timerfd->deadline && now >= timerfd->deadline) {
+        uint64_t count = 1;
+
+        if (timerfd->interval) {
+            count += (now - timerfd->deadline) / timerfd->interval;
+            timerfd->deadline += count * timerfd->interval;
+            if (install_async_timer(timerfd->deadline - now, &timerfd_expire, hdl) < 0) {
+                debug("timerfd: cannot re-arm the periodic timer\n");
+                timerfd->deadline = 0;
+            }
+        } else {
+            timerfd->deadline = 0;
+        }
+
+        if (!timerfd->expirations)
+            timerfd_set_ready(hdl);
+        timerfd->expirations += count;
+    }
+
+    unlock(&hdl->lock);
+    unlock(&timerfd_list_lock);
+}
+
+static bool timerfd_clock_valid(int clockid) {
+    switch (clockid) {
+        case CLOCK_REALTIME:
+        case CLOCK_MONOTONIC:
+        case CLOCK_BOOTTIME:
+        case CLOCK_REALTIME_ALARM:
+        case CLOCK_BOOTTIME_ALARM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int shim_do_timerfd_create(int clockid, int flags) {
+    if (!timerfd_clock_valid(clockid))
+        return -EINVAL;
+
+    if (flags & ~(TFD_CLOEXEC | TFD_NONBLOCK))
+        return -EINVAL;
+
+    if (!create_lock_runtime(&timerfd_list_lock))
+        return -ENOMEM;
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_TIMERFD;
+    set_handle_fs(hdl, &timerfd_builtin_fs);
+    hdl->flags    = O_RDONLY | (flags & TFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+
+    hdl->pal_handle = DkStreamOpen(URI_PREFIX_PIPE, PAL_ACCESS_RDWR, 0, 0, PAL_OPTION_NONBLOCK);
+    if (!hdl->pal_handle) {
+        put_handle(hdl);
+        return -PAL_ERRNO;
+    }
+
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+    timerfd->clockid     = clockid;
+    timerfd->deadline    = 0;
+    timerfd->interval    = 0;
+    timerfd->expirations = 0;
+
+    lock(&timerfd_list_lock);
+    INIT_LIST_HEAD(timerfd, list);
+    LISTP_ADD_TAIL(timerfd, &timerfd_list, list);
+    unlock(&timerfd_list_lock);
+
+    int ret = set_new_fd_handle(hdl, flags & TFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+    put_handle(hdl);
+    return ret;
+}
+
+static struct shim_handle* get_timerfd_handle(int fd) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (hdl && hdl->type != TYPE_TIMERFD) {
+        put_handle(hdl);
+        return NULL;
+    }
+    return hdl;
+}
+
+static uint64_t timespec_to_usec(const struct __kernel_timespec* ts) {
+    return ts->tv_sec * 1000000ULL + (ts->tv_nsec + 999) / 1000;
+}
+
+static void usec_to_timespec(uint64_t usec, struct __kernel_timespec* ts) {
+    ts->tv_sec  = usec / 1000000;
+    ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+static bool timespec_valid(const struct __kernel_timespec* ts) {
+    return ts->tv_sec >= 0 && ts->tv_nsec >= 0 && ts->tv_nsec < 1000000000;
+}
+
+/* must be called with hdl->lock held */
+static void timerfd_get_setting(struct shim_handle* hdl, uint64_t now,
+                                struct __kernel_itimerspec* setting) {
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+    uint64_t remaining = 0;
+
+    if (timerfd->deadline)
+        /* an expiration not yet handled by the async helper is reported as imminent */
+        remaining = timerfd->deadline > now ? timerfd->deadline - now : 1;
+
+    usec_to_timespec(remaining, &setting->it_value);
+    usec_to_timespec(timerfd->interval, &setting->it_interval);
+}
+
+int shim_do_timerfd_settime(int fd, int flags, const struct __kernel_itimerspec* new_setting,
+                            struct __kernel_itimerspec* old_setting) {
+    if (flags & ~(TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET))
+        return -EINVAL;
+
+    if (!new_setting || test_user_memory((void*)new_setting, sizeof(*new_setting), false))
+        return -EFAULT;
+
+    if (old_setting && test_user_memory(old_setting, sizeof(*old_setting), true))
+        return -EFAULT;
+
+    if (!timespec_valid(&new_setting->it_value) || !timespec_valid(&new_setting->it_interval))
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_timerfd_handle(fd);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+    uint64_t value    = timespec_to_usec(&new_setting->it_value);
+    uint64_t interval = timespec_to_usec(&new_setting->it_interval);
+    int ret = 0;
+
+    if (value && (flags & TFD_TIMER_ABSTIME)) {
+        /* convert the absolute time on the timer's clock into a relative one */
+        struct timespec clock_now;
+        ret = shim_do_clock_gettime(timerfd->clockid, &clock_now);
+        if (ret < 0)
+            goto out;
+
+        uint64_t clock_now_usec = clock_now.tv_sec * 1000000ULL + clock_now.tv_nsec / 1000;
+        /* an absolute time in the past expires right away */
+        value = value > clock_now_usec ? value - clock_now_usec : 1;
+    }
+
+    lock(&hdl->lock);
+
+    uint64_t now = DkSystemTimeQuery();
+    if (old_setting)
+        timerfd_get_setting(hdl, now, old_setting);
+
+    /* disarm the previous setting; an expiration of it already in flight is ignored by
+     * timerfd_expire() since it checks the new deadline */
+    cancel_async_timer(&timerfd_expire, hdl);
+    timerfd->deadline    = value ? now + value : 0;
+    timerfd->interval    = interval;
+    timerfd->expirations = 0;
+    timerfd_clear_ready(hdl);
+
+    if (value) {
+        /* the async helper computes its expiration time after `now`, so the callback never runs
+         * before the deadline */
+        ret = install_async_timer(value, &timerfd_expire, hdl);
+        if (ret < 0)
+            timerfd->deadline = 0;
+    }
+
+    unlock(&hdl->lock);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_timerfd_gettime(int fd, struct __kernel_itimerspec* cur_setting) {
+    if (!cur_setting || test_user_memory(cur_setting, sizeof(*cur_setting), true))
+        return -EFAULT;
+
+    struct shim_handle* hdl = get_timerfd_handle(fd);
+    if (!hdl)
+        return -EBADF;
+
+    lock(&hdl->lock);
+    timerfd_get_setting(hdl, DkSystemTimeQuery(), cur_setting);
+    unlock(&hdl->lock);
+
+    put_handle(hdl);
+    return 0;
+}
+
+static ssize_t timerfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    if (count < sizeof(uint64_t))
+        return -EINVAL;
+
+    while (true) {
+        lock(&hdl->lock);
+        uint64_t expirations = timerfd->expirations;
+        if (expirations) {
+            timerfd->expirations = 0;
+            timerfd_clear_ready(hdl);
+        }
+        bool nonblock = hdl->flags & O_NONBLOCK;
+        unlock(&hdl->lock);
+
+        if (expirations) {
+            memcpy(buf, &expirations, sizeof(expirations));
+            return sizeof(expirations);
+        }
+
+        if (nonblock)
+            return -EAGAIN;
+
+        PAL_FLG events = PAL_WAIT_READ;
+        PAL_FLG ret_events = 0;
+        if (!DkStreamsWaitEvents(1, &hdl->pal_handle, &events, &ret_events, NO_TIMEOUT) &&
+            PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN)
+            return -PAL_ERRNO;
+    }
+}
+
+static off_t timerfd_poll(struct shim_handle* hdl, int poll_type) {
+    off_t ret = 0;
+
+    lock(&hdl->lock);
+    if (poll_type == FS_POLL_SZ)
+        ret = hdl->info.timerfd.expirations ? sizeof(uint64_t) : 0;
+    else if ((poll_type & FS_POLL_RD) && hdl->info.timerfd.expirations)
+        ret = FS_POLL_RD;
+    unlock(&hdl->lock);
+
+    return ret;
+}
+
+static int timerfd_close(struct shim_handle* hdl) {
+    lock(&timerfd_list_lock);
+    if (!LIST_EMPTY(&hdl->info.timerfd, list))
+        LISTP_DEL_INIT(&hdl->info.timerfd, &timerfd_list, list);
+    unlock(&timerfd_list_lock);
+
+    cancel_async_timer(&timerfd_expire, hdl);
+    return 0;
+}
+
+static int timerfd_checkout(struct shim_handle* hdl) {
+    /* the readiness pipe and the timer itself stay with this process */
+    hdl->pal_handle = NULL;
+    hdl->info.timerfd.deadline = 0;
+    INIT_LIST_HEAD(&hdl->info.timerfd, list);
+    return 0;
+}
+
+static int timerfd_checkin(struct shim_handle* hdl) {
+    if (!create_lock_runtime(&timerfd_list_lock))
+        return -ENOMEM;
+
+    hdl->pal_handle = DkStreamOpen(URI_PREFIX_PIPE, PAL_ACCESS_RDWR, 0, 0, PAL_OPTION_NONBLOCK);
+    if (!hdl->pal_handle)
+        return -PAL_ERRNO;
+
+    if (hdl->info.timerfd.expirations)
+        timerfd_set_ready(hdl);
+
+    lock(&timerfd_list_lock);
+    LISTP_ADD_TAIL(&hdl->info.timerfd, &timerfd_list, list);
+    unlock(&timerfd_list_lock);
+    return 0;
+}
+
+struct shim_fs_ops timerfd_fs_ops = {
+    .read     = &timerfd_read,
+    .poll     = &timerfd_poll,
+    .close    = &timerfd_close,
+    .checkout = &timerfd_checkout,
+    .checkin  = &timerfd_checkin,
+};
+
+struct shim_mount timerfd_builtin_fs = {
+    .type   = "timerfd",
+    .fs_ops = &timerfd_fs_ops,
+};
@@ -18,6 +18,17 @@
  * shim_vfork.c
  *
  * Implementation of system call "vfork".
+ *
+ * By default, vfork() is an alias to fork(). With "sys.vfork = 1" in the
+ * manifest, the child instead runs on the host thread of the parent, in the
+ * same address space, while the parent is suspended. The child is expected to
+ * call execve() or _exit() right away: execve() sends only the handles, the
+ * working directory and the environment to the new process (no memory is
+ * checkpointed), and both calls switch execution back to the parent.
+ *
+ * The child runs on the stack of the parent, so the frames of the LibOS
+ * between the user stack pointer and the vfork() call site are saved when the
+ * child is created, and copied back before the parent resumes.
  */
 
 #include <asm/prctl.h>
@@ -33,79 +44,179 @@
 #include <sys/mman.h>
 #include <sys/syscall.h>
 
-int shim_do_vfork(void) {
-#ifdef ALIAS_VFORK_AS_FORK
-    debug("vfork() is an alias to fork() in Graphene, calling fork() now\n");
-    return shim_do_fork();
-#else
-    /* NOTE: leaving this old implementation for historical reference */
-    INC_PROFILE_OCCURENCE(syscall_use_ipc);
+/* the frames of the LibOS saved for the parent must be small; anything else
+ * means the syscall did not come through syscalldb, so fall back to fork() */
+#define VFORK_MAX_SAVED_STACK   (16 * 1024)
+#define VFORK_RESUME_STACK_SIZE (16 * 1024)
+
+struct shim_vfork_state {
+    void* jmpbuf[5];
+    struct shim_thread* child;
+    struct shim_context context;
+    void* saved_stack;
+    void* saved_stack_top;
+    /* slack for the frame of save_parent_stack() */
+    char stack_copy[VFORK_MAX_SAVED_STACK + 256];
+    char resume_stack[VFORK_RESUME_STACK_SIZE] __attribute__((aligned(16)));
+};
+
+static int vfork_enabled = -1;
+
+static bool real_vfork_enabled(void) {
+    if (vfork_enabled < 0) {
+        if (!root_config)
+            return false;
+
+        char cfg[2];
+        ssize_t len = get_config(root_config, "sys.vfork", cfg, sizeof(cfg));
+        vfork_enabled = (len == 1 && cfg[0] == '1');
+    }
 
-    /* DEP 7/7/12 - Why r13?
-     *
-     * Chia-che: when libc call vfork, they store the pointer to the
-     * caller in rdi. (reference: sysdeps/unix/sysv/linux/x86_64/vfork.S.
-     * Because rdi might be used in SHIM, I cache rdi in r13 (reference:
-     * syscallas.S).
-     */
-    struct shim_thread* cur_thread = get_cur_thread();
-    struct shim_thread* new_thread = get_new_thread(0);
-    /* put the new thread in a new process (thread group) */
+    return vfork_enabled;
+}
 
-    __asm__ volatile ("movq %%rbp, %0\r\n" : "=r"(new_thread->frameptr));
+/* Copies everything from the frame of this function up to the end of the
+ * syscall registers; this includes the frames of do_vfork() and the
+ * syscall wrapper, which the child is going to overwrite. */
+static void __attribute__((noinline)) save_parent_stack(struct shim_vfork_state* state) {
+    void* bottom = __builtin_frame_address(0);
+    size_t size  = state->saved_stack_top - bottom;
 
-    size_t stack_size = 4096;
+    assert(size <= sizeof(state->stack_copy));
+    memcpy(state->stack_copy, bottom, size);
+    state->saved_stack = bottom;
+}
 
-    if (new_thread->frameptr <= cur_thread->stack_top && new_thread->frameptr > cur_thread->stack)
-        stack_size = cur_thread->stack_top - new_thread->frameptr;
+/* Runs on the resume stack of the parent, so it can restore the original
+ * stack of the parent, and jumps back into shim_do_vfork(). */
+noreturn static void resume_parent(struct shim_thread* parent) {
+    struct shim_vfork_state* state = parent->vfork_state;
+    shim_tcb_t* tcb = shim_get_tcb();
 
-    void* dummy_stack = system_malloc(stack_size);
+    memcpy(state->saved_stack, state->stack_copy, state->saved_stack_top - state->saved_stack);
 
-    if (!dummy_stack) {
-        debug("creation of stack failed\n");
-        put_thread(new_thread);
-        return -PAL_ERRNO;
+    if (tcb->context.fs_base != state->context.fs_base)
+        DkSegmentRegister(PAL_SEGMENT_FS, (PAL_PTR)state->context.fs_base);
+    tcb->context = state->context;
+
+    set_cur_thread(parent);
+    __builtin_longjmp(state->jmpbuf, 1);
+}
+
+/* Called by the vfork child when it exits or has successfully called execve();
+ * the child must not be in the VM anymore. */
+noreturn void switch_dummy_thread(struct shim_thread* thread) {
+    struct shim_thread* parent = thread->dummy;
+    assert(parent && parent->vfork_state);
+    assert(!thread->in_vm);
+
+    lock(&thread->lock);
+    thread->dummy      = NULL;
+    /* the host thread belongs to the parent */
+    thread->pal_handle = NULL;
+    unlock(&thread->lock);
+
+    debug("vfork child %d done, switching back to parent %d\n", thread->tid, parent->tid);
+
+    __disable_preempt(shim_get_tcb());
+
+    void* stack = parent->vfork_state->resume_stack + VFORK_RESUME_STACK_SIZE;
+    __asm__ volatile("movq %0, %%rsp\r\n"
+                     "callq *%1\r\n"
+                     :: "r"(stack), "r"(&resume_parent), "D"(parent)
+                     : "memory");
+    __builtin_unreachable();
+}
+
+static int do_vfork(void) {
+    struct shim_thread* cur_thread = get_cur_thread();
+    shim_tcb_t* tcb = shim_get_tcb();
+    int ret;
+
+    struct shim_regs* parent_regs = tcb->context.regs;
+    void* saved_stack_top = (void*)parent_regs + sizeof(struct shim_regs);
+    void* sp;
+    __asm__ volatile("movq %%rsp, %0\r\n" : "=r"(sp));
+
+    if (!parent_regs || (void*)parent_regs < sp ||
+        saved_stack_top - sp > VFORK_MAX_SAVED_STACK) {
+        debug("vfork() not called on the user stack, calling fork() instead\n");
+        return shim_do_fork();
     }
 
-    memcpy(dummy_stack, new_thread->frameptr, stack_size);
-
-    /* assigned the stack of the thread */
-    lock(&cur_thread->lock);
-    new_thread->tgid      = new_thread->tid;
-    new_thread->in_vm     = true;
-    new_thread->is_alive  = true;
-    new_thread->stack     = cur_thread->stack;
-    new_thread->stack_top = cur_thread->stack_top;
-    cur_thread->stack     = dummy_stack;
-    cur_thread->stack_top = dummy_stack + stack_size;
-    cur_thread->frameptr  = NULL;
-    unlock(&cur_thread->lock);
-
-    /* Now we are good, set this child as ours */
-    set_as_child(NULL, new_thread);
-    /* add the child to the global list */
-    add_thread(new_thread);
-    new_thread->dummy = cur_thread;
+    if ((ret = prepare_ns_leaders()) < 0)
+        return ret;
+
+    struct shim_vfork_state* state = malloc(sizeof(*state));
+    if (!state)
+        return -ENOMEM;
+
+    struct shim_thread* new_thread = get_new_thread(0);
+    if (!new_thread) {
+        free(state);
+        return -ENOMEM;
+    }
 
-    struct shim_handle_map* handle_map = get_cur_handle_map(cur_thread);
-    /* pop the ref count of current handle map to prevent revocation */
-    get_handle_map(handle_map);
     struct shim_handle_map* new_map = NULL;
-    /* duplicate handle map intp a new handle map */
-    dup_handle_map(&new_map, handle_map);
-    /* set the new handle map to new thread */
+    if ((ret = dup_handle_map(&new_map, get_cur_handle_map(cur_thread))) < 0) {
+        put_thread(new_thread);
+        free(state);
+        return ret;
+    }
     set_handle_map(new_thread, new_map);
-    /* push back the ref count of handle map */
-    put_handle_map(handle_map);
 
-    /* we have the thread handle from PAL, now set it to the child */
+    state->child           = new_thread;
+    state->context         = tcb->context;
+    state->saved_stack_top = saved_stack_top;
+
+    new_thread->tgid       = new_thread->tid;
+    new_thread->in_vm      = true;
+    new_thread->is_alive   = true;
+    new_thread->dummy      = cur_thread;
     new_thread->pal_handle = cur_thread->pal_handle;
+    add_thread(new_thread);
+    set_as_child(cur_thread, new_thread);
+
+    cur_thread->vfork_state = state;
+
+    if (__builtin_setjmp(state->jmpbuf)) {
+        /* the parent is back: the locals above may be stale, so only use the
+         * state reachable from the current thread */
+        cur_thread = get_cur_thread();
+        state = cur_thread->vfork_state;
+        cur_thread->vfork_state = NULL;
 
-    /* set the current thread running */
+        IDTYPE child = state->child->tid;
+        put_thread(state->child);
+        free(state);
+
+        debug("shim_vfork success (returning %d)\n", child);
+        return child;
+    }
+
+    save_parent_stack(state);
+
+    /* from now on, this host thread runs the child until it calls execve() or
+     * _exit(); it returns 0 to the user code on the stack of the parent */
     set_cur_thread(new_thread);
-    put_thread(new_thread);
 
-    /* here we return immediately, no letting the hooks mes up our stack */
-    return 0;
-#endif
+    __disable_preempt(tcb);
+    struct shim_regs regs = *parent_regs;
+    if (regs.rsp != (unsigned long)saved_stack_top) {
+        /* clone(CLONE_VFORK) with a separate stack for the child */
+        fixup_child_context(&regs);
+    }
+    tcb->context.regs = &regs;
+    restore_context(&tcb->context);
+    __builtin_unreachable();
+}
+
+int shim_do_vfork(void) {
+    if (!real_vfork_enabled()) {
+        debug("vfork() is an alias to fork() in Graphene, calling fork() now\n");
+        return shim_do_fork();
+    }
+
+    INC_PROFILE_OCCURENCE(syscall_use_ipc);
+    return do_vfork();
 }
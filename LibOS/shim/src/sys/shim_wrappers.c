@@ -17,7 +17,7 @@
 /*
  * shim_wrapper.c
  *
- * Implementation of system call "readv" and "writev".
+ * Implementation of system call "readv", "writev", "preadv" and "pwritev".
  */
 
 #include <errno.h>
@@ -137,3 +137,115 @@ out:
     put_handle(hdl);
     return ret;
 }
+
+/* preadv and pwritev issue one positional read or write per vector, so unlike readv and writev
+ * they neither take the handle lock nor touch the file marker (see do_handle_pread). */
+ssize_t shim_do_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                       unsigned long pos_l, unsigned long pos_h) {
+    __UNUSED(pos_h);
+    off_t pos = (off_t)pos_l;
+
+    if (pos < 0)
+        return -EINVAL;
+
+    if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
+        return -EINVAL;
+
+    for (unsigned long i = 0; i < vlen; i++) {
+        if (vec[i].iov_base) {
+            if (vec[i].iov_base + vec[i].iov_len <= vec[i].iov_base)
+                return -EINVAL;
+            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, true))
+                return -EFAULT;
+        }
+    }
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    ssize_t ret = 0;
+
+    if (!(hdl->acc_mode & MAY_READ)) {
+        ret = -EACCES;
+        goto out;
+    }
+
+    ssize_t bytes = 0;
+
+    for (unsigned long i = 0; i < vlen; i++) {
+        if (!vec[i].iov_base)
+            continue;
+
+        ssize_t b_vec = do_handle_pread(hdl, vec[i].iov_base, vec[i].iov_len, pos + bytes);
+        if (b_vec < 0) {
+            ret = bytes ?: b_vec;
+            goto out;
+        }
+
+        bytes += b_vec;
+
+        if ((size_t)b_vec < vec[i].iov_len)
+            break;
+    }
+
+    ret = bytes;
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+ssize_t shim_do_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen,
+                        unsigned long pos_l, unsigned long pos_h) {
+    __UNUSED(pos_h);
+    off_t pos = (off_t)pos_l;
+
+    if (pos < 0)
+        return -EINVAL;
+
+    if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
+        return -EINVAL;
+
+    for (unsigned long i = 0; i < vlen; i++) {
+        if (vec[i].iov_base) {
+            if (vec[i].iov_base + vec[i].iov_len < vec[i].iov_base)
+                return -EINVAL;
+            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, false))
+                return -EFAULT;
+        }
+    }
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    ssize_t ret = 0;
+
+    if (!(hdl->acc_mode & MAY_WRITE)) {
+        ret = -EACCES;
+        goto out;
+    }
+
+    ssize_t bytes = 0;
+
+    for (unsigned long i = 0; i < vlen; i++) {
+        if (!vec[i].iov_base)
+            continue;
+
+        ssize_t b_vec = do_handle_pwrite(hdl, vec[i].iov_base, vec[i].iov_len, pos + bytes);
+        if (b_vec < 0) {
+            ret = bytes ?: b_vec;
+            goto out;
+        }
+
+        bytes += b_vec;
+
+        if ((size_t)b_vec < vec[i].iov_len)
+            break;
+    }
+
+    ret = bytes;
+out:
+    put_handle(hdl);
+    return ret;
+}
@@ -0,0 +1,131 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Unit test for the LZ4 compressor and decompressor of checkpoints. It runs on the host, outside
+ * of Graphene:
+ *
+ *   gcc -Wall -O2 -I../../include -o lz4-test lz4-test.c && ./lz4-test
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* lz4.c only needs the declarations below from the LibOS headers */
+#define _SHIM_INTERNAL_H_
+#define _SHIM_UTILS_H_
+
+#define LZ4_MAX_INPUT 65536
+
+size_t lz4_compress(const void* src, size_t size, void* dst, size_t dst_size);
+int lz4_decompress(const void* src, size_t csize, void* dst, size_t size);
+
+#include "lz4.c"
+
+/* worst case of the block format: one literal run with its length bytes */
+#define LZ4_BOUND(size) ((size) + (size) / 255 + 16)
+
+static uint8_t src[LZ4_MAX_INPUT + 1];
+static uint8_t dst[LZ4_BOUND(LZ4_MAX_INPUT)];
+static uint8_t out[LZ4_MAX_INPUT];
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 16;
+}
+
+/* Compresses and decompresses src[0..size); returns the compressed size */
+static size_t round_trip(const char* name, size_t size) {
+    size_t csize = lz4_compress(src, size, dst, sizeof(dst));
+    if (!csize) {
+        printf("%s: compression failed (size %zu)\n", name, size);
+        exit(1);
+    }
+
+    memset(out, 0xa5, sizeof(out));
+    if (lz4_decompress(dst, csize, out, size) < 0 || memcmp(src, out, size)) {
+        printf("%s: round trip failed (size %zu)\n", name, size);
+        exit(1);
+    }
+
+    printf("%s: %zu -> %zu bytes OK\n", name, size, csize);
+    return csize;
+}
+
+int main(void) {
+    size_t csize;
+
+    /* blocks without any match */
+    round_trip("empty", 0);
+    memcpy(src, "abcdefghijk", 11);
+    round_trip("short", 11);
+
+    for (size_t i = 0; i < LZ4_MAX_INPUT; i++)
+        src[i] = next_rand();
+    round_trip("random", LZ4_MAX_INPUT);
+
+    /* long matches with length bytes, and matches overlapping their output */
+    memset(src, 0, LZ4_MAX_INPUT);
+    csize = round_trip("zeros", LZ4_MAX_INPUT);
+    assert(csize < 1024);
+
+    for (size_t period = 1; period <= 8; period++) {
+        char name[32];
+        for (size_t i = 0; i < 4096; i++)
+            src[i] = 'a' + i % period;
+        snprintf(name, sizeof(name), "period %zu", period);
+        round_trip(name, 4096);
+    }
+
+    /* a page-like mix of zeros, repeated text and noise */
+    for (size_t i = 0; i < LZ4_MAX_INPUT; i++) {
+        if (i % 4096 < 1024)
+            src[i] = 0;
+        else if (i % 4096 < 3072)
+            src[i] = "graphene checkpoint "[i % 20];
+        else
+            src[i] = next_rand();
+    }
+    csize = round_trip("mixed", LZ4_MAX_INPUT);
+    assert(csize < LZ4_MAX_INPUT);
+
+    /* inputs and outputs out of bounds are refused */
+    assert(lz4_compress(src, LZ4_MAX_INPUT + 1, dst, sizeof(dst)) == 0);
+    assert(lz4_compress(src, LZ4_MAX_INPUT, dst, 16) == 0);
+    puts("size limits OK");
+
+    /* malformed blocks are rejected, never written out of bounds */
+    csize = lz4_compress(src, LZ4_MAX_INPUT, dst, sizeof(dst));
+    assert(lz4_decompress(dst, csize, out, LZ4_MAX_INPUT - 1) == -EINVAL);
+    assert(lz4_decompress(dst, csize - 1, out, LZ4_MAX_INPUT) == -EINVAL);
+    for (int i = 0; i < 1000; i++) {
+        size_t pos = next_rand() % csize;
+        uint8_t saved = dst[pos];
+        dst[pos] ^= 1 + next_rand() % 255;
+        int ret = lz4_decompress(dst, csize, out, LZ4_MAX_INPUT);
+        assert(ret == 0 || ret == -EINVAL);
+        dst[pos] = saved;
+    }
+    puts("malformed blocks OK");
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * lz4.c
+ *
+ * A compressor and decompressor for the LZ4 block format, used to compress the memory of
+ * checkpoints. The compressor is greedy and only takes inputs of up to LZ4_MAX_INPUT bytes, so all
+ * match offsets fit in the 16 bits of the format.
+ *
+ * A block is a sequence of: a token (literal length in the high 4 bits, match length minus 4 in
+ * the low 4 bits; 15 means more length bytes follow), the literals, and a 16-bit little-endian
+ * match offset. The last sequence has literals only.
+ */
+
+#include <shim_internal.h>
+#include <shim_utils.h>
+
+#define LZ4_MIN_MATCH     4
+#define LZ4_LAST_LITERALS 5  /* the last bytes of a block are always literals */
+#define LZ4_MFLIMIT       12 /* no match starts in the last bytes of a block */
+#define LZ4_HASH_BITS     12
+
+static inline uint32_t lz4_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t v) {
+    return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t* lz4_put_length(uint8_t* op, uint8_t* oend, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= oend)
+            return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend)
+        return NULL;
+    *op++ = len;
+    return op;
+}
+
+static uint8_t* lz4_put_literals(uint8_t* op, uint8_t* oend, uint8_t** token, const uint8_t* lit,
+                                 size_t len) {
+    if (op >= oend)
+        return NULL;
+
+    *token = op++;
+    **token = (len < 15 ? len : 15) << 4;
+    if (len >= 15 && !(op = lz4_put_length(op, oend, len - 15)))
+        return NULL;
+
+    if ((size_t)(oend - op) < len)
+        return NULL;
+
+    memcpy(op, lit, len);
+    return op + len;
+}
+
+/*
+ * Compress `size` bytes (at most LZ4_MAX_INPUT) from `src` into `dst`. Returns the compressed size,
+ * or 0 if it would exceed `dst_size` (the caller should then keep the data uncompressed).
+ */
+size_t lz4_compress(const void* src, size_t size, void* dst, size_t dst_size) {
+    const uint8_t* base   = src;
+    const uint8_t* ip     = base;
+    const uint8_t* anchor = base;
+    const uint8_t* iend   = base + size;
+    uint8_t* op           = dst;
+    uint8_t* oend         = op + dst_size;
+    uint8_t* token;
+    uint16_t table[1 << LZ4_HASH_BITS];
+
+    if (size > LZ4_MAX_INPUT)
+        return 0;
+
+    memset(table, 0, sizeof(table));
+
+    if (size > LZ4_MFLIMIT) {
+        const uint8_t* mflimit    = iend - LZ4_MFLIMIT;
+        const uint8_t* matchlimit = iend - LZ4_LAST_LITERALS;
+
+        while (ip < mflimit) {
+            uint32_t seq       = lz4_read32(ip);
+            uint32_t h         = lz4_hash(seq);
+            const uint8_t* ref = base + table[h];
+            table[h]           = ip - base;
+
+            if (ref >= ip || lz4_read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            size_t len = LZ4_MIN_MATCH;
+            while (ip + len < matchlimit && ref[len] == ip[len])
+                len++;
+
+            if (!(op = lz4_put_literals(op, oend, &token, anchor, ip - anchor)))
+                return 0;
+
+            if (oend - op < 2)
+                return 0;
+            uint16_t offset = ip - ref;
+            *op++ = offset & 0xff;
+            *op++ = offset >> 8;
+
+            len -= LZ4_MIN_MATCH;
+            *token |= len < 15 ? len : 15;
+            if (len >= 15 && !(op = lz4_put_length(op, oend, len - 15)))
+                return 0;
+
+            ip += len + LZ4_MIN_MATCH;
+            anchor = ip;
+        }
+    }
+
+    if (!(op = lz4_put_literals(op, oend, &token, anchor, iend - anchor)))
+        return 0;
+
+    return op - (uint8_t*)dst;
+}
+
+static int lz4_get_length(const uint8_t** ip, const uint8_t* iend, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend)
+            return -EINVAL;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+/*
+ * Decompress `csize` bytes from `src` into exactly `size` bytes at `dst`. Returns -EINVAL if the
+ * block is malformed.
+ */
+int lz4_decompress(const void* src, size_t csize, void* dst, size_t size) {
+    const uint8_t* ip   = src;
+    const uint8_t* iend = ip + csize;
+    uint8_t* op         = dst;
+    uint8_t* oend       = op + size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t len = token >> 4;
+        if (len == 15 && lz4_get_length(&ip, iend, &len) < 0)
+            return -EINVAL;
+        if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+            return -EINVAL;
+
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /* the last sequence has no match */
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -EINVAL;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (!offset || offset > (size_t)(op - (uint8_t*)dst))
+            return -EINVAL;
+
+        len = token & 15;
+        if (len == 15 && lz4_get_length(&ip, iend, &len) < 0)
+            return -EINVAL;
+        len += LZ4_MIN_MATCH;
+        if (len > (size_t)(oend - op))
+            return -EINVAL;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= len) {
+            memcpy(op, ref, len);
+            op += len;
+        } else {
+            /* the match overlaps the bytes it produces */
+            while (len--)
+                *op++ = *ref++;
+        }
+    }
+
+    return op == oend ? 0 : -EINVAL;
+}
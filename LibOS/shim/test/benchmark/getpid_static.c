@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NTRIES 1000000
+
+/* Built with -static, so getpid() issues a raw "syscall" instruction instead of
+ * calling into the LibOS. Compare runs with and without sys.patch_syscalls = 1. */
+int main(int argc, char** argv) {
+    long ntries = NTRIES;
+    struct timeval start, end;
+    volatile pid_t pid;
+
+    if (argc >= 2)
+        ntries = atol(argv[1]);
+
+    gettimeofday(&start, NULL);
+
+    for (long i = 0; i < ntries; i++)
+        pid = getpid();
+
+    gettimeofday(&end, NULL);
+
+    unsigned long long usec = (end.tv_sec - start.tv_sec) * 1000000ULL +
+                              (end.tv_usec - start.tv_usec);
+
+    printf("getpid() = %d, %ld calls in %llu usec (%.1f calls/sec)\n", pid, ntries, usec,
+           usec ? ntries * 1000000.0 / usec : 0.0);
+    return 0;
+}
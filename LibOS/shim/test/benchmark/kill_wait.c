@@ -0,0 +1,106 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define NROUNDS    100
+#define TEST_TIMES 64
+
+int pids[TEST_TIMES];
+
+static void sighand(int signum) {}
+
+static unsigned long long time_usec(const struct timeval* start, const struct timeval* end) {
+    return (end->tv_sec - start->tv_sec) * 1000000ULL + (end->tv_usec - start->tv_usec);
+}
+
+static unsigned long long kill_all(int times, int rounds) {
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < times; i++)
+            if (kill(pids[i], SIGUSR1) < 0) {
+                perror("kill error");
+                exit(1);
+            }
+
+    gettimeofday(&end, NULL);
+    return time_usec(&start, &end);
+}
+
+/* Signals 64 idle processes from their parent and from a sibling (which has to find out which
+ * process owns each PID), then measures killing and reaping all of them. */
+int main(int argc, char** argv) {
+    int times  = TEST_TIMES;
+    int rounds = NROUNDS;
+    struct timeval start, end;
+
+    if (argc >= 2) {
+        times = atoi(argv[1]);
+        if (times < 1 || times > TEST_TIMES)
+            return 1;
+    }
+    if (argc >= 3)
+        rounds = atoi(argv[2]);
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+    signal(SIGUSR1, sighand);
+
+    for (int i = 0; i < times; i++) {
+        pids[i] = fork();
+
+        if (pids[i] < 0) {
+            perror("fork error");
+            return 1;
+        }
+
+        if (pids[i] == 0) {
+            for (;;)
+                pause();
+        }
+    }
+
+    unsigned long long usec = kill_all(times, rounds);
+    printf("parent: %d kills in %llu usec (%.2f usec/kill)\n", times * rounds, usec,
+           (double)usec / (times * rounds));
+
+    int sibling = fork();
+    if (sibling < 0) {
+        perror("fork error");
+        return 1;
+    }
+
+    if (sibling == 0) {
+        usec = kill_all(times, rounds);
+        printf("sibling: %d kills in %llu usec (%.2f usec/kill)\n", times * rounds, usec,
+               (double)usec / (times * rounds));
+        exit(0);
+    }
+
+    if (waitpid(sibling, NULL, 0) < 0) {
+        perror("waitpid error");
+        return 1;
+    }
+
+    gettimeofday(&start, NULL);
+
+    for (int i = 0; i < times; i++)
+        kill(pids[i], SIGTERM);
+
+    for (int i = 0; i < times; i++)
+        if (waitpid(pids[i], NULL, 0) < 0) {
+            perror("waitpid error");
+            return 1;
+        }
+
+    gettimeofday(&end, NULL);
+    usec = time_usec(&start, &end);
+
+    printf("kill+wait: %d processes in %llu usec (%.2f usec/process)\n", times, usec,
+           (double)usec / times);
+    return 0;
+}
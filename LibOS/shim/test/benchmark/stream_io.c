@@ -0,0 +1,170 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NTRIES   100000
+#define PORT     8000
+#define FILE_LEN 4096
+
+static long ntries = NTRIES;
+
+static unsigned long long now_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void report(const char* name, unsigned long long nsec) {
+    printf("%-10s %ld round trips in %llu usec (%.1f nsec/round trip)\n", name, ntries,
+           nsec / 1000, (double)nsec / ntries);
+}
+
+static void xfer(ssize_t (*op)(int, void*, size_t), int fd, char* c) {
+    if (op(fd, c, 1) != 1) {
+        perror("transfer");
+        exit(1);
+    }
+}
+
+static ssize_t do_write(int fd, void* buf, size_t count) {
+    return write(fd, buf, count);
+}
+
+/* the peer thread echoes one byte at a time from rfd to wfd */
+struct echo {
+    int rfd, wfd;
+};
+
+static void* echo_thread(void* arg) {
+    struct echo* e = arg;
+    char c;
+
+    for (long i = 0; i < ntries; i++) {
+        xfer(read, e->rfd, &c);
+        xfer(do_write, e->wfd, &c);
+    }
+    return NULL;
+}
+
+/* one byte to the peer thread and back, through rfd/wfd on this side */
+static unsigned long long ping_pong(int rfd, int wfd, struct echo* peer) {
+    pthread_t thread;
+    char c = 'x';
+
+    if (pthread_create(&thread, NULL, echo_thread, peer)) {
+        perror("pthread_create");
+        exit(1);
+    }
+
+    unsigned long long start = now_nsec();
+    for (long i = 0; i < ntries; i++) {
+        xfer(do_write, wfd, &c);
+        xfer(read, rfd, &c);
+    }
+    unsigned long long nsec = now_nsec() - start;
+
+    pthread_join(thread, NULL);
+    return nsec;
+}
+
+static void bench_file(void) {
+    static char buf[FILE_LEN];
+    const char* path = "stream_io.tmp";
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror("open");
+        exit(1);
+    }
+    unlink(path);
+
+    unsigned long long start = now_nsec();
+    for (long i = 0; i < ntries; i++) {
+        if (pwrite(fd, buf, FILE_LEN, 0) != FILE_LEN || pread(fd, buf, FILE_LEN, 0) != FILE_LEN) {
+            perror("pwrite/pread");
+            exit(1);
+        }
+    }
+    report("file", now_nsec() - start);
+    close(fd);
+}
+
+static void bench_pipe(void) {
+    int to_peer[2], from_peer[2];
+
+    if (pipe(to_peer) < 0 || pipe(from_peer) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    struct echo peer = {.rfd = to_peer[0], .wfd = from_peer[1]};
+    report("pipe", ping_pong(from_peer[0], to_peer[1], &peer));
+
+    close(to_peer[0]);
+    close(to_peer[1]);
+    close(from_peer[0]);
+    close(from_peer[1]);
+}
+
+static void bench_tcp(void) {
+    struct sockaddr_in addr;
+    int one = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    int cs = socket(AF_INET, SOCK_STREAM, 0);
+    if (ls < 0 || cs < 0) {
+        perror("socket");
+        exit(1);
+    }
+    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(ls, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(ls, 1) < 0 ||
+        connect(cs, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind/listen/connect");
+        exit(1);
+    }
+
+    int ss = accept(ls, NULL, NULL);
+    if (ss < 0) {
+        perror("accept");
+        exit(1);
+    }
+    setsockopt(cs, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(ss, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct echo peer = {.rfd = ss, .wfd = ss};
+    report("tcp", ping_pong(cs, cs, &peer));
+
+    close(ss);
+    close(cs);
+    close(ls);
+}
+
+/* Latency of reads and writes on a file, a pipe and a loopback TCP connection. Run once with the
+ * default manifest and once with stream_io_io_uring.manifest, each under "strace -c -f" of the
+ * PAL loader to also compare the number of host system calls. */
+int main(int argc, char** argv) {
+    if (argc >= 2)
+        ntries = atol(argv[1]);
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    bench_file();
+    bench_pipe();
+    bench_tcp();
+    return 0;
+}
@@ -0,0 +1,101 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NTRIES 1000000
+
+static long ntries = NTRIES;
+static volatile long sink;
+
+static void call_getpid(void) {
+    sink = getpid();
+}
+
+static void call_gettid(void) {
+    sink = syscall(SYS_gettid);
+}
+
+static void call_getppid(void) {
+    sink = getppid();
+}
+
+static void call_getcpu(void) {
+    sink = sched_getcpu();
+}
+
+static void call_clock_gettime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    sink = ts.tv_nsec;
+}
+
+static const struct {
+    const char* name;
+    void (*call)(void);
+} calls[] = {
+    {"getpid", call_getpid},
+    {"gettid", call_gettid},
+    {"getppid", call_getppid},
+    {"getcpu", call_getcpu},
+    {"clock_gettime", call_clock_gettime},
+};
+
+static void run(const char* who) {
+    struct timespec start, end;
+
+    for (size_t i = 0; i < sizeof(calls) / sizeof(calls[0]); i++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        for (long j = 0; j < ntries; j++)
+            calls[i].call();
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        unsigned long long nsec = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+                                  (end.tv_nsec - start.tv_nsec);
+
+        printf("%s: %-14s %ld calls in %llu usec (%.1f nsec/call)\n", who, calls[i].name, ntries,
+               nsec / 1000, (double)nsec / ntries);
+    }
+}
+
+/* Round-trip cost of system calls that only return process or thread identity (getpid, gettid,
+ * getcpu) compared with getppid and clock_gettime. The child of a fork() repeats the measurement
+ * and checks that the identity it sees is its own. */
+int main(int argc, char** argv) {
+    if (argc >= 2)
+        ntries = atol(argv[1]);
+
+    run("parent");
+
+    fflush(stdout);
+
+    pid_t parent = getpid();
+    pid_t pid    = fork();
+    if (pid < 0) {
+        perror("fork error");
+        return 1;
+    }
+
+    if (pid == 0) {
+        if (getpid() == parent || syscall(SYS_gettid) != getpid() || getppid() != parent) {
+            printf("child: stale identity after fork\n");
+            exit(1);
+        }
+        run("child");
+        exit(0);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid error");
+        return 1;
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,74 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define SIZE_MB   1024
+#define NSTEPS    20000000
+#define PAGE_SIZE 4096
+#define SLOT      (PAGE_SIZE / sizeof(size_t))
+
+/* Chases pointers through one random cycle over all 4K pages of a large anonymous mapping, so
+ * that nearly every access misses the TLB. Run with "huge" and "small" to compare a mapping
+ * advised with MADV_HUGEPAGE against one with MADV_NOHUGEPAGE. */
+int main(int argc, char** argv) {
+    size_t size_mb = SIZE_MB;
+    int huge       = 1;
+
+    if (argc >= 2)
+        huge = strcmp(argv[1], "small") != 0;
+    if (argc >= 3)
+        size_mb = atol(argv[2]);
+
+    size_t size   = size_mb << 20;
+    size_t npages = size / PAGE_SIZE;
+    if (npages < 2)
+        return 1;
+
+    size_t* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap error");
+        return 1;
+    }
+
+    if (madvise(mem, size, huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) < 0)
+        perror("madvise error (continuing)");
+
+    /* Sattolo's algorithm: a random permutation that forms a single cycle */
+    size_t* order = malloc(npages * sizeof(*order));
+    if (!order)
+        return 1;
+    for (size_t i = 0; i < npages; i++)
+        order[i] = i;
+    srand(1);
+    for (size_t i = npages - 1; i > 0; i--) {
+        size_t j   = ((size_t)rand() * RAND_MAX + rand()) % i;
+        size_t tmp = order[i];
+        order[i]   = order[j];
+        order[j]   = tmp;
+    }
+    for (size_t i = 0; i < npages; i++)
+        mem[order[i] * SLOT] = order[(i + 1) % npages] * SLOT;
+    free(order);
+
+    struct timespec start, end;
+    size_t pos = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long i = 0; i < NSTEPS; i++)
+        pos = mem[pos];
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    unsigned long long nsec = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+                              (end.tv_nsec - start.tv_nsec);
+
+    printf("%s pages, %zu MB: %d accesses in %llu usec (%.1f nsec/access, last %zu)\n",
+           huge ? "huge" : "small", size_mb, NSTEPS, nsec / 1000, (double)nsec / NSTEPS, pos);
+
+    munmap(mem, size);
+    return 0;
+}
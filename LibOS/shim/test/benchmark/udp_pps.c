@@ -0,0 +1,103 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define PORT       8000
+#define NPACKETS   1000000
+#define BATCH      32
+#define MAX_BATCH  1024
+#define PACKET_LEN 64
+
+static struct mmsghdr smsgs[MAX_BATCH];
+static struct mmsghdr rmsgs[MAX_BATCH];
+static struct iovec iovs[MAX_BATCH];
+static struct sockaddr_in peers[MAX_BATCH];
+static char bufs[MAX_BATCH][PACKET_LEN];
+
+/* Pushes small UDP datagrams through loopback with sendmmsg()/recvmmsg(). Run with a batch size
+ * of 1 to compare against the cost of one datagram per system call. */
+int main(int argc, char** argv) {
+    long npackets = NPACKETS;
+    int batch     = BATCH;
+    struct sockaddr_in addr;
+    struct timeval start, end;
+
+    if (argc >= 2)
+        npackets = atol(argv[1]);
+    if (argc >= 3)
+        batch = atoi(argv[2]);
+    if (batch < 1 || batch > MAX_BATCH)
+        return 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int rfd = socket(AF_INET, SOCK_DGRAM, 0);
+    int sfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (rfd < 0 || sfd < 0) {
+        perror("socket error");
+        return 1;
+    }
+
+    if (bind(rfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind error");
+        return 1;
+    }
+
+    for (int i = 0; i < batch; i++) {
+        iovs[i].iov_base             = bufs[i];
+        iovs[i].iov_len              = PACKET_LEN;
+        smsgs[i].msg_hdr.msg_iov     = &iovs[i];
+        smsgs[i].msg_hdr.msg_iovlen  = 1;
+        smsgs[i].msg_hdr.msg_name    = &addr;
+        smsgs[i].msg_hdr.msg_namelen = sizeof(addr);
+        rmsgs[i].msg_hdr.msg_iov     = &iovs[i];
+        rmsgs[i].msg_hdr.msg_iovlen  = 1;
+        rmsgs[i].msg_hdr.msg_name    = &peers[i];
+    }
+
+    long sent = 0, received = 0;
+
+    gettimeofday(&start, NULL);
+
+    while (received < npackets) {
+        int n = npackets - sent < batch ? npackets - sent : batch;
+
+        int ret = sendmmsg(sfd, smsgs, n, 0);
+        if (ret < 0) {
+            perror("sendmmsg error");
+            return 1;
+        }
+        sent += ret;
+
+        for (int i = 0; i < ret; i++)
+            rmsgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+
+        ret = recvmmsg(rfd, rmsgs, ret, 0, NULL);
+        if (ret < 0) {
+            perror("recvmmsg error");
+            return 1;
+        }
+        received += ret;
+    }
+
+    gettimeofday(&end, NULL);
+
+    unsigned long long usec = (end.tv_sec - start.tv_sec) * 1000000ULL +
+                              (end.tv_usec - start.tv_usec);
+
+    printf("%ld packets (batch %d) in %llu usec (%.1f packets/sec)\n", received, batch, usec,
+           usec ? received * 1000000.0 / usec : 0.0);
+
+    close(sfd);
+    close(rfd);
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <linux/aio_abi.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#include "common.h"
+
+#define MAX_DEPTH   32
+#define CHUNK_SIZE  4096
+#define ITERATIONS  20000
+
+static const char* g_path;
+static int g_fd;
+static void* g_data;
+static size_t g_size;
+
+/* there are no glibc wrappers for the AIO system calls */
+static long io_setup(unsigned nr, aio_context_t* ctx) {
+    return syscall(__NR_io_setup, nr, ctx);
+}
+
+static long io_destroy(aio_context_t ctx) {
+    return syscall(__NR_io_destroy, ctx);
+}
+
+static long io_submit(aio_context_t ctx, long nr, struct iocb** iocbpp) {
+    return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+static long io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout) {
+    return syscall(__NR_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+static void prep_pread(struct iocb* iocb, void* buf, off_t offset) {
+    memset(iocb, 0, sizeof(*iocb));
+    iocb->aio_data       = (uintptr_t)buf;
+    iocb->aio_lio_opcode = IOCB_CMD_PREAD;
+    iocb->aio_fildes     = g_fd;
+    iocb->aio_buf        = (uintptr_t)buf;
+    iocb->aio_nbytes     = CHUNK_SIZE;
+    iocb->aio_offset     = offset;
+}
+
+static void submit(aio_context_t ctx, struct iocb* iocb) {
+    long ret = io_submit(ctx, 1, &iocb);
+    if (ret != 1)
+        fatal_error("io_submit(%s) returned %ld: %s\n", g_path, ret, strerror(errno));
+}
+
+static void check_event(struct io_event* event) {
+    struct iocb* iocb = (struct iocb*)(uintptr_t)event->obj;
+    if (event->res != CHUNK_SIZE)
+        fatal_error("AIO read(%s, %lld) returned %lld\n", g_path, (long long)iocb->aio_offset,
+                    (long long)event->res);
+    if (memcmp((void*)(uintptr_t)event->data, g_data + iocb->aio_offset, CHUNK_SIZE) != 0)
+        fatal_error("AIO read(%s, %lld) returned wrong data\n", g_path,
+                    (long long)iocb->aio_offset);
+}
+
+/* Keeps `depth` random reads of one chunk in flight, like fio with ioengine=libaio and
+ * rw=randread, and checks the data against the contents read upfront. */
+static void aio_randread(int depth) {
+    static char bufs[MAX_DEPTH][CHUNK_SIZE];
+    struct iocb iocbs[MAX_DEPTH];
+    struct io_event events[MAX_DEPTH];
+    aio_context_t ctx = 0;
+    unsigned int seed = depth;
+    struct timeval start, end;
+
+    if (io_setup(depth, &ctx) < 0)
+        fatal_error("io_setup(%d) failed: %s\n", depth, strerror(errno));
+
+    gettimeofday(&start, NULL);
+
+    int submitted = 0;
+    for (; submitted < depth; submitted++) {
+        prep_pread(&iocbs[submitted], bufs[submitted], rand_r(&seed) % (g_size - CHUNK_SIZE + 1));
+        submit(ctx, &iocbs[submitted]);
+    }
+
+    for (int completed = 0; completed < ITERATIONS;) {
+        long n = io_getevents(ctx, 1, depth, events, NULL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            fatal_error("io_getevents(%s) returned %ld: %s\n", g_path, n, strerror(errno));
+
+        for (long i = 0; i < n; i++) {
+            check_event(&events[i]);
+            completed++;
+            if (submitted < ITERATIONS) {
+                struct iocb* iocb = (struct iocb*)(uintptr_t)events[i].obj;
+                prep_pread(iocb, (void*)(uintptr_t)events[i].data,
+                           rand_r(&seed) % (g_size - CHUNK_SIZE + 1));
+                submit(ctx, iocb);
+                submitted++;
+            }
+        }
+    }
+
+    gettimeofday(&end, NULL);
+
+    if (io_destroy(ctx) < 0)
+        fatal_error("io_destroy failed: %s\n", strerror(errno));
+
+    unsigned long long usec = (end.tv_sec - start.tv_sec) * 1000000ULL +
+                              (end.tv_usec - start.tv_usec);
+    printf("aio randread(%s) depth %d OK: %llu usec (%.0f IOPS)\n", g_path, depth, usec,
+           usec ? ITERATIONS * 1000000.0 / usec : 0.0);
+}
+
+/* Reads the last chunk with IOCB_CMD_PREADV and waits for its completion on an eventfd. */
+static void aio_eventfd_check(void) {
+    char buf1[CHUNK_SIZE / 2], buf2[CHUNK_SIZE / 2];
+    struct iovec iov[2] = {{buf1, sizeof(buf1)}, {buf2, sizeof(buf2)}};
+    aio_context_t ctx = 0;
+    struct iocb iocb;
+    struct io_event event;
+
+    int efd = eventfd(0, EFD_CLOEXEC);
+    if (efd < 0)
+        fatal_error("eventfd failed: %s\n", strerror(errno));
+
+    if (io_setup(1, &ctx) < 0)
+        fatal_error("io_setup(1) failed: %s\n", strerror(errno));
+
+    memset(&iocb, 0, sizeof(iocb));
+    iocb.aio_lio_opcode = IOCB_CMD_PREADV;
+    iocb.aio_fildes     = g_fd;
+    iocb.aio_buf        = (uintptr_t)iov;
+    iocb.aio_nbytes     = 2;
+    iocb.aio_offset     = g_size - CHUNK_SIZE;
+    iocb.aio_flags      = IOCB_FLAG_RESFD;
+    iocb.aio_resfd      = efd;
+    submit(ctx, &iocb);
+
+    struct pollfd pfd = {.fd = efd, .events = POLLIN};
+    if (poll(&pfd, 1, 10000) != 1)
+        fatal_error("poll(eventfd) did not report the completion\n");
+
+    uint64_t count;
+    if (read(efd, &count, sizeof(count)) != sizeof(count) || count != 1)
+        fatal_error("read(eventfd) failed: %s\n", strerror(errno));
+
+    struct timespec zero = {0, 0};
+    if (io_getevents(ctx, 1, 1, &event, &zero) != 1)
+        fatal_error("io_getevents after eventfd failed: %s\n", strerror(errno));
+    if (event.obj != (uintptr_t)&iocb || event.res != CHUNK_SIZE)
+        fatal_error("AIO preadv(%s) returned %lld\n", g_path, (long long)event.res);
+    if (memcmp(buf1, g_data + g_size - CHUNK_SIZE, sizeof(buf1)) != 0 ||
+        memcmp(buf2, g_data + g_size - CHUNK_SIZE / 2, sizeof(buf2)) != 0)
+        fatal_error("AIO preadv(%s) returned wrong data\n", g_path);
+
+    if (io_destroy(ctx) < 0)
+        fatal_error("io_destroy failed: %s\n", strerror(errno));
+    close(efd);
+    printf("aio eventfd(%s) OK\n", g_path);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2)
+        fatal_error("Usage: %s <file_path> [max_depth]\n", argv[0]);
+
+    int max_depth = argc >= 3 ? atoi(argv[2]) : MAX_DEPTH;
+    if (max_depth < 1 || max_depth > MAX_DEPTH)
+        fatal_error("max_depth must be between 1 and %d\n", MAX_DEPTH);
+
+    setup();
+    g_path = argv[1];
+    g_fd   = open_input_fd(g_path);
+
+    struct stat st;
+    if (fstat(g_fd, &st) != 0)
+        fatal_error("Failed to stat file %s: %s\n", g_path, strerror(errno));
+    g_size = st.st_size;
+    if (g_size < CHUNK_SIZE)
+        fatal_error("File %s is smaller than %d bytes\n", g_path, CHUNK_SIZE);
+
+    g_data = alloc_buffer(g_size);
+    read_fd(g_path, g_fd, g_data, g_size);
+
+    for (int depth = 1; depth <= max_depth; depth *= 2)
+        aio_randread(depth);
+
+    aio_eventfd_check();
+
+    close_fd(g_path, g_fd);
+    free(g_data);
+    return 0;
+}
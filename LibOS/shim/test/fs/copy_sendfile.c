@@ -0,0 +1,17 @@
+#include <sys/sendfile.h>
+
+#include "common.h"
+
+void copy_data(int fi, int fo, const char* input_path, const char* output_path, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t ret = sendfile(fo, fi, NULL, size - offset);
+        if (ret < 0)
+            fatal_error("Failed to sendfile from %s to %s: %s\n", input_path, output_path,
+                        strerror(errno));
+        if (ret == 0)
+            fatal_error("sendfile from %s returned 0 at offset %zu\n", input_path, offset);
+        offset += ret;
+    }
+    printf("sendfile(%zu) OK\n", size);
+}
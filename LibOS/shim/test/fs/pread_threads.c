@@ -0,0 +1,105 @@
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#include "common.h"
+
+#define MAX_THREADS 8
+#define CHUNK_SIZE  4096
+#define ITERATIONS  10000
+
+static const char* g_path;
+static int g_fd;
+static void* g_data;
+static size_t g_size;
+
+/* Each thread reads random chunks of the file with pread() and checks them against the contents
+ * read upfront. */
+static void* reader(void* arg) {
+    unsigned int seed = (unsigned int)(uintptr_t)arg;
+    char buf[CHUNK_SIZE];
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        off_t offset = rand_r(&seed) % (g_size - CHUNK_SIZE + 1);
+        ssize_t ret  = pread(g_fd, buf, CHUNK_SIZE, offset);
+        if (ret != CHUNK_SIZE)
+            fatal_error("pread(%s, %ld) returned %zd: %s\n", g_path, (long)offset, ret,
+                        strerror(errno));
+        if (memcmp(buf, g_data + offset, CHUNK_SIZE) != 0)
+            fatal_error("pread(%s, %ld) returned wrong data\n", g_path, (long)offset);
+    }
+    return NULL;
+}
+
+static void pread_scaling(int nthreads) {
+    pthread_t threads[MAX_THREADS];
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+
+    for (int i = 0; i < nthreads; i++)
+        if (pthread_create(&threads[i], NULL, reader, (void*)(uintptr_t)(i + 1)) != 0)
+            fatal_error("pthread_create failed\n");
+
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    gettimeofday(&end, NULL);
+
+    unsigned long long usec = (end.tv_sec - start.tv_sec) * 1000000ULL +
+                              (end.tv_usec - start.tv_usec);
+    double mbytes = (double)nthreads * ITERATIONS * CHUNK_SIZE / (1024 * 1024);
+    printf("pread(%s) %d threads OK: %llu usec (%.1f MB/s)\n", g_path, nthreads, usec,
+           usec ? mbytes * 1000000.0 / usec : 0.0);
+}
+
+static void preadv_check(void) {
+    char buf1[CHUNK_SIZE / 2], buf2[CHUNK_SIZE / 2];
+    struct iovec iov[2] = {{buf1, sizeof(buf1)}, {buf2, sizeof(buf2)}};
+
+    ssize_t ret = preadv(g_fd, iov, 2, g_size - CHUNK_SIZE);
+    if (ret != CHUNK_SIZE)
+        fatal_error("preadv(%s) returned %zd: %s\n", g_path, ret, strerror(errno));
+    if (memcmp(buf1, g_data + g_size - CHUNK_SIZE, sizeof(buf1)) != 0 ||
+        memcmp(buf2, g_data + g_size - CHUNK_SIZE / 2, sizeof(buf2)) != 0)
+        fatal_error("preadv(%s) returned wrong data\n", g_path);
+    printf("preadv(%s) OK\n", g_path);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2)
+        fatal_error("Usage: %s <file_path> [max_threads]\n", argv[0]);
+
+    int max_threads = argc >= 3 ? atoi(argv[2]) : MAX_THREADS;
+    if (max_threads < 1 || max_threads > MAX_THREADS)
+        fatal_error("max_threads must be between 1 and %d\n", MAX_THREADS);
+
+    setup();
+    g_path = argv[1];
+    g_fd   = open_input_fd(g_path);
+
+    struct stat st;
+    if (fstat(g_fd, &st) != 0)
+        fatal_error("Failed to stat file %s: %s\n", g_path, strerror(errno));
+    g_size = st.st_size;
+    if (g_size < CHUNK_SIZE)
+        fatal_error("File %s is smaller than %d bytes\n", g_path, CHUNK_SIZE);
+
+    g_data = alloc_buffer(g_size);
+    read_fd(g_path, g_fd, g_data, g_size);
+
+    for (int n = 1; n <= max_threads; n *= 2)
+        pread_scaling(n);
+
+    preadv_check();
+
+    /* positional reads must not move the file offset */
+    off_t pos = tell_fd(g_path, g_fd);
+    if (pos != (off_t)g_size)
+        fatal_error("File offset of %s moved to %ld\n", g_path, (long)pos);
+    printf("tell(%s) OK\n", g_path);
+
+    close_fd(g_path, g_fd);
+    free(g_data);
+    return 0;
+}
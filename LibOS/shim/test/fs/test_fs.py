@@ -227,6 +227,23 @@ class TC_00_FileSystem(RegressionTestCase):
         self.do_truncate_test(65537, 65535)
         self.do_truncate_test(65537, 65536)
 
+    def test_150_pread_threads(self):
+        input_path = self.INPUT_FILES[-1] # existing file
+        stdout, stderr = self.run_binary(['pread_threads', input_path], timeout=60)
+        self.assertNotIn('ERROR: ', stderr)
+        for nthreads in [1, 2, 4, 8]:
+            self.assertIn('pread(' + input_path + ') ' + str(nthreads) + ' threads OK', stdout)
+        self.assertIn('preadv(' + input_path + ') OK', stdout)
+        self.assertIn('tell(' + input_path + ') OK', stdout)
+
+    def test_160_aio_randread(self):
+        input_path = self.INPUT_FILES[-1] # existing file
+        stdout, stderr = self.run_binary(['aio_randread', input_path], timeout=60)
+        self.assertNotIn('ERROR: ', stderr)
+        for depth in [1, 2, 4, 8, 16, 32]:
+            self.assertIn('aio randread(' + input_path + ') depth ' + str(depth) + ' OK', stdout)
+        self.assertIn('aio eventfd(' + input_path + ') OK', stdout)
+
     def verify_copy_content(self, input, output):
         self.assertTrue(filecmp.cmp(input, output, shallow=False))
 
@@ -246,6 +263,8 @@ class TC_00_FileSystem(RegressionTestCase):
             if exec == 'copy_whole':
                 self.assertIn('read_fd(' + size + ') input OK', stdout)
                 self.assertIn('write_fd(' + size + ') output OK', stdout)
+            if exec == 'copy_sendfile':
+                self.assertIn('sendfile(' + size + ') OK', stdout)
             if size != '0':
                 if 'copy_mmap' in exec:
                     self.assertIn('mmap_fd(' + size + ') input OK', stdout)
@@ -286,6 +305,9 @@ class TC_00_FileSystem(RegressionTestCase):
     def test_205_copy_dir_mmap_rev(self):
         self.do_copy_test('copy_mmap_rev', 60)
 
+    def test_206_copy_dir_sendfile(self):
+        self.do_copy_test('copy_sendfile', 30)
+
     def test_210_copy_dir_mounted(self):
         exec = 'copy_whole'
         stdout, stderr = self.run_binary([exec, '/mounted/input', '/mounted/output'], timeout=30)
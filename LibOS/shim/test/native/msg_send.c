@@ -63,8 +63,10 @@ void server(void) {
         }
     }
 
-    printf("time spent on %d msgsnd: %llu microsecond\n", TEST_TIMES,
-           (tv2.tv_sec * 1000000ull + tv2.tv_usec) - (tv1.tv_sec * 1000000ull + tv1.tv_usec));
+    unsigned long long usec =
+        (tv2.tv_sec * 1000000ull + tv2.tv_usec) - (tv1.tv_sec * 1000000ull + tv1.tv_usec);
+    printf("time spent on %d msgsnd: %llu microsecond (%.1f msgs/sec)\n", TEST_TIMES, usec,
+           usec ? TEST_TIMES * 1000000.0 / usec : 0.0);
 
     if (mode != IN_PROCESS)
         exit(0);
@@ -118,8 +120,10 @@ void client(void) {
         }
     }
 
-    printf("time spent on %d msgrcv: %llu microsecond\n", TEST_TIMES,
-           (tv2.tv_sec * 1000000ull + tv2.tv_usec) - (tv1.tv_sec * 1000000ull + tv1.tv_usec));
+    unsigned long long usec =
+        (tv2.tv_sec * 1000000ull + tv2.tv_usec) - (tv1.tv_sec * 1000000ull + tv1.tv_usec);
+    printf("time spent on %d msgrcv: %llu microsecond (%.1f msgs/sec)\n", TEST_TIMES, usec,
+           usec ? TEST_TIMES * 1000000.0 / usec : 0.0);
 
     if (mode != IN_PROCESS)
         exit(0);
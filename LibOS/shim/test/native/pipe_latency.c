@@ -1,3 +1,4 @@
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +9,66 @@
 #define NTRIES     10000
 #define TEST_TIMES 32
 
+static void* echo_thread(void* arg) {
+    int* pair_pipes = arg;
+    char byte;
+
+    for (int i = 0; i < NTRIES; i++) {
+        if (read(pair_pipes[0], &byte, 1) != 1) {
+            perror("read error");
+            exit(1);
+        }
+        if (write(pair_pipes[3], &byte, 1) != 1) {
+            perror("write error");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+/* same ping-pong between two threads of one process, where both ends of the pipes stay local */
+static int test_in_process(void) {
+    int pair_pipes[4];
+    pthread_t thread;
+    char byte = 0;
+
+    if (pipe(&pair_pipes[0]) < 0 || pipe(&pair_pipes[2]) < 0) {
+        perror("pipe error");
+        return 1;
+    }
+
+    if (pthread_create(&thread, NULL, echo_thread, pair_pipes) != 0) {
+        printf("pthread_create failed\n");
+        return 1;
+    }
+
+    struct timeval timevals[2];
+    gettimeofday(&timevals[0], NULL);
+
+    for (int i = 0; i < NTRIES; i++) {
+        if (write(pair_pipes[1], &byte, 1) != 1) {
+            perror("write error");
+            return 1;
+        }
+        if (read(pair_pipes[2], &byte, 1) != 1) {
+            perror("read error");
+            return 1;
+        }
+    }
+
+    gettimeofday(&timevals[1], NULL);
+    pthread_join(thread, NULL);
+
+    for (int i = 0; i < 4; i++)
+        close(pair_pipes[i]);
+
+    unsigned long long usec = (timevals[1].tv_sec - timevals[0].tv_sec) * 1000000ULL +
+                              (timevals[1].tv_usec - timevals[0].tv_usec);
+    printf("throughput for 2 threads to send %d message: %lf bytes/second\n", NTRIES,
+           1.0 * NTRIES * 2 * 1000000 / (usec ? usec : 1));
+    return 0;
+}
+
 int main(int argc, char** argv) {
     int times = TEST_TIMES;
     int pipes[6];
@@ -176,5 +237,5 @@ int main(int argc, char** argv) {
     printf("throughput for %d processes to send %d message: %lf bytes/second\n", times, NTRIES,
            1.0 * NTRIES * 2 * times * 1000000 / (end_time - start_time));
 
-    return 0;
+    return test_in_process();
 }
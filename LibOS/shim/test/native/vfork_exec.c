@@ -3,25 +3,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+/* Spawns ./exec_victim with vfork() and execv(), as many times as given on the command line, and
+ * reports the time spent per spawn. Run with "sys.vfork = 1" in the manifest to compare against
+ * vfork() aliased to fork(). */
 int main(int argc, const char** argv, const char** envp) {
     int newfd = dup(1), outfd = dup(1);
     char fd_argv[4];
     snprintf(fd_argv, 4, "%d", newfd);
     char* const new_argv[] = {"./exec_victim", fd_argv, NULL};
+    int count = argc > 1 ? atoi(argv[1]) : 1;
+    struct timeval start, end;
 
     setenv("IN_EXECVE", "1", 1);
 
-    int pid = vfork();
-    if (pid == 0) {
-        close(outfd);
-        execv(new_argv[0], new_argv);
+    gettimeofday(&start, NULL);
+
+    for (int i = 0; i < count; i++) {
+        int pid = vfork();
+        if (pid == 0) {
+            close(outfd);
+            execv(new_argv[0], new_argv);
+            _exit(1);
+        }
+
+        waitpid(pid, NULL, 0);
     }
 
-    wait(NULL);
+    gettimeofday(&end, NULL);
 
     FILE* out = fdopen(outfd, "a");
     if (!out) {
@@ -29,6 +42,11 @@ int main(int argc, const char** argv, const char** envp) {
         return -1;
     }
 
+    unsigned long long usec = (end.tv_sec - start.tv_sec) * 1000000ULL +
+                              (end.tv_usec - start.tv_usec);
+    if (count > 1)
+        fprintf(out, "%d spawns in %llu usec (%llu usec/spawn)\n", count, usec, usec / count);
+
     fprintf(out, "Goodbye world!\n");
     return 0;
 }
@@ -0,0 +1,67 @@
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NREADS 1000000
+
+static long long ts_ns(const struct timespec* ts) {
+    return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    struct timespec ts, res;
+    long long prev = 0, now;
+
+    /* MONOTONIC must never go backwards, also across a clock resync */
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < NREADS; i++) {
+            if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+                perror("clock_gettime(CLOCK_MONOTONIC)");
+                return 1;
+            }
+            now = ts_ns(&ts);
+            if (now < prev) {
+                printf("CLOCK_MONOTONIC went backwards by %lld ns\n", prev - now);
+                return 1;
+            }
+            prev = now;
+        }
+        sleep(1);
+    }
+    printf("CLOCK_MONOTONIC is monotonic\n");
+
+    if (clock_gettime(CLOCK_REALTIME, &ts) < 0) {
+        perror("clock_gettime(CLOCK_REALTIME)");
+        return 1;
+    }
+    if (ts.tv_sec < 1000000000L || ts.tv_sec - time(NULL) > 1 || time(NULL) - ts.tv_sec > 1) {
+        printf("CLOCK_REALTIME is off: %ld\n", (long)ts.tv_sec);
+        return 1;
+    }
+    printf("CLOCK_REALTIME matches time()\n");
+
+    /* the thread slept for 2 seconds, its CPU time must be well below that */
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+        perror("clock_gettime(CLOCK_THREAD_CPUTIME_ID)");
+        return 1;
+    }
+    if (ts_ns(&ts) >= 2000000000LL) {
+        printf("CLOCK_THREAD_CPUTIME_ID counts sleeping time\n");
+        return 1;
+    }
+
+    if (clock_getres(CLOCK_MONOTONIC, &res) < 0 || res.tv_sec != 0 || res.tv_nsec <= 0 ||
+        res.tv_nsec > 1000) {
+        printf("bad CLOCK_MONOTONIC resolution\n");
+        return 1;
+    }
+
+    if (clock_gettime((clockid_t)1000, &ts) != -1 || errno != EINVAL) {
+        printf("invalid clock id accepted\n");
+        return 1;
+    }
+
+    printf("TEST OK\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PARENT_VAL 0x1234
+#define CHILD_VAL  0x5678
+
+int main(void) {
+    volatile int* ptr = mmap(NULL, 0x1000, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                             -1, 0);
+    if (ptr == MAP_FAILED) {
+        err(1, "mmap");
+    }
+
+    *ptr = PARENT_VAL;
+
+    pid_t p = fork();
+    if (p < 0) {
+        err(1, "fork");
+    }
+
+    if (p == 0) {
+        // child
+        if (*ptr != PARENT_VAL) {
+            printf("child EXPECTED: 0x%x\nGOT     : 0x%x\n", PARENT_VAL, *ptr);
+            return 1;
+        }
+        *ptr = CHILD_VAL;
+        return 0;
+    }
+
+    // parent
+    int st = 0;
+    if (wait(&st) < 0) {
+        err(1, "wait");
+    }
+
+    if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) {
+        printf("abnormal child termination: %d\n", st);
+        return 1;
+    }
+
+    if (*ptr != CHILD_VAL) {
+        printf("parent EXPECTED: 0x%x\nGOT     : 0x%x\n", CHILD_VAL, *ptr);
+        return 1;
+    }
+
+    puts("Test successful!");
+    return 0;
+}
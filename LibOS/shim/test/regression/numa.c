@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define MAXNODE 1025
+
+static int read_file(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    size_t len = fread(buf, 1, size - 1, fp);
+    buf[len] = '\0';
+    fclose(fp);
+    return len;
+}
+
+int main(int argc, char** argv) {
+    unsigned long mask[MAXNODE / (8 * sizeof(unsigned long)) + 1];
+    char buf[1024];
+    int mode;
+
+    /* the node directory must list at least node 0, in the same format as Linux */
+    if (read_file("/sys/devices/system/node/online", buf, sizeof(buf)) <= 0 || buf[0] != '0')
+        return 1;
+    printf("/sys/devices/system/node/online: %s", buf);
+
+    if (read_file("/sys/devices/system/node/node0/cpulist", buf, sizeof(buf)) <= 0)
+        return 1;
+    if (read_file("/sys/devices/system/node/node0/meminfo", buf, sizeof(buf)) <= 0 ||
+            strncmp(buf, "Node 0 MemTotal:", strlen("Node 0 MemTotal:")))
+        return 1;
+    if (read_file("/sys/devices/system/node/node0/distance", buf, sizeof(buf)) <= 0 ||
+            strncmp(buf, "10", 2))
+        return 1;
+    puts("node0 files OK");
+
+    memset(mask, 0, sizeof(mask));
+    if (syscall(SYS_get_mempolicy, &mode, mask, MAXNODE, NULL, MPOL_F_MEMS_ALLOWED) < 0 ||
+            !(mask[0] & 1)) {
+        perror("get_mempolicy(MPOL_F_MEMS_ALLOWED)");
+        return 1;
+    }
+
+    /* bind the thread to node 0, which always exists, and read the policy back */
+    memset(mask, 0, sizeof(mask));
+    mask[0] = 1;
+    if (syscall(SYS_set_mempolicy, MPOL_BIND, mask, MAXNODE) < 0) {
+        perror("set_mempolicy");
+        return 1;
+    }
+    if (syscall(SYS_get_mempolicy, &mode, mask, MAXNODE, NULL, 0) < 0) {
+        perror("get_mempolicy");
+        return 1;
+    }
+    /* hosts which cannot place memory keep the default policy */
+    if (mode != MPOL_BIND && mode != MPOL_DEFAULT) {
+        printf("unexpected policy %d\n", mode);
+        return 1;
+    }
+    if (syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0) < 0) {
+        perror("set_mempolicy(MPOL_DEFAULT)");
+        return 1;
+    }
+
+    /* an empty mask is invalid for MPOL_BIND */
+    memset(mask, 0, sizeof(mask));
+    if (syscall(SYS_set_mempolicy, MPOL_BIND, mask, MAXNODE) != -1 || errno != EINVAL) {
+        puts("set_mempolicy with an empty mask did not fail");
+        return 1;
+    }
+    puts("set_mempolicy OK");
+
+    size_t size = 4 * 4096;
+    char* addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    memset(addr, 1, size);
+
+    mask[0] = 1;
+    if (syscall(SYS_mbind, addr, size, MPOL_BIND, mask, MAXNODE, MPOL_MF_MOVE) < 0) {
+        perror("mbind");
+        return 1;
+    }
+
+    void* pages[4];
+    int status[4];
+    for (int i = 0; i < 4; i++)
+        pages[i] = addr + i * 4096;
+    if (syscall(SYS_move_pages, 0, 4, pages, NULL, status, 0) < 0) {
+        perror("move_pages");
+        return 1;
+    }
+    for (int i = 0; i < 4; i++)
+        if (status[i] != 0) {
+            printf("page %d is on node %d after binding to node 0\n", i, status[i]);
+            return 1;
+        }
+    puts("mbind OK");
+
+    munmap(addr, size);
+    puts("TEST OK");
+    return 0;
+}
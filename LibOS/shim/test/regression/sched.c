@@ -6,7 +6,8 @@
 #include <sys/time.h>
 
 /* This test checks that our dummy implementations work correctly. None of the
- * below syscalls are actually propagated to the host OS or change anything.
+ * below syscalls except the affinity ones are actually propagated to the host OS
+ * or change anything.
  * NOTE: This test works correctly only on Graphene (not on Linux). */
 
 int main(int argc, char** argv) {
@@ -29,6 +30,12 @@ int main(int argc, char** argv) {
 
     cpu_set_t my_set;
     CPU_ZERO(&my_set);
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &my_set) != -1 || errno != EINVAL) {
+        perror("Setting an empty affinity did not fail with EINVAL");
+        return 1;
+    }
+
+    CPU_SET(0, &my_set);
     if (sched_setaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
         perror("Error setting affinity");
         return 1;
@@ -50,7 +57,8 @@ int main(int argc, char** argv) {
         return 2;
     }
 
-    if (sched_getaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
+    CPU_ZERO(&my_set);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &my_set) == -1 || !CPU_ISSET(0, &my_set)) {
         perror("Error getting affinity");
         return 2;
     }
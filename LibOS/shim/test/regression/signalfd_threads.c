@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define CHILD_STATUS 7
+
+static int done_pipe[2];
+static pid_t child_pid;
+
+static void fail(const char* msg) {
+    perror(msg);
+    exit(1);
+}
+
+/* forks a child which exits right away, then stays alive until the main thread is done, so that
+ * the SIGCHLD stays queued to this thread */
+static void* forking_thread(void* arg) {
+    (void)arg;
+
+    child_pid = fork();
+    if (child_pid < 0)
+        fail("fork");
+    if (child_pid == 0)
+        exit(CHILD_STATUS);
+
+    char c;
+    if (read(done_pipe[0], &c, 1) != 1)
+        fail("read of done_pipe");
+    return NULL;
+}
+
+static void test_sigchld_from_other_thread(int sfd) {
+    int efd = epoll_create1(0);
+    if (efd < 0)
+        fail("epoll_create1");
+
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = sfd};
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &event) < 0)
+        fail("epoll_ctl");
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, forking_thread, NULL))
+        fail("pthread_create");
+
+    int ret = epoll_wait(efd, &event, 1, 10000);
+    if (ret != 1 || event.data.fd != sfd)
+        fail("epoll_wait did not report the signalfd readable");
+
+    struct signalfd_siginfo ssi;
+    if (read(sfd, &ssi, sizeof(ssi)) != sizeof(ssi))
+        fail("read of signalfd");
+
+    if (ssi.ssi_signo != SIGCHLD || ssi.ssi_status != CHILD_STATUS ||
+        (pid_t)ssi.ssi_pid != child_pid) {
+        fprintf(stderr, "unexpected signal %u (pid %u, status %d)\n", ssi.ssi_signo, ssi.ssi_pid,
+                ssi.ssi_status);
+        exit(1);
+    }
+
+    if (write(done_pipe[1], "x", 1) != 1)
+        fail("write of done_pipe");
+    pthread_join(thread, NULL);
+
+    int status;
+    if (waitpid(child_pid, &status, 0) != child_pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != CHILD_STATUS)
+        fail("waitpid");
+
+    close(efd);
+    printf("SIGCHLD of a child forked by another thread OK\n");
+}
+
+static void* idle_thread(void* arg) {
+    (void)arg;
+
+    char c;
+    if (read(done_pipe[0], &c, 1) != 1)
+        fail("read of done_pipe");
+    return NULL;
+}
+
+static void test_process_signal_read_once(int sfd) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, idle_thread, NULL))
+        fail("pthread_create");
+
+    if (kill(getpid(), SIGUSR1) < 0)
+        fail("kill");
+
+    struct signalfd_siginfo ssi;
+    if (read(sfd, &ssi, sizeof(ssi)) != sizeof(ssi) || ssi.ssi_signo != SIGUSR1)
+        fail("read of SIGUSR1 from signalfd");
+
+    /* the signal was sent to the process, not to each of its threads */
+    if (read(sfd, &ssi, sizeof(ssi)) != -1 || errno != EAGAIN) {
+        fprintf(stderr, "SIGUSR1 was read more than once\n");
+        exit(1);
+    }
+
+    if (write(done_pipe[1], "x", 1) != 1)
+        fail("write of done_pipe");
+    pthread_join(thread, NULL);
+
+    printf("signal sent to a multi-threaded process read once OK\n");
+}
+
+static volatile pid_t handler_tid;
+static volatile pid_t unblocking_tid;
+static volatile int unblocking_done;
+
+static void sigusr1_handler(int sig) {
+    (void)sig;
+    handler_tid = syscall(SYS_gettid);
+}
+
+static void* unblocking_thread(void* arg) {
+    (void)arg;
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    if (pthread_sigmask(SIG_UNBLOCK, &mask, NULL))
+        fail("pthread_sigmask");
+
+    unblocking_tid = syscall(SYS_gettid);
+    while (!unblocking_done)
+        usleep(1000);
+    return NULL;
+}
+
+static void test_process_signal_to_unblocking_thread(int sfd) {
+    struct sigaction sa = {.sa_handler = sigusr1_handler};
+    if (sigaction(SIGUSR1, &sa, NULL) < 0)
+        fail("sigaction");
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, unblocking_thread, NULL))
+        fail("pthread_create");
+    while (!unblocking_tid)
+        usleep(1000);
+
+    if (kill(getpid(), SIGUSR1) < 0)
+        fail("kill");
+
+    /* the main thread blocks SIGUSR1, so the other thread has to take it */
+    for (int i = 0; i < 10000 && !handler_tid; i++)
+        usleep(1000);
+    if (handler_tid != unblocking_tid) {
+        fprintf(stderr, "SIGUSR1 handled by thread %d instead of %d\n", handler_tid,
+                unblocking_tid);
+        exit(1);
+    }
+
+    struct signalfd_siginfo ssi;
+    if (read(sfd, &ssi, sizeof(ssi)) != -1 || errno != EAGAIN) {
+        fprintf(stderr, "SIGUSR1 was also queued to the signalfd\n");
+        exit(1);
+    }
+
+    unblocking_done = 1;
+    pthread_join(thread, NULL);
+
+    printf("signal sent to a process taken by the thread not blocking it OK\n");
+}
+
+int main(void) {
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    /* blocked before any thread is created, so that every thread inherits the mask */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGUSR1);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        fail("sigprocmask");
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0)
+        fail("signalfd");
+
+    if (pipe(done_pipe) < 0)
+        fail("pipe");
+
+    test_sigchld_from_other_thread(sfd);
+    test_process_signal_read_once(sfd);
+    test_process_signal_to_unblocking_thread(sfd);
+
+    close(sfd);
+    printf("test completed successfully\n");
+    return 0;
+}
@@ -0,0 +1,36 @@
+#define _GNU_SOURCE
+#include <shim_unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* This test takes a snapshot after "warming up" some state; running it again through
+ * snapshot_restore.manifest resumes from the snapshot instead of starting from main().
+ * NOTE: This test works only on Graphene (not on Linux). */
+
+static char* warm_state;
+
+int main(int argc, char** argv) {
+    warm_state = malloc(64);
+    if (!warm_state) {
+        perror("malloc");
+        return 1;
+    }
+    strcpy(warm_state, "state initialized before snapshot");
+
+    long ret = syscall(__NR_snapshot, "tmp/snapshot.img");
+    if (ret < 0) {
+        perror("snapshot");
+        return 1;
+    }
+
+    if (ret == 1) {
+        printf("Snapshot written\n");
+        return 0;
+    }
+
+    printf("Resumed from snapshot: %s\n", warm_state);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#define _GNU_SOURCE
+#include <shim_unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* This test takes a snapshot, writes a part of a buffer and takes an incremental snapshot; running
+ * it again through snapshot_incremental_restore.manifest resumes from the second snapshot, which
+ * takes the rest of the buffer from the first one.
+ * NOTE: This test works only on Graphene (not on Linux). */
+
+#define BUF_SIZE   (64 * 4096)
+#define DIRTY_OFF  (BUF_SIZE / 2)
+#define DIRTY_SIZE 4096
+
+static char* buf;
+
+int main(int argc, char** argv) {
+    buf = mmap(NULL, BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    memset(buf, 'a', BUF_SIZE);
+
+    long ret = syscall(__NR_snapshot, "tmp/snapshot_base.img");
+    if (ret < 0) {
+        perror("snapshot");
+        return 1;
+    }
+    if (ret == 0) {
+        printf("Resumed from the first snapshot\n");
+        return 1;
+    }
+
+    memset(buf + DIRTY_OFF, 'b', DIRTY_SIZE);
+
+    ret = syscall(__NR_snapshot, "tmp/snapshot_delta.img");
+    if (ret < 0) {
+        perror("snapshot");
+        return 1;
+    }
+
+    if (ret == 1) {
+        printf("Snapshots written\n");
+        return 0;
+    }
+
+    for (int i = 0; i < BUF_SIZE; i++) {
+        char expected = (i >= DIRTY_OFF && i < DIRTY_OFF + DIRTY_SIZE) ? 'b' : 'a';
+        if (buf[i] != expected) {
+            printf("Wrong byte at offset %d: %c\n", i, buf[i]);
+            return 1;
+        }
+    }
+
+    printf("Resumed from incremental snapshot: buffer restored\n");
+    return 0;
+}
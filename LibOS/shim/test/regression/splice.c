@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MSG     "data written before the copy"
+#define MSG_LEN (sizeof(MSG) - 1)
+
+static void fail(const char* msg) {
+    perror(msg);
+    exit(1);
+}
+
+static void expect(int fd, const char* what) {
+    char buf[MSG_LEN + 1];
+    ssize_t ret = read(fd, buf, MSG_LEN);
+    if (ret != (ssize_t)MSG_LEN || memcmp(buf, MSG, MSG_LEN)) {
+        buf[ret > 0 ? ret : 0] = '\0';
+        fprintf(stderr, "%s: read %zd bytes \"%s\"\n", what, ret, buf);
+        exit(1);
+    }
+}
+
+/* a temporary file holding MSG, with its offset back at the start */
+static int msg_file(void) {
+    const char* path = "splice.tmp";
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        fail("open");
+    unlink(path);
+
+    if (write(fd, MSG, MSG_LEN) != MSG_LEN || lseek(fd, 0, SEEK_SET) != 0)
+        fail("write of file");
+    return fd;
+}
+
+/* the data is written to the pipes before any copy, so it is still buffered in the process */
+static void test_pipe(void) {
+    int p1[2], p2[2];
+    if (pipe(p1) < 0 || pipe(p2) < 0)
+        fail("pipe");
+
+    if (write(p1[1], MSG, MSG_LEN) != MSG_LEN)
+        fail("write of pipe");
+    if (splice(p1[0], NULL, p2[1], NULL, MSG_LEN, 0) != MSG_LEN)
+        fail("splice from pipe to pipe");
+    expect(p2[0], "splice from pipe to pipe");
+
+    int fd = msg_file();
+    if (splice(fd, NULL, p1[1], NULL, MSG_LEN, 0) != MSG_LEN)
+        fail("splice from file to pipe");
+    expect(p1[0], "splice from file to pipe");
+
+    if (write(p1[1], MSG, MSG_LEN) != MSG_LEN || ftruncate(fd, 0) < 0)
+        fail("write of pipe");
+    loff_t off = 0;
+    if (splice(p1[0], NULL, fd, &off, MSG_LEN, 0) != MSG_LEN)
+        fail("splice from pipe to file");
+    if (lseek(fd, 0, SEEK_SET) != 0)
+        fail("lseek");
+    expect(fd, "splice from pipe to file");
+
+    close(fd);
+    close(p1[0]);
+    close(p1[1]);
+    close(p2[0]);
+    close(p2[1]);
+    printf("splice through pipes OK\n");
+}
+
+static void test_socketpair(void) {
+    int sv[2], p[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0 || pipe(p) < 0)
+        fail("socketpair/pipe");
+
+    if (write(sv[0], MSG, MSG_LEN) != MSG_LEN)
+        fail("write of socketpair");
+    if (splice(sv[1], NULL, p[1], NULL, MSG_LEN, 0) != MSG_LEN)
+        fail("splice from socketpair to pipe");
+    expect(p[0], "splice from socketpair to pipe");
+
+    int fd = msg_file();
+    if (write(sv[0], MSG, MSG_LEN) != MSG_LEN)
+        fail("write of socketpair");
+    if (sendfile(sv[0], fd, NULL, MSG_LEN) != MSG_LEN)
+        fail("sendfile to socketpair");
+    expect(sv[1], "data written before sendfile");
+    expect(sv[1], "sendfile to socketpair");
+
+    close(fd);
+    close(sv[0]);
+    close(sv[1]);
+    close(p[0]);
+    close(p[1]);
+    printf("splice and sendfile through socketpairs OK\n");
+}
+
+int main(void) {
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    test_pipe();
+    test_socketpair();
+
+    printf("test completed successfully\n");
+    return 0;
+}
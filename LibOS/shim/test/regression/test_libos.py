@@ -9,6 +9,12 @@ from regression import (
     RegressionTestCase,
 )
 
+def skip_unless_io_uring(test, stderr):
+    # The Linux PAL disables the io_uring engine with a warning if the host cannot run it (fewer
+    # than 2 CPUs, Linux before 5.11); the test then went through the system calls only.
+    if 'io_uring engine disabled' in stderr:
+        test.skipTest('io_uring engine disabled on this host')
+
 class TC_00_Unittests(RegressionTestCase):
     def test_000_spinlock(self):
         stdout, _ = self.run_binary(['spinlock'])
@@ -103,6 +109,17 @@ class TC_01_Bootstrap(RegressionTestCase):
         stdout, _ = self.run_binary(['system'], timeout=60)
         self.assertIn('hello from system', stdout)
 
+    def test_205_vfork(self):
+        stdout, _ = self.run_binary(['vfork'], timeout=60)
+
+        # with sys.vfork = 1, the child runs in the parent's process until it exits or execs
+        self.assertIn('child exited with status: 42', stdout)
+        self.assertIn('Hello World (./exec_victim)!', stdout)
+        self.assertIn('child exec\'ed and exited with status: 0', stdout)
+        self.assertIn('child killed by signal: 10', stdout)
+        self.assertIn('child aborted by signal: 6', stdout)
+        self.assertIn('test completed successfully', stdout)
+
     def test_210_exec_invalid_args(self):
         stdout, _ = self.run_binary(['exec_invalid_args'])
 
@@ -276,6 +293,19 @@ class TC_30_Syscall(RegressionTestCase):
         stdout, _ = self.run_binary(['file_size'])
         self.assertIn('test completed successfully', stdout)
 
+    @unittest.skipIf(HAS_SGX, 'io_uring is only used by the Linux PAL')
+    def test_033_file_size_io_uring(self):
+        manifest = self.get_manifest('file_size_io_uring')
+        stdout, stderr = self.run_binary([manifest])
+        skip_unless_io_uring(self, stderr)
+        self.assertIn('test completed successfully', stdout)
+
+    def test_034_splice(self):
+        stdout, _ = self.run_binary(['splice'])
+        self.assertIn('splice through pipes OK', stdout)
+        self.assertIn('splice and sendfile through socketpairs OK', stdout)
+        self.assertIn('test completed successfully', stdout)
+
     def test_040_futex_bitset(self):
         stdout, _ = self.run_binary(['futex_bitset'])
 
@@ -336,6 +366,25 @@ class TC_30_Syscall(RegressionTestCase):
 
         self.assertIn('Test successful!', stdout)
 
+    def test_053_mprotect_file_fork_compressed(self):
+        manifest = self.get_manifest('mprotect_file_fork_compressed')
+        stdout, _ = self.run_binary([manifest])
+
+        self.assertIn('Test successful!', stdout)
+
+    def test_054_numa(self):
+        stdout, _ = self.run_binary(['numa'])
+        self.assertIn('node0 files OK', stdout)
+        self.assertIn('set_mempolicy OK', stdout)
+        self.assertIn('mbind OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    @unittest.skipIf(HAS_SGX, 'SGX PAL cannot share memory between enclaves')
+    def test_055_mmap_shared_anon(self):
+        stdout, _ = self.run_binary(['mmap_shared_anon'])
+
+        self.assertIn('Test successful!', stdout)
+
     @unittest.skip('sigaltstack isn\'t correctly implemented')
     def test_060_sigaltstack(self):
         stdout, _ = self.run_binary(['sigaltstack'])
@@ -363,17 +412,59 @@ class TC_30_Syscall(RegressionTestCase):
         self.assertIn('eventfd_using_various_flags completed successfully', stdout)
         self.assertIn('eventfd_using_fork completed successfully', stdout)
 
+    def test_075_timerfd_signalfd(self):
+        stdout, _ = self.run_binary(['timerfd_signalfd'])
+        self.assertIn('timerfd OK', stdout)
+        self.assertIn('signalfd OK', stdout)
+        self.assertIn('epoll on timerfd and signalfd OK', stdout)
+
+    def test_076_signalfd_threads(self):
+        stdout, _ = self.run_binary(['signalfd_threads'])
+        self.assertIn('SIGCHLD of a child forked by another thread OK', stdout)
+        self.assertIn('signal sent to a multi-threaded process read once OK', stdout)
+        self.assertIn('signal sent to a process taken by the thread not blocking it OK', stdout)
+        self.assertIn('test completed successfully', stdout)
+
     def test_080_sched(self):
         stdout, _ = self.run_binary(['sched'])
 
         # Scheduling Syscalls Test
         self.assertIn('Test completed successfully', stdout)
 
+    def test_085_clock_gettime(self):
+        stdout, _ = self.run_binary(['clock_gettime'])
+        self.assertIn('CLOCK_MONOTONIC is monotonic', stdout)
+        self.assertIn('CLOCK_REALTIME matches time()', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_090_sighandler_reset(self):
         stdout, _ = self.run_binary(['sighandler_reset'])
         self.assertIn('Got signal 17', stdout)
         self.assertIn('Handler was invoked 1 time(s).', stdout)
 
+    @unittest.skipIf(HAS_SGX, 'Snapshots are not protected, so they are disabled on SGX PAL')
+    def test_100_snapshot_restore(self):
+        stdout, _ = self.run_binary(['snapshot'])
+        self.assertIn('Snapshot written', stdout)
+
+        manifest = self.get_manifest('snapshot_restore')
+        stdout, _ = self.run_binary([manifest])
+        self.assertIn('Resumed from snapshot: state initialized before snapshot', stdout)
+        self.assertNotIn('Snapshot written', stdout)
+
+    @unittest.skipIf(HAS_SGX, 'Snapshots are not protected, so they are disabled on SGX PAL')
+    def test_101_snapshot_incremental(self):
+        stdout, _ = self.run_binary(['snapshot_incremental'])
+        self.assertIn('Snapshots written', stdout)
+        # only the pages written after the first snapshot are saved again
+        self.assertLess(os.path.getsize('tmp/snapshot_delta.img'),
+                        os.path.getsize('tmp/snapshot_base.img'))
+
+        manifest = self.get_manifest('snapshot_incremental_restore')
+        stdout, _ = self.run_binary([manifest])
+        self.assertIn('Resumed from incremental snapshot: buffer restored', stdout)
+        self.assertNotIn('Snapshots written', stdout)
+
 @unittest.skipUnless(HAS_SGX,
     'This test is only meaningful on SGX PAL because only SGX catches raw '
     'syscalls and redirects to Graphene\'s LibOS. If we will add seccomp to '
@@ -506,6 +597,14 @@ class TC_80_Socket(RegressionTestCase):
         self.assertIn('Data: This is packet 8', stdout)
         self.assertIn('Data: This is packet 9', stdout)
 
+    @unittest.skipIf(HAS_SGX, 'SGX PAL does not batch datagrams')
+    def test_210_socket_udp_mmsg(self):
+        stdout, _ = self.run_binary(['udp_mmsg'], timeout=50)
+        self.assertIn('recvmmsg(MSG_DONTWAIT) on empty socket: EAGAIN', stdout)
+        self.assertIn('recvmmsg(MSG_WAITFORONE): 3 datagrams', stdout)
+        self.assertIn('recvmmsg(MSG_DONTWAIT): 2 datagrams', stdout)
+        self.assertIn('test completed successfully', stdout)
+
     def test_300_socket_tcp_msg_peek(self):
         stdout, _ = self.run_binary(['tcp_msg_peek'], timeout=50)
         self.assertIn('[client] receiving with MSG_PEEK: Hello from server!', stdout)
@@ -514,6 +613,17 @@ class TC_80_Socket(RegressionTestCase):
         self.assertIn('[client] done', stdout)
         self.assertIn('[server] done', stdout)
 
+    @unittest.skipIf(HAS_SGX, 'io_uring is only used by the Linux PAL')
+    def test_301_socket_tcp_msg_peek_io_uring(self):
+        manifest = self.get_manifest('tcp_msg_peek_io_uring')
+        stdout, stderr = self.run_binary([manifest], timeout=50)
+        skip_unless_io_uring(self, stderr)
+        self.assertIn('[client] receiving with MSG_PEEK: Hello from server!', stdout)
+        self.assertIn('[client] receiving without MSG_PEEK: Hello from server!', stdout)
+        self.assertIn('[client] checking how many bytes are left unread: 0', stdout)
+        self.assertIn('[client] done', stdout)
+        self.assertIn('[server] done', stdout)
+
     def test_310_socket_tcp_ipv6_v6only(self):
         stdout, _ = self.run_binary(['tcp_ipv6_v6only'], timeout=50)
         self.assertIn('test completed successfully', stdout)
@@ -0,0 +1,162 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define TIMER_INTERVAL_NS (10 * 1000 * 1000)
+
+static void fail(const char* msg) {
+    perror(msg);
+    exit(1);
+}
+
+static void test_timerfd(void) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0)
+        fail("timerfd_create");
+
+    uint64_t count;
+    if (read(tfd, &count, sizeof(count)) != -1 || errno != EAGAIN)
+        fail("read of disarmed timerfd did not fail with EAGAIN");
+
+    struct itimerspec setting = {
+        .it_interval = {.tv_sec = 0, .tv_nsec = TIMER_INTERVAL_NS},
+        .it_value    = {.tv_sec = 0, .tv_nsec = TIMER_INTERVAL_NS},
+    };
+    if (timerfd_settime(tfd, 0, &setting, NULL) < 0)
+        fail("timerfd_settime");
+
+    struct itimerspec cur;
+    if (timerfd_gettime(tfd, &cur) < 0)
+        fail("timerfd_gettime");
+    if (cur.it_interval.tv_nsec != TIMER_INTERVAL_NS || cur.it_value.tv_sec != 0 ||
+        cur.it_value.tv_nsec > TIMER_INTERVAL_NS) {
+        fprintf(stderr, "timerfd_gettime returned wrong setting\n");
+        exit(1);
+    }
+
+    struct pollfd pfd = {.fd = tfd, .events = POLLIN};
+    if (poll(&pfd, 1, 5000) != 1 || !(pfd.revents & POLLIN))
+        fail("poll on timerfd");
+
+    /* let a few more periods pass and check that they are counted */
+    usleep(5 * TIMER_INTERVAL_NS / 1000);
+    if (read(tfd, &count, sizeof(count)) != sizeof(count) || count < 2) {
+        fprintf(stderr, "read of periodic timerfd returned %lu expirations\n", count);
+        exit(1);
+    }
+
+    /* an absolute time in the past expires right away */
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    struct itimerspec abs_setting = {.it_value = {.tv_sec = now.tv_sec - 1}};
+    if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &abs_setting, NULL) < 0)
+        fail("timerfd_settime(TFD_TIMER_ABSTIME)");
+    if (poll(&pfd, 1, 5000) != 1 || read(tfd, &count, sizeof(count)) != sizeof(count) ||
+        count != 1)
+        fail("absolute timerfd did not expire once");
+
+    close(tfd);
+    printf("timerfd OK\n");
+}
+
+static void test_signalfd(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        fail("sigprocmask");
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0)
+        fail("signalfd");
+
+    struct signalfd_siginfo info;
+    if (read(sfd, &info, sizeof(info)) != -1 || errno != EAGAIN)
+        fail("read of empty signalfd did not fail with EAGAIN");
+
+    if (kill(getpid(), SIGUSR1) < 0)
+        fail("kill");
+
+    struct pollfd pfd = {.fd = sfd, .events = POLLIN};
+    if (poll(&pfd, 1, 5000) != 1 || !(pfd.revents & POLLIN))
+        fail("poll on signalfd");
+
+    if (read(sfd, &info, sizeof(info)) != sizeof(info))
+        fail("read of signalfd");
+    if (info.ssi_signo != SIGUSR1 || info.ssi_pid != (uint32_t)getpid()) {
+        fprintf(stderr, "signalfd returned signal %u from %u\n", info.ssi_signo, info.ssi_pid);
+        exit(1);
+    }
+
+    close(sfd);
+    printf("signalfd OK\n");
+}
+
+static void test_epoll(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR2);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        fail("sigprocmask");
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK);
+    int tfd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK);
+    int efd = epoll_create1(0);
+    if (sfd < 0 || tfd < 0 || efd < 0)
+        fail("creating fds");
+
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = tfd};
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, tfd, &event) < 0)
+        fail("epoll_ctl(timerfd)");
+    event.data.fd = sfd;
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &event) < 0)
+        fail("epoll_ctl(signalfd)");
+
+    struct itimerspec setting = {.it_value = {.tv_sec = 0, .tv_nsec = TIMER_INTERVAL_NS}};
+    if (timerfd_settime(tfd, 0, &setting, NULL) < 0)
+        fail("timerfd_settime");
+    if (kill(getpid(), SIGUSR2) < 0)
+        fail("kill");
+
+    int got_timer = 0, got_signal = 0;
+    while (!got_timer || !got_signal) {
+        struct epoll_event events[2];
+        int n = epoll_wait(efd, events, 2, 5000);
+        if (n <= 0)
+            fail("epoll_wait");
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == tfd) {
+                uint64_t count;
+                if (read(tfd, &count, sizeof(count)) == sizeof(count) && count == 1)
+                    got_timer = 1;
+            } else {
+                struct signalfd_siginfo info;
+                if (read(sfd, &info, sizeof(info)) == sizeof(info) && info.ssi_signo == SIGUSR2)
+                    got_signal = 1;
+            }
+        }
+    }
+
+    close(efd);
+    close(tfd);
+    close(sfd);
+    printf("epoll on timerfd and signalfd OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    test_timerfd();
+    test_signalfd();
+    test_epoll();
+    return 0;
+}
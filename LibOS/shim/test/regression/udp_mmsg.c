@@ -0,0 +1,138 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SRV_IP "127.0.0.1"
+#define PORT   9931
+#define BUFLEN 64
+#define NMSGS  8
+
+static int send_packets(int s, struct sockaddr_in* addr, int first, int count, int flags) {
+    struct mmsghdr msgs[NMSGS];
+    struct iovec iovs[NMSGS];
+    char bufs[NMSGS][BUFLEN];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < count; i++) {
+        snprintf(bufs[i], BUFLEN, "This is packet %d", first + i);
+        iovs[i].iov_base            = bufs[i];
+        iovs[i].iov_len             = strlen(bufs[i]) + 1;
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(*addr);
+    }
+
+    return sendmmsg(s, msgs, count, flags);
+}
+
+static int recv_packets(int s, int first, int flags) {
+    struct mmsghdr msgs[NMSGS];
+    struct iovec iovs[NMSGS];
+    struct sockaddr_in addrs[NMSGS];
+    char bufs[NMSGS][BUFLEN];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < NMSGS; i++) {
+        iovs[i].iov_base            = bufs[i];
+        iovs[i].iov_len             = BUFLEN;
+        msgs[i].msg_hdr.msg_iov     = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        msgs[i].msg_hdr.msg_name    = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    }
+
+    int ret = recvmmsg(s, msgs, NMSGS, flags, NULL);
+    if (ret < 0)
+        return ret;
+
+    for (int i = 0; i < ret; i++) {
+        char expected[BUFLEN];
+        snprintf(expected, BUFLEN, "This is packet %d", first + i);
+        if (msgs[i].msg_len != strlen(expected) + 1 || strcmp(bufs[i], expected)) {
+            fprintf(stderr, "unexpected datagram %d: %s\n", i, bufs[i]);
+            exit(1);
+        }
+        if (msgs[i].msg_hdr.msg_namelen != sizeof(addrs[i]) ||
+            addrs[i].sin_family != AF_INET ||
+            addrs[i].sin_addr.s_addr != inet_addr(SRV_IP)) {
+            fprintf(stderr, "unexpected sender address of datagram %d\n", i);
+            exit(1);
+        }
+    }
+    return ret;
+}
+
+int main(void) {
+    struct sockaddr_in addr;
+    int ret;
+
+    int rs = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int ss = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (rs < 0 || ss < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = inet_addr(SRV_IP);
+
+    if (bind(rs, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    /* nothing queued yet: MSG_DONTWAIT must not block */
+    ret = recv_packets(rs, 0, MSG_DONTWAIT);
+    if (ret != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        fprintf(stderr, "recvmmsg(MSG_DONTWAIT) on empty socket returned %d\n", ret);
+        return 1;
+    }
+    printf("recvmmsg(MSG_DONTWAIT) on empty socket: EAGAIN\n");
+
+    if ((ret = send_packets(ss, &addr, 0, 3, 0)) != 3) {
+        fprintf(stderr, "sendmmsg() returned %d\n", ret);
+        return 1;
+    }
+
+    /* fewer datagrams than requested: MSG_WAITFORONE returns what is there instead of blocking */
+    ret = recv_packets(rs, 0, MSG_WAITFORONE);
+    if (ret < 1) {
+        fprintf(stderr, "recvmmsg(MSG_WAITFORONE) returned %d\n", ret);
+        return 1;
+    }
+    int done = ret;
+    while (done < 3) {
+        if ((ret = recv_packets(rs, done, MSG_WAITFORONE)) < 1) {
+            fprintf(stderr, "recvmmsg(MSG_WAITFORONE) returned %d\n", ret);
+            return 1;
+        }
+        done += ret;
+    }
+    printf("recvmmsg(MSG_WAITFORONE): %d datagrams\n", done);
+
+    if ((ret = send_packets(ss, &addr, 3, 2, MSG_DONTWAIT)) != 2) {
+        fprintf(stderr, "sendmmsg(MSG_DONTWAIT) returned %d\n", ret);
+        return 1;
+    }
+
+    ret = recv_packets(rs, 3, MSG_DONTWAIT);
+    if (ret != 2) {
+        fprintf(stderr, "recvmmsg(MSG_DONTWAIT) returned %d\n", ret);
+        return 1;
+    }
+    printf("recvmmsg(MSG_DONTWAIT): %d datagrams\n", ret);
+
+    close(ss);
+    close(rs);
+    printf("test completed successfully\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* vfork() a child that runs `child` and wait for it; returns its wait status */
+static int run_child(void (*child)(void)) {
+    pid_t pid = vfork();
+    if (pid < 0) {
+        perror("vfork failed");
+        exit(1);
+    }
+
+    if (pid == 0) {
+        child();
+        _exit(1);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid) {
+        perror("waitpid failed");
+        exit(1);
+    }
+    return status;
+}
+
+static void child_exit(void) {
+    _exit(42);
+}
+
+static void child_exec(void) {
+    char* const argv[] = {"./exec_victim", NULL};
+    execv(argv[0], argv);
+}
+
+static void child_kill(void) {
+    kill(getpid(), SIGUSR1);
+}
+
+static void child_abort(void) {
+    abort();
+}
+
+int main(void) {
+    int status;
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    status = run_child(child_exit);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 42)
+        return 1;
+    printf("child exited with status: %d\n", WEXITSTATUS(status));
+
+    status = run_child(child_exec);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return 1;
+    printf("child exec'ed and exited with status: %d\n", WEXITSTATUS(status));
+
+    status = run_child(child_kill);
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGUSR1)
+        return 1;
+    printf("child killed by signal: %d\n", WTERMSIG(status));
+
+    /* SIGABRT kills the whole process, which must still be only the child's */
+    status = run_child(child_abort);
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT)
+        return 1;
+    printf("child aborted by signal: %d\n", WTERMSIG(status));
+
+    puts("test completed successfully");
+    return 0;
+}
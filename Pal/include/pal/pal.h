@@ -289,12 +289,21 @@ typedef struct PAL_CPU_INFO_ {
     PAL_NUM cpu_stepping;
     double  cpu_bogomips;
     PAL_STR cpu_flags;
+    PAL_IDX* cpu_core;    /*!< core ID of each CPU, NULL if the host does not report them */
+    PAL_IDX* cpu_package; /*!< physical package ID of each CPU, NULL if not reported */
 } PAL_CPU_INFO;
 
 typedef struct PAL_MEM_INFO_ {
     PAL_NUM mem_total;
 } PAL_MEM_INFO;
 
+typedef struct PAL_NUMA_INFO_ {
+    PAL_NUM   node_num; /*!< number of NUMA nodes, 0 if the host does not report a topology */
+    PAL_IDX*  cpu_node; /*!< NUMA node of each CPU, `cpu_num` entries */
+    PAL_NUM*  node_mem; /*!< memory size of each node in bytes, `node_num` entries */
+    PAL_IDX*  distance; /*!< `node_num` x `node_num` matrix of node distances */
+} PAL_NUMA_INFO;
+
 /********** PAL APIs **********/
 typedef struct PAL_CONTROL_ {
     PAL_STR host_type;
@@ -341,6 +350,7 @@ typedef struct PAL_CONTROL_ {
 
     PAL_CPU_INFO cpu_info; /*!< CPU information (only required ones) */
     PAL_MEM_INFO mem_info; /*!< memory information (only required ones) */
+    PAL_NUMA_INFO numa_info; /*!< NUMA topology of the host */
 
     /* Purely for profiling */
     PAL_NUM startup_time;
@@ -363,6 +373,7 @@ PAL_CONTROL * pal_control_addr (void);
 /*! Memory Allocation Flags */
 enum PAL_ALLOC {
     PAL_ALLOC_RESERVE  = 0x0001, /*!< Only reserve the memory */
+    PAL_ALLOC_HUGEPAGE = 0x0002, /*!< Back the memory with huge pages if the host can */
     PAL_ALLOC_INTERNAL = 0x8000, /*!< Allocate for PAL (valid only if #IN_PAL) */
 };
 
@@ -417,6 +428,123 @@ DkVirtualMemoryFree(PAL_PTR addr, PAL_NUM size);
 PAL_BOL
 DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot);
 
+/*!
+ * \brief Change the allocation flags of a previously allocated memory mapping.
+ *
+ * \param addr the address
+ * \param size the size
+ * \param alloc_type see #DkVirtualMemoryAlloc(); only #PAL_ALLOC_HUGEPAGE can be changed
+ *
+ * Both `addr` and `size` must be non-zero and aligned at the allocation alignment. The flags are
+ * hints: a host that cannot honor them leaves the mapping as it is and still succeeds.
+ */
+PAL_BOL
+DkVirtualMemoryAdvise(PAL_PTR addr, PAL_NUM size, PAL_FLG alloc_type);
+
+/*! NUMA memory policies (same values as the Linux MPOL_* modes) */
+enum PAL_MEMPOLICY {
+    PAL_MEMPOLICY_DEFAULT    = 0, /*!< allocate on the node of the running CPU */
+    PAL_MEMPOLICY_PREFERRED  = 1, /*!< prefer the single node in the mask */
+    PAL_MEMPOLICY_BIND       = 2, /*!< allocate only from the nodes in the mask */
+    PAL_MEMPOLICY_INTERLEAVE = 3, /*!< interleave pages over the nodes in the mask */
+    PAL_MEMPOLICY_LOCAL      = 4, /*!< allocate on the node of the faulting CPU */
+};
+
+/*! Flags for #DkVirtualMemoryBind */
+enum PAL_MEMBIND {
+    PAL_MEMBIND_STRICT = 0x1, /*!< fail if existing pages do not follow the policy */
+    PAL_MEMBIND_MOVE   = 0x2, /*!< migrate existing pages to follow the policy */
+};
+
+/*!
+ * \brief Set the NUMA policy of a previously allocated memory mapping.
+ *
+ * \param addr the address, aligned at the allocation alignment
+ * \param size the size
+ * \param policy one of the #PAL_MEMPOLICY values
+ * \param nodemask bitmask of NUMA nodes, may be `NULL` for #PAL_MEMPOLICY_DEFAULT and
+ *  #PAL_MEMPOLICY_LOCAL
+ * \param maxnode number of bits in `nodemask`
+ * \param flags a combination of the #PAL_MEMBIND flags
+ */
+PAL_BOL
+DkVirtualMemoryBind(PAL_PTR addr, PAL_NUM size, PAL_FLG policy, PAL_NUM* nodemask,
+                    PAL_NUM maxnode, PAL_FLG flags);
+
+/*!
+ * \brief Set the NUMA policy used for new allocations of the current thread.
+ *
+ * \param policy one of the #PAL_MEMPOLICY values
+ * \param nodemask see #DkVirtualMemoryBind()
+ * \param maxnode see #DkVirtualMemoryBind()
+ */
+PAL_BOL
+DkThreadSetMemoryPolicy(PAL_FLG policy, PAL_NUM* nodemask, PAL_NUM maxnode);
+
+/*!
+ * \brief Query a NUMA policy.
+ *
+ * \param addr if `NULL`, query the policy of the current thread, otherwise the policy of the
+ *  mapping containing `addr`
+ * \param[out] policy the #PAL_MEMPOLICY value in effect
+ * \param[out] nodemask if not `NULL`, receives the node mask of the policy
+ * \param maxnode number of bits in `nodemask`
+ */
+PAL_BOL
+DkMemoryPolicyQuery(PAL_PTR addr, PAL_FLG* policy, PAL_NUM* nodemask, PAL_NUM maxnode);
+
+/*!
+ * \brief Move pages to other NUMA nodes, or query where they reside.
+ *
+ * \param count number of pages
+ * \param pages addresses of the pages
+ * \param nodes target node of each page, or `NULL` to only query the current nodes
+ * \param[out] status for each page, the node it resides on or a negative PAL error code
+ */
+PAL_BOL
+DkVirtualMemoryMovePages(PAL_NUM count, PAL_PTR* pages, const int* nodes, int* status);
+
+/*!
+ * \brief Create an anonymous shared memory object.
+ *
+ * \param size size of the object in bytes, a multiple of the allocation alignment
+ * \return a handle that can be mapped with DkStreamMap() without #PAL_PROT_WRITECOPY, and passed
+ *  to child processes with DkSendHandle(); all these mappings share the same memory
+ */
+PAL_HANDLE
+DkSharedMemoryCreate(PAL_NUM size);
+
+/*!
+ * \brief Find the pages of a private file mapping that no longer match the file.
+ *
+ * \param addr the address, aligned at the allocation alignment
+ * \param size the size, a multiple of the allocation alignment
+ * \param[out] dirty for each page (of the allocation alignment), whether it has been written since
+ *  it was mapped; pages that were never touched are not dirty
+ */
+PAL_BOL
+DkVirtualMemoryQueryDirty(PAL_PTR addr, PAL_NUM size, PAL_BOL* dirty);
+
+/*!
+ * \brief Start tracking which pages of the process are written.
+ *
+ * Pages written after this call are reported by DkVirtualMemoryQueryWritten(), until the next
+ * call. Fails with PAL_ERROR_NOTSUPPORT if the host cannot track writes.
+ */
+PAL_BOL
+DkVirtualMemoryTrackWrites(void);
+
+/*!
+ * \brief Find the pages written since the last call to DkVirtualMemoryTrackWrites().
+ *
+ * \param addr the address, aligned at the allocation alignment
+ * \param size the size, a multiple of the allocation alignment
+ * \param[out] written for each page (of the allocation alignment), whether it has been written;
+ *  pages of mappings created since then are always reported as written
+ */
+PAL_BOL
+DkVirtualMemoryQueryWritten(PAL_PTR addr, PAL_NUM size, PAL_BOL* written);
+
 
 /*
  * PROCESS CREATION
@@ -560,6 +688,67 @@ DkStreamRead(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, P
 PAL_NUM
 DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, PAL_STR dest);
 
+/*!
+ * \brief Transfer data from one open stream to another without passing it through the caller.
+ *
+ * Up to `count` bytes are read from `src` and written to `dest` on the host. As with
+ * #DkStreamRead and #DkStreamWrite, `src_offset` and `dest_offset` are used only if the
+ * corresponding handle is a file. Fails with PAL_ERROR_NOTSUPPORT if the host cannot transfer
+ * between the two streams; the caller is then expected to copy the data itself.
+ *
+ * \return the number of bytes transferred or PAL_STREAM_ERROR for failure.
+ */
+PAL_NUM
+DkStreamTransfer(PAL_HANDLE dest, PAL_NUM dest_offset, PAL_HANDLE src, PAL_NUM src_offset,
+                 PAL_NUM count);
+
+/*! Buffer segment of a datagram, layout-compatible with `struct iovec` */
+typedef struct _PAL_IOVEC {
+    PAL_PTR base;
+    PAL_NUM len;
+} PAL_IOVEC;
+
+/*! Datagram descriptor for #DkStreamReadBatch and #DkStreamWriteBatch */
+typedef struct _PAL_DGRAM {
+    PAL_IOVEC* iov;  /*!< payload, scattered over `iovcnt` segments */
+    PAL_NUM iovcnt;
+    char* addr;      /*!< peer URI (e.g. "udp:127.0.0.1:8000"), or NULL on connected sockets */
+    PAL_NUM addrlen; /*!< size of the `addr` buffer */
+    PAL_NUM bytes;   /*!< number of bytes actually received or sent */
+} PAL_DGRAM;
+
+enum PAL_BATCH {
+    PAL_BATCH_NONBLOCK   = 01, /*!< do not block, even if the handle is blocking */
+    PAL_BATCH_WAITFORONE = 02, /*!< block only until the first datagram is received */
+};
+
+/*!
+ * \brief Receive a batch of datagrams from a UDP socket.
+ *
+ * Blocks like #DkStreamRead until all `count` datagrams are received, unless the handle is
+ * non-blocking or `options` say otherwise, in which case only the datagrams already queued are
+ * returned. For each received datagram, `bytes` is set and, if `addr` is given, the sender's URI
+ * is stored in it, or an empty string if it does not fit. Fails with PAL_ERROR_NOTSUPPORT if the host cannot batch reads on this handle.
+ *
+ * \param options can be a combination of the #PAL_BATCH flags
+ * \return the number of datagrams received or PAL_STREAM_ERROR for failure.
+ */
+PAL_NUM
+DkStreamReadBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, PAL_NUM count, PAL_FLG options);
+
+/*!
+ * \brief Send a batch of datagrams on a UDP socket.
+ *
+ * Each datagram is sent to its `addr` URI (required for unconnected sockets) and its `bytes` is
+ * set to the number of bytes sent. Fails with PAL_ERROR_NOTSUPPORT if the host cannot batch
+ * writes on this handle.
+ *
+ * \param options can be #PAL_BATCH_NONBLOCK
+ * \return the number of datagrams sent or PAL_STREAM_ERROR if the first one failed.
+ */
+PAL_NUM
+DkStreamWriteBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, PAL_NUM count, PAL_FLG options);
+
 enum PAL_DELETE {
     PAL_DELETE_RD = 01, /*!< shut down the read side only */
     PAL_DELETE_WR = 02, /*!< shut down the write side only */
@@ -725,6 +914,26 @@ noreturn void DkThreadExit(PAL_PTR clear_child_tid);
 PAL_BOL
 DkThreadResume(PAL_HANDLE thread);
 
+/*!
+ * \brief Set the CPU affinity of a thread.
+ *
+ * \param thread the thread handle
+ * \param cpumask_size size in bytes of `cpu_mask`
+ * \param cpu_mask bitmask of the CPUs (indexed like #PAL_CPU_INFO) the thread may run on
+ */
+PAL_BOL
+DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
+/*!
+ * \brief Get the CPU affinity of a thread.
+ *
+ * \param thread the thread handle
+ * \param cpumask_size size in bytes of `cpu_mask`, at least enough for `cpu_num` bits
+ * \param[out] cpu_mask bitmask of the CPUs the thread may run on
+ */
+PAL_BOL
+DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
 /*
  * Exception Handling
  */
@@ -836,6 +1045,25 @@ DkEventClear(PAL_HANDLE eventHandle);
  */
 PAL_BOL DkSynchronizationObjectWait(PAL_HANDLE handle, PAL_NUM timeout_us);
 
+/*!
+ * \brief Wait on a 32-bit word in memory shared with other processes.
+ *
+ * Blocks as long as the word at `addr` holds `val`, until #DkFutexWake is called on the same word
+ * by a thread of any process which maps the memory, or until the timeout expires.
+ *
+ * \param addr the address of the word, aligned to 4 bytes
+ * \param val the value the word is expected to hold
+ * \param timeout_us is the maximum time that the API should wait (in
+ *  microseconds), or #NO_TIMEOUT to wait until woken up
+ * \return true if woken up or if the word did not hold `val`, false otherwise
+ */
+PAL_BOL DkFutexWait(PAL_PTR addr, PAL_NUM val, PAL_NUM timeout_us);
+
+/*!
+ * \brief Wake up at most `count` threads waiting in #DkFutexWait on the word at `addr`.
+ */
+PAL_BOL DkFutexWake(PAL_PTR addr, PAL_NUM count);
+
 enum PAL_WAIT {
     PAL_WAIT_SIGNAL = 1, /*!< ignored in events */
     PAL_WAIT_READ   = 2,
@@ -874,6 +1102,23 @@ void DkObjectClose(PAL_HANDLE objectHandle);
 PAL_NUM
 DkSystemTimeQuery(void);
 
+/*! Host clocks for #DkSystemClockQuery */
+enum PAL_CLOCK {
+    PAL_CLOCK_REALTIME,        /*!< wall-clock time */
+    PAL_CLOCK_MONOTONIC,       /*!< time since an unspecified point; never goes backwards */
+    PAL_CLOCK_PROCESS_CPUTIME, /*!< CPU time consumed by the process */
+    PAL_CLOCK_THREAD_CPUTIME,  /*!< CPU time consumed by the calling thread */
+};
+
+/*!
+ * \brief Read one of the host clocks with nanosecond resolution.
+ *
+ * \param clock one of #PAL_CLOCK
+ * \return the time in nanoseconds, or 0 on failure
+ */
+PAL_NUM
+DkSystemClockQuery(PAL_FLG clock);
+
 /*!
  * \brief Cryptographically secure random.
  *
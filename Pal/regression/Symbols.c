@@ -14,6 +14,15 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkVirtualMemoryAlloc);
     PRINT_SYMBOL(DkVirtualMemoryFree);
     PRINT_SYMBOL(DkVirtualMemoryProtect);
+    PRINT_SYMBOL(DkVirtualMemoryAdvise);
+    PRINT_SYMBOL(DkVirtualMemoryBind);
+    PRINT_SYMBOL(DkThreadSetMemoryPolicy);
+    PRINT_SYMBOL(DkMemoryPolicyQuery);
+    PRINT_SYMBOL(DkVirtualMemoryMovePages);
+    PRINT_SYMBOL(DkSharedMemoryCreate);
+    PRINT_SYMBOL(DkVirtualMemoryQueryDirty);
+    PRINT_SYMBOL(DkVirtualMemoryTrackWrites);
+    PRINT_SYMBOL(DkVirtualMemoryQueryWritten);
 
     PRINT_SYMBOL(DkProcessCreate);
     PRINT_SYMBOL(DkProcessExit);
@@ -22,6 +31,9 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkStreamWaitForClient);
     PRINT_SYMBOL(DkStreamRead);
     PRINT_SYMBOL(DkStreamWrite);
+    PRINT_SYMBOL(DkStreamTransfer);
+    PRINT_SYMBOL(DkStreamReadBatch);
+    PRINT_SYMBOL(DkStreamWriteBatch);
     PRINT_SYMBOL(DkStreamDelete);
     PRINT_SYMBOL(DkStreamMap);
     PRINT_SYMBOL(DkStreamUnmap);
@@ -41,6 +53,8 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkThreadYieldExecution);
     PRINT_SYMBOL(DkThreadExit);
     PRINT_SYMBOL(DkThreadResume);
+    PRINT_SYMBOL(DkThreadSetCpuAffinity);
+    PRINT_SYMBOL(DkThreadGetCpuAffinity);
 
     PRINT_SYMBOL(DkSetExceptionHandler);
     PRINT_SYMBOL(DkExceptionReturn);
@@ -52,10 +66,13 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkEventSet);
     PRINT_SYMBOL(DkEventClear);
     PRINT_SYMBOL(DkSynchronizationObjectWait);
+    PRINT_SYMBOL(DkFutexWait);
+    PRINT_SYMBOL(DkFutexWake);
 
     PRINT_SYMBOL(DkObjectClose);
 
     PRINT_SYMBOL(DkSystemTimeQuery);
+    PRINT_SYMBOL(DkSystemClockQuery);
     PRINT_SYMBOL(DkRandomBitsRead);
     PRINT_SYMBOL(DkInstructionCacheFlush);
     PRINT_SYMBOL(DkSegmentRegister);
@@ -263,12 +263,24 @@ class TC_02_Symbols(RegressionTestCase):
         'DkVirtualMemoryAlloc',
         'DkVirtualMemoryFree',
         'DkVirtualMemoryProtect',
+        'DkVirtualMemoryAdvise',
+        'DkVirtualMemoryBind',
+        'DkThreadSetMemoryPolicy',
+        'DkMemoryPolicyQuery',
+        'DkVirtualMemoryMovePages',
+        'DkSharedMemoryCreate',
+        'DkVirtualMemoryQueryDirty',
+        'DkVirtualMemoryTrackWrites',
+        'DkVirtualMemoryQueryWritten',
         'DkProcessCreate',
         'DkProcessExit',
         'DkStreamOpen',
         'DkStreamWaitForClient',
         'DkStreamRead',
         'DkStreamWrite',
+        'DkStreamTransfer',
+        'DkStreamReadBatch',
+        'DkStreamWriteBatch',
         'DkStreamDelete',
         'DkStreamMap',
         'DkStreamUnmap',
@@ -286,6 +298,8 @@ class TC_02_Symbols(RegressionTestCase):
         'DkThreadYieldExecution',
         'DkThreadExit',
         'DkThreadResume',
+        'DkThreadSetCpuAffinity',
+        'DkThreadGetCpuAffinity',
         'DkSetExceptionHandler',
         'DkExceptionReturn',
         'DkMutexCreate',
@@ -295,9 +309,12 @@ class TC_02_Symbols(RegressionTestCase):
         'DkEventSet',
         'DkEventClear',
         'DkSynchronizationObjectWait',
+        'DkFutexWait',
+        'DkFutexWake',
         'DkStreamsWaitEvents',
         'DkObjectClose',
         'DkSystemTimeQuery',
+        'DkSystemClockQuery',
         'DkRandomBitsRead',
         'DkInstructionCacheFlush',
         'DkSegmentRegister',
@@ -20,6 +20,8 @@
  * This file contains implementation of Drawbridge event synchronization APIs.
  */
 
+#include <limits.h>
+
 #include "api.h"
 #include "pal.h"
 #include "pal_defs.h"
@@ -88,6 +90,45 @@ void DkEventWait(PAL_HANDLE handle) {
     LEAVE_PAL_CALL();
 }
 
+/* PAL call DkFutexWait: wait on a word in shared memory */
+PAL_BOL DkFutexWait(PAL_PTR addr, PAL_NUM val, PAL_NUM timeout_us) {
+    ENTER_PAL_CALL(DkFutexWait);
+
+    if (!addr || (uintptr_t)addr % sizeof(uint32_t)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int64_t timeout = timeout_us == NO_TIMEOUT ? -1 : (int64_t)timeout_us;
+    int ret         = _DkFutexWait((uint32_t*)addr, val, timeout);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+/* PAL call DkFutexWake: wake up threads waiting on a word in shared memory */
+PAL_BOL DkFutexWake(PAL_PTR addr, PAL_NUM count) {
+    ENTER_PAL_CALL(DkFutexWake);
+
+    if (!addr || (uintptr_t)addr % sizeof(uint32_t) || !count) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkFutexWake((uint32_t*)addr, count > INT_MAX ? INT_MAX : (int)count);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 void DkEventClear(PAL_HANDLE handle) {
     ENTER_PAL_CALL(DkEventClear);
 
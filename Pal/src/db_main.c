@@ -455,6 +455,9 @@ noreturn void pal_main (
         goto out_fail;
     }
     __pal_control.mem_info.mem_total = _DkMemoryQuota();
+    if (_DkGetNumaInfo(&__pal_control.numa_info, __pal_control.cpu_info.cpu_num) < 0) {
+        goto out_fail;
+    }
 
 #if PROFILING == 1
     pal_state.tail_startup_time      += _DkSystemTimeQuery() - before_tail;
@@ -107,3 +107,187 @@ DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot) {
 
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
+
+PAL_BOL
+DkVirtualMemoryAdvise(PAL_PTR addr, PAL_NUM size, PAL_FLG alloc_type) {
+    ENTER_PAL_CALL(DkVirtualMemoryAdvise);
+
+    if (!addr || !size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)addr, size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryAdvise((void*)addr, size, alloc_type);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryBind(PAL_PTR addr, PAL_NUM size, PAL_FLG policy, PAL_NUM* nodemask,
+                    PAL_NUM maxnode, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkVirtualMemoryBind);
+
+    if (!addr || !size || !IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size) ||
+        policy > PAL_MEMPOLICY_LOCAL) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)addr, size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryBind((void*)addr, size, policy, nodemask, maxnode, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkThreadSetMemoryPolicy(PAL_FLG policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    ENTER_PAL_CALL(DkThreadSetMemoryPolicy);
+
+    if (policy > PAL_MEMPOLICY_LOCAL) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkThreadSetMemoryPolicy(policy, nodemask, maxnode);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkMemoryPolicyQuery(PAL_PTR addr, PAL_FLG* policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    ENTER_PAL_CALL(DkMemoryPolicyQuery);
+
+    if (!policy) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkMemoryPolicyQuery((void*)addr, policy, nodemask, maxnode);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryMovePages(PAL_NUM count, PAL_PTR* pages, const int* nodes, int* status) {
+    ENTER_PAL_CALL(DkVirtualMemoryMovePages);
+
+    if (!pages || !status) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryMovePages(count, (void**)pages, nodes, status);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryQueryDirty(PAL_PTR addr, PAL_NUM size, PAL_BOL* dirty) {
+    ENTER_PAL_CALL(DkVirtualMemoryQueryDirty);
+
+    if (!addr || !dirty || !IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryQueryDirty((void*)addr, size, dirty);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryTrackWrites(void) {
+    ENTER_PAL_CALL(DkVirtualMemoryTrackWrites);
+
+    int ret = _DkVirtualMemoryTrackWrites();
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryQueryWritten(PAL_PTR addr, PAL_NUM size, PAL_BOL* written) {
+    ENTER_PAL_CALL(DkVirtualMemoryQueryWritten);
+
+    if (!addr || !written || !IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryQueryWritten((void*)addr, size, written);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_HANDLE
+DkSharedMemoryCreate(PAL_NUM size) {
+    ENTER_PAL_CALL(DkSharedMemoryCreate);
+
+    if (!size || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(NULL);
+    }
+
+    PAL_HANDLE handle = NULL;
+    int ret = _DkSharedMemoryCreate(&handle, size);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(NULL);
+    }
+
+    LEAVE_PAL_CALL_RETURN(handle);
+}
@@ -32,6 +32,19 @@ PAL_NUM DkSystemTimeQuery(void) {
     return time;
 }
 
+PAL_NUM DkSystemClockQuery(PAL_FLG clock) {
+    ENTER_PAL_CALL(DkSystemClockQuery);
+
+    uint64_t time_ns;
+    int ret = _DkSystemClockQuery(clock, &time_ns);
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(0);
+    }
+
+    LEAVE_PAL_CALL_RETURN(time_ns);
+}
+
 PAL_NUM DkRandomBitsRead(PAL_PTR buffer, PAL_NUM size) {
     ENTER_PAL_CALL(DkRandomBitsRead);
 
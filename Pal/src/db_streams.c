@@ -353,6 +353,107 @@ DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer,
     LEAVE_PAL_CALL_RETURN(ret);
 }
 
+/* PAL call DkStreamTransfer: Move data between two streams on the host. Return
+   number of bytes if succeeded,
+   or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM
+DkStreamTransfer(PAL_HANDLE dest, PAL_NUM dest_offset, PAL_HANDLE src, PAL_NUM src_offset,
+                 PAL_NUM count) {
+    ENTER_PAL_CALL(DkStreamTransfer);
+
+    if (!dest || !src) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    if (UNKNOWN_HANDLE(dest) || UNKNOWN_HANDLE(src)) {
+        _DkRaiseFailure(PAL_ERROR_BADHANDLE);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamTransfer(dest, dest_offset, src, src_offset, count);
+
+    if (!ret)
+        ret = -PAL_ERROR_ENDOFSTREAM;
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* _DkStreamReadBatch and _DkStreamWriteBatch for internal use, move several
+   datagrams at once. The actual behavior is defined by handler */
+int64_t _DkStreamReadBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, size_t count, int options) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->readbatch)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->readbatch(handle, dgrams, count, options);
+}
+
+int64_t _DkStreamWriteBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, size_t count, int options) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->writebatch)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->writebatch(handle, dgrams, count, options);
+}
+
+/* PAL call DkStreamReadBatch: Receive several datagrams from a stream. Return
+   number of datagrams if succeeded,
+   or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM
+DkStreamReadBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, PAL_NUM count, PAL_FLG options) {
+    ENTER_PAL_CALL(DkStreamReadBatch);
+
+    if (!handle || !dgrams || !count) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamReadBatch(handle, dgrams, count, options);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* PAL call DkStreamWriteBatch: Send several datagrams on a stream. Return
+   number of datagrams if succeeded,
+   or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM
+DkStreamWriteBatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, PAL_NUM count, PAL_FLG options) {
+    ENTER_PAL_CALL(DkStreamWriteBatch);
+
+    if (!handle || !dgrams || !count) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamWriteBatch(handle, dgrams, count, options);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
 /* _DkStreamAttributesQuery of internal use. The function query attribute
    of streams by their URI */
 int _DkStreamAttributesQuery(const char* uri, PAL_STREAM_ATTR* attr) {
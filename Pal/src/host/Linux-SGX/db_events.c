@@ -130,6 +130,20 @@ int _DkEventWait(PAL_HANDLE event) {
     return ret;
 }
 
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us) {
+    /* enclave memory is never shared with other processes */
+    __UNUSED(addr);
+    __UNUSED(val);
+    __UNUSED(timeout_us);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkFutexWake(uint32_t* addr, int count) {
+    __UNUSED(addr);
+    __UNUSED(count);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
 int _DkEventClear(PAL_HANDLE event) {
     atomic_set(event->event.signaled, 0);
     return 0;
@@ -583,3 +583,13 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
 
     return rv;
 }
+
+int _DkGetNumaInfo (PAL_NUMA_INFO * ni, PAL_NUM cpu_num)
+{
+    __UNUSED(cpu_num);
+
+    /* the enclave cannot trust or use the host's node layout (see _DkVirtualMemoryBind()), so
+     * the topology is left empty and the LibOS presents a single node */
+    memset(ni, 0, sizeof(*ni));
+    return 0;
+}
@@ -91,6 +91,75 @@ int _DkVirtualMemoryProtect(void* addr, uint64_t size, int prot) {
     return 0;
 }
 
+/* enclave pages are never backed by huge pages, so the advice is ignored */
+int _DkVirtualMemoryAdvise(void* addr, uint64_t size, int alloc_type) {
+    __UNUSED(addr);
+    __UNUSED(size);
+    __UNUSED(alloc_type);
+    return 0;
+}
+
+/* Enclave memory is allocated by the untrusted host when the enclave is built, so its placement
+ * cannot be changed from inside. */
+int _DkVirtualMemoryBind(void* addr, uint64_t size, int policy, PAL_NUM* nodemask,
+                         PAL_NUM maxnode, int flags) {
+    __UNUSED(addr);
+    __UNUSED(size);
+    __UNUSED(policy);
+    __UNUSED(nodemask);
+    __UNUSED(maxnode);
+    __UNUSED(flags);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkThreadSetMemoryPolicy(int policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    __UNUSED(policy);
+    __UNUSED(nodemask);
+    __UNUSED(maxnode);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkMemoryPolicyQuery(void* addr, PAL_FLG* policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    __UNUSED(addr);
+    __UNUSED(policy);
+    __UNUSED(nodemask);
+    __UNUSED(maxnode);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkVirtualMemoryMovePages(PAL_NUM count, void** pages, const int* nodes, int* status) {
+    __UNUSED(count);
+    __UNUSED(pages);
+    __UNUSED(nodes);
+    __UNUSED(status);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+/* untrusted memory cannot back memory of the enclave */
+int _DkSharedMemoryCreate(PAL_HANDLE* handle, uint64_t size) {
+    __UNUSED(handle);
+    __UNUSED(size);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkVirtualMemoryQueryDirty(void* addr, uint64_t size, PAL_BOL* dirty) {
+    __UNUSED(addr);
+    __UNUSED(size);
+    __UNUSED(dirty);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkVirtualMemoryTrackWrites(void) {
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkVirtualMemoryQueryWritten(void* addr, uint64_t size, PAL_BOL* written) {
+    __UNUSED(addr);
+    __UNUSED(size);
+    __UNUSED(written);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
 uint64_t _DkMemoryQuota(void) {
     return pal_sec.heap_max - pal_sec.heap_min;
 }
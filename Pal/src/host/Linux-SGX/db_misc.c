@@ -43,6 +43,20 @@ unsigned long _DkSystemTimeQuery(void) {
     return microsec;
 }
 
+int _DkSystemClockQuery(int clock, uint64_t* time_ns) {
+    /* the untrusted host only reports wall-clock time, in microseconds */
+    if (clock != PAL_CLOCK_REALTIME)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    unsigned long microsec;
+    int ret = ocall_gettime(&microsec);
+    if (ret)
+        return -PAL_ERROR_DENIED;
+
+    *time_ns = microsec * 1000ULL;
+    return 0;
+}
+
 size_t _DkRandomBitsRead(void* buffer, size_t size) {
     uint32_t rand;
     for (size_t i = 0; i < size; i += sizeof(rand)) {
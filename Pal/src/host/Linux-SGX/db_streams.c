@@ -215,6 +215,18 @@ static int handle_deserialize(PAL_HANDLE* handle, const void* data, size_t size)
     return 0;
 }
 
+/* Trusted and protected files are checked or decrypted inside the enclave, so their data cannot
+ * bypass it; the caller falls back to copying through the enclave. */
+int64_t _DkStreamTransfer(PAL_HANDLE dest, uint64_t dest_offset, PAL_HANDLE src,
+                          uint64_t src_offset, uint64_t count) {
+    __UNUSED(dest);
+    __UNUSED(dest_offset);
+    __UNUSED(src);
+    __UNUSED(src_offset);
+    __UNUSED(count);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
 /*!
  * \brief Send `cargo` handle to a process identified via `hdl` handle.
  *
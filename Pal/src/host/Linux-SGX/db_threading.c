@@ -165,6 +165,24 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
 }
 
+/* The enclave cannot rely on the untrusted host to schedule its threads anyway, so affinity is
+ * not forwarded to it. */
+int _DkThreadSetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask)
+{
+    __UNUSED(thread);
+    __UNUSED(cpumask_size);
+    __UNUSED(cpu_mask);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkThreadGetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask)
+{
+    __UNUSED(thread);
+    __UNUSED(cpumask_size);
+    __UNUSED(cpu_mask);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
 struct handle_ops thread_ops = {
     /* nothing */
 };
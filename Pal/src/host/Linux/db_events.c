@@ -129,6 +129,30 @@ int _DkEventWait(PAL_HANDLE event) {
     return ret;
 }
 
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us) {
+    struct timespec waittime;
+    struct timespec* waittimep = NULL;
+
+    if (timeout_us >= 0) {
+        waittime.tv_sec  = timeout_us / 1000000;
+        waittime.tv_nsec = (timeout_us % 1000000) * 1000;
+        waittimep        = &waittime;
+    }
+
+    /* not FUTEX_PRIVATE_FLAG: the word may be in memory shared with other processes */
+    int ret = INLINE_SYSCALL(futex, 6, addr, FUTEX_WAIT, val, waittimep, NULL, 0);
+
+    if (IS_ERR(ret) && ERRNO(ret) != EWOULDBLOCK)
+        return unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+int _DkFutexWake(uint32_t* addr, int count) {
+    int ret = INLINE_SYSCALL(futex, 6, addr, FUTEX_WAKE, count, NULL, NULL, 0);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 int _DkEventClear(PAL_HANDLE event) {
     atomic_set(&event->event.signaled, 0);
     return 0;
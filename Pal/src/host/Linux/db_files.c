@@ -73,7 +73,7 @@ static int64_t file_read (PAL_HANDLE handle, uint64_t offset, uint64_t count,
     int fd = handle->file.fd;
     int64_t ret;
 
-    ret = INLINE_SYSCALL(pread64, 4, fd, buffer, count, offset);
+    ret = uring_read(fd, buffer, count, offset, false);
 
     if (IS_ERR(ret))
         return unix_to_pal_error(ERRNO(ret));
@@ -88,7 +88,7 @@ static int64_t file_write (PAL_HANDLE handle, uint64_t offset, uint64_t count,
     int fd = handle->file.fd;
     int64_t ret;
 
-    ret = INLINE_SYSCALL(pwrite64, 4, fd, buffer, count, offset);
+    ret = uring_write(fd, buffer, count, offset, false);
 
     if (IS_ERR(ret))
         return unix_to_pal_error(ERRNO(ret));
@@ -381,6 +381,44 @@ static char * cpu_flags[]
           "pbe",    // "pending break event"
         };
 
+/* Reads a small sysfs file into the null-terminated `buf`; returns its length or a negative PAL
+ * error code */
+static int read_sysfs_file(const char* path, char* buf, size_t size) {
+    int fd = INLINE_SYSCALL(open, 3, path, O_RDONLY|O_CLOEXEC, 0);
+    if (IS_ERR(fd))
+        return unix_to_pal_error(ERRNO(fd));
+
+    int ret = INLINE_SYSCALL(read, 3, fd, buf, size - 1);
+    INLINE_SYSCALL(close, 1, fd);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    buf[ret] = '\0';
+    return ret;
+}
+
+/* Parses the next "first[-last]" element of a sysfs list like "0-3,8"; returns the position
+ * after it, or NULL at the end of the list */
+static const char* next_list_range(const char* ptr, int* first, int* last) {
+    char* end;
+
+    while (*ptr == ' ' || *ptr == '\t' || *ptr == ',')
+        ptr++;
+
+    *first = (int)strtol(ptr, &end, 10);
+    if (ptr == end || *first < 0)
+        return NULL;
+
+    *last = *first;
+    if (*end == '-') {
+        ptr = end + 1;
+        *last = (int)strtol(ptr, &end, 10);
+        if (ptr == end || *last < *first)
+            return NULL;
+    }
+    return end;
+}
+
 /*
  * Returns the number of online CPUs read from /sys/devices/system/cpu/online, -errno on failure.
  * Understands complex formats like "1,3-5,6".
@@ -447,6 +485,45 @@ static double get_bogomips(void) {
     return sanitize_bogomips_value(get_bogomips_from_cpuinfo_buf(buf, sizeof(buf)));
 }
 
+/* Reads the core and package of each CPU from sysfs; leaves them NULL if they are not there */
+static int get_cpu_topology(PAL_CPU_INFO* ci) {
+    char buf[32];
+    char path[64];
+
+    ci->cpu_core    = NULL;
+    ci->cpu_package = NULL;
+
+    PAL_IDX* core    = malloc(sizeof(PAL_IDX) * ci->cpu_num);
+    PAL_IDX* package = malloc(sizeof(PAL_IDX) * ci->cpu_num);
+    if (!core || !package) {
+        free(core);
+        free(package);
+        return -PAL_ERROR_NOMEM;
+    }
+
+    for (PAL_NUM cpu = 0; cpu < ci->cpu_num; cpu++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%lu/topology/core_id", cpu);
+        if (read_sysfs_file(path, buf, sizeof(buf)) < 0)
+            goto out_unknown;
+        core[cpu] = atol(buf);
+
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%lu/topology/physical_package_id", cpu);
+        if (read_sysfs_file(path, buf, sizeof(buf)) < 0)
+            goto out_unknown;
+        package[cpu] = atol(buf);
+    }
+
+    ci->cpu_core    = core;
+    ci->cpu_package = package;
+    return 0;
+
+out_unknown:
+    free(core);
+    free(package);
+    return 0;
+}
+
 int _DkGetCPUInfo (PAL_CPU_INFO * ci)
 {
     unsigned int words[PAL_CPUID_WORD_NUM];
@@ -483,6 +560,13 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
     }
     ci->cpu_num = cores;
 
+    rv = get_cpu_topology(ci);
+    if (rv < 0) {
+        free(vendor_id);
+        free(brand);
+        return rv;
+    }
+
     cpuid(1, 0, words);
     ci->cpu_family   = BIT_EXTRACT_LE(words[PAL_CPUID_WORD_EAX],  8, 12);
     ci->cpu_model    = BIT_EXTRACT_LE(words[PAL_CPUID_WORD_EAX],  4,  8);
@@ -526,3 +610,78 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
 
     return rv;
 }
+
+int _DkGetNumaInfo (PAL_NUMA_INFO * ni, PAL_NUM cpu_num)
+{
+    char buf[512];
+    char path[64];
+    int first, last;
+
+    memset(ni, 0, sizeof(*ni));
+
+    /* kernels built without NUMA support have no node directory; report no topology then */
+    if (read_sysfs_file("/sys/devices/system/node/online", buf, sizeof(buf)) < 0)
+        return 0;
+
+    int nodes = 0;
+    for (const char* ptr = buf; (ptr = next_list_range(ptr, &first, &last));)
+        if (last + 1 > nodes)
+            nodes = last + 1;
+
+    if (!nodes)
+        return 0;
+
+    PAL_IDX* cpu_node = malloc(sizeof(PAL_IDX) * (cpu_num ? cpu_num : 1));
+    PAL_NUM* node_mem = malloc(sizeof(PAL_NUM) * nodes);
+    PAL_IDX* distance = malloc(sizeof(PAL_IDX) * nodes * nodes);
+    if (!cpu_node || !node_mem || !distance) {
+        free(cpu_node);
+        free(node_mem);
+        free(distance);
+        return -PAL_ERROR_NOMEM;
+    }
+
+    memset(cpu_node, 0, sizeof(PAL_IDX) * cpu_num);
+
+    for (int node = 0; node < nodes; node++) {
+        node_mem[node] = 0;
+        for (int i = 0; i < nodes; i++)
+            distance[node * nodes + i] = (i == node) ? 10 : 20;
+
+        /* nodes in gaps of the online list have no directory and keep the defaults */
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if (read_sysfs_file(path, buf, sizeof(buf)) >= 0)
+            for (const char* ptr = buf; (ptr = next_list_range(ptr, &first, &last));)
+                for (int cpu = first; cpu <= last && (PAL_NUM)cpu < cpu_num; cpu++)
+                    cpu_node[cpu] = node;
+
+        /* the first line is "Node <n> MemTotal:   <size> kB" */
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node);
+        if (read_sysfs_file(path, buf, sizeof(buf)) >= 0) {
+            const char* total = buf;
+            while (*total && *total != ':')
+                total++;
+            if (*total)
+                node_mem[node] = (PAL_NUM)atol(total + 1) * 1024;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance", node);
+        if (read_sysfs_file(path, buf, sizeof(buf)) >= 0) {
+            char* ptr = buf;
+            for (int i = 0; i < nodes; i++) {
+                char* end;
+                long dist = strtol(ptr, &end, 10);
+                if (ptr == end)
+                    break;
+                distance[node * nodes + i] = dist;
+                ptr = end;
+            }
+        }
+    }
+
+    ni->node_num = nodes;
+    ni->cpu_node = cpu_node;
+    ni->node_mem = node_mem;
+    ni->distance = distance;
+    return 0;
+}
@@ -31,6 +31,8 @@
 
 #include <asm/mman.h>
 #include <asm/fcntl.h>
+#include <linux/mempolicy.h>
+#include <linux/memfd.h>
 
 bool _DkCheckMemoryMappable (const void * addr, size_t size)
 {
@@ -51,6 +53,9 @@ int _DkVirtualMemoryAlloc (void ** paddr, size_t size, int alloc_type,
     if (IS_ERR_P(mem))
         return unix_to_pal_error(ERRNO_P(mem));
 
+    if (alloc_type & PAL_ALLOC_HUGEPAGE)
+        _DkVirtualMemoryAdvise(mem, size, alloc_type);
+
     *paddr = mem;
     return 0;
 }
@@ -69,6 +74,184 @@ int _DkVirtualMemoryProtect (void * addr, size_t size, int prot)
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
 }
 
+int _DkVirtualMemoryAdvise (void * addr, size_t size, int alloc_type)
+{
+    int advice = (alloc_type & PAL_ALLOC_HUGEPAGE) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE;
+    int ret = INLINE_SYSCALL(madvise, 3, addr, size, advice);
+
+    /* kernels without transparent huge pages reject the advice; it is only a hint */
+    if (IS_ERR(ret) && ERRNO(ret) != EINVAL)
+        return unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+/* PAL node masks count their bits, while the host interfaces take one more than that */
+#define HOST_MAXNODE(maxnode)   ((maxnode) ? (maxnode) + 1 : 0)
+
+int _DkVirtualMemoryBind (void * addr, size_t size, int policy, PAL_NUM * nodemask,
+                          PAL_NUM maxnode, int flags)
+{
+    /* PAL_MEMPOLICY and PAL_MEMBIND values are the same as the host ones */
+    int ret = INLINE_SYSCALL(mbind, 6, addr, size, policy, nodemask,
+                             nodemask ? HOST_MAXNODE(maxnode) : 0, flags);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+int _DkThreadSetMemoryPolicy (int policy, PAL_NUM * nodemask, PAL_NUM maxnode)
+{
+    int ret = INLINE_SYSCALL(set_mempolicy, 3, policy, nodemask,
+                             nodemask ? HOST_MAXNODE(maxnode) : 0);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+int _DkMemoryPolicyQuery (void * addr, PAL_FLG * policy, PAL_NUM * nodemask, PAL_NUM maxnode)
+{
+    int mode;
+    int ret = INLINE_SYSCALL(get_mempolicy, 5, &mode, nodemask,
+                             nodemask ? HOST_MAXNODE(maxnode) : 0, addr,
+                             addr ? MPOL_F_ADDR : 0);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    /* strip the mode flags (e.g. MPOL_F_STATIC_NODES) the host reports along with the mode */
+    *policy = mode & ~MPOL_MODE_FLAGS;
+    return 0;
+}
+
+int _DkVirtualMemoryMovePages (PAL_NUM count, void ** pages, const int * nodes, int * status)
+{
+    int ret = INLINE_SYSCALL(move_pages, 6, 0, count, pages, nodes, status, MPOL_MF_MOVE);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    for (PAL_NUM i = 0; i < count; i++)
+        if (status[i] < 0)
+            status[i] = unix_to_pal_error(-status[i]);
+
+    return 0;
+}
+
+/* the memory is a file without a name, so the object is a file handle and gets mapped, sent to
+ * other processes and closed like one */
+int _DkSharedMemoryCreate (PAL_HANDLE * handle, uint64_t size)
+{
+    static const char path[] = "/memfd:graphene-shm";
+
+    int fd = INLINE_SYSCALL(memfd_create, 2, path + static_strlen("/memfd:"), MFD_CLOEXEC);
+    if (IS_ERR(fd))
+        return unix_to_pal_error(ERRNO(fd));
+
+    int ret = INLINE_SYSCALL(ftruncate, 2, fd, size);
+    if (IS_ERR(ret)) {
+        INLINE_SYSCALL(close, 1, fd);
+        return unix_to_pal_error(ERRNO(ret));
+    }
+
+    PAL_HANDLE hdl = malloc(HANDLE_SIZE(file) + sizeof(path));
+    if (!hdl) {
+        INLINE_SYSCALL(close, 1, fd);
+        return -PAL_ERROR_NOMEM;
+    }
+
+    SET_HANDLE_TYPE(hdl, file);
+    HANDLE_HDR(hdl)->flags |= RFD(0)|WFD(0);
+    hdl->file.fd = fd;
+    hdl->file.map_start = NULL;
+    char * realpath = (void *) hdl + HANDLE_SIZE(file);
+    memcpy(realpath, path, sizeof(path));
+    hdl->file.realpath = (PAL_STR) realpath;
+    *handle = hdl;
+    return 0;
+}
+
+/* pages of a private file mapping are copied to anonymous memory when written, and written pages
+ * are marked soft-dirty, which /proc/self/pagemap reports (see
+ * Documentation/admin-guide/mm/pagemap.rst and soft-dirty.rst in Linux) */
+#define PAGEMAP_PRESENT     (1ULL << 63)
+#define PAGEMAP_SWAPPED     (1ULL << 62)
+#define PAGEMAP_FILE        (1ULL << 61)
+#define PAGEMAP_SOFT_DIRTY  (1ULL << 55)
+
+static int read_pagemap (void * addr, uint64_t size, PAL_BOL * out, bool soft_dirty)
+{
+    int fd = INLINE_SYSCALL(open, 3, "/proc/self/pagemap", O_RDONLY, 0);
+    if (IS_ERR(fd))
+        return unix_to_pal_error(ERRNO(fd));
+
+    uint64_t entries[256];
+    uint64_t first = (uint64_t) addr / pal_state.alloc_align;
+    uint64_t npages = size / pal_state.alloc_align;
+    int ret = 0;
+
+    for (uint64_t i = 0 ; i < npages ; ) {
+        uint64_t count = npages - i;
+        if (count > ARRAY_SIZE(entries))
+            count = ARRAY_SIZE(entries);
+
+        ret = INLINE_SYSCALL(pread64, 4, fd, entries, count * sizeof(entries[0]),
+                             (first + i) * sizeof(entries[0]));
+        if (IS_ERR(ret)) {
+            ret = unix_to_pal_error(ERRNO(ret));
+            break;
+        }
+        if (!ret) {
+            ret = -PAL_ERROR_INVAL;
+            break;
+        }
+
+        count = ret / sizeof(entries[0]);
+        for (uint64_t j = 0 ; j < count ; j++)
+            out[i + j] = soft_dirty ? !!(entries[j] & PAGEMAP_SOFT_DIRTY) :
+                         (entries[j] & (PAGEMAP_PRESENT|PAGEMAP_SWAPPED)) &&
+                         !(entries[j] & PAGEMAP_FILE);
+        i += count;
+        ret = 0;
+    }
+
+    INLINE_SYSCALL(close, 1, fd);
+    return ret;
+}
+
+int _DkVirtualMemoryQueryDirty (void * addr, uint64_t size, PAL_BOL * dirty)
+{
+    return read_pagemap(addr, size, dirty, false);
+}
+
+static volatile int soft_dirty_probe;
+
+int _DkVirtualMemoryTrackWrites (void)
+{
+    int fd = INLINE_SYSCALL(open, 3, "/proc/self/clear_refs", O_WRONLY, 0);
+    if (IS_ERR(fd))
+        return unix_to_pal_error(ERRNO(fd));
+
+    /* "4" clears the soft-dirty bits of all pages */
+    int ret = INLINE_SYSCALL(write, 3, fd, "4", 1);
+    INLINE_SYSCALL(close, 1, fd);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    /* kernels without CONFIG_MEM_SOFT_DIRTY accept the request, but never mark pages written */
+    soft_dirty_probe++;
+
+    void * page = ALLOC_ALIGN_DOWN_PTR((void *) &soft_dirty_probe);
+    PAL_BOL written;
+    if ((ret = read_pagemap(page, pal_state.alloc_align, &written, true)) < 0)
+        return ret;
+
+    return written ? 0 : -PAL_ERROR_NOTSUPPORT;
+}
+
+int _DkVirtualMemoryQueryWritten (void * addr, uint64_t size, PAL_BOL * written)
+{
+    return read_pagemap(addr, size, written, true);
+}
+
 static int read_proc_meminfo (const char * key, unsigned long * val)
 {
     int fd = INLINE_SYSCALL(open, 3, "/proc/meminfo", O_RDONLY, 0);
@@ -110,6 +110,46 @@ unsigned long _DkSystemTimeQuery(void) {
 #endif
 }
 
+int _DkSystemClockQuery(int clock, uint64_t* time_ns) {
+    int host_clock;
+
+    switch (clock) {
+        case PAL_CLOCK_REALTIME:
+            host_clock = CLOCK_REALTIME;
+            break;
+        case PAL_CLOCK_MONOTONIC:
+            host_clock = CLOCK_MONOTONIC;
+            break;
+        case PAL_CLOCK_PROCESS_CPUTIME:
+            host_clock = CLOCK_PROCESS_CPUTIME_ID;
+            break;
+        case PAL_CLOCK_THREAD_CPUTIME:
+            host_clock = CLOCK_THREAD_CPUTIME_ID;
+            break;
+        default:
+            return -PAL_ERROR_INVAL;
+    }
+
+    struct timespec time;
+    int ret;
+
+#if USE_VDSO_GETTIME == 1
+    if (linux_state.vdso_clock_gettime) {
+        ret = linux_state.vdso_clock_gettime(host_clock, &time);
+    } else {
+#endif
+        ret = INLINE_SYSCALL(clock_gettime, 2, host_clock, &time);
+#if USE_VDSO_GETTIME == 1
+    }
+#endif
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    *time_ns = 1000000000ULL * time.tv_sec + time.tv_nsec;
+    return 0;
+}
+
 #if USE_ARCH_RDRAND == 1
 int _DkRandomBitsRead(void* buffer, int size) {
     int total_bytes = 0;
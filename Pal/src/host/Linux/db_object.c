@@ -46,6 +46,9 @@ int _DkSynchronizationObjectWait(PAL_HANDLE handle, int64_t timeout_us) {
     return ops->wait(handle, timeout_us);
 }
 
+/* Handle sets up to this size are waited on with pollfd arrays on the stack */
+#define WAIT_EVENTS_STACK_HANDLES 8
+
 /* Wait for specific events on all handles in the handle array and return multiple events
  * (including errors) reported by the host. Return 0 on success, PAL error on failure. */
 int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events, PAL_FLG* ret_events,
@@ -55,15 +58,23 @@ int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events
     if (count == 0)
         return 0;
 
-    struct pollfd* fds = malloc(count * MAX_FDS * sizeof(*fds));
-    if (!fds) {
-        return -PAL_ERROR_NOMEM;
-    }
+    /* small handle sets (the common case of event loops) are polled without allocating */
+    struct pollfd fds_stack[WAIT_EVENTS_STACK_HANDLES * MAX_FDS];
+    size_t offsets_stack[WAIT_EVENTS_STACK_HANDLES * MAX_FDS];
+    struct pollfd* fds = fds_stack;
+    size_t* offsets    = offsets_stack;
 
-    size_t* offsets = malloc(count * MAX_FDS * sizeof(*offsets));
-    if (!offsets) {
-        free(fds);
-        return -PAL_ERROR_NOMEM;
+    if (count > WAIT_EVENTS_STACK_HANDLES) {
+        fds = malloc(count * MAX_FDS * sizeof(*fds));
+        if (!fds) {
+            return -PAL_ERROR_NOMEM;
+        }
+
+        offsets = malloc(count * MAX_FDS * sizeof(*offsets));
+        if (!offsets) {
+            free(fds);
+            return -PAL_ERROR_NOMEM;
+        }
     }
 
     /* collect all FDs of all PAL handles that may report read/write events */
@@ -162,7 +173,9 @@ int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events
 
     ret = 0;
 out:
-    free(fds);
-    free(offsets);
+    if (fds != fds_stack) {
+        free(fds);
+        free(offsets);
+    }
     return ret;
 }
@@ -130,7 +130,8 @@ static int pipe_waitforclient(PAL_HANDLE handle, PAL_HANDLE* client) {
     if (handle->pipe.fd == PAL_IDX_POISON)
         return -PAL_ERROR_DENIED;
 
-    int newfd = INLINE_SYSCALL(accept4, 4, handle->pipe.fd, NULL, NULL, O_CLOEXEC);
+    int newfd = uring_accept4(handle->pipe.fd, NULL, NULL, O_CLOEXEC,
+                              handle->pipe.nonblocking);
     if (IS_ERR(newfd))
         return unix_to_pal_error(ERRNO(newfd));
 
@@ -299,8 +300,10 @@ static int64_t pipe_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void*
         return -PAL_ERROR_NOTCONNECTION;
 
     int fd = IS_HANDLE_TYPE(handle, pipeprv) ? handle->pipeprv.fds[0] : handle->pipe.fd;
+    bool nonblock = IS_HANDLE_TYPE(handle, pipeprv) ? handle->pipeprv.nonblocking
+                                                    : handle->pipe.nonblocking;
 
-    ssize_t bytes = INLINE_SYSCALL(read, 3, fd, buffer, len);
+    ssize_t bytes = uring_read(fd, buffer, len, -1, nonblock);
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
@@ -328,8 +331,10 @@ static int64_t pipe_write(PAL_HANDLE handle, uint64_t offset, size_t len, const
         return -PAL_ERROR_NOTCONNECTION;
 
     int fd = IS_HANDLE_TYPE(handle, pipeprv) ? handle->pipeprv.fds[1] : handle->pipe.fd;
+    bool nonblock = IS_HANDLE_TYPE(handle, pipeprv) ? handle->pipeprv.nonblocking
+                                                    : handle->pipe.nonblocking;
 
-    ssize_t bytes = INLINE_SYSCALL(write, 3, fd, buffer, len);
+    ssize_t bytes = uring_write(fd, buffer, len, -1, nonblock);
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
@@ -40,6 +40,7 @@ typedef __kernel_pid_t pid_t;
 #include <asm/errno.h>
 #include <asm/fcntl.h>
 #include <asm/poll.h>
+#include <linux/futex.h>
 #include <linux/sched.h>
 #include <linux/time.h>
 #include <linux/types.h>
@@ -117,6 +118,11 @@ struct proc_args {
     unsigned int    parent_data_size;
     unsigned int    exec_data_size;
     unsigned int    manifest_data_size;
+
+    /* set if the child was pre-spawned as a zygote (see below); in this case the executable
+     * cannot be inherited, so it is sent over the process stream right after the arguments */
+    unsigned int    zygote;
+    unsigned int    exec_on_stream;
 };
 
 /*
@@ -157,11 +163,223 @@ failed:
     return -PAL_ERROR_DENIED;
 }
 
-int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
+/*
+ * Execute a new PAL loader which will wait in init_child_process() for its
+ * process arguments. On success, returns the size of the serialized child's
+ * end of the process stream (stored in *parent_data) and the parent's end in
+ * *child_handle. If @signals_blocked, the calling thread has the async
+ * signals blocked already and they are left blocked.
+ */
+static int spawn_process (PAL_HANDLE exec, const char ** args, bool signals_blocked,
+                          PAL_HANDLE * child_handle, void ** parent_data)
+{
+    PAL_HANDLE parent_handle = NULL, chdl = NULL;
+    struct proc_param param;
+    int ret;
+
+    ret = create_process_handle(&parent_handle, &chdl);
+    if (ret < 0)
+        return ret;
+
+    param.parent = parent_handle;
+    param.exec = exec;
+    param.manifest = pal_state.manifest_handle;
+
+    void * data = NULL;
+    ret = handle_serialize(parent_handle, &data);
+    if (ret < 0)
+        goto out;
+    size_t datasz = (size_t)ret;
+
+    /* the first argument must be the PAL */
+    int argc = 0;
+    if (args)
+        for (; args[argc] ; argc++);
+    param.argv = __alloca(sizeof(const char *) * (argc + 2));
+    param.argv[0] = PAL_LOADER;
+    if (args)
+        memcpy(&param.argv[1], args, sizeof(const char *) * argc);
+    param.argv[argc + 1] = NULL;
+
+    /* Child's signal handler may mess with parent's memory during vfork(),
+     * so block signals
+     */
+    ret = signals_blocked ? 0 : block_async_signals(true);
+    if (ret < 0) {
+        free(data);
+        goto out;
+    }
+
+    ret = child_process(&param);
+    if (IS_ERR(ret)) {
+        if (!signals_blocked)
+            block_async_signals(false);
+        free(data);
+        ret = -PAL_ERROR_DENIED;
+        goto out;
+    }
+
+    chdl->process.pid = ret;
+
+    /* children unblock async signals by signal_setup() */
+    ret = signals_blocked ? 0 : block_async_signals(false);
+    if (ret < 0) {
+        free(data);
+        goto out;
+    }
+
+    *child_handle = chdl;
+    *parent_data = data;
+    ret = (int)datasz;
+out:
+    _DkObjectClose(parent_handle);
+    if (ret < 0)
+        _DkObjectClose(chdl);
+    return ret;
+}
+
+/*
+ * Zygotes are PAL loaders spawned ahead of time (loader.zygote in the
+ * manifest), so that fork emulation does not pay for execve and PAL
+ * relocation on its critical path. An idle zygote sits in
+ * init_child_process() until _DkProcessCreate() hands it the process
+ * arguments. Only creations without extra arguments (i.e., fork) can be
+ * served by a zygote; everything else takes the regular path.
+ */
+#define MAX_ZYGOTES     8
+
+struct zygote {
+    PAL_HANDLE  child;
+    void *      parent_data;
+    size_t      parent_data_size;
+};
+
+static struct zygote zygotes[MAX_ZYGOTES];
+static int zygote_cnt = 0;
+static int zygote_max = -1;     /* not read from the manifest yet */
+static PAL_LOCK zygote_lock = LOCK_INIT;
+
+static int get_zygote_max (void)
+{
+    if (zygote_max >= 0)
+        return zygote_max;
+
+    int max = 0;
+    char cfgbuf[CONFIG_MAX];
+    if (pal_state.root_config &&
+        get_config(pal_state.root_config, "loader.zygote", cfgbuf, sizeof(cfgbuf)) > 0) {
+        max = atoi(cfgbuf);
+        if (max < 0)
+            max = 0;
+        if (max > MAX_ZYGOTES)
+            max = MAX_ZYGOTES;
+    }
+
+    zygote_max = max;
+    return max;
+}
+
+static bool take_zygote (struct zygote * z)
+{
+    bool found = false;
+
+    _DkInternalLock(&zygote_lock);
+    if (zygote_cnt) {
+        *z = zygotes[--zygote_cnt];
+        found = true;
+    }
+    _DkInternalUnlock(&zygote_lock);
+    return found;
+}
+
+static void refill_zygotes (bool signals_blocked)
+{
+    int max = get_zygote_max();
+
+    while (true) {
+        _DkInternalLock(&zygote_lock);
+        int cnt = zygote_cnt;
+        _DkInternalUnlock(&zygote_lock);
+        if (cnt >= max)
+            break;
+
+        struct zygote z;
+        int ret = spawn_process(NULL, NULL, signals_blocked, &z.child, &z.parent_data);
+        if (ret < 0)
+            break;
+        z.parent_data_size = ret;
+
+        _DkInternalLock(&zygote_lock);
+        if (zygote_cnt < max) {
+            zygotes[zygote_cnt++] = z;
+            z.child = NULL;
+        }
+        _DkInternalUnlock(&zygote_lock);
+
+        /* another thread filled the pool meanwhile; the zygote exits on
+           seeing the end of its process stream */
+        if (z.child) {
+            _DkObjectClose(z.child);
+            free(z.parent_data);
+            break;
+        }
+    }
+}
+
+/*
+ * The pool is refilled by a PAL-internal thread, so that neither the first
+ * creation nor the following ones wait for spawning zygotes. The thread
+ * sleeps on zygote_refill_req between refills; it never runs LibOS code, so
+ * it keeps the async signals blocked.
+ */
+static int zygote_refill_req = 0;
+static bool zygote_thread_started = false;
+
+static int zygote_thread (void * param)
+{
+    __UNUSED(param);
+    block_async_signals(true);
+
+    while (true) {
+        while (!__atomic_exchange_n(&zygote_refill_req, 0, __ATOMIC_ACQ_REL))
+            INLINE_SYSCALL(futex, 6, &zygote_refill_req, FUTEX_WAIT, 0, NULL, NULL, 0);
+
+        refill_zygotes(/*signals_blocked=*/true);
+    }
+    return 0;
+}
+
+static void request_zygote_refill (void)
 {
+    bool start = false;
+
+    _DkInternalLock(&zygote_lock);
+    if (!zygote_thread_started)
+        start = zygote_thread_started = true;
+    _DkInternalUnlock(&zygote_lock);
+
+    __atomic_store_n(&zygote_refill_req, 1, __ATOMIC_RELEASE);
+
+    if (start) {
+        PAL_HANDLE thread;
+        if (_DkThreadCreate(&thread, zygote_thread, NULL) < 0) {
+            /* refill on the spot, and try a thread again next time */
+            _DkInternalLock(&zygote_lock);
+            zygote_thread_started = false;
+            _DkInternalUnlock(&zygote_lock);
+            refill_zygotes(/*signals_blocked=*/false);
+        }
+        return;
+    }
 
+    INLINE_SYSCALL(futex, 6, &zygote_refill_req, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
+{
     PAL_HANDLE exec = NULL;
-    PAL_HANDLE parent_handle = NULL, child_handle = NULL;
+    PAL_HANDLE child_handle = NULL;
+    bool use_zygote = false;
     int ret;
 #if PROFILING == 1
     unsigned long before_create = _DkSystemTimeQuery();
@@ -193,30 +411,36 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
             exec->file.map_start = (PAL_PTR)exec_map->l_map_start;
     }
 
-    /* step 2: create parant and child process handle */
-
-    struct proc_param param;
-    ret = create_process_handle(&parent_handle, &child_handle);
-    if (ret < 0)
-        goto out;
-
-    param.parent = parent_handle;
-    param.exec = exec;
-    param.manifest = pal_state.manifest_handle;
+    /* step 2: take a zygote, or create a child process which waits for its
+       parameters */
+
+    size_t parent_datasz, exec_datasz, manifest_datasz;
+    void * parent_data;
+    void * exec_data;
+    void * manifest_data;
+    struct zygote z;
+    bool try_zygote = (!args || !args[0]) && get_zygote_max();
+
+retry:
+    parent_datasz = exec_datasz = manifest_datasz = 0;
+    parent_data = exec_data = manifest_data = NULL;
+    use_zygote = false;
+
+    if (try_zygote && take_zygote(&z)) {
+        child_handle = z.child;
+        parent_data = z.parent_data;
+        parent_datasz = z.parent_data_size;
+        use_zygote = true;
+    } else {
+        ret = spawn_process(exec, args, /*signals_blocked=*/false, &child_handle, &parent_data);
+        if (ret < 0)
+            goto out;
+        parent_datasz = (size_t)ret;
+    }
 
     /* step 3: compose process parameter */
 
-    size_t parent_datasz = 0, exec_datasz = 0, manifest_datasz = 0;
-    void * parent_data = NULL;
-    void * exec_data = NULL;
-    void * manifest_data = NULL;
-
-    ret = handle_serialize(parent_handle, &parent_data);
-    if (ret < 0)
-        goto out;
-    parent_datasz = (size_t)ret;
-
-    if (exec) {
+    if (exec && !use_zygote) {
         ret = handle_serialize(exec, &exec_data);
         if (ret < 0) {
             free(parent_data);
@@ -242,7 +466,10 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
     memcpy(&proc_args->pal_sec, &pal_sec, sizeof(struct pal_sec));
     proc_args->pal_sec._dl_debug_state = NULL;
     proc_args->pal_sec._r_debug = NULL;
+    proc_args->pal_sec.process_id = child_handle->process.pid;
     proc_args->memory_quota = linux_state.memory_quota;
+    proc_args->zygote = use_zygote;
+    proc_args->exec_on_stream = use_zygote && exec;
 
     void * data = (void *) (proc_args + 1);
 
@@ -266,43 +493,10 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
         proc_args->manifest_data_size = 0;
     }
 
-    /* step 4: create a child thread which will execve in the future */
-
-    /* the first argument must be the PAL */
-    int argc = 0;
-    if (args)
-        for (; args[argc] ; argc++);
-    param.argv = __alloca(sizeof(const char *) * (argc + 2));
-    param.argv[0] = PAL_LOADER;
-    if (args)
-        memcpy(&param.argv[1], args, sizeof(const char *) * argc);
-    param.argv[argc + 1] = NULL;
-
 #if PROFILING == 1
     proc_args->process_create_time = before_create;
 #endif
 
-    /* Child's signal handler may mess with parent's memory during vfork(),
-     * so block signals
-     */
-    ret = block_async_signals(true);
-    if (ret < 0)
-        goto out;
-
-    ret = child_process(&param);
-    if (IS_ERR(ret)) {
-        ret = -PAL_ERROR_DENIED;
-        goto out;
-    }
-
-    proc_args->pal_sec.process_id = ret;
-    child_handle->process.pid = ret;
-
-    /* children unblock async signals by signal_setup() */
-    ret = block_async_signals(false);
-    if (ret < 0)
-        goto out;
-
     /* step 4: send parameters over the process handle */
 
     ret = INLINE_SYSCALL(write, 3,
@@ -312,20 +506,38 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
 
     if (IS_ERR(ret) || (size_t)ret < sizeof(struct proc_args) + datasz) {
         ret = -PAL_ERROR_DENIED;
-        goto out;
+        goto failed;
+    }
+
+    if (proc_args->exec_on_stream) {
+        ret = _DkSendHandle(child_handle, exec);
+        if (ret < 0)
+            goto failed;
     }
 
     *handle = child_handle;
     ret = 0;
+    goto out;
+failed:
+    if (use_zygote) {
+        /* the zygote is gone (e.g., killed on the host), so fall back to
+           creating the process on the spot */
+        _DkObjectClose(child_handle);
+        child_handle = NULL;
+        try_zygote = false;
+        goto retry;
+    }
 out:
-    if (parent_handle)
-        _DkObjectClose(parent_handle);
     if (exec)
         _DkObjectClose(exec);
     if (ret < 0) {
         if (child_handle)
             _DkObjectClose(child_handle);
     }
+    /* prepare zygotes for the next process creation in the background, after
+       the child is already busy initializing */
+    if (get_zygote_max())
+        request_zygote_refill();
     return ret;
 }
 
@@ -353,6 +565,10 @@ void init_child_process (PAL_HANDLE * parent_handle,
         return;
     }
 
+    /* an idle zygote whose creator exited or dropped it */
+    if (!bytes)
+        _DkProcessExit(0);
+
     /* a child must have parent handle and an executable */
     if (!proc_args->parent_data_size)
         INIT_FAIL(PAL_ERROR_INVAL, "invalid process created");
@@ -380,6 +596,21 @@ void init_child_process (PAL_HANDLE * parent_handle,
     data += proc_args->parent_data_size;
     *parent_handle = parent;
 
+    /* a zygote receives the executable over the parent stream */
+    if (proc_args->exec_on_stream) {
+        PAL_HANDLE exec = NULL;
+
+        ret = _DkReceiveHandle(parent, &exec);
+        if (ret < 0)
+            INIT_FAIL(-ret, "cannot receive executable handle");
+        *exec_handle = exec;
+    }
+
+    /* a zygote has been waiting since its spawning; count its time from now
+       on */
+    if (proc_args->zygote)
+        pal_state.start_time = _DkSystemTimeQueryEarly();
+
     /* occupy PROC_INIT_FD so no one will use it */
     INLINE_SYSCALL(dup2, 2, 0, PROC_INIT_FD);
 
@@ -397,6 +397,22 @@ failed:
     return ret;
 }
 
+/* io_uring (see db_uring.c) does not apply the timeouts of sockets, so sockets with timeouts use
+ * the system calls */
+static int64_t sock_recvmsg(PAL_HANDLE handle, struct msghdr* hdr) {
+    if (handle->sock.receivetimeout)
+        return INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, hdr, 0);
+
+    return uring_recvmsg(handle->sock.fd, hdr, 0, handle->sock.nonblocking);
+}
+
+static int64_t sock_sendmsg(PAL_HANDLE handle, struct msghdr* hdr) {
+    if (handle->sock.sendtimeout)
+        return INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, hdr, MSG_NOSIGNAL);
+
+    return uring_sendmsg(handle->sock.fd, hdr, MSG_NOSIGNAL, handle->sock.nonblocking);
+}
+
 /* accept a tcp connection */
 static int tcp_accept(PAL_HANDLE handle, PAL_HANDLE* client) {
     if (!IS_HANDLE_TYPE(handle, tcpsrv) || !handle->sock.bind || handle->sock.conn)
@@ -411,7 +427,8 @@ static int tcp_accept(PAL_HANDLE handle, PAL_HANDLE* client) {
     socklen_t addrlen = sizeof(struct sockaddr);
     int ret           = 0;
 
-    int newfd = INLINE_SYSCALL(accept4, 4, handle->sock.fd, &buffer, &addrlen, O_CLOEXEC);
+    int newfd = uring_accept4(handle->sock.fd, &buffer, &addrlen, O_CLOEXEC,
+                              handle->sock.nonblocking || handle->sock.receivetimeout);
 
     if (IS_ERR(newfd))
         switch (ERRNO(newfd)) {
@@ -565,7 +582,7 @@ static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, size_t len, void* bu
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
+    int64_t bytes = sock_recvmsg(handle, &hdr);
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -599,7 +616,7 @@ static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, size_t len, const v
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
+    int64_t bytes = sock_sendmsg(handle, &hdr);
     if (IS_ERR(bytes))
         bytes = unix_to_pal_error(ERRNO(bytes));
 
@@ -780,7 +797,7 @@ static int64_t udp_receive(PAL_HANDLE handle, uint64_t offset, size_t len, void*
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
+    int64_t bytes = sock_recvmsg(handle, &hdr);
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -814,7 +831,7 @@ static int64_t udp_receivebyaddr(PAL_HANDLE handle, uint64_t offset, size_t len,
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
+    int64_t bytes = sock_recvmsg(handle, &hdr);
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -852,7 +869,7 @@ static int64_t udp_send(PAL_HANDLE handle, uint64_t offset, size_t len, const vo
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
+    int64_t bytes = sock_sendmsg(handle, &hdr);
     if (IS_ERR(bytes))
         bytes = unix_to_pal_error(ERRNO(bytes));
 
@@ -898,13 +915,148 @@ static int64_t udp_sendbyaddr(PAL_HANDLE handle, uint64_t offset, size_t len, co
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
+    int64_t bytes = sock_sendmsg(handle, &hdr);
     if (IS_ERR(bytes))
         bytes = unix_to_pal_error(ERRNO(bytes));
 
     return bytes;
 }
 
+/* Upper bound on the datagrams moved by one host sendmmsg/recvmmsg; the
+   callers simply get a short count and issue another batch */
+#define UDP_BATCH_MAX 64
+
+/* same as struct mmsghdr, which glibc only exposes under _GNU_SOURCE */
+struct host_mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+static_assert(sizeof(PAL_IOVEC) == sizeof(struct iovec) &&
+              offsetof(PAL_IOVEC, base) == offsetof(struct iovec, iov_base) &&
+              offsetof(PAL_IOVEC, len) == offsetof(struct iovec, iov_len),
+              "PAL_IOVEC must be layout-compatible with struct iovec");
+
+static int64_t udp_receivebatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, size_t count,
+                                int options) {
+    bool srv = IS_HANDLE_TYPE(handle, udpsrv);
+
+    if (!srv && !IS_HANDLE_TYPE(handle, udp))
+        return -PAL_ERROR_NOTCONNECTION;
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (count > UDP_BATCH_MAX)
+        count = UDP_BATCH_MAX;
+
+    struct host_mmsghdr msgs[UDP_BATCH_MAX];
+    struct sockaddr_in6 addrs[UDP_BATCH_MAX];
+
+    for (size_t i = 0; i < count; i++) {
+        struct msghdr* hdr = &msgs[i].msg_hdr;
+        hdr->msg_name       = (srv && dgrams[i].addr) ? &addrs[i] : NULL;
+        hdr->msg_namelen    = hdr->msg_name ? sizeof(addrs[i]) : 0;
+        hdr->msg_iov        = (struct iovec*)dgrams[i].iov;
+        hdr->msg_iovlen     = dgrams[i].iovcnt;
+        hdr->msg_control    = NULL;
+        hdr->msg_controllen = 0;
+        hdr->msg_flags      = 0;
+        msgs[i].msg_len     = 0;
+    }
+
+    int flags = ((options & PAL_BATCH_NONBLOCK) ? MSG_DONTWAIT : 0) |
+                ((options & PAL_BATCH_WAITFORONE) ? MSG_WAITFORONE : 0);
+
+    int64_t ret = INLINE_SYSCALL(recvmmsg, 5, handle->sock.fd, msgs, count, flags, NULL);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    for (int64_t i = 0; i < ret; i++) {
+        dgrams[i].bytes = msgs[i].msg_len;
+
+        if (!msgs[i].msg_hdr.msg_name)
+            continue;
+
+        /* the datagrams are already taken from the socket, so a sender address which does not
+         * fit is left empty rather than failing the whole batch */
+        char* addr_uri = strcpy_static(dgrams[i].addr, URI_PREFIX_UDP, dgrams[i].addrlen);
+        if (!addr_uri ||
+            inet_create_uri(addr_uri, dgrams[i].addr + dgrams[i].addrlen - addr_uri,
+                            (struct sockaddr*)&addrs[i], msgs[i].msg_hdr.msg_namelen) < 0) {
+            if (dgrams[i].addrlen)
+                dgrams[i].addr[0] = '\0';
+        }
+    }
+
+    return ret;
+}
+
+static int64_t udp_sendbatch(PAL_HANDLE handle, PAL_DGRAM* dgrams, size_t count, int options) {
+    bool srv = IS_HANDLE_TYPE(handle, udpsrv);
+
+    if (!srv && !IS_HANDLE_TYPE(handle, udp))
+        return -PAL_ERROR_NOTCONNECTION;
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (count > UDP_BATCH_MAX)
+        count = UDP_BATCH_MAX;
+
+    struct host_mmsghdr msgs[UDP_BATCH_MAX];
+    struct sockaddr_in6 addrs[UDP_BATCH_MAX];
+    char addrbuf[PAL_SOCKADDR_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        struct msghdr* hdr = &msgs[i].msg_hdr;
+
+        if (srv) {
+            const char* addr = dgrams[i].addr;
+            if (!addr || !strstartswith_static(addr, URI_PREFIX_UDP))
+                return -PAL_ERROR_INVAL;
+
+            addr += static_strlen(URI_PREFIX_UDP);
+            size_t len = strlen(addr);
+            if (len >= sizeof(addrbuf))
+                return -PAL_ERROR_TOOLONG;
+            memcpy(addrbuf, addr, len + 1);
+
+            char* uri = addrbuf;
+            size_t addrlen;
+            int err = inet_parse_uri(&uri, (struct sockaddr*)&addrs[i], &addrlen);
+            if (err < 0)
+                return err;
+
+            hdr->msg_name    = &addrs[i];
+            hdr->msg_namelen = addrlen;
+        } else {
+            hdr->msg_name    = (void*)handle->sock.conn;
+            hdr->msg_namelen = addr_size((struct sockaddr*)handle->sock.conn);
+        }
+
+        hdr->msg_iov        = (struct iovec*)dgrams[i].iov;
+        hdr->msg_iovlen     = dgrams[i].iovcnt;
+        hdr->msg_control    = NULL;
+        hdr->msg_controllen = 0;
+        hdr->msg_flags      = 0;
+        msgs[i].msg_len     = 0;
+    }
+
+    int flags = MSG_NOSIGNAL | ((options & PAL_BATCH_NONBLOCK) ? MSG_DONTWAIT : 0);
+
+    int64_t ret = INLINE_SYSCALL(sendmmsg, 4, handle->sock.fd, msgs, count, flags);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    for (int64_t i = 0; i < ret; i++)
+        dgrams[i].bytes = msgs[i].msg_len;
+
+    return ret;
+}
+
 static int socket_delete(PAL_HANDLE handle, int access) {
     if (handle->sock.fd == PAL_IDX_POISON)
         return 0;
@@ -1193,6 +1345,8 @@ struct handle_ops udp_ops = {
     .open           = &udp_open,
     .read           = &udp_receive,
     .write          = &udp_send,
+    .readbatch      = &udp_receivebatch,
+    .writebatch     = &udp_sendbatch,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -1204,6 +1358,8 @@ struct handle_ops udpsrv_ops = {
     .open           = &udp_open,
     .readbyaddr     = &udp_receivebyaddr,
     .writebyaddr    = &udp_sendbyaddr,
+    .readbatch      = &udp_receivebatch,
+    .writebatch     = &udp_sendbatch,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
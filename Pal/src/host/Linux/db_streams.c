@@ -222,6 +222,74 @@ int handle_deserialize(PAL_HANDLE* handle, const void* data, int size) {
     return 0;
 }
 
+/* Host fd to read from or write to for the streams _DkStreamTransfer can use, or -1 */
+static int transfer_fd(PAL_HANDLE handle, bool write) {
+    PAL_IDX fd;
+
+    switch (PAL_GET_TYPE(handle)) {
+        case pal_type_file:
+            fd = handle->file.fd;
+            break;
+        case pal_type_pipe:
+        case pal_type_pipecli:
+            fd = handle->pipe.fd;
+            break;
+        case pal_type_pipeprv:
+            fd = handle->pipeprv.fds[write ? 1 : 0];
+            break;
+        case pal_type_tcp:
+            fd = handle->sock.fd;
+            break;
+        case pal_type_dev:
+            fd = write ? handle->dev.fd_out : handle->dev.fd_in;
+            break;
+        default:
+            return -1;
+    }
+
+    return fd == PAL_IDX_POISON ? -1 : (int)fd;
+}
+
+/*!
+ * \brief Move up to `count` bytes from `src` to `dest` inside the host kernel.
+ *
+ * The source has to be a file: it is copied with copy_file_range() if the destination is a file
+ * too, and with sendfile() otherwise. Pipes and sockets are UNIX/TCP sockets on the host, which
+ * can be neither sendfile()'d from nor spliced without an intermediate host pipe.
+ *
+ * \return  Number of bytes transferred (0 at the end of `src`), negative PAL error code otherwise.
+ */
+int64_t _DkStreamTransfer(PAL_HANDLE dest, uint64_t dest_offset, PAL_HANDLE src,
+                          uint64_t src_offset, uint64_t count) {
+    if (!IS_HANDLE_TYPE(src, file))
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int in  = transfer_fd(src, /*write=*/false);
+    int out = transfer_fd(dest, /*write=*/true);
+    if (in < 0 || out < 0)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    off_t in_off = src_offset;
+    int64_t ret;
+
+    if (IS_HANDLE_TYPE(dest, file)) {
+        off_t out_off = dest_offset;
+        ret = INLINE_SYSCALL(copy_file_range, 6, in, &in_off, out, &out_off, count, 0);
+        if (!IS_ERR(ret) ||
+            (ERRNO(ret) != ENOSYS && ERRNO(ret) != EXDEV && ERRNO(ret) != EINVAL))
+            goto out;
+
+        /* files are written with pwrite64(), so the host file position is free to use */
+        ret = INLINE_SYSCALL(lseek, 3, out, dest_offset, SEEK_SET);
+        if (IS_ERR(ret))
+            goto out;
+    }
+
+    ret = INLINE_SYSCALL(sendfile, 4, out, in, &in_off, count);
+out:
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
+}
+
 /*!
  * \brief Send `cargo` handle to a process identified via `hdl` handle.
  *
@@ -239,6 +239,8 @@ noreturn void _DkThreadExit(int* clear_child_tid) {
     assert(handle);
 
     block_async_signals(true);
+    uring_thread_exit();
+
     if (tcb->alt_stack) {
         stack_t ss;
         ss.ss_sp    = NULL;
@@ -300,6 +302,25 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return 0;
 }
 
+int _DkThreadSetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask)
+{
+    int ret = INLINE_SYSCALL(sched_setaffinity, 3, thread->thread.tid, cpumask_size, cpu_mask);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+int _DkThreadGetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask)
+{
+    int ret = INLINE_SYSCALL(sched_getaffinity, 3, thread->thread.tid, cpumask_size, cpu_mask);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    /* the host only fills the bytes covering its CPUs */
+    memset((char*)cpu_mask + ret, 0, cpumask_size - ret);
+    return 0;
+}
+
 struct handle_ops thread_ops = {
     /* nothing */
 };
@@ -0,0 +1,377 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * db_uring.c
+ *
+ * This file contains the io_uring engine of the Linux PAL, enabled with "loader.io_uring = 1" in
+ * the manifest. Reads, writes, recvmsg/sendmsg and accepts on streams are submitted to a ring of
+ * the calling thread. A kernel thread, shared by all rings of the process, polls the rings for
+ * submissions, so an operation which completes right away (e.g., a read from the page cache, or
+ * from a socket with pending data) takes no host system call. Other operations are waited for with
+ * io_uring_enter().
+ *
+ * Each function below returns the same as the system call it replaces, which is used instead if
+ * the host cannot poll rings for unprivileged processes (before Linux 5.11). The callers say if the
+ * stream is non-blocking, which is passed as RWF_NOWAIT or MSG_DONTWAIT. The ring already returns
+ * -EAGAIN on host descriptors with O_NONBLOCK; the flags also cover the streams whose mode is only
+ * kept in the PAL handle.
+ */
+
+#include <asm/errno.h>
+#include <asm/mman.h>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include "api.h"
+#include "atomic.h"
+#include "pal.h"
+#include "pal_debug.h"
+#include "pal_defs.h"
+#include "pal_error.h"
+#include "pal_internal.h"
+#include "pal_linux.h"
+#include "pal_linux_defs.h"
+
+#define URING_ENTRIES    4    /* one operation at a time, and its cancellation */
+#define URING_SQ_IDLE_MS 10   /* the kernel thread sleeps after this time without submissions */
+#define URING_SPIN       2000 /* completion checks before sleeping in io_uring_enter() */
+#define URING_MAX_RW     0x7ffff000 /* same as the host limit for read() and write() */
+
+/* the user data of cancellations, which are never waited for */
+#define URING_CANCEL_DATA 0
+
+struct uring {
+    int fd;
+    bool busy;
+    uint64_t seq;
+
+    void* ring;
+    size_t ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    uint32_t sq_entries;
+    uint32_t* sq_head;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_flags;
+    uint32_t* sq_array;
+
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+};
+
+static int g_uring_enabled = -1; /* not read from the manifest yet */
+static struct uring g_uring_anchor; /* never used, owns the kernel thread shared by all rings */
+static PAL_LOCK g_uring_lock = LOCK_INIT;
+
+static void uring_destroy(struct uring* ring) {
+    if (ring->sqes)
+        INLINE_SYSCALL(munmap, 2, ring->sqes, ring->sqes_size);
+    if (ring->ring)
+        INLINE_SYSCALL(munmap, 2, ring->ring, ring->ring_size);
+    INLINE_SYSCALL(close, 1, ring->fd);
+}
+
+/* Set up a ring whose submissions are polled by the kernel thread of `wq_fd` (or a new one if
+ * `wq_fd` is negative). Returns 0 or a negative host error. */
+static int uring_setup(struct uring* ring, int wq_fd) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags          = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = URING_SQ_IDLE_MS;
+    if (wq_fd >= 0) {
+        params.flags |= IORING_SETUP_ATTACH_WQ;
+        params.wq_fd = wq_fd;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = INLINE_SYSCALL(io_uring_setup, 2, URING_ENTRIES, &params);
+    if (IS_ERR(ring->fd))
+        return ring->fd;
+
+    /* streams are not registered with the ring, and both rings share one mapping */
+    if (!(params.features & IORING_FEAT_SQPOLL_NONFIXED) ||
+        !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        INLINE_SYSCALL(close, 1, ring->fd);
+        return -ENOSYS;
+    }
+
+    size_t sq_size  = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_size  = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void* ptr = (void*)ARCH_MMAP(NULL, ring->ring_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (IS_ERR_P(ptr)) {
+        uring_destroy(ring);
+        return -ERRNO_P(ptr);
+    }
+    ring->ring = ptr;
+
+    ptr = (void*)ARCH_MMAP(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (IS_ERR_P(ptr)) {
+        uring_destroy(ring);
+        return -ERRNO_P(ptr);
+    }
+    ring->sqes = ptr;
+
+    ring->sq_entries = params.sq_entries;
+    ring->sq_head    = ring->ring + params.sq_off.head;
+    ring->sq_tail    = ring->ring + params.sq_off.tail;
+    ring->sq_mask    = ring->ring + params.sq_off.ring_mask;
+    ring->sq_flags   = ring->ring + params.sq_off.flags;
+    ring->sq_array   = ring->ring + params.sq_off.array;
+    ring->cq_head    = ring->ring + params.cq_off.head;
+    ring->cq_tail    = ring->ring + params.cq_off.tail;
+    ring->cq_mask    = ring->ring + params.cq_off.ring_mask;
+    ring->cqes       = ring->ring + params.cq_off.cqes;
+    return 0;
+}
+
+static bool uring_enabled(void) {
+    if (g_uring_enabled >= 0)
+        return g_uring_enabled;
+
+    _DkInternalLock(&g_uring_lock);
+    if (g_uring_enabled < 0) {
+        char cfgbuf[CONFIG_MAX];
+        bool enabled = pal_state.root_config &&
+                       get_config(pal_state.root_config, "loader.io_uring", cfgbuf,
+                                  sizeof(cfgbuf)) == 1 && cfgbuf[0] == '1';
+
+        /* the kernel thread needs a core of its own, or it competes with the waiting threads */
+        if (enabled && __pal_control.cpu_info.cpu_num < 2) {
+            printf("Warning: io_uring engine disabled, it needs at least 2 CPUs\n");
+            enabled = false;
+        }
+
+        /* without io_uring (e.g., disabled by the host), the system calls are used */
+        int ret;
+        if (enabled && (ret = uring_setup(&g_uring_anchor, -1)) < 0) {
+            printf("Warning: io_uring engine disabled, the host cannot poll rings (%d)\n", ret);
+            enabled = false;
+        }
+
+        g_uring_enabled = enabled;
+    }
+    _DkInternalUnlock(&g_uring_lock);
+
+    return g_uring_enabled;
+}
+
+/* Returns the ring of the current thread, or NULL if the system call should be used instead. */
+static struct uring* get_uring(void) {
+    if (!uring_enabled())
+        return NULL;
+
+    PAL_TCB_LINUX* tcb  = get_tcb_linux();
+    struct uring* ring = tcb->uring;
+
+    if (!ring) {
+        ring = malloc(sizeof(*ring));
+        if (!ring)
+            return NULL;
+
+        if (uring_setup(ring, g_uring_anchor.fd) < 0) {
+            free(ring);
+            return NULL;
+        }
+        tcb->uring = ring;
+    }
+
+    /* already waiting for an operation, e.g., interrupted by a signal handler */
+    if (ring->busy)
+        return NULL;
+
+    return ring;
+}
+
+void uring_thread_exit(void) {
+    PAL_TCB_LINUX* tcb = get_tcb_linux();
+
+    if (tcb->uring) {
+        uring_destroy(tcb->uring);
+        free(tcb->uring);
+        tcb->uring = NULL;
+    }
+}
+
+static void uring_submit(struct uring* ring, const struct io_uring_sqe* req, uint64_t user_data) {
+    uint32_t tail = *ring->sq_tail;
+    uint32_t idx  = tail & *ring->sq_mask;
+
+    /* at most one operation and its cancellation are in flight, so there is always room */
+    assert(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) < ring->sq_entries);
+
+    ring->sqes[idx]           = *req;
+    ring->sqes[idx].user_data = user_data;
+    ring->sq_array[idx]       = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    /* the store to the tail must be visible before checking if the kernel thread sleeps */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+        INLINE_SYSCALL(io_uring_enter, 6, ring->fd, 0, 0, IORING_ENTER_SQ_WAKEUP, NULL, 0);
+}
+
+/* Wait for the completion of the operation tagged `user_data` and store its result in `res`.
+ * Returns 0, or a negative host error of io_uring_enter() (e.g., -EINTR if a signal arrived), in
+ * which case the operation may still be in flight. */
+static int uring_wait(struct uring* ring, uint64_t user_data, long* res) {
+    for (int i = 0;; i++) {
+        uint32_t head = *ring->cq_head;
+
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+            uint64_t data = cqe->user_data;
+            long result   = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            /* other completions are of cancellations */
+            if (data == user_data) {
+                *res = result;
+                return 0;
+            }
+            continue;
+        }
+
+        if (i < URING_SPIN) {
+            CPU_RELAX();
+            continue;
+        }
+
+        int ret = INLINE_SYSCALL(io_uring_enter, 6, ring->fd, 0, 1, IORING_ENTER_GETEVENTS,
+                                 NULL, 0);
+        if (IS_ERR(ret) && ERRNO(ret) != EAGAIN && ERRNO(ret) != EBUSY)
+            return ret;
+    }
+}
+
+static long uring_call(struct uring* ring, const struct io_uring_sqe* req) {
+    uint64_t user_data = ++ring->seq;
+    long res;
+
+    ring->busy = true;
+    uring_submit(ring, req, user_data);
+
+    int ret = uring_wait(ring, user_data, &res);
+    if (ret < 0) {
+        /* the system call would return the error right away, so cancel the operation; it may
+         * have completed in the meantime, and then its result is returned instead */
+        struct io_uring_sqe cancel;
+        memset(&cancel, 0, sizeof(cancel));
+        cancel.opcode = IORING_OP_ASYNC_CANCEL;
+        cancel.fd     = -1;
+        cancel.addr   = user_data;
+        uring_submit(ring, &cancel, URING_CANCEL_DATA);
+
+        while (uring_wait(ring, user_data, &res) < 0)
+            ;
+        if (res == -ECANCELED)
+            res = ret;
+    }
+
+    ring->busy = false;
+    return res;
+}
+
+long uring_read(int fd, void* buf, size_t count, int64_t offset, bool nonblock) {
+    struct uring* ring = get_uring();
+    if (!ring)
+        return offset < 0 ? INLINE_SYSCALL(read, 3, fd, buf, count)
+                          : INLINE_SYSCALL(pread64, 4, fd, buf, count, offset);
+
+    struct io_uring_sqe req;
+    memset(&req, 0, sizeof(req));
+    req.opcode = IORING_OP_READ;
+    req.fd     = fd;
+    req.addr   = (uint64_t)buf;
+    req.len    = count < URING_MAX_RW ? count : URING_MAX_RW;
+    req.off    = offset; /* -1 for the current position */
+    if (nonblock)
+        req.rw_flags = RWF_NOWAIT;
+    return uring_call(ring, &req);
+}
+
+long uring_write(int fd, const void* buf, size_t count, int64_t offset, bool nonblock) {
+    struct uring* ring = get_uring();
+    if (!ring)
+        return offset < 0 ? INLINE_SYSCALL(write, 3, fd, buf, count)
+                          : INLINE_SYSCALL(pwrite64, 4, fd, buf, count, offset);
+
+    struct io_uring_sqe req;
+    memset(&req, 0, sizeof(req));
+    req.opcode = IORING_OP_WRITE;
+    req.fd     = fd;
+    req.addr   = (uint64_t)buf;
+    req.len    = count < URING_MAX_RW ? count : URING_MAX_RW;
+    req.off    = offset;
+    if (nonblock)
+        req.rw_flags = RWF_NOWAIT;
+    return uring_call(ring, &req);
+}
+
+long uring_recvmsg(int fd, struct msghdr* hdr, int flags, bool nonblock) {
+    struct uring* ring = get_uring();
+    if (!ring)
+        return INLINE_SYSCALL(recvmsg, 3, fd, hdr, flags);
+
+    struct io_uring_sqe req;
+    memset(&req, 0, sizeof(req));
+    req.opcode    = IORING_OP_RECVMSG;
+    req.fd        = fd;
+    req.addr      = (uint64_t)hdr;
+    req.len       = 1;
+    req.msg_flags = nonblock ? flags | MSG_DONTWAIT : flags;
+    return uring_call(ring, &req);
+}
+
+long uring_sendmsg(int fd, const struct msghdr* hdr, int flags, bool nonblock) {
+    struct uring* ring = get_uring();
+    if (!ring)
+        return INLINE_SYSCALL(sendmsg, 3, fd, hdr, flags);
+
+    struct io_uring_sqe req;
+    memset(&req, 0, sizeof(req));
+    req.opcode    = IORING_OP_SENDMSG;
+    req.fd        = fd;
+    req.addr      = (uint64_t)hdr;
+    req.len       = 1;
+    req.msg_flags = nonblock ? flags | MSG_DONTWAIT : flags;
+    return uring_call(ring, &req);
+}
+
+long uring_accept4(int fd, struct sockaddr* addr, unsigned int* addrlen, int flags,
+                   bool nonblock) {
+    struct uring* ring = nonblock ? NULL : get_uring();
+    if (!ring)
+        return INLINE_SYSCALL(accept4, 4, fd, addr, addrlen, flags);
+
+    struct io_uring_sqe req;
+    memset(&req, 0, sizeof(req));
+    req.opcode       = IORING_OP_ACCEPT;
+    req.fd           = fd;
+    req.addr         = (uint64_t)addr;
+    req.addr2        = (uint64_t)addrlen;
+    req.accept_flags = flags;
+    return uring_call(ring, &req);
+}
@@ -194,9 +194,21 @@ typedef struct pal_tcb_linux {
         void *      alt_stack;
         int         (*callback) (void *);
         void *      param;
+        struct uring * uring;
     };
 } PAL_TCB_LINUX;
 
+/* io_uring engine (see db_uring.c); these return the same as the replaced system calls */
+struct msghdr;
+struct sockaddr;
+long uring_read (int fd, void * buf, size_t count, int64_t offset, bool nonblock);
+long uring_write (int fd, const void * buf, size_t count, int64_t offset, bool nonblock);
+long uring_recvmsg (int fd, struct msghdr * hdr, int flags, bool nonblock);
+long uring_sendmsg (int fd, const struct msghdr * hdr, int flags, bool nonblock);
+long uring_accept4 (int fd, struct sockaddr * addr, unsigned int * addrlen, int flags,
+                    bool nonblock);
+void uring_thread_exit (void);
+
 noreturn void pal_linux_main (void * args);
 int pal_thread_init (void * tcbptr);
 
@@ -50,6 +50,14 @@ int _DkEventClear(PAL_HANDLE event) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkFutexWake(uint32_t* addr, int count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 static int event_close(PAL_HANDLE handle) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
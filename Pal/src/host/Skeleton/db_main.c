@@ -61,3 +61,9 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
     /* needs to be implemented */
     return 0;
 }
+
+int _DkGetNumaInfo (PAL_NUMA_INFO * ni, PAL_NUM cpu_num)
+{
+    /* needs to be implemented */
+    return 0;
+}
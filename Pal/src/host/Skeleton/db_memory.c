@@ -43,6 +43,43 @@ int _DkVirtualMemoryProtect(void* addr, uint64_t size, int prot) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkVirtualMemoryAdvise(void* addr, uint64_t size, int alloc_type) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryBind(void* addr, uint64_t size, int policy, PAL_NUM* nodemask,
+                         PAL_NUM maxnode, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkThreadSetMemoryPolicy(int policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkMemoryPolicyQuery(void* addr, PAL_FLG* policy, PAL_NUM* nodemask, PAL_NUM maxnode) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryMovePages(PAL_NUM count, void** pages, const int* nodes, int* status) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkSharedMemoryCreate(PAL_HANDLE* handle, uint64_t size) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryQueryDirty(void* addr, uint64_t size, PAL_BOL* dirty) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryTrackWrites(void) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryQueryWritten(void* addr, uint64_t size, PAL_BOL* written) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 unsigned long _DkMemoryQuota(void) {
     return 0;
 }
@@ -43,6 +43,10 @@ unsigned long _DkSystemTimeQuery(void) {
     return 0;
 }
 
+int _DkSystemClockQuery(int clock, uint64_t* time_ns) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 size_t _DkRandomBitsRead(void* buffer, size_t size) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
@@ -38,6 +38,13 @@ int _DkStreamUnmap(void* addr, uint64_t size) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+/* _DkStreamTransfer for internal use. Move data between two streams on the
+   host. */
+int64_t _DkStreamTransfer(PAL_HANDLE dest, uint64_t dest_offset, PAL_HANDLE src,
+                          uint64_t src_offset, uint64_t count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 /* _DkSendHandle for internal use. Send a PAL_HANDLE over the given
    process handle. */
 int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
@@ -56,6 +56,14 @@ int _DkThreadResume(PAL_HANDLE threadHandle) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 struct handle_ops thread_ops = {
     /* nothing */
 };
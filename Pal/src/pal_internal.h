@@ -69,6 +69,11 @@ struct handle_ops {
     int64_t (*writebyaddr) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                             const void * buffer, const char * addr, size_t addrlen);
 
+    /* 'readbatch' and 'writebatch' move several datagrams at once, used by
+       DkStreamReadBatch and DkStreamWriteBatch */
+    int64_t (*readbatch) (PAL_HANDLE handle, PAL_DGRAM * dgrams, size_t count, int options);
+    int64_t (*writebatch) (PAL_HANDLE handle, PAL_DGRAM * dgrams, size_t count, int options);
+
     /* 'close' and 'delete' is used by DkObjectClose and DkStreamDelete,
        'close' will close the stream, while 'delete' actually destroy
        the stream, such as deleting a file or shutting down a socket */
@@ -274,6 +279,8 @@ unsigned long _DkMemoryQuota (void);
 unsigned long _DkMemoryAvailableQuota (void);
 // Returns 0 on success, negative PAL code on failure
 int _DkGetCPUInfo (PAL_CPU_INFO * info);
+// Returns 0 on success (also if the host has no NUMA topology), negative PAL code on failure
+int _DkGetNumaInfo (PAL_NUMA_INFO * info, PAL_NUM cpu_num);
 
 /* Internal DK calls, in case any of the internal routines needs to use them */
 /* DkStream calls */
@@ -284,6 +291,10 @@ int64_t _DkStreamRead (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                        void * buf, char * addr, int addrlen);
 int64_t _DkStreamWrite (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                         const void * buf, const char * addr, int addrlen);
+int64_t _DkStreamTransfer (PAL_HANDLE dest, uint64_t dest_offset, PAL_HANDLE src,
+                           uint64_t src_offset, uint64_t count);
+int64_t _DkStreamReadBatch (PAL_HANDLE handle, PAL_DGRAM * dgrams, size_t count, int options);
+int64_t _DkStreamWriteBatch (PAL_HANDLE handle, PAL_DGRAM * dgrams, size_t count, int options);
 int _DkStreamAttributesQuery (const char * uri, PAL_STREAM_ATTR * attr);
 int _DkStreamAttributesQueryByHandle (PAL_HANDLE hdl, PAL_STREAM_ATTR * attr);
 int _DkStreamMap (PAL_HANDLE handle, void ** addr, int prot, uint64_t offset,
@@ -303,6 +314,8 @@ noreturn void _DkThreadExit(int* clear_child_tid);
 int _DkThreadDelayExecution (unsigned long * duration);
 void _DkThreadYieldExecution (void);
 int _DkThreadResume (PAL_HANDLE threadHandle);
+int _DkThreadSetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+int _DkThreadGetCpuAffinity (PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
 int _DkProcessCreate (PAL_HANDLE * handle, const char * uri,
                       const char ** args);
 noreturn void _DkProcessExit (int exitCode);
@@ -321,11 +334,23 @@ int _DkEventSet (PAL_HANDLE event, int wakeup);
 int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us);
 int _DkEventWait(PAL_HANDLE event);
 int _DkEventClear (PAL_HANDLE event);
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us);
+int _DkFutexWake(uint32_t* addr, int count);
 
 /* DkVirtualMemory calls */
 int _DkVirtualMemoryAlloc (void ** paddr, uint64_t size, int alloc_type, int prot);
 int _DkVirtualMemoryFree (void * addr, uint64_t size);
 int _DkVirtualMemoryProtect (void * addr, uint64_t size, int prot);
+int _DkVirtualMemoryAdvise (void * addr, uint64_t size, int alloc_type);
+int _DkVirtualMemoryBind (void * addr, uint64_t size, int policy, PAL_NUM * nodemask,
+                          PAL_NUM maxnode, int flags);
+int _DkThreadSetMemoryPolicy (int policy, PAL_NUM * nodemask, PAL_NUM maxnode);
+int _DkMemoryPolicyQuery (void * addr, PAL_FLG * policy, PAL_NUM * nodemask, PAL_NUM maxnode);
+int _DkVirtualMemoryMovePages (PAL_NUM count, void ** pages, const int * nodes, int * status);
+int _DkSharedMemoryCreate (PAL_HANDLE * handle, uint64_t size);
+int _DkVirtualMemoryQueryDirty (void * addr, uint64_t size, PAL_BOL * dirty);
+int _DkVirtualMemoryTrackWrites (void);
+int _DkVirtualMemoryQueryWritten (void * addr, uint64_t size, PAL_BOL * written);
 
 /* DkObject calls */
 int _DkObjectReference (PAL_HANDLE objectHandle);
@@ -344,6 +369,7 @@ void _DkInternalLock(PAL_LOCK* mut);
 void _DkInternalUnlock(PAL_LOCK* mut);
 bool _DkInternalIsLocked(PAL_LOCK* mut);
 unsigned long _DkSystemTimeQuery (void);
+int _DkSystemClockQuery (int clock, uint64_t * time_ns);
 
 /*
  * Cryptographically secure random.